@@ -178,7 +178,8 @@ EMACSnow_Object emacObjects[DK_TM4C129X_EMACCOUNT];
 UInt8 macAddress[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
 
 const EMACSnow_HWAttrs emacHWAttrs[DK_TM4C129X_EMACCOUNT] = {
-    {EMAC0_BASE, INT_EMAC0, macAddress}
+    {EMAC0_BASE, INT_EMAC0, macAddress, SYSCTL_PERIPH_EMAC0,
+     SYSCTL_PERIPH_EPHY0}
 };
 
 const EMAC_Config EMAC_config[] = {
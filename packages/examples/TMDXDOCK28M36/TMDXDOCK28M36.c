@@ -140,7 +140,8 @@ EMACTiva_Object emacObjects[TMDXDOCK28M36_EMACCOUNT];
 UInt8 macAddress[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
 
 const EMACTiva_HWAttrs emacHWAttrs[TMDXDOCK28M36_EMACCOUNT] = {
-    {INT_ETH, macAddress}
+    /* Channels 6 and 7 are mapped to the EMAC after reset */
+    {INT_ETH, macAddress, UDMA_CHANNEL_ETH0RX, UDMA_CHANNEL_ETH0TX, NULL, 0, 0}
 };
 
 const EMAC_Config EMAC_config[] = {
@@ -222,6 +223,9 @@ Void TMDXDOCK28M36_initEMAC(Void)
         System_abort("Change the macAddress variable to match your board's MAC sticker");
     }
 
+    /* The EMAC driver moves frames with the uDMA */
+    TMDXDOCK28M36_initDMA();
+
     /* Once EMAC_init is called, EMAC_config cannot be changed */
     EMAC_init();
 }
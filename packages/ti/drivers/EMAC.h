@@ -74,6 +74,11 @@ extern "C" {
 #include <xdc/std.h>
 #include <ti/drivers/ENV.h>
 
+/*!
+ *  @brief      A handle that is returned from a EMAC_config[] entry.
+ */
+typedef struct EMAC_Config      *EMAC_Handle;
+
 /* Prototypes of EMAC interface */
 typedef Void (*EMAC_InitFxn)(UInt);
 typedef Bool (*EMAC_isLinkUpFxn)(UInt);
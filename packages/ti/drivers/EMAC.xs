@@ -36,68 +36,45 @@
 function viewInitBasic(view)
 {
     var Program = xdc.useModule('xdc.rov.Program');
-    var EMAC = xdc.useModule('ti.drivers.EMAC');
 
     var tree = viewDetailed();
 
     /* List if entries for the ROV module */
     var eventViews = new Array();
 
+    var modCfg = Program.getModuleConfig('ti.drivers.EMAC');
+
     for (var elem in tree) {
 
         /* Create a new element for ROV */
         var viewElem = Program.newViewStruct('ti.drivers.EMAC', 'Basic');
         viewElem.functionTable = tree[elem].fxnTablePtr;
         viewElem.emacHandle     = elem.toString(16);
+        viewElem.libType = modCfg.libType;
 
-        /* Add this element to the array of elements */
-        eventViews[eventViews.length] = viewElem;
-    }
-
-    var modCfg = Program.getModuleConfig('ti.drivers.EMAC');
-    viewElem.libType = modCfg.libType;
-
-    var macAddress = Program.fetchArray(
+        var macAddress = Program.fetchArray(
                 {type: 'xdc.rov.support.ScalarStructs.S_UChar', isScalar: true},
                 Number(tree[elem].hwAttrs.macAddress), 6);
 
-    viewElem.macAddress = macAddress[0].toString(16) + "-" +
-                          macAddress[1].toString(16) + "-" +
-                          macAddress[2].toString(16) + "-" +
-                          macAddress[3].toString(16) + "-" +
-                          macAddress[4].toString(16) + "-" +
-                          macAddress[5].toString(16);
-
-
-    var emacTivaSymbol = Program.getSymbolValue("EMACTiva_fxnTable");
-    var emacSnowDataSymbol = Program.getSymbolValue("EMACSnow_private");
-    if (emacSnowDataSymbol != -1) {
-        var data = Program.fetchStruct(
-                       EMAC.EMACSnow_Data$fetchDesc, emacSnowDataSymbol);
+        viewElem.macAddress = macAddress[0].toString(16) + "-" +
+                              macAddress[1].toString(16) + "-" +
+                              macAddress[2].toString(16) + "-" +
+                              macAddress[3].toString(16) + "-" +
+                              macAddress[4].toString(16) + "-" +
+                              macAddress[5].toString(16);
 
         /* linkUp field is either zero (down) or non-zero (UP) */
-        if (data.linkUp) {
+        if (tree[elem].object.linkUp) {
             viewElem.linkUp = true;
         }
         else {
            viewElem.linkUp = false;
         }
-    }
-    else if (emacTivaSymbol != -1) {
-        var emacConfigSymbol = Program.getSymbolValue("EMAC_config");
-        var emacHandle = Program.fetchStruct(EMAC.EMAC_Config$fetchDesc,
-                                             emacConfigSymbol);
-        var object = Program.fetchStruct(
-                 EMAC.EMACTiva_Object$fetchDesc, emacHandle.object);
 
-        /* linkUp field is either zero (down) or non-zero (UP) */
-        if (object.linkUp) {
-            viewElem.linkUp = true;
-        }
-        else {
-           viewElem.linkUp = false;
-        }
+        /* Add this element to the array of elements */
+        eventViews[eventViews.length] = viewElem;
     }
+
     view.elements = eventViews;
 }
 
@@ -107,7 +84,6 @@ function viewInitBasic(view)
 function viewInitStats(view)
 {
     var Program = xdc.useModule('xdc.rov.Program');
-    var EMAC = xdc.useModule('ti.drivers.EMAC');
 
     var tree = viewDetailed();
 
@@ -117,32 +93,14 @@ function viewInitStats(view)
     for (var elem in tree) {
         /* Create a new element for ROV */
         var viewElem = Program.newViewStruct('ti.drivers.EMAC', 'Statistics');
-        eventViews[eventViews.length] = viewElem;
-    }
-
-    var emacTivaSymbol = Program.getSymbolValue("EMACTiva_fxnTable");
-    var emacSnowDataSymbol = Program.getSymbolValue("EMACSnow_private");
 
-    if (emacSnowDataSymbol != -1) {
-        var data = Program.fetchStruct(
-                       EMAC.EMACSnow_Data$fetchDesc, emacSnowDataSymbol);
         /* Fill in the values */
-        viewElem.rxCount      = data.rxCount;
-        viewElem.rxDropped    = data.rxDropped;
-        viewElem.txSent       = data.txSent;
-        viewElem.txDropped    = data.txDropped;
-    }
-    else if (emacTivaSymbol != -1) {
-        var emacConfigSymbol = Program.getSymbolValue("EMAC_config");
-        var emacHandle = Program.fetchStruct(EMAC.EMAC_Config$fetchDesc,
-                                             emacConfigSymbol);
-        var object = Program.fetchStruct(
-                 EMAC.EMACTiva_Object$fetchDesc, emacHandle.object);
-
-        viewElem.rxCount      = object.rxCount;
-        viewElem.rxDropped    = object.rxDropped;
-        viewElem.txSent       = object.txSent;
-        viewElem.txDropped    = object.txDropped;
+        viewElem.rxCount      = tree[elem].object.rxCount;
+        viewElem.rxDropped    = tree[elem].object.rxDropped;
+        viewElem.txSent       = tree[elem].object.txSent;
+        viewElem.txDropped    = tree[elem].object.txDropped;
+
+        eventViews[eventViews.length] = viewElem;
     }
 
     view.elements = eventViews;
@@ -35,8 +35,11 @@
 #include <xdc/runtime/Diags.h>
 #include <xdc/runtime/Error.h>
 #include <xdc/runtime/Log.h>
+#include <xdc/runtime/Timestamp.h>
 
 #include <ti/drivers/GPIO.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Swi.h>
 
 #if defined(MWARE) || defined(TIVAWARE) || defined(CCWARE)
 #include <ti/sysbios/family/arm/m3/Hwi.h>
@@ -64,9 +67,199 @@
 #define GPIOIntEnable       GPIOPinIntEnable
 #endif
 
-extern const GPIO_Config GPIO_config[];
+/*
+ * On Tiva, MWare and CC3200 parts the GPIODATA register is address-masked:
+ * a single store only changes the pins selected by the address, so writes
+ * to a set of pins need no interrupt lock.
+ */
+#if !defined(MSP430WARE) && !defined(STARTERWARE)
+#define GPIO_MASKED_DATA
+#endif
+
+/*
+ * Index of the highest pending pin. Where the compiler exposes the ARM CLZ
+ * instruction this is a single instruction, otherwise GPIO_msb() does a
+ * fixed five step search.
+ */
+#if defined(__TI_COMPILER_VERSION__) && defined(__TMS470__)
+#define GPIO_MSB(x)         (31 - _norm(x))
+#elif defined(__GNUC__) && defined(__arm__)
+#define GPIO_MSB(x)         (31 - __builtin_clz(x))
+#elif defined(__IAR_SYSTEMS_ICC__) && defined(__ARM_PROFILE_M__)
+#include <intrinsics.h>
+#define GPIO_MSB(x)         (31 - __CLZ(x))
+#else
+#define GPIO_MSB(x)         GPIO_msb(x)
+#define GPIO_NEED_MSB
+#endif
+
+/* Index of the lowest pending pin, the only bit left by x & -x */
+#define GPIO_LSB(x)         GPIO_MSB((x) & (~(x) + 1))
+
+/* Port bit mask of the pin(s) described by a GPIO_HWAttrs */
+#if defined(STARTERWARE)
+#define GPIO_PINMASK(attrs) ((Bits32)1 << (attrs)->pin)
+#else
+#define GPIO_PINMASK(attrs) ((Bits32)(attrs)->pin)
+#endif
+
 static Int GPIO_count = -1; /* Also used to check status for initialization */
 
+/* Prototypes */
+static Void GPIO_clearPins(ULong port, Bits32 pins);
+static Void GPIO_dispatch(GPIO_PinCallback const callbacks[], Bits32 pins);
+#if defined(GPIO_NEED_MSB)
+static UInt GPIO_msb(Bits32 pins);
+#endif
+static Bits32 GPIO_readPins(ULong port, Bits32 mask);
+
+/*
+ *  ======== GPIO_clearPins ========
+ *  Clears the interrupt flags of a set of pins on one port.
+ */
+static Void GPIO_clearPins(ULong port, Bits32 pins)
+{
+#if defined(STARTERWARE)
+    UInt i;
+
+    /* StarterWare clears one pin number at a time */
+    while (pins) {
+        i = GPIO_MSB(pins);
+        pins &= ~((Bits32)1 << i);
+        GPIOPinIntClear(port, GPIO_INT_LINE_1, i);
+    }
+#else
+    GPIOIntClear(port, pins);
+#endif
+}
+
+/*
+ *  ======== GPIO_dispatch ========
+ *  Calls the callback of each pin set in pins, highest pin first. The cost
+ *  per pending pin does not depend on its position in the port.
+ */
+static Void GPIO_dispatch(GPIO_PinCallback const callbacks[], Bits32 pins)
+{
+    UInt i;
+
+    while (pins) {
+        i = GPIO_MSB(pins);
+        pins &= ~((Bits32)1 << i);
+
+        Assert_isTrue(callbacks[i].fxn != NULL, NULL);
+        callbacks[i].fxn(i, callbacks[i].arg);
+    }
+}
+
+#if defined(GPIO_NEED_MSB)
+/*
+ *  ======== GPIO_msb ========
+ *  Returns the index of the highest bit set in pins, which must not be 0.
+ */
+static UInt GPIO_msb(Bits32 pins)
+{
+    UInt i = 0;
+
+    if (pins & 0xFFFF0000) {
+        pins >>= 16;
+        i += 16;
+    }
+    if (pins & 0xFF00) {
+        pins >>= 8;
+        i += 8;
+    }
+    if (pins & 0xF0) {
+        pins >>= 4;
+        i += 4;
+    }
+    if (pins & 0xC) {
+        pins >>= 2;
+        i += 2;
+    }
+    if (pins & 0x2) {
+        i += 1;
+    }
+
+    return (i);
+}
+#endif
+
+/*
+ *  ======== GPIO_readPins ========
+ *  Returns the input levels of the pins in mask as port bits.
+ */
+static Bits32 GPIO_readPins(ULong port, Bits32 mask)
+{
+    Bits32 value;
+#if defined(MSP430WARE)
+    Bits32 pin;
+
+    /* GPIO_getInputPinValue() only reports a single pin */
+    value = 0;
+    for (pin = 1; pin != 0 && pin <= mask; pin <<= 1) {
+        if ((mask & pin) &&
+            GPIO_getInputPinValue(port, pin) == GPIO_INPUT_PIN_HIGH) {
+            value |= pin;
+        }
+    }
+#elif defined(STARTERWARE)
+    value = GPIOMultiplePinsRead(port, mask);
+#else
+    value = GPIOPinRead(port, mask);
+#endif
+
+    return (value & mask);
+}
+
+/*
+ *  ======== GPIO_captureRead ========
+ */
+UInt GPIO_captureRead(GPIO_Capture const *capture, GPIO_CaptureEvent events[],
+                      UInt count, UInt timeout)
+{
+    UInt i;
+    UInt avail;
+    UInt tail;
+    GPIO_CaptureObject *object;
+    Semaphore_Handle sem;
+
+    Assert_isTrue(capture != NULL && events != NULL, NULL);
+
+    object = capture->object;
+
+    if (capture->semStruct != NULL && timeout != 0) {
+        sem = Semaphore_handle((Semaphore_Struct *)(capture->semStruct));
+
+        /*
+         * Drop a post for a batch that was already read before looking at
+         * the ring. The Hwi posts when the ring reaches batch events, so a
+         * post after this reset always means a full batch is queued.
+         */
+        Semaphore_reset(sem, 0);
+        if (object->head - object->tail < capture->batch) {
+            Semaphore_pend(sem, timeout);
+        }
+    }
+
+    avail = object->head - object->tail;
+
+    if (count > avail) {
+        count = avail;
+    }
+
+    /* Only the Hwi moves head and only the reader moves tail */
+    tail = object->tail;
+    for (i = 0; i < count; i++) {
+        events[i] = capture->events[(tail + i) & (capture->numEvents - 1)];
+    }
+    object->tail = tail + count;
+
+    Log_print2(Diags_USER2, "GPIO: port 0x%x, %d capture events read",
+               capture->port, count);
+
+    return (count);
+}
+
 /*
  *  ======== GPIO_clearInt ========
  */
@@ -147,11 +340,183 @@ Void GPIO_enableInt(UInt index, GPIO_IntType intType)
                attrs->port, attrs->pin);
 }
 
+/*
+ *  ======== GPIO_groupInit ========
+ */
+Void GPIO_groupInit(GPIO_Group *group, UInt const indexes[], UInt count)
+{
+    UInt i;
+    GPIO_HWAttrs const *attrs;
+
+    Assert_isTrue(GPIO_count >= 0 && group != NULL, NULL);
+    Assert_isTrue(indexes != NULL && count > 0, NULL);
+
+    group->port = GPIO_config[indexes[0]].hwAttrs->port;
+    group->mask = 0;
+
+    for (i = 0; i < count; i++) {
+        Assert_isTrue((Int)indexes[i] < GPIO_count, NULL);
+
+        attrs = GPIO_config[indexes[i]].hwAttrs;
+
+        /* All pins of a group must be on the same port */
+        Assert_isTrue(attrs->port == group->port, NULL);
+
+        group->mask |= GPIO_PINMASK(attrs);
+    }
+
+    /* Values are aligned to the lowest pin of the group */
+    for (group->shift = 0; group->shift < 31 &&
+        !(group->mask & ((Bits32)1 << group->shift)); group->shift++) {
+    }
+
+    Log_print2(Diags_USER1, "GPIO: port 0x%x, pins 0x%x grouped",
+               group->port, group->mask);
+}
+
+/*
+ *  ======== GPIO_groupRead ========
+ */
+Bits32 GPIO_groupRead(GPIO_Group const *group)
+{
+    Bits32 value;
+
+    Assert_isTrue(group != NULL, NULL);
+
+    value = GPIO_readPins(group->port, group->mask) >> group->shift;
+
+    Log_print3(Diags_USER1, "GPIO: port 0x%x, pins 0x%x read 0x%x",
+               group->port, group->mask, value);
+
+    return (value);
+}
+
+/*
+ *  ======== GPIO_groupToggle ========
+ */
+Void GPIO_groupToggle(GPIO_Group const *group)
+{
+#if defined(MSP430WARE)
+    UInt key;
+#else
+    Bits32 value;
+#endif
+
+    Assert_isTrue(group != NULL, NULL);
+
+#if defined(MSP430WARE)
+    key = Hwi_disable();
+    GPIO_toggleOutputOnPin(group->port, group->mask);
+    Hwi_restore(key);
+#elif defined(STARTERWARE)
+    value = GPIOMultiplePinsRead(group->port, group->mask);
+    GPIOMultiplePinsWrite(group->port, ~value & group->mask,
+                          value & group->mask);
+#else
+    value = GPIOPinRead(group->port, group->mask);
+    GPIOPinWrite(group->port, group->mask, ~value);
+#endif
+
+    Log_print2(Diags_USER1, "GPIO: port 0x%x, pins 0x%x toggled",
+               group->port, group->mask);
+}
+
+/*
+ *  ======== GPIO_groupWrite ========
+ */
+Void GPIO_groupWrite(GPIO_Group const *group, Bits32 value)
+{
+#if defined(MSP430WARE)
+    UInt key;
+#endif
+
+    Assert_isTrue(group != NULL, NULL);
+
+    value = (value << group->shift) & group->mask;
+
+#if defined(MSP430WARE)
+    key = Hwi_disable();
+    GPIO_setOutputHighOnPin(group->port, value);
+    GPIO_setOutputLowOnPin(group->port, ~value & group->mask);
+    Hwi_restore(key);
+#elif defined(STARTERWARE)
+    GPIOMultiplePinsWrite(group->port, value, ~value & group->mask);
+#else
+    GPIOPinWrite(group->port, group->mask, value);
+#endif
+
+    Log_print3(Diags_USER1, "GPIO: port 0x%x, pins 0x%x wrote 0x%x",
+               group->port, group->mask, value);
+}
+
+/*
+ *  ======== GPIO_hwiCaptureFxn ========
+ *  Hwi function for ports set up with GPIO_setupCapture(). Edges that
+ *  arrive while the ring is being filled are handled in the same Hwi run.
+ */
+Void GPIO_hwiCaptureFxn(UArg arg)
+{
+    Bits32 pins;
+    Bits32 levels;
+    UInt i;
+    UInt head;
+    UInt queued;
+    UInt32 now;
+    GPIO_CaptureEvent *event;
+    GPIO_Capture const *capture = (GPIO_Capture const *)arg;
+    GPIO_CaptureObject *object = capture->object;
+
+    for (;;) {
+        /* Take the timestamp before anything else to keep jitter low */
+        now = Timestamp_get32();
+
+#if defined(STARTERWARE)
+        pins = GPIORawIntStatus(capture->port, GPIO_INT_LINE_1, capture->pins);
+#else
+        pins = GPIOIntStatus(capture->port, 0xFF);
+#endif
+        pins &= capture->pins;
+        if (pins == 0) {
+            break;
+        }
+
+        GPIO_clearPins(capture->port, pins);
+        levels = GPIO_readPins(capture->port, pins);
+
+        head = object->head;
+        queued = head - object->tail;
+        while (pins) {
+            i = GPIO_MSB(pins);
+            pins &= ~((Bits32)1 << i);
+
+            if (head - object->tail >= capture->numEvents) {
+                /* Ring is full; the oldest events are kept */
+                object->overruns++;
+                continue;
+            }
+
+            event = &(capture->events[head & (capture->numEvents - 1)]);
+            event->timestamp = now;
+            event->pin = i;
+            event->level = (levels >> i) & 0x1;
+            head++;
+        }
+
+        /* Publish the new events to the reader */
+        object->head = head;
+
+        if (capture->semStruct != NULL && queued < capture->batch &&
+            head - object->tail >= capture->batch) {
+            Semaphore_post(Semaphore_handle(
+                (Semaphore_Struct *)(capture->semStruct)));
+        }
+    }
+}
+
 /*
  *  ======== GPIO_hwiIntFxn ========
  *  Hwi function that processes GPIO interrupts.
  */
- #ifndef MSP430WARE
 Void GPIO_hwiIntFxn(UArg callbacks)
 {
     Bits32 pins;
@@ -167,17 +532,57 @@ Void GPIO_hwiIntFxn(UArg callbacks)
     pins = GPIOIntStatus(portCallback->port, 0xFF) & 0xFF;
 #endif
 
-    /* Match the interrupt to its corresponding callback function */
-    for (i = 0; pins; i++) {
-        if (pins & 0x1) {
-            Assert_isTrue(portCallback->callbackFxn[i] != NULL, NULL);
-            portCallback->callbackFxn[i]();
-        }
-        pins = pins >> 1;
+    /*
+     * Match the interrupt to its corresponding callback function, lowest pin
+     * first as GPIO_setupCallbacks() users have always been called
+     */
+    while (pins) {
+        i = GPIO_LSB(pins);
+        pins &= ~((Bits32)1 << i);
+
+        Assert_isTrue(portCallback->callbackFxn[i] != NULL, NULL);
+        portCallback->callbackFxn[i]();
     }
 }
+
+/*
+ *  ======== GPIO_hwiPortFxn ========
+ *  Hwi function for ports set up with GPIO_setupPortCallbacks().
+ */
+Void GPIO_hwiPortFxn(UArg arg)
+{
+    Bits32 pins;
+    Bits32 stamp;
+    UInt i;
+    UInt32 now;
+    GPIO_PortCallbacks const *callbacks = (GPIO_PortCallbacks const *)arg;
+
+    /* Find out which pins have their interrupt flags set */
+#if defined(STARTERWARE)
+    pins = GPIORawIntStatus(callbacks->port, GPIO_INT_LINE_1, 0xFFFFFFFF);
+#else
+    pins = GPIOIntStatus(callbacks->port, 0xFF) & 0xFF;
 #endif
 
+    GPIO_clearPins(callbacks->port, pins);
+
+    if (callbacks->swiStruct == NULL) {
+        GPIO_dispatch(callbacks->callbacks, pins);
+        return;
+    }
+
+    /* Timestamp the edges and leave the callbacks to the Swi */
+    now = Timestamp_get32();
+    for (stamp = pins; stamp; ) {
+        i = GPIO_MSB(stamp);
+        stamp &= ~((Bits32)1 << i);
+        callbacks->object->timestamp[i] = now;
+    }
+    callbacks->object->pending |= pins;
+
+    Swi_post(Swi_handle((Swi_Struct *)(callbacks->swiStruct)));
+}
+
 /*
  *  ======== GPIO_init ========
  */
@@ -198,7 +603,9 @@ Void GPIO_init()
  */
 Bits32 GPIO_read(UInt index)
 {
+#if !defined(GPIO_MASKED_DATA)
     UInt key;
+#endif
     Bits32 value;
     GPIO_HWAttrs const *attrs;
 
@@ -206,11 +613,16 @@ Bits32 GPIO_read(UInt index)
 
     attrs = GPIO_config[index].hwAttrs;
 
+#if defined(GPIO_MASKED_DATA)
+    /* A single masked load */
+    value = GPIOPinRead(attrs->port, attrs->pin);
+#else
     /* Make atomic update */
     key = Hwi_disable();
 	value = GPIOPinRead(attrs->port, attrs->pin);
 
     Hwi_restore(key);
+#endif
 
     Log_print3(Diags_USER1, "GPIO: port 0x%x, pin 0x%x read 0x%x",
                attrs->port, attrs->pin, value);
@@ -224,9 +636,6 @@ Bits32 GPIO_read(UInt index)
  */
 Void GPIO_setupCallbacks(GPIO_Callbacks const *callbacks)
 {
-#if defined(MSP430WARE)
-    Assert_isTrue(FALSE, NULL);
-#else
     Error_Block eb;
     Hwi_Params hwiParams;
     static Int index = 0;
@@ -250,7 +659,113 @@ Void GPIO_setupCallbacks(GPIO_Callbacks const *callbacks)
     else {
         index++;
     }
-#endif
+}
+
+/*
+ *  ======== GPIO_setupCapture ========
+ *  This function is not thread-safe.
+ */
+Void GPIO_setupCapture(GPIO_Capture const *capture)
+{
+    Error_Block eb;
+    Hwi_Params hwiParams;
+    Semaphore_Params semParams;
+
+    Assert_isTrue(GPIO_count > 0 && capture != NULL, NULL);
+    Assert_isTrue(capture->hwiStruct != NULL && capture->object != NULL,
+                  NULL);
+    /* The ring size must be a power of two */
+    Assert_isTrue(capture->events != NULL && capture->numEvents != 0 &&
+        (capture->numEvents & (capture->numEvents - 1)) == 0, NULL);
+
+    capture->object->head = 0;
+    capture->object->tail = 0;
+    capture->object->overruns = 0;
+
+    if (capture->semStruct != NULL) {
+        Semaphore_Params_init(&semParams);
+        semParams.mode = Semaphore_Mode_BINARY;
+        Semaphore_construct((Semaphore_Struct *)(capture->semStruct), 0,
+                            &semParams);
+    }
+
+    /* Construct hardware interrupt */
+    Hwi_Params_init(&hwiParams);
+    hwiParams.arg = (UArg)capture;
+    hwiParams.priority = capture->priority;
+    Error_init(&eb);
+    Hwi_construct((Hwi_Struct *)(capture->hwiStruct), capture->intNum,
+                  GPIO_hwiCaptureFxn, &hwiParams, &eb);
+    if (Error_check(&eb)) {
+        Log_error1("GPIO: Error constructing capture Hwi for GPIO Port %d",
+                   capture->port);
+        if (capture->semStruct != NULL) {
+            Semaphore_destruct((Semaphore_Struct *)(capture->semStruct));
+        }
+    }
+}
+
+/*
+ *  ======== GPIO_setupPortCallbacks ========
+ *  This function is not thread-safe.
+ */
+Void GPIO_setupPortCallbacks(GPIO_PortCallbacks const *callbacks)
+{
+    Error_Block eb;
+    Hwi_Params hwiParams;
+    Swi_Params swiParams;
+
+    Assert_isTrue(GPIO_count > 0 && callbacks != NULL, NULL);
+    Assert_isTrue(callbacks->hwiStruct != NULL, NULL);
+    Assert_isTrue(callbacks->swiStruct == NULL || callbacks->object != NULL,
+                  NULL);
+
+    Error_init(&eb);
+
+    if (callbacks->swiStruct != NULL) {
+        callbacks->object->pending = 0;
+
+        Swi_Params_init(&swiParams);
+        swiParams.arg0 = (UArg)callbacks;
+        Swi_construct((Swi_Struct *)(callbacks->swiStruct), GPIO_swiPortFxn,
+                      &swiParams, &eb);
+        if (Error_check(&eb)) {
+            Log_error1("GPIO: Error constructing Swi for GPIO Port %d",
+                       callbacks->port);
+            return;
+        }
+    }
+
+    /* Construct hardware interrupt */
+    Hwi_Params_init(&hwiParams);
+    hwiParams.arg = (UArg)callbacks;
+    Hwi_construct((Hwi_Struct *)(callbacks->hwiStruct), callbacks->intNum,
+                  GPIO_hwiPortFxn, &hwiParams, &eb);
+    if (Error_check(&eb)) {
+        Log_error1("GPIO: Error constructing Hwi for GPIO Port %d",
+                   callbacks->port);
+        if (callbacks->swiStruct != NULL) {
+            Swi_destruct((Swi_Struct *)(callbacks->swiStruct));
+        }
+    }
+}
+
+/*
+ *  ======== GPIO_swiPortFxn ========
+ *  Swi function that runs the callbacks deferred by GPIO_hwiPortFxn().
+ */
+Void GPIO_swiPortFxn(UArg arg0, UArg arg1)
+{
+    UInt key;
+    Bits32 pins;
+    GPIO_PortCallbacks const *callbacks = (GPIO_PortCallbacks const *)arg0;
+
+    key = Hwi_disable();
+    pins = callbacks->object->pending;
+    callbacks->object->pending = 0;
+    Hwi_restore(key);
+
+    GPIO_dispatch(callbacks->callbacks, pins);
 }
 
 /*
@@ -300,7 +815,9 @@ Void GPIO_toggle(UInt index)
  */
 Void GPIO_write(UInt index, Bits32 value)
 {
+#if !defined(GPIO_MASKED_DATA)
     UInt key;
+#endif
     GPIO_HWAttrs const *attrs;
 
     Assert_isTrue(GPIO_count >= 0 && (Int)index < GPIO_count, NULL);
@@ -308,6 +825,10 @@ Void GPIO_write(UInt index, Bits32 value)
 
     attrs = GPIO_config[index].hwAttrs;
 
+#if defined(GPIO_MASKED_DATA)
+    /* A single masked store only changes this index's pin(s) */
+    GPIOPinWrite(attrs->port, attrs->pin, value);
+#else
     key = Hwi_disable();
 
 #if defined(MSP430WARE)
@@ -322,6 +843,7 @@ Void GPIO_write(UInt index, Bits32 value)
 #endif
 
     Hwi_restore(key);
+#endif
 
     Log_print3(Diags_USER1, "GPIO: port 0x%x, pin 0x%x wrote 0x%x",
                attrs->port, attrs->pin, value);
@@ -154,10 +154,123 @@
  *  }
  *  @endcode
  *
+ *  ## GPIO pin groups #
+ *
+ *  Several output or input pins on the same port can be accessed as a unit,
+ *  for example the data lines of a parallel bus. GPIO_groupInit() computes
+ *  the port and pin mask of a set of GPIO indexes once; GPIO_groupWrite(),
+ *  GPIO_groupRead() and GPIO_groupToggle() then update or sample all pins of
+ *  the group with a single register access where the hardware allows it.
+ *  Values are aligned to the lowest pin of the group, so an 8-bit bus on
+ *  pins 0-7 of a port, or on pins 8-15, is written with the byte itself.
+ *
+ *  @code
+ *  GPIO_Group dataBus;
+ *  const UInt dataPins[] = {Board_D0, Board_D1, Board_D2, Board_D3,
+ *                           Board_D4, Board_D5, Board_D6, Board_D7};
+ *
+ *  GPIO_groupInit(&dataBus, dataPins, 8);
+ *  GPIO_groupWrite(&dataBus, 0xA5);
+ *  @endcode
+ *
+ *  On Tiva and Concerto devices the GPIO data register is address-masked, so
+ *  GPIO_write() and GPIO_groupWrite() are single stores that neither lock
+ *  interrupts nor disturb the other pins of the port.
+ *
+ *  ## Fast path #
+ *
+ *  GPIO_readFast(), GPIO_writeFast() and GPIO_toggleFast() take a port and
+ *  pin mask instead of a GPIO index. They are macros without Asserts or Log
+ *  calls. On Tiva and Concerto devices they expand to a direct access of the
+ *  address-masked GPIO data register. If the board header defines the port and
+ *  pin of a bit-banged line as constants, each call compiles to one load or
+ *  store at a constant address.
+ *
+ *  @code
+ *  // Board header
+ *  #define Board_LCD_WR_PORT   GPIO_PORTB_BASE
+ *  #define Board_LCD_WR_PIN    GPIO_PIN_5
+ *
+ *  // Application code
+ *  GPIO_writeFast(Board_LCD_WR_PORT, Board_LCD_WR_PIN, 0);
+ *  GPIO_writeFast(Board_LCD_WR_PORT, Board_LCD_WR_PIN, ~0);
+ *  @endcode
+ *
+ *  The pin of a GPIO index can also be used with GPIO_writeIndexFast() and
+ *  friends. These skip the checks but still load the port and pin from
+ *  *GPIO_config*.
+ *
  *  Keep in mind that the callback functions will be called in the context of
  *  an interrupt service routine and should be designed accordingly. Also, it
  *  is the user's responsibility to call GPIO_clearInt() to allow further
- *  interrupt to occur. The callback setup is not supported for all platforms.
+ *  interrupt to occur.
+ *
+ *  ## GPIO port callbacks #
+ *
+ *  GPIO_setupPortCallbacks() is an alternative to GPIO_setupCallbacks(). Each
+ *  pin's callback receives the pin number and an application argument, so
+ *  one function can serve several pins. The driver clears the interrupt
+ *  flags before dispatching, and pending pins are found with a count leading
+ *  zeros instruction where the compiler provides one.
+ *
+ *  If a Swi_Struct is supplied, the Hwi only timestamps the edges with
+ *  Timestamp_get32() and posts the Swi, and the callbacks run in the Swi.
+ *  The timestamp of a pin's most recent edge is in the timestamp array of the
+ *  port's GPIO_PortObject. Several edges of the same pin before the Swi runs
+ *  result in one callback. This mode is meant for edge-triggered interrupts.
+ *
+ *  @code
+ *  Void encoderFxn(UInt pin, UArg arg);
+ *
+ *  Hwi_Struct portCHwi;
+ *  Swi_Struct portCSwi;
+ *  GPIO_PortObject portCObject;
+ *
+ *  const GPIO_PortCallbacks portCCallbacks = {
+ *      GPIO_PORTC_BASE, INT_GPIOC, &portCHwi, &portCSwi, &portCObject,
+ *      {{NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0},
+ *       {encoderFxn, 0}, {encoderFxn, 1}, {NULL, 0}, {NULL, 0}}
+ *  };
+ *
+ *  GPIO_setupPortCallbacks(&portCCallbacks);
+ *  @endcode
+ *
+ *  ## GPIO edge capture #
+ *
+ *  For pulse width and frequency measurement GPIO_setupCapture() attaches a
+ *  capture Hwi to a port instead of callbacks. The Hwi reads Timestamp_get32()
+ *  as its first action and appends a GPIO_CaptureEvent (pin, level after the
+ *  edge, timestamp) per pending pin to a ring buffer. Edges that arrive
+ *  while the Hwi runs are collected in the same Hwi run. The ring has a
+ *  single producer and a single consumer, so neither side locks interrupts.
+ *  A task drains it in batches with GPIO_captureRead(), optionally pending on
+ *  a semaphore that is posted once batch events are queued.
+ *
+ *  Giving the capture Hwi a higher priority than the other interrupts keeps
+ *  nesting out of the timestamps. The priority must still be one that
+ *  SYS/BIOS manages, because the Hwi posts the semaphore: on the M3/M4
+ *  targets priority 0 is a zero-latency interrupt, which must not call
+ *  SYS/BIOS APIs. The edge direction is taken from the pin
+ *  level read in the Hwi, so pulses shorter than the interrupt latency can be
+ *  recorded with the wrong level. Hardware timer capture pins are not used
+ *  by this driver.
+ *
+ *  @code
+ *  Hwi_Struct captureHwi;
+ *  Semaphore_Struct captureSem;
+ *  GPIO_CaptureObject captureObject;
+ *  GPIO_CaptureEvent captureEvents[64];
+ *
+ *  const GPIO_Capture portDCapture = {
+ *      GPIO_PORTD_BASE, INT_GPIOD, &captureHwi, 0x20, &captureObject,
+ *      captureEvents, 64, 16, &captureSem, 0x20
+ *  };
+ *
+ *  GPIO_setupCapture(&portDCapture);
+ *  GPIO_enableInt(Board_PULSE_IN, GPIO_INT_BOTH_EDGES);
+ *
+ *  n = GPIO_captureRead(&portDCapture, events, 16, BIOS_WAIT_FOREVER);
+ *  @endcode
  *
  *  # Instrumentation #
  *  The GPIO driver interface produces log statements if instrumentation is
@@ -181,8 +294,15 @@ extern "C" {
 
 #include <ti/drivers/ENV.h>
 
+#if defined(TIVAWARE) || defined(MWARE)
+#include <inc/hw_gpio.h>
+#endif
+
 /* Extern'd hwiIntFxn */
+extern Void GPIO_hwiCaptureFxn(UArg arg);
 extern Void GPIO_hwiIntFxn(UArg callbacks);
+extern Void GPIO_hwiPortFxn(UArg arg);
+extern Void GPIO_swiPortFxn(UArg arg0, UArg arg1);
 
 /*!
  *  @brief  GPIO direction indictator
@@ -224,6 +344,99 @@ typedef struct GPIO_Callbacks {
     Void (*callbackFxn[ENV_GPIO_CALLBACK_AMT])(Void);
 } GPIO_Callbacks;
 
+/*!
+ *  @brief  GPIO pin callback function
+ *
+ *  @param  pin     Pin number within the port (pin 0 is 0 and so on)
+ *  @param  arg     Argument from the pin's GPIO_PinCallback entry
+ */
+typedef Void (*GPIO_PinCallbackFxn)(UInt pin, UArg arg);
+
+/*!
+ *  @brief  GPIO pin callback and its argument
+ */
+typedef struct GPIO_PinCallback {
+    GPIO_PinCallbackFxn fxn;    /*!< Callback function, NULL if unused */
+    UArg arg;                   /*!< Argument passed to fxn */
+} GPIO_PinCallback;
+
+/*!
+ *  @brief  GPIO port callback state
+ *
+ *  Run-time state of a GPIO_PortCallbacks structure that defers its
+ *  callbacks to a Swi. The application provides the memory; it is only
+ *  written by the GPIO driver.
+ */
+typedef struct GPIO_PortObject {
+    /*! Pins whose edge has not been handed to the Swi yet */
+    volatile Bits32 pending;
+    /*! Timestamp_get32() value of each pin's most recent edge */
+    UInt32 timestamp[ENV_GPIO_CALLBACK_AMT];
+} GPIO_PortObject;
+
+/*!
+ *  @brief  GPIO port callback structure
+ *
+ *  Used with GPIO_setupPortCallbacks(). Each entry of the callbacks array
+ *  corresponds to a pin in the specified port (pin 0 to index 0 and so on).
+ *  This structure must be persistent.
+ */
+typedef struct GPIO_PortCallbacks {
+    ULong port;                 /*!< GPIO port */
+    UInt intNum;                /*!< GPIO interrupt number */
+    Ptr hwiStruct;              /*!< Pointer to a family specific Hwi_Struct */
+    /*! Pointer to a Swi_Struct to run the callbacks in, or NULL to run them
+     *  in the Hwi */
+    Ptr swiStruct;
+    /*! Run-time state; required if swiStruct is not NULL */
+    GPIO_PortObject *object;
+    /*! Array of callbacks, one per pin */
+    GPIO_PinCallback callbacks[ENV_GPIO_CALLBACK_AMT];
+} GPIO_PortCallbacks;
+
+/*!
+ *  @brief  GPIO capture event
+ */
+typedef struct GPIO_CaptureEvent {
+    UInt32 timestamp;           /*!< Timestamp_get32() at Hwi entry */
+    UInt8 pin;                  /*!< Pin number within the port */
+    UInt8 level;                /*!< Pin level after the edge (1 = rising) */
+} GPIO_CaptureEvent;
+
+/*!
+ *  @brief  GPIO capture state
+ *
+ *  Run-time state of a GPIO_Capture ring. The application provides the
+ *  memory; it is only written by the GPIO driver.
+ */
+typedef struct GPIO_CaptureObject {
+    volatile UInt head;         /*!< Events written; moved by the Hwi */
+    volatile UInt tail;         /*!< Events read; moved by the reader */
+    volatile UInt overruns;     /*!< Events dropped because the ring was full */
+} GPIO_CaptureObject;
+
+/*!
+ *  @brief  GPIO edge capture structure
+ *
+ *  Used with GPIO_setupCapture(). This structure must be persistent.
+ */
+typedef struct GPIO_Capture {
+    ULong port;                 /*!< GPIO port */
+    UInt intNum;                /*!< GPIO interrupt number */
+    Ptr hwiStruct;              /*!< Pointer to a family specific Hwi_Struct */
+    Bits32 pins;                /*!< Port bit mask of the captured pins */
+    GPIO_CaptureObject *object; /*!< Run-time state */
+    GPIO_CaptureEvent *events;  /*!< Ring buffer of numEvents entries */
+    UInt numEvents;             /*!< Ring size; must be a power of two */
+    UInt batch;                 /*!< Queued events that post semStruct */
+    /*! Pointer to a Semaphore_Struct to pend on in GPIO_captureRead(), or
+     *  NULL */
+    Ptr semStruct;
+    /*! Capture Hwi priority; must be a SYS/BIOS managed level, not a
+     *  zero-latency interrupt (priority 0 on the M3/M4 targets) */
+    Int priority;
+} GPIO_Capture;
+
 /*!
  *  @brief  GPIO Hardware attributes
  *
@@ -249,6 +462,101 @@ typedef struct GPIO_Config {
     GPIO_HWAttrs  const *hwAttrs;
 } GPIO_Config;
 
+/* Application supplied GPIO configuration, used by the index fast path */
+extern const GPIO_Config GPIO_config[];
+
+/*!
+ *  @def    GPIO_readFast(port, pin)
+ *  @brief  Reads GPIO pin(s) without checks or logging
+ *
+ *  port and pin are the same as in GPIO_HWAttrs. The value is the same as
+ *  returned by GPIO_read().
+ */
+/*!
+ *  @def    GPIO_writeFast(port, pin, value)
+ *  @brief  Writes GPIO pin(s) without checks, logging or interrupt locking
+ *
+ *  value has the same meaning as for GPIO_write().
+ */
+/*!
+ *  @def    GPIO_toggleFast(port, pin)
+ *  @brief  Toggles GPIO pin(s) without checks or logging
+ *
+ *  The read and write are not atomic with respect to other threads writing
+ *  the same pin(s).
+ */
+#if defined(TIVAWARE) || defined(MWARE)
+#define GPIO_dataReg(port, pin) \
+    HWREG((port) + GPIO_O_DATA + ((Bits32)(pin) << 2))
+#define GPIO_readFast(port, pin)            (GPIO_dataReg(port, pin))
+#define GPIO_writeFast(port, pin, value)    (GPIO_dataReg(port, pin) = (value))
+#define GPIO_toggleFast(port, pin)          (GPIO_dataReg(port, pin) ^= 0xFF)
+
+#elif defined(MSP430WARE)
+#define GPIO_readFast(port, pin)            GPIO_getInputPinValue(port, pin)
+#define GPIO_writeFast(port, pin, value)    ((value) ? \
+    GPIO_setOutputHighOnPin(port, pin) : GPIO_setOutputLowOnPin(port, pin))
+#define GPIO_toggleFast(port, pin)          GPIO_toggleOutputOnPin(port, pin)
+
+#elif defined(STARTERWARE)
+#define GPIO_readFast(port, pin)            GPIOPinRead(port, pin)
+#define GPIO_writeFast(port, pin, value)    GPIOPinWrite(port, pin, value)
+#define GPIO_toggleFast(port, pin) \
+    GPIOPinWrite(port, pin, GPIOPinRead(port, pin) ? 0x0 : 0x1)
+
+#else
+#define GPIO_readFast(port, pin)            GPIOPinRead(port, pin)
+#define GPIO_writeFast(port, pin, value)    GPIOPinWrite(port, pin, value)
+#define GPIO_toggleFast(port, pin) \
+    GPIOPinWrite(port, pin, ~GPIOPinRead(port, pin))
+#endif
+
+/*! GPIO_readFast() for a GPIO index */
+#define GPIO_readIndexFast(index) \
+    GPIO_readFast(GPIO_config[index].hwAttrs->port, \
+                  GPIO_config[index].hwAttrs->pin)
+
+/*! GPIO_writeFast() for a GPIO index */
+#define GPIO_writeIndexFast(index, value) \
+    GPIO_writeFast(GPIO_config[index].hwAttrs->port, \
+                   GPIO_config[index].hwAttrs->pin, value)
+
+/*! GPIO_toggleFast() for a GPIO index */
+#define GPIO_toggleIndexFast(index) \
+    GPIO_toggleFast(GPIO_config[index].hwAttrs->port, \
+                    GPIO_config[index].hwAttrs->pin)
+
+/*!
+ *  @brief  GPIO pin group
+ *
+ *  A set of pins on one GPIO port that is read and written as a unit. It is
+ *  filled in by GPIO_groupInit() and must not be changed by the application.
+ */
+typedef struct GPIO_Group {
+    ULong  port;                /*!< GPIO port of the pins in the group */
+    Bits32 mask;                /*!< Port bit mask of the pins in the group */
+    UInt   shift;               /*!< Port bit of the lowest pin in the group */
+} GPIO_Group;
+
+/*!
+ *  @brief      Reads captured GPIO edges
+ *
+ *  Copies up to count events from the capture ring, oldest first. If fewer
+ *  than the capture's batch events are queued and a semaphore was given, the
+ *  calling task pends for up to timeout ticks until batch events are queued.
+ *  Only one task may read a capture ring.
+ *
+ *  @param      capture     GPIO_Capture set up with GPIO_setupCapture()
+ *  @param      events      Array to receive the events
+ *  @param      count       Size of events
+ *  @param      timeout     Clock ticks to wait for a batch; 0 does not wait
+ *
+ *  @return     Number of events copied into events
+ */
+extern UInt GPIO_captureRead(GPIO_Capture const *capture,
+                             GPIO_CaptureEvent events[], UInt count,
+                             UInt timeout);
+
 /*!
  *  @brief      Clears the GPIO interrupt flag
  *
@@ -279,6 +587,54 @@ extern Void GPIO_disableInt(UInt index);
  */
 extern Void GPIO_enableInt(UInt index, GPIO_IntType intType);
 
+/*!
+ *  @brief      Initializes a GPIO pin group
+ *
+ *  Computes the port and pin mask for the GPIO indexes given, so they can be
+ *  accessed together with GPIO_groupRead(), GPIO_groupToggle() and
+ *  GPIO_groupWrite(). All indexes must be on the same GPIO port. This
+ *  function must be called after GPIO_init().
+ *
+ *  @param      group       GPIO_Group to initialize
+ *  @param      indexes     Array of GPIO indexes that form the group
+ *  @param      count       Number of entries in indexes
+ */
+extern Void GPIO_groupInit(GPIO_Group *group, UInt const indexes[],
+                           UInt count);
+
+/*!
+ *  @brief      Reads the pins of a GPIO pin group
+ *
+ *  @param      group   GPIO_Group initialized by GPIO_groupInit()
+ *
+ *  @return     Pin values, aligned so that bit 0 is the lowest pin of the
+ *              group
+ */
+extern Bits32 GPIO_groupRead(GPIO_Group const *group);
+
+/*!
+ *  @brief      Toggles all pins of a GPIO pin group
+ *
+ *  Pins of the port outside the group are not affected. The read and write
+ *  of the group's pins are not atomic with respect to other threads writing
+ *  the same pins.
+ *
+ *  @param      group   GPIO_Group initialized by GPIO_groupInit()
+ */
+extern Void GPIO_groupToggle(GPIO_Group const *group);
+
+/*!
+ *  @brief      Writes all pins of a GPIO pin group
+ *
+ *  Bit 0 of value is written to the lowest pin of the group, bit 1 to the
+ *  port bit above it and so on. Bits that do not fall on a pin of the group
+ *  are ignored. Pins of the port outside the group are not affected.
+ *
+ *  @param      group   GPIO_Group initialized by GPIO_groupInit()
+ *  @param      value   Pin values, aligned to the lowest pin of the group
+ */
+extern Void GPIO_groupWrite(GPIO_Group const *group, Bits32 value);
+
 /*!
  *  @brief  Initializes the GPIO module
  *
@@ -298,12 +654,42 @@ extern Void GPIO_init(Void);
  *  This function is not thread-safe. Multiple threads should not call this
  *  at the same time.
  *
- *  This function is not supported on all platforms.
- *
  *  @param      callbacks   GPIO_Callbacks structure for the port being set up
  */
 extern Void GPIO_setupCallbacks(GPIO_Callbacks const *callbacks);
 
+/*!
+ *  @brief      Initializes GPIO edge capture for a port
+ *
+ *  Constructs the capture Hwi, and the semaphore if one is given, for a
+ *  GPIO port. The driver clears the interrupt flags of the captured pins.
+ *  Interrupts for the pins are enabled afterwards with GPIO_enableInt(),
+ *  normally with GPIO_INT_BOTH_EDGES. Level-triggered interrupts must not be
+ *  used with capture, as the Hwi keeps running while the level persists.
+ *
+ *  This function is not thread-safe. Multiple threads should not call this
+ *  at the same time.
+ *
+ *  @param      capture     GPIO_Capture structure for the port
+ */
+extern Void GPIO_setupCapture(GPIO_Capture const *capture);
+
+/*!
+ *  @brief      Initializes GPIO interrupts with per-pin arguments
+ *
+ *  Uses the GPIO_PortCallbacks structure to create the hardware interrupt,
+ *  and the Swi if one is given, for a GPIO port. The driver clears the
+ *  interrupt flags of the pending pins, so GPIO_clearInt() does not need to
+ *  be called from the callbacks. This function must be called before
+ *  GPIO_enableInt().
+ *
+ *  This function is not thread-safe. Multiple threads should not call this
+ *  at the same time.
+ *
+ *  @param      callbacks   GPIO_PortCallbacks structure for the port
+ */
+extern Void GPIO_setupPortCallbacks(GPIO_PortCallbacks const *callbacks);
+
 /*!
  *  @brief      Reads the value of a GPIO pin
  *
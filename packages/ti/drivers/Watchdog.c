@@ -38,6 +38,7 @@
 #include <ti/drivers/Watchdog.h>
 
 #include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
 
 /* Externs */
 extern const Watchdog_Config Watchdog_config[];
@@ -45,6 +46,20 @@ extern const Watchdog_Config Watchdog_config[];
 /* Also used to check status for initialization */
 static Int Watchdog_count = -1;
 
+/*
+ * Task supervisor state. The supervisor Clock function feeds the Watchdog
+ * only while every registered client keeps checking in.
+ */
+static struct {
+    Watchdog_Handle     handle;     /* Watchdog fed by the supervisor */
+    Watchdog_MissFxn    missFxn;    /* Called once when a client misses */
+    Watchdog_Client    *clients;    /* List of registered clients */
+    Watchdog_Client    *missed;     /* First client that missed, or NULL */
+    Clock_Struct        clock;      /* Runs Watchdog_superviseFxn */
+} supervisor;
+
+static Void Watchdog_superviseFxn(UArg arg);
+
 /* Default Watchdog parameters structure */
 const Watchdog_Params Watchdog_defaultParams = {
     NULL,                   /* callbackFxn */
@@ -115,6 +130,30 @@ Void Watchdog_Params_init(Watchdog_Params *params)
 }
 
 
+/*
+ *  ======== Watchdog_register ========
+ */
+Void Watchdog_register(Watchdog_Client *client, String name, UInt deadline)
+{
+    UInt key;
+
+    Assert_isTrue(client != NULL && deadline > 0, NULL);
+
+    client->checkIns = 0;
+    client->deadline = deadline;
+    client->name = name;
+    client->lastCheckIns = 0;
+    client->lastSeen = Clock_getTicks();
+
+    key = Hwi_disable();
+    client->next = supervisor.clients;
+    supervisor.clients = client;
+    Hwi_restore(key);
+
+    Log_print2(Diags_USER1, "Watchdog: client %s registered, deadline %d",
+               (UArg)name, deadline);
+}
+
 /*
  *  ======== Watchdog_setReload ========
  */
@@ -124,3 +163,95 @@ Void Watchdog_setReload(Watchdog_Handle handle, ULong value)
 
     handle->fxnTablePtr->watchdogSetReload(handle, value);
 }
+
+/*
+ *  ======== Watchdog_superviseFxn ========
+ *  Clock function of the supervisor. Feeds the Watchdog if every client has
+ *  checked in within its deadline.
+ */
+static Void Watchdog_superviseFxn(UArg arg)
+{
+    UInt checkIns;
+    UInt32 now;
+    Watchdog_Client *client;
+
+    /* Once a client has missed, the Watchdog is left to expire */
+    if (supervisor.missed != NULL) {
+        return;
+    }
+
+    now = Clock_getTicks();
+
+    /* Clients are only added at the head, so the list can be walked */
+    for (client = supervisor.clients; client != NULL; client = client->next) {
+        checkIns = client->checkIns;
+        if (checkIns != client->lastCheckIns) {
+            client->lastCheckIns = checkIns;
+            client->lastSeen = now;
+        }
+        else if (now - client->lastSeen > client->deadline) {
+            supervisor.missed = client;
+
+            Log_error2("Watchdog: client %s missed its deadline by %d ticks",
+                       (IArg)client->name,
+                       now - client->lastSeen - client->deadline);
+
+            if (supervisor.missFxn != NULL) {
+                supervisor.missFxn(client);
+            }
+            return;
+        }
+    }
+
+    Watchdog_clear(supervisor.handle);
+}
+
+/*
+ *  ======== Watchdog_superviseStart ========
+ */
+Void Watchdog_superviseStart(Watchdog_Handle handle, UInt period,
+                             Watchdog_MissFxn missFxn)
+{
+    Clock_Params clockParams;
+
+    Assert_isTrue(Watchdog_count >= 0 && handle != NULL, NULL);
+    Assert_isTrue(supervisor.handle == NULL && period > 0, NULL);
+
+    supervisor.handle = handle;
+    supervisor.missFxn = missFxn;
+    supervisor.missed = NULL;
+
+    Clock_Params_init(&clockParams);
+    clockParams.period = period;
+    clockParams.startFlag = TRUE;
+    Clock_construct(&(supervisor.clock), Watchdog_superviseFxn, period,
+                    &clockParams);
+
+    Log_print2(Diags_USER1, "Watchdog: handle %x supervised every %d ticks",
+               (UArg)handle, period);
+}
+
+/*
+ *  ======== Watchdog_unregister ========
+ */
+Void Watchdog_unregister(Watchdog_Client *client)
+{
+    UInt key;
+    Watchdog_Client **link;
+
+    Assert_isTrue(client != NULL, NULL);
+
+    /* The Clock function runs as a Swi, so locking Hwis covers it */
+    key = Hwi_disable();
+    for (link = &(supervisor.clients); *link != NULL;
+         link = &((*link)->next)) {
+        if (*link == client) {
+            *link = client->next;
+            break;
+        }
+    }
+    Hwi_restore(key);
+
+    Log_print1(Diags_USER1, "Watchdog: client %s unregistered",
+               (UArg)client->name);
+}
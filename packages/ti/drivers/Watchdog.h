@@ -72,6 +72,42 @@
  *  // handle may now be used to interact with the Watchdog just created
  *  @endcode
  *
+ *  ## Supervising several tasks #
+ *
+ *  A single task calling Watchdog_clear() says nothing about the others. With
+ *  Watchdog_superviseStart() the driver feeds the Watchdog from a Clock
+ *  function instead, and only does so while every registered client has
+ *  checked in within its deadline. Each task registers a Watchdog_Client
+ *  and calls Watchdog_checkIn(), which only increments a counter, from its
+ *  main loop.
+ *
+ *  When a client misses its deadline, the supervisor logs the client's name
+ *  and calls the miss function once. This happens from the Clock (Swi)
+ *  context, before the Watchdog expires. After that the Watchdog is no
+ *  longer fed, and it resets the device or calls the callbackFxn given to
+ *  Watchdog_open(), depending on the target and reset mode. Deadlines are
+ *  checked at the supervisor period, so the Watchdog timeout has to be
+ *  longer than the largest deadline plus one period.
+ *
+ *  @code
+ *  Watchdog_Client controlClient;
+ *
+ *  Void missFxn(Watchdog_Client *client)
+ *  {
+ *      // Save client->name for post-mortem analysis
+ *  }
+ *
+ *  handle = Watchdog_open(Board_WATCHDOG0, &params);
+ *  Watchdog_superviseStart(handle, 10, missFxn);
+ *
+ *  // In the control task
+ *  Watchdog_register(&controlClient, "control", 5);
+ *  while (1) {
+ *      ...
+ *      Watchdog_checkIn(&controlClient);
+ *  }
+ *  @endcode
+ *
  *  # Implementation #
  *
  *  This module serves as the main interface for TI-RTOS
@@ -168,6 +204,30 @@ typedef struct Watchdog_Params {
                                              Not supported on all targets. */
 } Watchdog_Params;
 
+/*!
+ *  @brief      Watchdog supervisor client
+ *
+ *  One per supervised task. The application provides the memory and fills it
+ *  in with Watchdog_register(). Apart from checking in with
+ *  Watchdog_checkIn(), the fields are not to be accessed by the user.
+ */
+typedef struct Watchdog_Client {
+    volatile UInt           checkIns;       /* Incremented by the client */
+    UInt                    deadline;       /* Clock ticks between check-ins */
+    String                  name;           /* Logged if the deadline is missed */
+    UInt                    lastCheckIns;   /* checkIns at the last look */
+    UInt32                  lastSeen;       /* Clock tick of last check-in */
+    struct Watchdog_Client *next;           /* Next registered client */
+} Watchdog_Client;
+
+/*!
+ *  @brief      Watchdog supervisor miss callback
+ *
+ *  Called once, from the supervisor's Clock function, with the first client
+ *  found to have missed its deadline.
+ */
+typedef Void (*Watchdog_MissFxn)(Watchdog_Client *client);
+
 /*!
  *  @brief      A function pointer to a driver specific implementation of
  *              Watchdog_clear().
@@ -221,6 +281,16 @@ typedef struct Watchdog_Config {
     Void              const *hwAttrs;     /*!< Pointer to hardware attribute */
 } Watchdog_Config;
 
+/*!
+ *  @brief      Checks a supervised task in
+ *
+ *  Tells the supervisor that the client's task is alive. This is a single
+ *  increment and may be called as often as needed.
+ *
+ *  @param      client      Watchdog_Client registered by the task
+ */
+#define Watchdog_checkIn(client)    ((client)->checkIns++)
+
 /*!
  *  @brief      Clears the Watchdog
  *
@@ -278,6 +348,20 @@ extern Watchdog_Handle Watchdog_open(UInt index, Watchdog_Params *params);
  */
 extern Void Watchdog_Params_init(Watchdog_Params *params);
 
+/*!
+ *  @brief      Registers a task with the Watchdog supervisor
+ *
+ *  The client must call Watchdog_checkIn() at least once every deadline
+ *  Clock ticks from now on. client must be persistent until it is passed to
+ *  Watchdog_unregister().
+ *
+ *  @param      client      Watchdog_Client to register
+ *  @param      name        Name logged if the deadline is missed
+ *  @param      deadline    Maximum Clock ticks between check-ins
+ */
+extern Void Watchdog_register(Watchdog_Client *client, String name,
+                              UInt deadline);
+
 /*!
  *  @brief      Sets the Watchdog reload value
  *
@@ -294,6 +378,28 @@ extern Void Watchdog_Params_init(Watchdog_Params *params);
  */
 extern Void Watchdog_setReload(Watchdog_Handle handle, ULong value);
 
+/*!
+ *  @brief      Starts feeding a Watchdog from the task supervisor
+ *
+ *  Constructs a Clock function that runs every period Clock ticks. Each run
+ *  calls Watchdog_clear() on handle if all registered clients checked in
+ *  within their deadlines. The application must not call Watchdog_clear()
+ *  itself after this. Only one Watchdog can be supervised.
+ *
+ *  @param      handle      Watchdog Handle returned by Watchdog_open()
+ *  @param      period      Supervisor period in Clock ticks
+ *  @param      missFxn     Called when a client misses its deadline, or NULL
+ */
+extern Void Watchdog_superviseStart(Watchdog_Handle handle, UInt period,
+                                    Watchdog_MissFxn missFxn);
+
+/*!
+ *  @brief      Removes a task from the Watchdog supervisor
+ *
+ *  @param      client      Watchdog_Client passed to Watchdog_register()
+ */
+extern Void Watchdog_unregister(Watchdog_Client *client);
+
 #ifdef __cplusplus
 }
 #endif
@@ -47,6 +47,11 @@ function module$static$init(mod, params)
                        WiFi, "txPayloadSize");
     }
 
+    if ((params.txBufferCount < 1) || (params.txBufferCount > 2)) {
+        WiFi.$logError("The Wifi.txBufferCount must be 1 or 2",
+                       WiFi, "txBufferCount");
+    }
+
     if (params.rxPayloadSize > 1460) {
         WiFi.$logError("The Wifi.rxPayloadSize cannot be larger than 1460",
                        WiFi, "rxPayloadSize");
@@ -32,15 +32,10 @@
 
 /*
  *  ======== EMACSnow.c ========
- *  This driver is currently supports only 1 EMACSnow port. In the future
- *  when multiple ports are required, this driver needs to move all the
- *  EMACSnow_Data fields into the EMACSnow_Object structure. The APIs need to get
- *  to the fields via the pvt_data field in the NETIF_DEVICE that
- *  is passed in. ROV must be changed to support the change also.
- *  The NETIF_DEVICE structure should go into the EMACSnow_Object also.
- *
- *  This changes are not being done at this time because of the impact on
- *  the complexity of the code.
+ *  All driver state lives in the EMACSnow_Object of each EMAC_config entry.
+ *  The NDK entry points get to it via the pvt_data field in the
+ *  NETIF_DEVICE, which points at the EMAC_config entry. The Hwi and Swi
+ *  get the same pointer as their argument.
  */
 #include <xdc/std.h>
 #include <xdc/runtime/Assert.h>
@@ -70,59 +65,71 @@
 #include "driverlib/debug.h"
 #include "driverlib/emac.h"
 #include <driverlib/sysctl.h>
-/* Name of the device. */
-#define ETHERNET_NAME "eth0"
+/* Name of the device. The instance number replaces the last character. */
+#define ETHERNET_NAME "eth"
+
+/* One slot is always left empty to tell a full pool from an empty one */
+#define RX_POOL_SLOTS (EMACSnow_NUM_RX_POOL_PKTS + 1)
 
-#ifndef NUM_RX_DESCRIPTORS
-#define NUM_RX_DESCRIPTORS 4
+/*
+ *  Maximum number of received frames handled in one run of the Swi. If the
+ *  budget is used up the Swi re-posts itself with the receive interrupt left
+ *  masked, so a burst is polled instead of taking an interrupt per frame.
+ *  One walk of the ring stops one descriptor short of where it started, so
+ *  the budget must be below the number of receive descriptors to be reached.
+ */
+#ifndef RX_POLL_BUDGET
+#define RX_POLL_BUDGET (EMACSnow_NUM_RX_DESCRIPTORS - 1)
 #endif
 
-#ifndef NUM_TX_DESCRIPTORS
-#define NUM_TX_DESCRIPTORS 4
+#if (RX_POLL_BUDGET < 1) || (RX_POLL_BUDGET >= EMACSnow_NUM_RX_DESCRIPTORS)
+#error "RX_POLL_BUDGET must be between 1 and EMACSnow_NUM_RX_DESCRIPTORS - 1"
 #endif
 
-#ifndef EMAC_PHY_CONFIG
-#define EMAC_PHY_CONFIG         (EMAC_PHY_TYPE_INTERNAL |                     \
-                                 EMAC_PHY_INT_MDIX_EN |                       \
-                                 EMAC_PHY_AN_100B_T_FULL_DUPLEX)
+/*
+ *  Receive interrupt moderation. Once a Swi run sees at least
+ *  RX_COALESCE_THRESHOLD frames, descriptors are primed with their
+ *  completion interrupt disabled, except for every RX_COALESCE_FRAMES'th
+ *  one. The receive watchdog (RIWT, in units of 256 system clocks) raises
+ *  the interrupt for the remaining frames. Moderation is turned off again
+ *  when a run sees a single frame, to keep latency low at light load.
+ */
+#ifndef RX_COALESCE_THRESHOLD
+#define RX_COALESCE_THRESHOLD 2
 #endif
 
-unsigned long g_ulStatus; // TODO fix
+#ifndef RX_COALESCE_FRAMES
+#define RX_COALESCE_FRAMES (EMACSnow_NUM_RX_DESCRIPTORS / 2)
+#endif
 
-static Void EMACSnow_handleRx();
-static Void EMACSnow_processTransmitted();
+#ifndef RX_COALESCE_WATCHDOG
+#define RX_COALESCE_WATCHDOG 48
+#endif
 
-/*
- *  Helper struct holding a DMA descriptor and the pbuf it currently refers
- *  to.
- */
-typedef struct {
-  tEMACDMADescriptor Desc;
-  PBM_Handle hPkt;
-} tDescriptor;
+#define EMACSNOW_INTERRUPTS     (EMAC_INT_RECEIVE | EMAC_INT_TRANSMIT |       \
+                                 EMAC_INT_TX_STOPPED | EMAC_INT_RX_NO_BUFFER | \
+                                 EMAC_INT_RX_STOPPED | EMAC_INT_PHY)
 
-typedef struct {
-    tDescriptor *pDescriptors;
-    unsigned long ulNumDescs;
-    unsigned long ulWrite;
-    unsigned long ulRead;
-} tDescriptorList;
+#define EMACSNOW_RX_INTERRUPTS  (EMAC_INT_RECEIVE | EMAC_INT_RX_NO_BUFFER |   \
+                                 EMAC_INT_RX_STOPPED)
+
+#ifndef EMAC_PHY_CONFIG
+#define EMAC_PHY_CONFIG         (EMAC_PHY_TYPE_INTERNAL |                     \
+                                 EMAC_PHY_INT_MDIX_EN |                       \
+                                 EMAC_PHY_AN_100B_T_FULL_DUPLEX)
+#endif
 
 /*
- * Global variable for this interface's private data.  Needed to allow
- * the interrupt handlers access to this information outside of the
- * context of the lwIP netif.
+ *  Marks a Tx descriptor that carries a non-final segment of a frame. The
+ *  buffer and completion belong to the frame's last descriptor.
  */
-static tDescriptor g_pTxDescriptors[NUM_TX_DESCRIPTORS];
-static tDescriptor g_pRxDescriptors[NUM_RX_DESCRIPTORS];
+#define TX_INTERMEDIATE_SEG ((PBM_Handle)1)
 
-static tDescriptorList g_TxDescList = {
-    g_pTxDescriptors, NUM_TX_DESCRIPTORS, 0, 0
-};
+#define PHY_PHYS_ADDR 1
 
-static tDescriptorList g_RxDescList = {
-    g_pRxDescriptors, NUM_RX_DESCRIPTORS, 0, 0
-};
+static UInt EMACSnow_handleRx(EMAC_Handle handle, UInt budget);
+static Void EMACSnow_updateFilters(EMAC_Handle handle);
+static Void EMACSnow_processTransmitted(EMAC_Handle handle);
 
 /* EMAC function table for snowflake implementation */
 const EMAC_FxnTable EMACSnow_fxnTable = {
@@ -131,101 +138,231 @@ const EMAC_FxnTable EMACSnow_fxnTable = {
 };
 
 /* Application is required to provide this variable */
-extern EMAC_Config EMAC_config;
+extern const EMAC_Config EMAC_config[];
 
 /*
- *  The struct is used to store the private data for the EMACSnow controller.
- *  TODO move some of this into the EMACSnow_Object
+ *  ======== EMACSnow_rxPoolFill ========
+ *  Top up the receive packet pool. This is the only producer of the pool and
+ *  must only be called from the NDK task context (never from the Swi), so
+ *  the heap is never touched while receiving frames.
  */
-typedef struct EMACSnow_Data {
-    STKEVENT_Handle hEvent;
-    PBMQ            PBMQ_tx;
-    PBMQ            PBMQ_rx;
-    UInt            rxCount;
-    UInt            rxDropped;
-    UInt            txSent;
-    UInt            txDropped;
-    UInt            abnormalInts;
-    UInt            isrCount;
-    UInt            linkUp;
-    tDescriptorList *pTxDescList;
-    tDescriptorList *pRxDescList;
-} EMACSnow_Data;
-
-/* Only supporting one EMACSnow device */
-static EMACSnow_Data EMACSnow_private;
-
-/* Internal flag to make sure the driver is initialized properly */
-static volatile Bool _EMACSnow_initialized = FALSE;
+static Void EMACSnow_rxPoolFill(EMACSnow_Object *object)
+{
+    PBM_Handle hPkt;
+    UInt next;
 
-#define PHY_PHYS_ADDR 1
+    next = object->rxPoolPut + 1;
+    if (next == RX_POOL_SLOTS) {
+        next = 0;
+    }
+
+    while (next != object->rxPoolGet) {
+        hPkt = PBM_alloc(ETH_MAX_PAYLOAD);
+        if (hPkt == NULL) {
+            break;
+        }
+
+        /* Fill in the slot before publishing it to the Swi */
+        object->rxPool[object->rxPoolPut] = hPkt;
+        object->rxPoolPut = next;
+
+        next++;
+        if (next == RX_POOL_SLOTS) {
+            next = 0;
+        }
+    }
+}
+
+/*
+ *  ======== EMACSnow_rxPoolGet ========
+ *  Take a packet from the receive packet pool. This is the only consumer of
+ *  the pool and is called from the Swi. Returns NULL if the pool is empty.
+ */
+static PBM_Handle EMACSnow_rxPoolGet(EMACSnow_Object *object)
+{
+    PBM_Handle hPkt;
+    UInt get = object->rxPoolGet;
+
+    if (get == object->rxPoolPut) {
+        return (NULL);
+    }
+
+    hPkt = object->rxPool[get];
+
+    get++;
+    if (get == RX_POOL_SLOTS) {
+        get = 0;
+    }
+    object->rxPoolGet = get;
+
+    return (hPkt);
+}
+
+/*
+ *  ======== EMACSnow_primeTx ========
+ *  Queue one frame made of numSegs buffers on the Tx descriptor ring, one
+ *  descriptor per segment. The frame's last descriptor owns hPkt and the
+ *  completion callback. Returns FALSE if the ring does not have room for
+ *  the whole frame.
+ */
+static Bool EMACSnow_primeTx(EMAC_Handle handle, EMACSnow_TxSegment *segs,
+                             UInt numSegs, PBM_Handle hPkt,
+                             EMACSnow_TxDoneFxn doneFxn, UArg arg)
+{
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
+    EMACSnow_DescriptorList *pDescList = &(object->txDescList);
+    EMACSnow_Descriptor *pDesc;
+    EMACSnow_Descriptor *pFirst;
+    unsigned long ulWrite;
+    UInt i;
+    UInt key;
+
+    if ((numSegs == 0) || (numSegs > pDescList->ulNumDescs)) {
+        return (FALSE);
+    }
+
+    /* Both the NDK and the application may be sending */
+    key = Hwi_disable();
+
+    /* Make sure all descriptors the frame needs are free */
+    ulWrite = pDescList->ulWrite;
+    for (i = 0; i < numSegs; i++) {
+        pDesc = &(pDescList->pDescriptors[ulWrite]);
+        if (pDesc->hPkt || pDesc->txDoneFxn) {
+            Hwi_restore(key);
+            return (FALSE);
+        }
+        ulWrite++;
+        if (ulWrite == pDescList->ulNumDescs) {
+            ulWrite = 0;
+        }
+    }
+
+    pFirst = &(pDescList->pDescriptors[pDescList->ulWrite]);
+    for (i = 0; i < numSegs; i++) {
+        pDesc = &(pDescList->pDescriptors[pDescList->ulWrite]);
+
+        /* Fill in the buffer pointer and length */
+        pDesc->Desc.ui32Count = segs[i].len;
+        pDesc->Desc.pvBuffer1 = segs[i].buffer;
+        pDesc->Desc.ui32CtrlStatus = (/*DES0_TX_CTRL_IP_ALL_CKHSUMS |*/ DES0_TX_CTRL_CHAINED);
+
+        if (i == 0) {
+            pDesc->Desc.ui32CtrlStatus |= DES0_TX_CTRL_FIRST_SEG;
+        }
+
+        if (i == (numSegs - 1)) {
+            pDesc->Desc.ui32CtrlStatus |= (DES0_TX_CTRL_LAST_SEG |
+                                           DES0_TX_CTRL_INTERRUPT);
+            pDesc->hPkt = hPkt;
+            pDesc->txDoneFxn = doneFxn;
+            pDesc->txDoneArg = arg;
+        }
+        else {
+            pDesc->hPkt = TX_INTERMEDIATE_SEG;
+        }
+
+        /*
+         *  Hand the later segments to the hardware first. The first one is
+         *  released last so the DMA never starts on a partial frame.
+         */
+        if (pDesc != pFirst) {
+            pDesc->Desc.ui32CtrlStatus |= DES0_TX_CTRL_OWN;
+        }
+
+        pDescList->ulWrite++;
+        if (pDescList->ulWrite == pDescList->ulNumDescs) {
+            pDescList->ulWrite = 0;
+        }
+    }
+    pFirst->Desc.ui32CtrlStatus |= DES0_TX_CTRL_OWN;
+
+    Hwi_restore(key);
+
+    object->txSent++;
+
+    EMACTxDMAPollDemand(hwAttrs->baseAddr);
+
+    return (TRUE);
+}
 
 /*
  *  ======== EMACSnow_processPendingTx ========
  *  TODO handle buffers being in shared memory...
  */
-static Void EMACSnow_processPendingTx()
+static Void EMACSnow_processPendingTx(EMAC_Handle handle)
 {
-    UINT8  *pBuffer;
-    UInt    len;
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_TxSegment seg;
     PBM_Handle hPkt;
-    tDescriptor *pDesc;
 
     /*
      *  If there are pending packets, send one.
      *  Otherwise quit the loop.
      */
-    hPkt = PBMQ_deq(&EMACSnow_private.PBMQ_tx);
+    hPkt = PBMQ_deq(&object->PBMQ_tx);
     if (hPkt != NULL) {
 
-        pDesc = &(EMACSnow_private.pTxDescList->pDescriptors[EMACSnow_private.pTxDescList->ulWrite]);
-        if (pDesc->hPkt) {
-            PBM_free(hPkt);
-            EMACSnow_private.txDropped++;
-            return;
-        }
-
         /* Get the pointer to the buffer and the length */
-        pBuffer = PBM_getDataBuffer(hPkt) + PBM_getDataOffset(hPkt);
-        len = PBM_getValidLen(hPkt);
+        seg.buffer = PBM_getDataBuffer(hPkt) + PBM_getDataOffset(hPkt);
+        seg.len = PBM_getValidLen(hPkt);
 
-        /* Fill in the buffer pointer and length */
-        pDesc->Desc.ui32Count = len;
-        pDesc->Desc.pvBuffer1 = pBuffer;
-        pDesc->Desc.ui32CtrlStatus = DES0_TX_CTRL_FIRST_SEG;
-
-        pDesc->Desc.ui32CtrlStatus |= (/*DES0_TX_CTRL_IP_ALL_CKHSUMS |*/ DES0_TX_CTRL_CHAINED);
-        pDesc->Desc.ui32CtrlStatus |= (DES0_TX_CTRL_LAST_SEG |
-                                       DES0_TX_CTRL_INTERRUPT);
-        EMACSnow_private.pTxDescList->ulWrite++;
-        if (EMACSnow_private.pTxDescList->ulWrite == NUM_TX_DESCRIPTORS) {
-            EMACSnow_private.pTxDescList->ulWrite = 0;
+        if (!EMACSnow_primeTx(handle, &seg, 1, hPkt, NULL, 0)) {
+            PBM_free(hPkt);
+            object->txDropped++;
         }
-        pDesc->hPkt = hPkt;
-        pDesc->Desc.ui32CtrlStatus |= DES0_TX_CTRL_OWN;
-
-        EMACSnow_private.txSent++;
-
-        EMACTxDMAPollDemand(EMAC0_BASE);
     }
 
     return;
 }
 
+/*
+ *  ======== EMACSnow_setRxCoalescing ========
+ *  Switch receive interrupt moderation on or off. Descriptors primed from
+ *  now on pick up the new mode. The receive watchdog is left running in
+ *  both modes so frames landing in descriptors primed before a switch
+ *  still raise an interrupt.
+ */
+static Void EMACSnow_setRxCoalescing(EMACSnow_Object *object, UInt enable)
+{
+    if (enable == object->rxCoalescing) {
+        return;
+    }
+
+    object->rxCoalescing = enable;
+    object->rxCoalesceCount = 0;
+
+    Log_print1(Diags_USER1, "EMACSnow_setRxCoalescing: coalescing = %d",
+               enable);
+}
 
 /*
  *  ======== EMACSnow_handlePackets ========
  */
 static Void EMACSnow_handlePackets(UArg arg0, UArg arg1)
 {
-    Log_print1(Diags_USER1, "EMACSnow_handlePackets handling packets status = 0x%x", g_ulStatus);
+    EMAC_Handle handle = (EMAC_Handle)arg0;
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
+    UInt key;
+    ULong status;
+    UInt rxFrames;
+
+    /* Collect the events posted by the Hwi since the last run */
+    key = Hwi_disable();
+    status = object->intStatus;
+    object->intStatus = 0;
+    Hwi_restore(key);
+
+    Log_print1(Diags_USER1, "EMACSnow_handlePackets handling packets status = 0x%x", status);
 
     /* Process the transmit DMA list, freeing any buffers that have been
      * transmitted since our last interrupt.
      */
-    if (g_ulStatus & EMAC_INT_TRANSMIT) {
+    if (status & EMAC_INT_TRANSMIT) {
         Log_print0(Diags_USER1, "EMACSnow_handlePackets Tx ones...");
-        EMACSnow_processTransmitted();
+        EMACSnow_processTransmitted(handle);
     }
 
     /*
@@ -234,24 +371,48 @@ static Void EMACSnow_handlePackets(UArg arg0, UArg arg1)
      * stalled due to missing buffers since the receive function will attempt to
      * allocate new pbufs for descriptor entries which have none.
      */
-    if (g_ulStatus & (EMAC_INT_RECEIVE | EMAC_INT_RX_NO_BUFFER |
-        EMAC_INT_RX_STOPPED)) {
+    if (status & EMACSNOW_RX_INTERRUPTS) {
         Log_print0(Diags_USER1, "EMACSnow_handlePackets Rx ones...");
-        EMACSnow_handleRx();
+        rxFrames = EMACSnow_handleRx(handle, RX_POLL_BUDGET);
+
+        /* Adapt the interrupt moderation to the current receive rate */
+        if (rxFrames >= RX_COALESCE_THRESHOLD) {
+            EMACSnow_setRxCoalescing(object, TRUE);
+        }
+        else if (rxFrames <= 1) {
+            EMACSnow_setRxCoalescing(object, FALSE);
+        }
+
+        if (rxFrames == RX_POLL_BUDGET) {
+            /*
+             *  There may be more frames waiting. Keep polling from the Swi
+             *  with the receive interrupts masked and let everything else
+             *  through.
+             */
+            object->rxPolls++;
+
+            key = Hwi_disable();
+            object->intStatus |= EMAC_INT_RECEIVE;
+            Hwi_restore(key);
+
+            EMACIntEnable(hwAttrs->baseAddr,
+                          EMACSNOW_INTERRUPTS & ~EMACSNOW_RX_INTERRUPTS);
+            Swi_post(object->swi);
+            return;
+        }
     }
 
     Log_print0(Diags_USER1, "EMACSnow_handlePackets re-enable peripheral...");
-    EMACIntEnable(EMAC0_BASE, (EMAC_INT_RECEIVE | EMAC_INT_TRANSMIT |
-                        EMAC_INT_TX_STOPPED | EMAC_INT_RX_NO_BUFFER |
-                        EMAC_INT_RX_STOPPED | EMAC_INT_PHY));
+    EMACIntEnable(hwAttrs->baseAddr, EMACSNOW_INTERRUPTS);
 }
 
 /*
  *  ======== EMACSnow_processTransmitted ========
  */
-static Void EMACSnow_processTransmitted()
+static Void EMACSnow_processTransmitted(EMAC_Handle handle)
 {
-    tDescriptor *pDesc;
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_Descriptor *pDesc;
     unsigned long ulNumDescs;
 
     /*
@@ -259,21 +420,28 @@ static Void EMACSnow_processTransmitted()
      * write pointer or find a descriptor that the hardware is still working
      * on.
      */
-    for (ulNumDescs = 0; ulNumDescs < NUM_TX_DESCRIPTORS; ulNumDescs++) {
-        pDesc = &(EMACSnow_private.pTxDescList->pDescriptors[EMACSnow_private.pTxDescList->ulRead]);
+    for (ulNumDescs = 0; ulNumDescs < EMACSnow_NUM_TX_DESCRIPTORS; ulNumDescs++) {
+        pDesc = &(object->txDescList.pDescriptors[object->txDescList.ulRead]);
         /* Has the buffer attached to this descriptor been transmitted? */
         if (pDesc->Desc.ui32CtrlStatus & DES0_TX_CTRL_OWN) {
             /* No - we're finished. */
             break;
         }
 
-        /* Does this descriptor have a buffer attached to it? */
-        if (pDesc->hPkt) {
-            /* Yes - free it if it's not marked as an intermediate pbuf */
-            if (!((uint32_t)(pDesc->hPkt) & 1)) {
+        /* Does this descriptor have a frame attached to it? */
+        if (pDesc->hPkt || pDesc->txDoneFxn) {
+            /*
+             *  Yes - free the packet and complete the frame unless this is
+             *  an intermediate segment.
+             */
+            if (pDesc->hPkt && !((uint32_t)(pDesc->hPkt) & 1)) {
                 PBM_free(pDesc->hPkt);
             }
+            if (pDesc->txDoneFxn) {
+                pDesc->txDoneFxn(pDesc->txDoneArg);
+            }
             pDesc->hPkt = NULL;
+            pDesc->txDoneFxn = NULL;
         }
         else {
             /* If the descriptor has no buffer, we are finished. */
@@ -281,22 +449,36 @@ static Void EMACSnow_processTransmitted()
         }
 
         /* Move on to the next descriptor. */
-        EMACSnow_private.pTxDescList->ulRead++;
-        if (EMACSnow_private.pTxDescList->ulRead == NUM_TX_DESCRIPTORS) {
-            EMACSnow_private.pTxDescList->ulRead = 0;
+        object->txDescList.ulRead++;
+        if (object->txDescList.ulRead == EMACSnow_NUM_TX_DESCRIPTORS) {
+            object->txDescList.ulRead = 0;
         }
     }
 }
 
 /*
  *  ======== EMACSnow_primeRx ========
- *  TODO make an EMACSnow_primeTx
  */
-static Void EMACSnow_primeRx(PBM_Handle hPkt, tDescriptor *desc)
+static Void EMACSnow_primeRx(EMACSnow_Object *object, PBM_Handle hPkt,
+                             EMACSnow_Descriptor *desc)
 {
     desc->hPkt = hPkt;
     desc->Desc.ui32Count = DES1_RX_CTRL_CHAINED;
 
+    /*
+     *  When moderating, only every RX_COALESCE_FRAMES'th descriptor raises
+     *  the receive interrupt directly. The receive watchdog covers the rest.
+     */
+    if (object->rxCoalescing) {
+        object->rxCoalesceCount++;
+        if (object->rxCoalesceCount >= RX_COALESCE_FRAMES) {
+            object->rxCoalesceCount = 0;
+        }
+        else {
+            desc->Desc.ui32Count |= DES1_RX_CTRL_DISABLE_INT;
+        }
+    }
+
     /* We got a buffer so fill in the payload pointer and size. */
     desc->Desc.pvBuffer1 = PBM_getDataBuffer(hPkt) + PBM_getDataOffset(hPkt);
     desc->Desc.ui32Count |= (ETH_MAX_PAYLOAD << DES1_RX_CTRL_BUFF1_SIZE_S);
@@ -307,23 +489,28 @@ static Void EMACSnow_primeRx(PBM_Handle hPkt, tDescriptor *desc)
 
 /*
  *  ======== EMACSnow_handleRx ========
+ *  Handle at most budget received frames. Returns the number of descriptors
+ *  consumed.
  */
-static Void EMACSnow_handleRx()
+static UInt EMACSnow_handleRx(EMAC_Handle handle, UInt budget)
 {
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
     PBM_Handle  hPkt;
     PBM_Handle  hPktNew;
     Long len;
-    tDescriptorList *pDescList;
+    EMACSnow_DescriptorList *pDescList;
     unsigned long ulDescEnd;
+    UInt frames = 0;
+    UInt enqueued = 0;
 
     /* Get a pointer to the receive descriptor list. */
-    pDescList = EMACSnow_private.pRxDescList;
+    pDescList = &(object->rxDescList);
 
     /* Determine where we start and end our walk of the descriptor list */
     ulDescEnd = pDescList->ulRead ? (pDescList->ulRead - 1) : (pDescList->ulNumDescs - 1);
 
     /* Step through the descriptors that are marked for CPU attention. */
-    while (pDescList->ulRead != ulDescEnd) {
+    while ((pDescList->ulRead != ulDescEnd) && (frames < budget)) {
 
         /* Does the current descriptor have a buffer attached to it? */
         hPkt = pDescList->pDescriptors[pDescList->ulRead].hPkt;
@@ -336,59 +523,60 @@ static Void EMACSnow_handleRx()
               break;
             }
 
+            frames++;
+
             /* Yes - does the frame contain errors? */
             if (pDescList->pDescriptors[pDescList->ulRead].Desc.ui32CtrlStatus &
                DES0_RX_STAT_ERR) {
                 /*
                  *  This is a bad frame so discard it and update the relevant
-                 *  statistics.
+                 *  statistics. The buffer goes straight back to the ring.
                  */
                 Log_error0("EMACSnow_handleRx: DES0_RX_STAT_ERR");
-                EMACSnow_private.rxDropped++;
-                EMACSnow_primeRx(hPkt, &(pDescList->pDescriptors[pDescList->ulRead]));
-                pDescList->ulRead++;
-                break;
+                object->rxDropped++;
+                EMACSnow_primeRx(object, hPkt, &(pDescList->pDescriptors[pDescList->ulRead]));
             }
             else {
-                /* Allocate a new buffer for this descriptor */
-                hPktNew = PBM_alloc(ETH_MAX_PAYLOAD);
+                /* Take a replacement buffer for this descriptor from the pool */
+                hPktNew = EMACSnow_rxPoolGet(object);
                 if (hPktNew == NULL) {
                     /*
-                     *  Leave the packet in the descriptor and owned by the driver.
-                     *  Process when the next interrupt occurs.
+                     *  The pool has not been refilled by the stack yet. Drop
+                     *  the frame and recycle its buffer so the ring never
+                     *  stalls waiting for memory.
                      */
-                    break;
+                    Log_print0(Diags_USER1,
+                               "EMACSnow_handleRx: receive pool empty");
+                    object->rxDropped++;
+                    EMACSnow_primeRx(object, hPkt,
+                                     &(pDescList->pDescriptors[pDescList->ulRead]));
                 }
+                else {
+                    /* This is a good frame so pass it up the stack. */
+                    len = (pDescList->pDescriptors[pDescList->ulRead].Desc.ui32CtrlStatus &
+                          DES0_RX_STAT_FRAME_LENGTH_M) >> DES0_RX_STAT_FRAME_LENGTH_S;
 
-                /* This is a good frame so pass it up the stack. */
-                len = (pDescList->pDescriptors[pDescList->ulRead].Desc.ui32CtrlStatus &
-                      DES0_RX_STAT_FRAME_LENGTH_M) >> DES0_RX_STAT_FRAME_LENGTH_S;
+                    /* Remove the CRC */
+                    PBM_setValidLen(hPkt, len - 4);
 
-                /* Remove the CRC */
-                PBM_setValidLen(hPkt, len - 4);
-
-                /*
-                 *  Place the packet onto the receive queue to be handled in the
-                 *  EMACSnow_pkt_service function (which is called by the
-                 *  NDK stack).
-                 */
-                PBMQ_enq(&EMACSnow_private.PBMQ_rx, hPkt);
-
-                Log_print2(Diags_USER2, "EMACSnow_handleRx: Enqueued recv packet 0x%x, length = %d",
-                    (IArg)hPkt, len - 4);
+                    /*
+                     *  Place the packet onto the receive queue to be handled in
+                     *  the EMACSnow_pkt_service function (which is called by
+                     *  the NDK stack).
+                     */
+                    PBMQ_enq(&object->PBMQ_rx, hPkt);
 
-                /* Update internal statistic */
-                EMACSnow_private.rxCount++;
+                    Log_print2(Diags_USER2, "EMACSnow_handleRx: Enqueued recv packet 0x%x, length = %d",
+                        (IArg)hPkt, len - 4);
 
-                /*
-                 *  Notify NDK stack of pending Rx Ethernet packet and
-                 *  that it was triggered by an external event.
-                 */
-                STKEVENT_signal(EMACSnow_private.hEvent, STKEVENT_ETHERNET, 1);
+                    /* Update internal statistic */
+                    object->rxCount++;
+                    enqueued++;
 
-                /* Prime the receive descriptor back up for future packets */
-                EMACSnow_primeRx(hPktNew,
-                                 &(pDescList->pDescriptors[pDescList->ulRead]));
+                    /* Prime the receive descriptor back up for future packets */
+                    EMACSnow_primeRx(object, hPktNew,
+                                     &(pDescList->pDescriptors[pDescList->ulRead]));
+                }
             }
         }
 
@@ -398,13 +586,25 @@ static Void EMACSnow_handleRx()
             pDescList->ulRead = 0;
         }
     }
+
+    /*
+     *  Notify NDK stack once for the whole batch of pending Rx Ethernet
+     *  packets and that it was triggered by an external event.
+     */
+    if (enqueued) {
+        STKEVENT_signal(object->hEvent, STKEVENT_ETHERNET, 1);
+    }
+
+    return (frames);
 }
 
 /*
  *  ======== EMACSnow_processPhyInterrupt ========
  */
-Void EMACSnow_processPhyInterrupt()
+static Void EMACSnow_processPhyInterrupt(EMAC_Handle handle)
 {
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
     UInt16 value, status;
     UInt32 config, mode, rxMaxFrameSize;
 
@@ -413,26 +613,26 @@ Void EMACSnow_processPhyInterrupt()
      * Note that we are only enabling sources in EPHY_MISR1 so we don't
      * read EPHY_MISR2.
      */
-    value = EMACPHYRead(EMAC0_BASE, PHY_PHYS_ADDR, EPHY_MISR1);
+    value = EMACPHYRead(hwAttrs->baseAddr, PHY_PHYS_ADDR, EPHY_MISR1);
 
     /* Read the current PHY status. */
-    status = EMACPHYRead(EMAC0_BASE, PHY_PHYS_ADDR, EPHY_STS);
+    status = EMACPHYRead(hwAttrs->baseAddr, PHY_PHYS_ADDR, EPHY_STS);
 
     /* Has the link status changed? */
     if (value & EPHY_MISR1_LINKSTAT) {
         /* Is link up or down now? */
         if (status & EPHY_STS_LINK) {
-            EMACSnow_private.linkUp = TRUE;
+            object->linkUp = TRUE;
         }
         else {
-            EMACSnow_private.linkUp = FALSE;
+            object->linkUp = FALSE;
         }
     }
 
     /* Has the speed or duplex status changed? */
     if (value & (EPHY_MISR1_SPEED | EPHY_MISR1_SPEED | EPHY_MISR1_ANC)) {
         /* Get the current MAC configuration. */
-        EMACConfigGet(EMAC0_BASE, (uint32_t *)&config, (uint32_t *)&mode,
+        EMACConfigGet(hwAttrs->baseAddr, (uint32_t *)&config, (uint32_t *)&mode,
                         (uint32_t *)&rxMaxFrameSize);
 
         /* What speed is the interface running at now?
@@ -457,46 +657,47 @@ Void EMACSnow_processPhyInterrupt()
         }
 
         /* Reconfigure the MAC */
-        EMACConfigSet(EMAC0_BASE, config, mode, rxMaxFrameSize);
+        EMACConfigSet(hwAttrs->baseAddr, config, mode, rxMaxFrameSize);
     }
 }
 
 /*
  *  ======== EMACSnow_hwiIntFxn ========
  */
-Void EMACSnow_hwiIntFxn(UArg callbacks)
+static Void EMACSnow_hwiIntFxn(UArg arg)
 {
-    EMACSnow_Object *object = (EMACSnow_Object *)(EMAC_config.objects);
+    EMAC_Handle handle = (EMAC_Handle)arg;
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
     ULong status;
 
-    EMACSnow_private.linkUp = (EMACPHYRead(EMAC0_BASE, 0, EPHY_BMSR) & EPHY_BMSR_LINKSTAT);
+    object->linkUp = (EMACPHYRead(hwAttrs->baseAddr, 0, EPHY_BMSR) & EPHY_BMSR_LINKSTAT);
 
-    EMACSnow_private.isrCount++;
+    object->isrCount++;
 
     /* Read and Clear the interrupt. */
-    status = EMACIntStatus(EMAC0_BASE, true);
-    EMACIntClear(EMAC0_BASE, status);
+    status = EMACIntStatus(hwAttrs->baseAddr, true);
+    EMACIntClear(hwAttrs->baseAddr, status);
 
     /*
      *  Disable the Ethernet interrupts.  Since the interrupts have not been
      *  handled, they are not asserted.  Once they are handled by the Ethernet
      *  interrupt, it will re-enable the interrupts.
      */
-    EMACIntDisable(EMAC0_BASE, (EMAC_INT_RECEIVE | EMAC_INT_TRANSMIT |
-                     EMAC_INT_TX_STOPPED | EMAC_INT_RX_NO_BUFFER |
-                     EMAC_INT_RX_STOPPED | EMAC_INT_PHY));
+    EMACIntDisable(hwAttrs->baseAddr, EMACSNOW_INTERRUPTS);
 
     if (status & EMAC_INT_ABNORMAL_INT) {
-        EMACSnow_private.abnormalInts++;
+        object->abnormalInts++;
     }
 
-    g_ulStatus = status;
+    /* Accumulate until the Swi runs; it may still be polling a burst */
+    object->intStatus |= status;
 
     if (status & EMAC_INT_PHY) {
-        EMACSnow_processPhyInterrupt();
+        EMACSnow_processPhyInterrupt(handle);
     }
 
-    Log_print1(Diags_USER1, "EMACSnow_hwiIntFxn Posting Swi status = 0x%x", g_ulStatus);
+    Log_print1(Diags_USER1, "EMACSnow_hwiIntFxn Posting Swi status = 0x%x", object->intStatus);
 
     /* Have the Swi handle the incoming packets and re-enable peripheral */
     Swi_post(object->swi);
@@ -507,66 +708,71 @@ Void EMACSnow_hwiIntFxn(UArg callbacks)
  *  The function is used to initialize and start the EMACSnow
  *  controller and device.
  */
-Int  EMACSnow_emacStart(struct NETIF_DEVICE* ptr_net_device)
+static Int EMACSnow_emacStart(struct NETIF_DEVICE* ptr_net_device)
 {
     UInt16 value;
-	EMACSnow_Object *object = (EMACSnow_Object *)(EMAC_config.objects);
-	EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(EMAC_config.hwAttrs);
+    EMAC_Handle handle = (EMAC_Handle)(ptr_net_device->pvt_data);
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
+    Swi_Params swiParams;
+    Hwi_Params hwiParams;
     Error_Block eb;
 
-	/*
-     *  Create the Swi that handles incoming packets.
-     *  Take default parameters.
+    /*
+     *  Create the Swi that handles incoming packets. The instance is
+     *  passed as the argument.
      */
     Error_init(&eb);
+    Swi_Params_init(&swiParams);
+    swiParams.arg0 = (UArg)handle;
     object->swi = Swi_create(EMACSnow_handlePackets,
-                             NULL, &eb);
+                             &swiParams, &eb);
     if (object->swi == NULL) {
         Log_error0("EMACSnow_emacStart: Swi_create failed");
-		return (-1);
+        return (-1);
     }
 
     /* Create the hardware interrupt */
-    object->hwi = Hwi_create(hwAttrs->intNum, EMACSnow_hwiIntFxn, NULL, &eb);
+    Hwi_Params_init(&hwiParams);
+    hwiParams.arg = (UArg)handle;
+    object->hwi = Hwi_create(hwAttrs->intNum, EMACSnow_hwiIntFxn, &hwiParams,
+                             &eb);
     if (object->hwi == NULL) {
         Log_error0("EMACSnow_emacStart: Hwi_create failed");
         return (-1);
     }
 
     /* Clear any stray PHY interrupts that may be set. */
-    value = EMACPHYRead(EMAC0_BASE, PHY_PHYS_ADDR, EPHY_MISR1);
-    value = EMACPHYRead(EMAC0_BASE, PHY_PHYS_ADDR, EPHY_MISR2);
+    value = EMACPHYRead(hwAttrs->baseAddr, PHY_PHYS_ADDR, EPHY_MISR1);
+    value = EMACPHYRead(hwAttrs->baseAddr, PHY_PHYS_ADDR, EPHY_MISR2);
 
     /* Configure and enable the link status change interrupt in the PHY. */
-    value = EMACPHYRead(EMAC0_BASE, PHY_PHYS_ADDR, EPHY_SCR);
+    value = EMACPHYRead(hwAttrs->baseAddr, PHY_PHYS_ADDR, EPHY_SCR);
     value |= (EPHY_SCR_INTEN_EXT | EPHY_SCR_INTOE_EXT);
-    EMACPHYWrite(EMAC0_BASE, PHY_PHYS_ADDR, EPHY_SCR, value);
-    EMACPHYWrite(EMAC0_BASE, PHY_PHYS_ADDR, EPHY_MISR1, (EPHY_MISR1_LINKSTATEN |
+    EMACPHYWrite(hwAttrs->baseAddr, PHY_PHYS_ADDR, EPHY_SCR, value);
+    EMACPHYWrite(hwAttrs->baseAddr, PHY_PHYS_ADDR, EPHY_MISR1, (EPHY_MISR1_LINKSTATEN |
                  EPHY_MISR1_SPEEDEN | EPHY_MISR1_DUPLEXMEN | EPHY_MISR1_ANCEN));
 
-    /*
-     *  Set MAC filtering options.  We receive all broadcast and multicast
-     *  packets along with those addressed specifically for us.
-     */
-    EMACFrameFilterSet(EMAC0_BASE, (EMAC_FRMFILTER_HASH_AND_PERFECT |
-                       EMAC_FRMFILTER_PASS_MULTICAST));
+    /* Set MAC filtering options. */
+    EMACSnow_updateFilters(handle);
+
+    /* Start the receive watchdog used for interrupt moderation */
+    EMACRxWatchdogTimerSet(hwAttrs->baseAddr, RX_COALESCE_WATCHDOG);
 
     /* Clear any pending interrupts. */
-    EMACIntClear(EMAC0_BASE, EMACIntStatus(EMAC0_BASE, false));
+    EMACIntClear(hwAttrs->baseAddr, EMACIntStatus(hwAttrs->baseAddr, false));
 
     /* Enable the Ethernet MAC transmitter and receiver. */
-    EMACTxEnable(EMAC0_BASE);
-    EMACRxEnable(EMAC0_BASE);
+    EMACTxEnable(hwAttrs->baseAddr);
+    EMACRxEnable(hwAttrs->baseAddr);
 
     /* Enable the Ethernet RX and TX interrupt source. */
-    EMACIntEnable(EMAC0_BASE, (EMAC_INT_RECEIVE | EMAC_INT_TRANSMIT |
-                  EMAC_INT_TX_STOPPED | EMAC_INT_RX_NO_BUFFER |
-                  EMAC_INT_RX_STOPPED | EMAC_INT_PHY));
+    EMACIntEnable(hwAttrs->baseAddr, EMACSNOW_INTERRUPTS);
 
     /* Enable the Ethernet Interrupt handler. */
     Hwi_enableInterrupt(hwAttrs->intNum);
 
-    EMACPHYWrite(EMAC0_BASE, PHY_PHYS_ADDR, EPHY_BMCR, (EPHY_BMCR_ANEN |
+    EMACPHYWrite(hwAttrs->baseAddr, PHY_PHYS_ADDR, EPHY_BMCR, (EPHY_BMCR_ANEN |
                  EPHY_BMCR_RESTARTAN));
     Log_print0(Diags_USER2, "EMACSnow_emacStart: start completed");
 
@@ -578,37 +784,39 @@ Int  EMACSnow_emacStart(struct NETIF_DEVICE* ptr_net_device)
  *  The function is used to de-initialize and stop the EMACSnow
  *  controller and device.
  */
-Int  EMACSnow_emacStop(struct NETIF_DEVICE* ptr_net_device)
+static Int EMACSnow_emacStop(struct NETIF_DEVICE* ptr_net_device)
 {
-    EMACSnow_Object *object = (EMACSnow_Object *)(EMAC_config.objects);
-    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(EMAC_config.hwAttrs);
+    EMAC_Handle handle = (EMAC_Handle)(ptr_net_device->pvt_data);
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
     PBM_Handle hPkt;
 
-    EMACIntDisable(EMAC0_BASE, (EMAC_INT_RECEIVE | EMAC_INT_TRANSMIT |
-                     EMAC_INT_TX_STOPPED | EMAC_INT_RX_NO_BUFFER |
-                     EMAC_INT_RX_STOPPED | EMAC_INT_PHY));
+    EMACIntDisable(hwAttrs->baseAddr, EMACSNOW_INTERRUPTS);
     Hwi_disableInterrupt(hwAttrs->intNum);
 
     if (object->hwi != NULL) {
         Hwi_delete(&(object->hwi));
     }
 
-	if (object->swi != NULL) {
+    if (object->swi != NULL) {
         Swi_delete(&(object->swi));
     }
-    while (PBMQ_count(&EMACSnow_private.PBMQ_rx)) {
+    while (PBMQ_count(&object->PBMQ_rx)) {
         /* Dequeue a packet from the driver receive queue. */
-        hPkt = PBMQ_deq(&EMACSnow_private.PBMQ_rx);
+        hPkt = PBMQ_deq(&object->PBMQ_rx);
         PBM_free(hPkt);
     }
 
-    while (PBMQ_count(&EMACSnow_private.PBMQ_tx)) {
+    while (PBMQ_count(&object->PBMQ_tx)) {
         /* Dequeue a packet from the driver receive queue. */
-        hPkt = PBMQ_deq(&EMACSnow_private.PBMQ_tx);
+        hPkt = PBMQ_deq(&object->PBMQ_tx);
         PBM_free(hPkt);
     }
 
-
+    /* Return the spare receive packets */
+    while ((hPkt = EMACSnow_rxPoolGet(object)) != NULL) {
+        PBM_free(hPkt);
+    }
 
     Log_print0(Diags_USER2, "EMACSnow_emacStop: stop completed");
 
@@ -620,11 +828,19 @@ Int  EMACSnow_emacStop(struct NETIF_DEVICE* ptr_net_device)
  *  The function is used to poll the EMACSnow controller to check
  *  if there has been any activity
  */
-Void EMACSnow_emacPoll(struct NETIF_DEVICE* ptr_net_device, uint timer_tick)
+static Void EMACSnow_emacPoll(struct NETIF_DEVICE* ptr_net_device, uint timer_tick)
 {
+    EMAC_Handle handle = (EMAC_Handle)(ptr_net_device->pvt_data);
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
+
     /* Send pending Tx packets */
-    EMACSnow_processPendingTx();
-    EMACSnow_private.linkUp = (EMACPHYRead(EMAC0_BASE, 0, EPHY_BMSR) & EPHY_BMSR_LINKSTAT);
+    EMACSnow_processPendingTx(handle);
+
+    /* Replace any spare receive packets used since the last poll */
+    EMACSnow_rxPoolFill(object);
+
+    object->linkUp = (EMACPHYRead(hwAttrs->baseAddr, 0, EPHY_BMSR) & EPHY_BMSR_LINKSTAT);
 }
 
 /*
@@ -632,34 +848,176 @@ Void EMACSnow_emacPoll(struct NETIF_DEVICE* ptr_net_device, uint timer_tick)
  *  The function is the interface routine invoked by the NDK stack to
  *  pass packets to the driver.
  */
-Int  EMACSnow_emacSend(struct NETIF_DEVICE* ptr_net_device, PBM_Handle hPkt)
+static Int EMACSnow_emacSend(struct NETIF_DEVICE* ptr_net_device, PBM_Handle hPkt)
 {
+    EMAC_Handle handle = (EMAC_Handle)(ptr_net_device->pvt_data);
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+
     /*
      *  Enqueue the packet onto the end of the transmit queue.
      *  This is done to ensure that the packets are sent in order.
      */
-    PBMQ_enq(&EMACSnow_private.PBMQ_tx, hPkt);
+    PBMQ_enq(&object->PBMQ_tx, hPkt);
 
     Log_print2(Diags_USER2, "EMACSnow_emacSend: enqueued hPkt = 0x%x, len = %d", (IArg)hPkt, PBM_getValidLen(hPkt));
 
     /* Transmit pending packets */
-    EMACSnow_processPendingTx();
+    EMACSnow_processPendingTx(handle);
 
     return (0);
 }
 
+/*
+ *  ======== EMACSnow_updateFilters ========
+ *  Program the MAC address filters from the multicast list and the receive
+ *  filter mode. The first multicast addresses use the spare perfect address
+ *  filters; the rest go into the 64-bit hash table.
+ */
+static Void EMACSnow_updateFilters(EMAC_Handle handle)
+{
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
+    UInt32 hash[2] = {0, 0};
+    UInt32 flags;
+    UInt32 numPerfect;
+    UInt32 bit;
+    UInt   i;
+    UInt   numMcast = object->mcastCount;
+
+    /* Only program the list if it is being filtered on */
+    if (object->rxFilter != EMACSnow_RXFILTER_MULTICAST) {
+        numMcast = 0;
+    }
+
+    /* Address filter 0 holds our own address */
+    numPerfect = EMACNumAddrGet(hwAttrs->baseAddr) - 1;
+
+    for (i = 0; i < numPerfect; i++) {
+        if (i < numMcast) {
+            EMACAddrSet(hwAttrs->baseAddr, i + 1, object->mcastList[i]);
+            EMACAddrFilterSet(hwAttrs->baseAddr, i + 1, EMAC_FILTER_ADDR_ENABLE);
+        }
+        else {
+            EMACAddrFilterSet(hwAttrs->baseAddr, i + 1, 0);
+        }
+    }
+
+    for (i = numPerfect; i < numMcast; i++) {
+        bit = EMACHashFilterBitCalculate(object->mcastList[i]);
+        hash[bit >> 5] |= (1 << (bit & 0x1F));
+    }
+    EMACHashFilterSet(hwAttrs->baseAddr, hash[1], hash[0]);
+
+    switch (object->rxFilter) {
+        case EMACSnow_RXFILTER_DIRECT:
+            flags = 0;
+            break;
+
+        case EMACSnow_RXFILTER_ALLMULTICAST:
+            flags = EMAC_FRMFILTER_PASS_MULTICAST;
+            break;
+
+        case EMACSnow_RXFILTER_ALL:
+            flags = EMAC_FRMFILTER_RX_ALL;
+            break;
+
+        case EMACSnow_RXFILTER_MULTICAST:
+        default:
+            /* Multicast must match the hash table or a perfect filter */
+            flags = (EMAC_FRMFILTER_HASH_AND_PERFECT |
+                     EMAC_FRMFILTER_HASH_MULTICAST);
+            break;
+    }
+
+    EMACFrameFilterSet(hwAttrs->baseAddr, flags | EMAC_FRMFILTER_PASS_NO_CTRL);
+
+    Log_print2(Diags_USER2,
+               "EMACSnow_updateFilters: filter = %d, multicast addresses = %d",
+               object->rxFilter, numMcast);
+}
+
+/*
+ *  ======== EMACSnow_findMcast ========
+ *  Returns the index of the address in the multicast list, or -1.
+ */
+static Int EMACSnow_findMcast(EMACSnow_Object *object, UInt8 *addr)
+{
+    UInt i;
+
+    for (i = 0; i < object->mcastCount; i++) {
+        if (memcmp(object->mcastList[i], addr, 6) == 0) {
+            return (i);
+        }
+    }
+
+    return (-1);
+}
+
 /*
  *  ======== EMACSnow_emacioctl ========
  *  The function is called by the NDK core stack to configure the driver
  */
-Int EMACSnow_emacioctl(struct NETIF_DEVICE* ptr_net_device, uint cmd,
+static Int EMACSnow_emacioctl(struct NETIF_DEVICE* ptr_net_device, uint cmd,
                Void* pbuf, uint size)
 {
-    /* No control commands are currently supported for this driver */
-    Log_print0(Diags_USER2, "EMACSnow_emacioctl: emacioctl called");
+    EMAC_Handle handle = (EMAC_Handle)(ptr_net_device->pvt_data);
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    Int i;
+
+    Log_print1(Diags_USER2, "EMACSnow_emacioctl: emacioctl called, cmd = 0x%x",
+               cmd);
+
+    switch (cmd) {
+        case NIMU_ADD_MULTICAST_ADDRESS:
+            if ((pbuf == NULL) || (size < 6)) {
+                return (-1);
+            }
+
+            /* Already joined */
+            if (EMACSnow_findMcast(object, (UInt8 *)pbuf) >= 0) {
+                return (0);
+            }
+
+            if (object->mcastCount == EMACSnow_NUM_MCAST_ADDRS) {
+                Log_error0("EMACSnow_emacioctl: multicast list full");
+                return (-1);
+            }
+
+            memcpy(object->mcastList[object->mcastCount],
+                   pbuf, 6);
+            object->mcastCount++;
+            EMACSnow_updateFilters(handle);
+            return (0);
+
+        case NIMU_DEL_MULTICAST_ADDRESS:
+            if ((pbuf == NULL) || (size < 6)) {
+                return (-1);
+            }
+
+            i = EMACSnow_findMcast(object, (UInt8 *)pbuf);
+            if (i < 0) {
+                return (-1);
+            }
 
-    if ((cmd == NIMU_ADD_MULTICAST_ADDRESS) || (cmd == NIMU_DEL_MULTICAST_ADDRESS)) {
-        return (0);
+            /* Keep the list packed */
+            object->mcastCount--;
+            memcpy(object->mcastList[i],
+                   object->mcastList[object->mcastCount], 6);
+            EMACSnow_updateFilters(handle);
+            return (0);
+
+        case EMACSnow_IOCTL_SET_RX_FILTER:
+            if ((pbuf == NULL) || (size < sizeof(UInt)) ||
+                (*(UInt *)pbuf > EMACSnow_RXFILTER_ALL)) {
+                return (-1);
+            }
+
+            object->rxFilter = *(UInt *)pbuf;
+            EMACSnow_updateFilters(handle);
+            return (0);
+
+        default:
+            break;
     }
 
     return (-1);
@@ -670,15 +1028,17 @@ Int EMACSnow_emacioctl(struct NETIF_DEVICE* ptr_net_device, uint cmd,
  *  The function is called by the NDK core stack to receive any packets
  *  from the driver.
  */
-Void EMACSnow_pkt_service(NETIF_DEVICE* ptr_net_device)
+static Void EMACSnow_pkt_service(NETIF_DEVICE* ptr_net_device)
 {
+    EMAC_Handle handle = (EMAC_Handle)(ptr_net_device->pvt_data);
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
     PBM_Handle  hPkt;
 
     /* Give all queued packets to the stack */
-    while (PBMQ_count(&EMACSnow_private.PBMQ_rx)) {
+    while (PBMQ_count(&object->PBMQ_rx)) {
 
         /* Dequeue a packet from the driver receive queue. */
-        hPkt = PBMQ_deq(&EMACSnow_private.PBMQ_rx);
+        hPkt = PBMQ_deq(&object->PBMQ_rx);
 
         /*
          *  Prepare the packet so that it can be passed up the networking stack.
@@ -695,24 +1055,48 @@ Void EMACSnow_pkt_service(NETIF_DEVICE* ptr_net_device)
         NIMUReceivePacket(hPkt);
     }
 
+    /* Replace the spare receive packets the Swi has handed to the ring */
+    EMACSnow_rxPoolFill(object);
+
     /* Work has been completed; the receive queue is empty. */
     return;
 }
 
+/*
+ *  ======== EMACSnow_sendSegments ========
+ */
+Int EMACSnow_sendSegments(UInt index, EMACSnow_TxSegment *segs,
+                          UInt numSegs, EMACSnow_TxDoneFxn doneFxn, UArg arg)
+{
+    EMAC_Handle handle = (EMAC_Handle)&(EMAC_config[index]);
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+
+    Assert_isTrue(object->initialized == TRUE, NULL);
+    Assert_isTrue(doneFxn != NULL, NULL);
+
+    if (!EMACSnow_primeTx(handle, segs, numSegs, NULL, doneFxn, arg)) {
+        Log_print1(Diags_USER1,
+                   "EMACSnow_sendSegments: no room for %d segments", numSegs);
+        return (-1);
+    }
+
+    Log_print1(Diags_USER2, "EMACSnow_sendSegments: queued %d segments",
+               numSegs);
+
+    return (0);
+}
+
 /*
  *  ======== EMACSnow_init ========
  *  The function is used to initialize the EMACSnow driver
  */
 Void EMACSnow_init(UInt index)
 {
-    /* Currently only supports 1 EMACSnow peripheral */
-    Assert_isTrue((index == 0), NULL);
-
-    Assert_isTrue(_EMACSnow_initialized == FALSE, NULL);
-    _EMACSnow_initialized = TRUE;
+    EMACSnow_Object *object = (EMACSnow_Object *)(EMAC_config[index].objects);
 
-    /* Initialize the global structures */
-    memset(&EMACSnow_private, 0, sizeof(EMACSnow_Data));
+    /* Initialize the instance */
+    memset(object, 0, sizeof(EMACSnow_Object));
+    object->initialized = TRUE;
 
     Log_print0(Diags_USER2, "EMACSnow_init: setup successfully completed");
 }
@@ -721,61 +1105,79 @@ Void EMACSnow_init(UInt index)
  *  ======== EMACSnow_InitDMADescriptors ========
  * Initialize the transmit and receive DMA descriptor lists.
  */
-Void EMACSnow_InitDMADescriptors(Void)
+static Void EMACSnow_InitDMADescriptors(EMAC_Handle handle)
 {
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
+    EMACSnow_Descriptor *txDescs = object->txDescriptors;
+    EMACSnow_Descriptor *rxDescs = object->rxDescriptors;
     Int i;
     PBM_Handle  hPkt;
 
+    object->txDescList.pDescriptors = txDescs;
+    object->txDescList.ulNumDescs   = EMACSnow_NUM_TX_DESCRIPTORS;
+    object->txDescList.ulWrite      = 0;
+    object->txDescList.ulRead       = 0;
+
+    object->rxDescList.pDescriptors = rxDescs;
+    object->rxDescList.ulNumDescs   = EMACSnow_NUM_RX_DESCRIPTORS;
+    object->rxDescList.ulWrite      = 0;
+    object->rxDescList.ulRead       = 0;
+
     /* Transmit list -  mark all descriptors as not owned by the hardware */
-    for (i = 0; i < NUM_TX_DESCRIPTORS; i++) {
-        g_pTxDescriptors[i].hPkt = NULL;
-        g_pTxDescriptors[i].Desc.ui32Count = 0;
-        g_pTxDescriptors[i].Desc.pvBuffer1 = 0;
-        g_pTxDescriptors[i].Desc.DES3.pLink = ((i == (NUM_TX_DESCRIPTORS - 1)) ?
-               &g_pTxDescriptors[0].Desc : &g_pTxDescriptors[i + 1].Desc);
-        g_pTxDescriptors[i].Desc.ui32CtrlStatus = DES0_TX_CTRL_INTERRUPT |
-                                                  /*DES0_TX_CTRL_IP_ALL_CKHSUMS |*/
-                                                  DES0_TX_CTRL_CHAINED;
+    for (i = 0; i < EMACSnow_NUM_TX_DESCRIPTORS; i++) {
+        txDescs[i].hPkt = NULL;
+        txDescs[i].txDoneFxn = NULL;
+        txDescs[i].Desc.ui32Count = 0;
+        txDescs[i].Desc.pvBuffer1 = 0;
+        txDescs[i].Desc.DES3.pLink = ((i == (EMACSnow_NUM_TX_DESCRIPTORS - 1)) ?
+               &txDescs[0].Desc : &txDescs[i + 1].Desc);
+        txDescs[i].Desc.ui32CtrlStatus = DES0_TX_CTRL_INTERRUPT |
+                                         /*DES0_TX_CTRL_IP_ALL_CKHSUMS |*/
+                                         DES0_TX_CTRL_CHAINED;
     }
 
     /*
      * Receive list -  tag each descriptor with a buffer and set all fields to
      * allow packets to be received.
      */
-    for (i = 0; i < NUM_RX_DESCRIPTORS; i++) {
+    for (i = 0; i < EMACSnow_NUM_RX_DESCRIPTORS; i++) {
         hPkt = PBM_alloc(ETH_MAX_PAYLOAD);
         if (hPkt) {
-            EMACSnow_primeRx(hPkt, &(g_pRxDescriptors[i]));
+            EMACSnow_primeRx(object, hPkt, &(rxDescs[i]));
         }
         else {
             System_abort("EMACSnow_InitDMADescriptors: PBM_alloc error\n");
-            g_pRxDescriptors[i].Desc.pvBuffer1 = 0;
-            g_pRxDescriptors[i].Desc.ui32CtrlStatus = 0;
+            rxDescs[i].Desc.pvBuffer1 = 0;
+            rxDescs[i].Desc.ui32CtrlStatus = 0;
         }
-        g_pRxDescriptors[i].Desc.DES3.pLink =
-                ((i == (NUM_RX_DESCRIPTORS - 1)) ?
-                &g_pRxDescriptors[0].Desc : &g_pRxDescriptors[i + 1].Desc);
+        rxDescs[i].Desc.DES3.pLink =
+                ((i == (EMACSnow_NUM_RX_DESCRIPTORS - 1)) ?
+                &rxDescs[0].Desc : &rxDescs[i + 1].Desc);
     }
 
     /* Set the descriptor pointers in the hardware. */
-    EMACRxDMADescriptorListSet(EMAC0_BASE, &g_pRxDescriptors[0].Desc);
-    EMACTxDMADescriptorListSet(EMAC0_BASE, &g_pTxDescriptors[0].Desc);
+    EMACRxDMADescriptorListSet(hwAttrs->baseAddr, &rxDescs[0].Desc);
+    EMACTxDMADescriptorListSet(hwAttrs->baseAddr, &txDescs[0].Desc);
 }
 
 /*
- *  ======== EMACSnow_NIMUInit ========
- *  The function is used to initialize and register the EMACSnow
+ *  ======== EMACSnow_NIMUInitInstance ========
+ *  The function is used to initialize and register one EMACSnow instance
  *  with the Network Interface Management Unit (NIMU)
  */
-Int EMACSnow_NIMUInit(STKEVENT_Handle hEvent)
+static Int EMACSnow_NIMUInitInstance(EMAC_Handle handle, UInt index,
+                                     STKEVENT_Handle hEvent)
 {
-    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(EMAC_config.hwAttrs);
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
     Types_FreqHz freq;
     NETIF_DEVICE *device;
 
-    Assert_isTrue(_EMACSnow_initialized == TRUE, NULL);
+    Assert_isTrue(object->initialized == TRUE, NULL);
 
-    Log_print0(Diags_USER2, "EMACSnow_NIMUInit: init called");
+    Log_print1(Diags_USER2, "EMACSnow_NIMUInit: init called for instance %d",
+               index);
 
     /* Allocate memory for the EMAC. Memory freed in the NDK stack shutdown */
     device = mmAlloc(sizeof(NETIF_DEVICE));
@@ -795,37 +1197,44 @@ Int EMACSnow_NIMUInit(STKEVENT_Handle hEvent)
     device->mac_address[5] = hwAttrs->macAddress[5];
 
     /* Initialize the Packet Device Information struct */
-    PBMQ_init(&EMACSnow_private.PBMQ_rx);
-    PBMQ_init(&EMACSnow_private.PBMQ_tx);
-    EMACSnow_private.hEvent       = hEvent;
-    EMACSnow_private.pTxDescList  = &g_TxDescList;
-    EMACSnow_private.pRxDescList  = &g_RxDescList;
-    EMACSnow_private.rxCount      = 0;
-    EMACSnow_private.rxDropped    = 0;
-    EMACSnow_private.txSent       = 0;
-    EMACSnow_private.txDropped    = 0;
-    EMACSnow_private.abnormalInts = 0;
-    EMACSnow_private.isrCount = 0;
-    EMACSnow_private.linkUp       = FALSE;
-
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_EMAC0);
-    SysCtlPeripheralReset(SYSCTL_PERIPH_EMAC0);
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_EPHY0);
-    SysCtlPeripheralReset(SYSCTL_PERIPH_EPHY0);
-
-    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_EMAC0)) {
-        /* Keep waiting... */
-    }
-
-    EMACPHYConfigSet(EMAC0_BASE, EMAC_PHY_CONFIG);
+    PBMQ_init(&object->PBMQ_rx);
+    PBMQ_init(&object->PBMQ_tx);
+    object->hEvent       = hEvent;
+    object->intStatus    = 0;
+    object->rxCount      = 0;
+    object->rxDropped    = 0;
+    object->txSent       = 0;
+    object->txDropped    = 0;
+    object->abnormalInts = 0;
+    object->isrCount = 0;
+    object->linkUp       = FALSE;
+    object->rxCoalescing = FALSE;
+    object->rxPolls      = 0;
+
+    /* Peripherals left at 0 in the hwAttrs are powered up by the board file */
+    if (hwAttrs->emacPeriph != 0) {
+        SysCtlPeripheralEnable(hwAttrs->emacPeriph);
+        SysCtlPeripheralReset(hwAttrs->emacPeriph);
+    }
+    if (hwAttrs->phyPeriph != 0) {
+        SysCtlPeripheralEnable(hwAttrs->phyPeriph);
+        SysCtlPeripheralReset(hwAttrs->phyPeriph);
+    }
+    if (hwAttrs->emacPeriph != 0) {
+        while (!SysCtlPeripheralReady(hwAttrs->emacPeriph)) {
+            /* Keep waiting... */
+        }
+    }
+
+    EMACPHYConfigSet(hwAttrs->baseAddr, EMAC_PHY_CONFIG);
 
     BIOS_getCpuFreq(&freq);
-    EMACInit(EMAC0_BASE, freq.lo,
+    EMACInit(hwAttrs->baseAddr, freq.lo,
              EMAC_BCONFIG_MIXED_BURST | EMAC_BCONFIG_PRIORITY_FIXED,
              4, 4, 0);
 
     /* Set MAC configuration options. */
-    EMACConfigSet(EMAC0_BASE, (EMAC_CONFIG_FULL_DUPLEX |
+    EMACConfigSet(hwAttrs->baseAddr, (EMAC_CONFIG_FULL_DUPLEX |
                                //EMAC_CONFIG_CHECKSUM_OFFLOAD |
                                EMAC_CONFIG_7BYTE_PREAMBLE |
                                EMAC_CONFIG_IF_GAP_96BITS |
@@ -838,24 +1247,31 @@ Int EMACSnow_NIMUInit(STKEVENT_Handle hEvent)
                    EMAC_MODE_RX_THRESHOLD_64_BYTES), 0);
 
     /* Program the MAC address into the Ethernet controller. */
-    EMACAddrSet(EMAC0_BASE, 0,
+    EMACAddrSet(hwAttrs->baseAddr, 0,
                   (unsigned char *)device->mac_address);
 
     /*
-     * Set MAC filtering options.  We receive all broadcast and multicast
-     * packets along with those addressed specifically for us.
+     * Set MAC filtering options.  We receive all broadcast packets, those
+     * addressed specifically for us and those for the multicast groups the
+     * stack has joined.
      */
-    EMACFrameFilterSet(EMAC0_BASE, (EMAC_FRMFILTER_SADDR          |
-                                    EMAC_FRMFILTER_PASS_MULTICAST |
-                                    EMAC_FRMFILTER_PASS_NO_CTRL));
+    object->rxFilter   = EMACSnow_RXFILTER_MULTICAST;
+    object->mcastCount = 0;
+    EMACSnow_updateFilters(handle);
 
     /* Initialize the DMA descriptors. */
-    EMACSnow_InitDMADescriptors();
+    EMACSnow_InitDMADescriptors(handle);
+
+    /* Pre-allocate the spare receive packets */
+    object->rxPoolPut    = 0;
+    object->rxPoolGet    = 0;
+    EMACSnow_rxPoolFill(object);
 
     /* Populate the Network Interface Object. */
-    strcpy(device->name, ETHERNET_NAME);
+    System_snprintf(device->name, sizeof(device->name), ETHERNET_NAME "%d",
+                    index);
     device->mtu         = ETH_MAX_PAYLOAD - ETHHDR_SIZE;
-    device->pvt_data    = (Void *)&EMACSnow_private;  // TODO alloc instead?
+    device->pvt_data    = (Void *)handle;
 
     /* Populate the Driver Interface Functions. */
     device->start       = EMACSnow_emacStart;
@@ -878,12 +1294,39 @@ Int EMACSnow_NIMUInit(STKEVENT_Handle hEvent)
 }
 
 /*
- *  ======== EMACSnow_linkUp ========
+ *  ======== EMACSnow_NIMUInit ========
+ *  The function is used to initialize and register every EMACSnow instance
+ *  in EMAC_config with the Network Interface Management Unit (NIMU)
+ */
+Int EMACSnow_NIMUInit(STKEVENT_Handle hEvent)
+{
+    UInt index;
+
+    for (index = 0; EMAC_config[index].fxnTablePtr != NULL; index++) {
+        if (EMAC_config[index].fxnTablePtr != &EMACSnow_fxnTable) {
+            continue;
+        }
+
+        if (EMACSnow_NIMUInitInstance((EMAC_Handle)&(EMAC_config[index]),
+                                      index, hEvent) < 0) {
+            return (-1);
+        }
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== EMACSnow_isLinkUp ========
  */
 Bool EMACSnow_isLinkUp(UInt index)
 {
-    EMACSnow_private.linkUp = (EMACPHYRead(EMAC0_BASE, 0, EPHY_BMSR) & EPHY_BMSR_LINKSTAT);
-    if (EMACSnow_private.linkUp) {
+    EMAC_Handle handle = (EMAC_Handle)&(EMAC_config[index]);
+    EMACSnow_Object *object = (EMACSnow_Object *)(handle->objects);
+    EMACSnow_HWAttrs *hwAttrs = (EMACSnow_HWAttrs *)(handle->hwAttrs);
+
+    object->linkUp = (EMACPHYRead(hwAttrs->baseAddr, 0, EPHY_BMSR) & EPHY_BMSR_LINKSTAT);
+    if (object->linkUp) {
         return (TRUE);
     }
     else {
@@ -62,6 +62,33 @@ extern "C" {
 #define _INCLUDE_NIMU_CODE
 #include <ti/ndk/inc/stkmain.h>
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <driverlib/emac.h>
+
+/*! Number of receive DMA descriptors per EMACSnow instance */
+#ifndef EMACSnow_NUM_RX_DESCRIPTORS
+#define EMACSnow_NUM_RX_DESCRIPTORS     4
+#endif
+
+/*! Number of transmit DMA descriptors per EMACSnow instance */
+#ifndef EMACSnow_NUM_TX_DESCRIPTORS
+#define EMACSnow_NUM_TX_DESCRIPTORS     4
+#endif
+
+/*!
+ *  Number of spare receive packets kept per EMACSnow instance. The Swi swaps
+ *  a full descriptor buffer for one of these instead of calling PBM_alloc.
+ */
+#ifndef EMACSnow_NUM_RX_POOL_PKTS
+#define EMACSnow_NUM_RX_POOL_PKTS       (EMACSnow_NUM_RX_DESCRIPTORS * 2)
+#endif
+
+/*! Number of multicast addresses each EMACSnow instance can join */
+#ifndef EMACSnow_NUM_MCAST_ADDRS
+#define EMACSnow_NUM_MCAST_ADDRS        32
+#endif
+
 /*! @brief  EMACSnow function table */
 extern const EMAC_FxnTable EMACSnow_fxnTable;
 
@@ -72,18 +99,112 @@ typedef struct EMACSnow_HWAttrs {
     ULong baseAddr; /*!< EMAC port */
     UInt8 intNum;    /*!< Interrupt Vector Id */
     UInt8 *macAddress;  /*!< Pointer to MAC address */
+    /*! SysCtl peripheral of the MAC (e.g. SYSCTL_PERIPH_EMAC0), or 0 if the
+     *  board file powers it up */
+    ULong emacPeriph;
+    /*! SysCtl peripheral of the internal PHY (e.g. SYSCTL_PERIPH_EPHY0), or
+     *  0 for an external PHY */
+    ULong phyPeriph;
 } EMACSnow_HWAttrs;
 
+/*!
+ *  @brief  Driver specific NIMU ioctl command to select the receive filter.
+ *
+ *  The argument is a pointer to a UInt holding an EMACSnow_RxFilter value.
+ */
+#define EMACSnow_IOCTL_SET_RX_FILTER    0x100
+
+/*!
+ *  @brief  EMACSnow receive filter modes
+ *
+ *  Broadcast frames and frames addressed to the interface are received in
+ *  every mode.
+ */
+typedef enum EMACSnow_RxFilter {
+    EMACSnow_RXFILTER_DIRECT = 0,       /*!< No multicast frames */
+    EMACSnow_RXFILTER_MULTICAST,        /*!< Joined multicast groups only */
+    EMACSnow_RXFILTER_ALLMULTICAST,     /*!< All multicast frames */
+    EMACSnow_RXFILTER_ALL               /*!< Promiscuous */
+} EMACSnow_RxFilter;
+
+/*!
+ *  @brief  One buffer of a frame passed to EMACSnow_sendSegments()
+ */
+typedef struct EMACSnow_TxSegment {
+    UInt8  *buffer;     /*!< Start of the segment */
+    UInt    len;        /*!< Length of the segment in bytes */
+} EMACSnow_TxSegment;
+
+/*!
+ *  @brief  Called from the EMACSnow Swi once a frame passed to
+ *          EMACSnow_sendSegments() has been transmitted and its buffers
+ *          may be reused.
+ */
+typedef Void (*EMACSnow_TxDoneFxn)(UArg arg);
+
+/*!
+ *  @brief  DMA descriptor and the packet it currently refers to
+ */
+typedef struct EMACSnow_Descriptor {
+    tEMACDMADescriptor  Desc;
+    PBM_Handle          hPkt;
+    EMACSnow_TxDoneFxn  txDoneFxn;
+    UArg                txDoneArg;
+} EMACSnow_Descriptor;
+
+/*!
+ *  @brief  Ring of DMA descriptors
+ */
+typedef struct EMACSnow_DescriptorList {
+    EMACSnow_Descriptor *pDescriptors;
+    UInt32               ulNumDescs;
+    UInt32               ulWrite;
+    UInt32               ulRead;
+} EMACSnow_DescriptorList;
+
 /*!
  *  @brief  EMACSnow Object
  *
  *  This structure should not be directly accessed. It is specified
  *  here to allow the application to supply the needed memory to the
- *  EMACSnow module.
+ *  EMACSnow module. The DMA descriptors live in the object, so it must be
+ *  placed in memory the EMAC DMA can access.
  */
 typedef struct EMACSnow_Object {
     Swi_Handle      swi;
-	Hwi_Handle      hwi;
+    Hwi_Handle      hwi;
+    UInt            rxCount;
+    UInt            rxDropped;
+    UInt            txSent;
+    UInt            txDropped;
+    UInt            linkUp;
+    UInt            abnormalInts;
+    UInt            isrCount;
+    Bool            initialized;
+    volatile UInt32 intStatus;      /* Events seen by the Hwi for the Swi */
+    STKEVENT_Handle hEvent;
+    PBMQ            PBMQ_tx;
+    PBMQ            PBMQ_rx;
+
+    EMACSnow_DescriptorList txDescList;
+    EMACSnow_DescriptorList rxDescList;
+    EMACSnow_Descriptor     txDescriptors[EMACSnow_NUM_TX_DESCRIPTORS];
+    EMACSnow_Descriptor     rxDescriptors[EMACSnow_NUM_RX_DESCRIPTORS];
+
+    /* Spare receive packets; one slot is always left empty */
+    PBM_Handle      rxPool[EMACSnow_NUM_RX_POOL_PKTS + 1];
+    volatile UInt   rxPoolPut;
+    volatile UInt   rxPoolGet;
+
+    /* Receive interrupt moderation */
+    UInt            rxCoalescing;
+    UInt            rxCoalesceCount;
+    UInt            rxPolls;
+
+    /* Address filtering */
+    UInt            rxFilter;
+    UInt            mcastCount;
+    UInt8           mcastList[EMACSnow_NUM_MCAST_ADDRS][6];
 } EMACSnow_Object;
 
 /*!
@@ -108,9 +229,38 @@ extern Bool EMACSnow_isLinkUp(UInt index);
 /*!
  *  @brief  This function is needed in the NIMUDeviceTable that is required
  *          by the NDK.
+ *
+ *  One NIMUDeviceTable entry registers every EMACSnow instance in
+ *  EMAC_config. Instance n is named "eth<n>".
  */
 extern Int EMACSnow_NIMUInit(STKEVENT_Handle hEvent);
 
+/*!
+ *  @brief  This function transmits one Ethernet frame gathered from several
+ *          buffers without copying them.
+ *
+ *  Each segment uses one Tx DMA descriptor, so a header and its payload can
+ *  live in different buffers. The buffers must stay untouched until
+ *  doneFxn is called. The first segment must start with the Ethernet
+ *  header. The frame shares the Tx descriptor ring with the NDK stack.
+ *
+ *  @param  index    Index of the EMACSnow instance in EMAC_config
+ *
+ *  @param  segs     Array of segments making up the frame
+ *
+ *  @param  numSegs  Number of entries in segs
+ *
+ *  @param  doneFxn  Function called once the frame has been transmitted
+ *
+ *  @param  arg      Argument passed to doneFxn
+ *
+ *  @return 0 if the frame was queued. -1 if there were not enough free Tx
+ *          descriptors.
+ */
+extern Int EMACSnow_sendSegments(UInt index, EMACSnow_TxSegment *segs,
+                                 UInt numSegs, EMACSnow_TxDoneFxn doneFxn,
+                                 UArg arg);
+
 #ifdef __cplusplus
 }
 #endif
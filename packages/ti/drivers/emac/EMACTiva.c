@@ -63,6 +63,7 @@
 #include <inc/hw_types.h>
 #include <driverlib/ethernet.h>
 #include <driverlib/sysctl.h>
+#include <driverlib/udma.h>
 #include <inc/hw_ethernet.h>
 
 #include <ti/drivers/EMAC.h>
@@ -71,6 +72,30 @@
 /* Name of the device. */
 #define NIMUINTERFACE_NAME "eth0"
 
+/*
+ *  Maximum number of received frames handled in one run of the Swi. If the
+ *  budget is used up the Swi re-posts itself with the receive interrupt left
+ *  masked, so a burst is polled instead of taking an interrupt per frame.
+ */
+#ifndef RX_POLL_BUDGET
+#define RX_POLL_BUDGET 8
+#endif
+
+/* Frames are moved by the uDMA when both channels are given in the hwAttrs */
+#define EMACTIVA_USE_DMA(hwAttrs) (((hwAttrs)->rxChannelIndex != 0) && \
+                                   ((hwAttrs)->txChannelIndex != 0))
+
+/*
+ *  The FIFO prefixes each received frame with a 2 byte length field and
+ *  appends the 4 byte FCS; the length field counts both. The uDMA receive
+ *  path stores the first FIFO word (length plus the first two data bytes)
+ *  at the start of the PBM buffer and reads the rest of the frame word
+ *  aligned behind it, so the frame data starts at RX_DMA_OFFSET.
+ */
+#define RX_FRAME_OVERHEAD 6
+#define RX_DMA_OFFSET     2
+#define RX_DMA_BUF_SIZE   (ETH_MAX_PAYLOAD + RX_FRAME_OVERHEAD + 4)
+
 /* EMAC function table for Tiva implementation */
 const EMAC_FxnTable EMACTiva_fxnTable = {
         EMACTiva_init,
@@ -83,7 +108,9 @@ extern EMAC_Config EMAC_config;
 /* Forward prototypes as needed */
 static Void EMACTiva_handlePendingTx();
 static Void EMACTiva_handleRx(UArg arg0, UArg arg1);
+static Void EMACTiva_handleDma(UArg arg0, UArg arg1);
 static Void EMACTiva_hwiIntFxn(UArg callbacks);
+static Void EMACTiva_setupDma(EMACTiva_HWAttrs *hwAttrs);
 
 /*
  *  ======== EMACTiva_emacioctl ========
@@ -110,9 +137,13 @@ static Int EMACTiva_emacioctl(struct NETIF_DEVICE* ptr_net_device, uint cmd,
 static Void EMACTiva_emacPoll(struct NETIF_DEVICE* ptr_net_device, uint timer_tick)
 {
     EMACTiva_Object *object = (EMACTiva_Object *)(EMAC_config.objects);
+    UInt key;
 
-    /* Send pending Tx packets */
+    /* Send pending Tx packets. The uDMA Swi also feeds the TX queue. */
+    key = Swi_disable();
     EMACTiva_handlePendingTx();
+    Swi_restore(key);
+
     object->linkUp = EthernetPHYRead(ETH_BASE, PHY_MR1) & PHY_MR1_LINK;
 }
 
@@ -124,15 +155,19 @@ static Void EMACTiva_emacPoll(struct NETIF_DEVICE* ptr_net_device, uint timer_ti
 static Int EMACTiva_emacSend(struct NETIF_DEVICE* ptr_net_device, PBM_Handle hPkt)
 {
     EMACTiva_Object *object = (EMACTiva_Object *)(EMAC_config.objects);
+    UInt key;
 
     /*
      *  Enqueue the packet onto the end of the transmit queue.
      *  This is done to ensure that the packets are sent in order.
+     *  The uDMA Swi also feeds the TX queue, so keep it out meanwhile.
      */
+    key = Swi_disable();
     PBMQ_enq(&object->PBMQ_tx, hPkt);
 
     /* Transmit pending packets */
     EMACTiva_handlePendingTx();
+    Swi_restore(key);
 
     return (0);
 }
@@ -168,6 +203,43 @@ static Void EMACTiva_emacServicePacket(NETIF_DEVICE* ptr_net_device)
     return;
 }
 
+/*
+ *  ======== EMACTiva_setupDma ========
+ *  Maps the Ethernet requests onto the RX and TX uDMA channels and sets
+ *  their attributes. The uDMA itself (enable, control table) is set up by
+ *  the application, see EMACTiva_HWAttrs.
+ */
+static Void EMACTiva_setupDma(EMACTiva_HWAttrs *hwAttrs)
+{
+    UInt key;
+
+    /* A lock is needed because we are accessing shared uDMA registers.*/
+    key = Hwi_disable();
+
+    /* Configure channel mapping; NULL keeps the reset (default) mapping */
+    if (hwAttrs->channelMappingFxn != NULL) {
+        hwAttrs->channelMappingFxn(hwAttrs->rxChannelMappingFxnArg);
+        hwAttrs->channelMappingFxn(hwAttrs->txChannelMappingFxnArg);
+    }
+
+    /*
+     *  Primary control structures, normal priority, and requests unmasked.
+     *  Transfers are started by software (UDMA_MODE_AUTO), so burst-only
+     *  is not used either.
+     */
+    uDMAChannelAttributeDisable(hwAttrs->rxChannelIndex,
+                                UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    uDMAChannelAttributeDisable(hwAttrs->txChannelIndex,
+                                UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+
+    Hwi_restore(key);
+
+    Log_print2(Diags_USER1, "EMACTiva: uDMA channels %d (RX), %d (TX)",
+               hwAttrs->rxChannelIndex, hwAttrs->txChannelIndex);
+}
+
 /*
  *  ======== EMACTiva_emacStart ========
  *  The function is used to initialize and start the EMACTiva
@@ -182,10 +254,15 @@ static Int EMACTiva_emacStart(struct NETIF_DEVICE* ptr_net_device)
     Error_init(&eb);
 
     /*
-     *  Create the Swi that handles incoming packets.
-     *  Take default parameters.
+     *  Create the Swi that handles incoming packets (and, with the uDMA,
+     *  completed transfers). Take default parameters.
      */
-    object->swi = Swi_create(EMACTiva_handleRx, NULL, &eb);
+    if (EMACTIVA_USE_DMA(hwAttrs)) {
+        object->swi = Swi_create(EMACTiva_handleDma, NULL, &eb);
+    }
+    else {
+        object->swi = Swi_create(EMACTiva_handleRx, NULL, &eb);
+    }
     if (object->swi == NULL) {
         Log_error0("EMACTiva: Swi_create failed");
         return (-1);
@@ -198,6 +275,10 @@ static Int EMACTiva_emacStart(struct NETIF_DEVICE* ptr_net_device)
         return (-1);
     }
 
+    if (EMACTIVA_USE_DMA(hwAttrs)) {
+        EMACTiva_setupDma(hwAttrs);
+    }
+
     /* Enable the Ethernet Controller transmitter and receiver. */
     EthernetEnable(ETH_BASE);
 
@@ -229,6 +310,20 @@ static Int EMACTiva_emacStop(struct NETIF_DEVICE* ptr_net_device)
 
     EthernetDisable(ETH_BASE);
 
+    if (EMACTIVA_USE_DMA(hwAttrs)) {
+        uDMAChannelDisable(hwAttrs->rxChannelIndex);
+        uDMAChannelDisable(hwAttrs->txChannelIndex);
+
+        if (object->rxDmaPkt != NULL) {
+            PBM_free(object->rxDmaPkt);
+            object->rxDmaPkt = NULL;
+        }
+        if (object->txDmaPkt != NULL) {
+            PBM_free(object->txDmaPkt);
+            object->txDmaPkt = NULL;
+        }
+    }
+
     if (object->hwi != NULL) {
         Hwi_delete(&(object->hwi));
     }
@@ -252,53 +347,269 @@ static Int EMACTiva_emacStop(struct NETIF_DEVICE* ptr_net_device)
 }
 
 /*
- *  ======== EMACTiva_handlePendingTx ========
+ *  ======== EMACTiva_putFrame ========
+ *  Copy a frame into the TX FIFO with the CPU and release it.
  */
-static Void EMACTiva_handlePendingTx()
+static Void EMACTiva_putFrame(EMACTiva_Object *object, PBM_Handle hPkt)
 {
-    EMACTiva_Object *object = (EMACTiva_Object *)(EMAC_config.objects);
     UINT8  *pBuffer;
     UInt    len;
     Long    sentLen;
+
+    /* Get the pointer to the buffer and the length */
+    pBuffer = PBM_getDataBuffer(hPkt) + PBM_getDataOffset(hPkt);
+    len = PBM_getValidLen(hPkt);
+
+    sentLen = EthernetPacketPutNonBlocking(ETH_BASE, pBuffer, len);
+    if (sentLen < 0) {
+        Log_print2(Diags_USER1,
+            "EMACTiva: failed to transmit packet 0x%x len = %d",
+            (IArg)hPkt, len);
+        object->txDropped++;
+    }
+    else {
+        Log_print2(Diags_USER2,
+            "EMACTiva: Sent packet 0x%x to network len = %d",
+            (IArg)hPkt, len);
+        object->txSent++;
+    }
+
+    PBM_free(hPkt);
+}
+
+/*
+ *  ======== EMACTiva_startTxDma ========
+ *  Start writing a frame into the TX FIFO with the uDMA. The frame is
+ *  handed to the MAC by EMACTiva_handleDma once the transfer is done.
+ *  Returns FALSE if the frame cannot be transferred by the uDMA.
+ */
+static Bool EMACTiva_startTxDma(EMACTiva_Object *object,
+                                EMACTiva_HWAttrs *hwAttrs, PBM_Handle hPkt)
+{
+    UINT8  *pBuffer;
+    UInt    len;
+    UInt    key;
+
+    pBuffer = PBM_getDataBuffer(hPkt) + PBM_getDataOffset(hPkt);
+    len = PBM_getValidLen(hPkt);
+
+    /*
+     *  The first FIFO word carries the payload length and the first two
+     *  bytes of the frame. The uDMA moves the rest a word at a time, so it
+     *  must start on a word boundary. The NDK normally places the Ethernet
+     *  header 2 bytes off a word boundary to align the IP header.
+     */
+    if ((((UInt32)(pBuffer + 2)) & 0x3) || (len <= ETHHDR_SIZE) ||
+        (len > ETH_MAX_PAYLOAD)) {
+        return (FALSE);
+    }
+
+    HWREG(ETH_BASE + MAC_O_DATA) = (len - ETHHDR_SIZE) |
+                                   ((UInt32)pBuffer[0] << 16) |
+                                   ((UInt32)pBuffer[1] << 24);
+
+    object->txDmaPkt = hPkt;
+
+    /*
+     *  The last word may read up to 3 bytes past the frame. They stay
+     *  inside the PBM buffer and the MAC ignores them.
+     */
+    uDMAChannelControlSet(hwAttrs->txChannelIndex | UDMA_PRI_SELECT,
+                          UDMA_SIZE_32 | UDMA_SRC_INC_32 | UDMA_DST_INC_NONE |
+                          UDMA_ARB_8);
+    uDMAChannelTransferSet(hwAttrs->txChannelIndex | UDMA_PRI_SELECT,
+                           UDMA_MODE_AUTO, (Void *)(pBuffer + 2),
+                           (Void *)(ETH_BASE + MAC_O_DATA),
+                           (len - 2 + 3) / 4);
+
+    /* A lock is needed because we are accessing shared uDMA registers.*/
+    key = Hwi_disable();
+    uDMAChannelEnable(hwAttrs->txChannelIndex);
+    uDMAChannelRequest(hwAttrs->txChannelIndex);
+    Hwi_restore(key);
+
+    Log_print2(Diags_USER2, "EMACTiva: uDMA TX started 0x%x len = %d",
+               (IArg)hPkt, len);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== EMACTiva_handlePendingTx ========
+ *  Must be called with the Swi disabled or from the Swi.
+ */
+static Void EMACTiva_handlePendingTx()
+{
+    EMACTiva_Object *object = (EMACTiva_Object *)(EMAC_config.objects);
+    EMACTiva_HWAttrs *hwAttrs = (EMACTiva_HWAttrs *)(EMAC_config.hwAttrs);
     PBM_Handle hPkt;
 
-    /* Transmit pending packets */
-    while (EthernetSpaceAvail(ETH_BASE)) {
+    /*
+     *  Transmit pending packets. The MAC holds a single TX frame, which is
+     *  busy until a running uDMA transfer has been handed to the MAC.
+     */
+    while ((object->txDmaPkt == NULL) && EthernetSpaceAvail(ETH_BASE)) {
 
         /*
          *  If there are pending packets, send one.
          *  Otherwise quit the loop.
          */
         hPkt = PBMQ_deq(&object->PBMQ_tx);
-        if (hPkt != NULL) {
-
-            /* Get the pointer to the buffer and the length */
-            pBuffer = PBM_getDataBuffer(hPkt) + PBM_getDataOffset(hPkt);
-            len = PBM_getValidLen(hPkt);
-
-            sentLen = EthernetPacketPutNonBlocking(ETH_BASE, pBuffer, len);
-            if (sentLen < 0) {
-                Log_print2(Diags_USER1,
-                    "EMACTiva: failed to transmit packet 0x%x len = %d",
-                    (IArg)hPkt, len);
-                object->txDropped++;
-            }
-            else {
-                Log_print2(Diags_USER2,
-                    "EMACTiva: Sent packet 0x%x to network len = %d",
-                    (IArg)hPkt, len);
-                object->txSent++;
-            }
-
-            PBM_free(hPkt);
+        if (hPkt == NULL) {
+            break;
         }
-        else {
+
+        /* The uDMA completion interrupt takes it from here */
+        if (EMACTIVA_USE_DMA(hwAttrs) &&
+            EMACTiva_startTxDma(object, hwAttrs, hPkt)) {
             break;
         }
+
+        EMACTiva_putFrame(object, hPkt);
     }
     return;
 }
 
+/*
+ *  ======== EMACTiva_startRxDma ========
+ *  Start reading the frame at the head of the RX FIFO into a PBM with the
+ *  uDMA. Frames with a bad length are dropped here. Returns FALSE if no
+ *  PBM is available.
+ */
+static Bool EMACTiva_startRxDma(EMACTiva_Object *object,
+                                EMACTiva_HWAttrs *hwAttrs)
+{
+    PBM_Handle hPkt;
+    UInt8   dummyBuffer[4];
+    UInt32 *pBuffer;
+    UInt32  firstWord;
+    UInt32  frameLen;
+    UInt32  words;
+    UInt    key;
+
+    hPkt = PBM_alloc(RX_DMA_BUF_SIZE);
+    if (hPkt == NULL) {
+        Log_print0(Diags_USER1, "EMACTiva: no PBM packets available");
+
+        /*
+         *  Drop this incoming packet. The rest of the packet will
+         *  be dropped by the Ethernet API.
+         */
+        EthernetPacketGetNonBlocking(ETH_BASE, dummyBuffer,
+                                     sizeof(dummyBuffer));
+
+        object->rxDropped++;
+        return (FALSE);
+    }
+    pBuffer = (UInt32 *)PBM_getDataBuffer(hPkt);
+
+    firstWord = HWREG(ETH_BASE + MAC_O_DATA);
+    frameLen = firstWord & 0xFFFF;
+    words = (frameLen + 3) / 4;
+
+    if ((frameLen <= RX_FRAME_OVERHEAD) ||
+        (frameLen > ETH_MAX_PAYLOAD + RX_FRAME_OVERHEAD)) {
+        Log_print1(Diags_USER1, "EMACTiva: bad frame length %d", frameLen);
+
+        /* Drain the rest of the frame from the FIFO (none if frameLen is 0) */
+        while (words-- > 1) {
+            firstWord = HWREG(ETH_BASE + MAC_O_DATA);
+        }
+
+        PBM_free(hPkt);
+        object->rxDropped++;
+        return (TRUE);
+    }
+
+    pBuffer[0] = firstWord;
+    PBM_setDataOffset(hPkt, RX_DMA_OFFSET);
+    PBM_setValidLen(hPkt, frameLen - RX_FRAME_OVERHEAD);
+    object->rxDmaPkt = hPkt;
+
+    uDMAChannelControlSet(hwAttrs->rxChannelIndex | UDMA_PRI_SELECT,
+                          UDMA_SIZE_32 | UDMA_SRC_INC_NONE | UDMA_DST_INC_32 |
+                          UDMA_ARB_8);
+    uDMAChannelTransferSet(hwAttrs->rxChannelIndex | UDMA_PRI_SELECT,
+                           UDMA_MODE_AUTO, (Void *)(ETH_BASE + MAC_O_DATA),
+                           (Void *)&pBuffer[1], words - 1);
+
+    /* A lock is needed because we are accessing shared uDMA registers.*/
+    key = Hwi_disable();
+    uDMAChannelEnable(hwAttrs->rxChannelIndex);
+    uDMAChannelRequest(hwAttrs->rxChannelIndex);
+    Hwi_restore(key);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== EMACTiva_handleDma ========
+ *  Swi used instead of EMACTiva_handleRx when frames are moved by the uDMA.
+ *  It runs on the Ethernet interrupt, which also signals the completion of
+ *  the uDMA transfers on the Ethernet channels. One transfer per direction
+ *  is in flight at a time.
+ */
+static Void EMACTiva_handleDma(UArg arg0, UArg arg1)
+{
+    EMACTiva_Object *object = (EMACTiva_Object *)(EMAC_config.objects);
+    EMACTiva_HWAttrs *hwAttrs = (EMACTiva_HWAttrs *)(EMAC_config.hwAttrs);
+
+    /* Hand a completely written frame to the MAC */
+    if ((object->txDmaPkt != NULL) &&
+        (uDMAChannelIsEnabled(hwAttrs->txChannelIndex) == FALSE)) {
+        HWREG(ETH_BASE + MAC_O_TR) = MAC_TR_NEWTX;
+
+        PBM_free(object->txDmaPkt);
+        object->txDmaPkt = NULL;
+        object->txSent++;
+    }
+
+    /* Start the next frame once the MAC has room for it */
+    EMACTiva_handlePendingTx();
+
+    /* Queue a completely read frame for the stack */
+    if ((object->rxDmaPkt != NULL) &&
+        (uDMAChannelIsEnabled(hwAttrs->rxChannelIndex) == FALSE)) {
+        PBMQ_enq(&object->PBMQ_rx, object->rxDmaPkt);
+
+        Log_print1(Diags_USER2, "EMACTiva: enqueued received 0x%x",
+            (IArg)object->rxDmaPkt);
+
+        object->rxDmaPkt = NULL;
+        object->rxCount++;
+        object->rxDmaBatch++;
+    }
+
+    /* Start reading the next frame */
+    while ((object->rxDmaPkt == NULL) &&
+           (EthernetPacketAvail(ETH_BASE) == TRUE)) {
+        if (EMACTiva_startRxDma(object, hwAttrs) == FALSE) {
+            break;
+        }
+    }
+
+    /*
+     *  Notify NDK stack once the FIFO has run dry or a budget worth of
+     *  frames has been queued.
+     */
+    if ((object->rxDmaBatch != 0) &&
+        ((object->rxDmaPkt == NULL) || (object->rxDmaBatch >= RX_POLL_BUDGET))) {
+        STKEVENT_signal(object->hEvent, STKEVENT_ETHERNET, 1);
+        object->rxDmaBatch = 0;
+    }
+
+    /*
+     *  Re-enable the Ethernet interrupts. While a frame is being read the
+     *  receive interrupt stays masked; the uDMA completion brings us back.
+     */
+    if (object->rxDmaPkt != NULL) {
+        EthernetIntEnable(ETH_BASE, ETH_INT_TX);
+    }
+    else {
+        EthernetIntEnable(ETH_BASE, ETH_INT_RX | ETH_INT_TX);
+    }
+}
+
 /*
  *  ======== EMACTiva_handleRx ========
  */
@@ -309,10 +620,26 @@ static Void EMACTiva_handleRx(UArg arg0, UArg arg1)
     UInt8 dummyBuffer[4];
     UInt8 *pBuffer;
     Long len;
+    UInt frames = 0;
+    UInt enqueued = 0;
 
-    /* Process all incoming packets */
+    /* Process incoming packets, up to the poll budget */
     while (EthernetPacketAvail(ETH_BASE) == TRUE) {
 
+        if (frames == RX_POLL_BUDGET) {
+            /*
+             *  More frames are waiting. Come back in another Swi run with
+             *  the receive interrupt still masked, but let TX through.
+             */
+            if (enqueued) {
+                STKEVENT_signal(object->hEvent, STKEVENT_ETHERNET, 1);
+            }
+            EthernetIntEnable(ETH_BASE, ETH_INT_TX);
+            Swi_post(object->swi);
+            return;
+        }
+        frames++;
+
         /*
          *  Alloc a PBM packet. The incoming Ethernet packet will be
          *  placed into this buffer.
@@ -358,16 +685,18 @@ static Void EMACTiva_handleRx(UArg arg0, UArg arg1)
 
             /* Update internal statistic */
             object->rxCount++;
-
-            /*
-             *  Notify NDK stack of pending Rx Ethernet packet and
-             *  that it was triggered by an external event.
-             */
-            STKEVENT_signal(object->hEvent, STKEVENT_ETHERNET, 1);
-
+            enqueued++;
         }
     }
 
+    /*
+     *  Notify NDK stack once for the whole batch of pending Rx Ethernet
+     *  packets and that it was triggered by an external event.
+     */
+    if (enqueued) {
+        STKEVENT_signal(object->hEvent, STKEVENT_ETHERNET, 1);
+    }
+
     /* Re-enable the Ethernet interrupts. */
     EthernetIntEnable(ETH_BASE, ETH_INT_RX | ETH_INT_TX);
 }
@@ -68,10 +68,44 @@ extern const EMAC_FxnTable EMACTiva_fxnTable;
 
 /*!
  *  @brief  EMACTiva Hardware attributes
+ *
+ *  When rxChannelIndex and txChannelIndex are non-zero, frames are moved
+ *  between the MAC FIFO and the PBM buffers by the micro DMA controller
+ *  instead of the CPU. The application must have enabled the uDMA and
+ *  set its control table before the NDK stack is started (e.g. with the
+ *  board's initDMA function). Leave both fields zero to copy with the CPU.
+ *
+ *  When the stack starts, the driver calls channelMappingFxn with the RX
+ *  and TX mapping arguments to route the Ethernet requests to the channels,
+ *  and resets the channel attributes (primary control structure, normal
+ *  priority, requests unmasked). channelMappingFxn may be NULL if the
+ *  channels are still in their reset mapping, which on Concerto devices is
+ *  the Ethernet mapping of channels 6 and 7.
+ *
+ *  A sample structure is shown below:
+ *  @code
+ *  const EMACTiva_HWAttrs emacHWAttrs[] = {
+ *      {
+ *          INT_ETH,
+ *          macAddress,
+ *          UDMA_CHANNEL_ETH0RX,
+ *          UDMA_CHANNEL_ETH0TX,
+ *          NULL,
+ *          0,
+ *          0
+ *      }
+ *  };
+ *  @endcode
  */
 typedef struct EMACTiva_HWAttrs {
-    UInt8 intNum;       /*!< Interrupt Vector Id */
-    UInt8 *macAddress;  /*!< Pointer to MAC address */
+    UInt8 intNum;           /*!< Interrupt Vector Id */
+    UInt8 *macAddress;      /*!< Pointer to MAC address */
+    UInt32 rxChannelIndex;  /*!< uDMA channel for RX frames (0 = no DMA) */
+    UInt32 txChannelIndex;  /*!< uDMA channel for TX frames (0 = no DMA) */
+    /*! uDMA mapping function for the channels, NULL keeps the reset mapping */
+    Void  (*channelMappingFxn)(ULong);
+    ULong rxChannelMappingFxnArg;   /*!< MappingFxn arg to map the RX channel */
+    ULong txChannelMappingFxnArg;   /*!< MappingFxn arg to map the TX channel */
 } EMACTiva_HWAttrs;
 
 /*!
@@ -92,6 +126,9 @@ typedef struct EMACTiva_Object {
     PBMQ            PBMQ_tx;
     PBMQ            PBMQ_rx;
     STKEVENT_Handle hEvent;
+    PBM_Handle      rxDmaPkt;   /* Frame being read by the uDMA */
+    PBM_Handle      txDmaPkt;   /* Frame being written by the uDMA */
+    UInt            rxDmaBatch; /* Frames received since the last signal */
 } EMACTiva_Object;
 
 /*!
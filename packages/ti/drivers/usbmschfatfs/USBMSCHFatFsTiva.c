@@ -30,6 +30,8 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include <xdc/std.h>
 #include <xdc/runtime/Error.h>
 #include <xdc/runtime/Assert.h>
@@ -51,6 +53,9 @@
 #include <usblib/usbmsc.h>
 #include <usblib/host/usbhost.h>
 #include <usblib/host/usbhmsc.h>
+#if defined(TIVAWARE)
+#include <usblib/host/usbhhub.h>
+#endif
 
 #if defined(TIVAWARE)
 /* c99 types needed by TivaWare */
@@ -60,23 +65,96 @@ typedef uint32_t                    USBMSCEventType;
 #define g_sUSBHostMSCClassDriver    g_USBHostMSCClassDriver
 #define eUSBModeHost                USB_MODE_HOST
 #define ui32Event                   ulEvent
+#define ui32Instance                ulInstance
 typedef ULong                       USBMSCEventType;
 #endif
 
 #define DRIVE_NOT_MOUNTED           ~0
+#define SECTOR_SIZE                 512
+
+/* Sector cache line states */
+#define CACHE_VALID                 0x01
+#define CACHE_DIRTY                 0x02
+
+/*
+ * Most sectors moved by one USBHMSCBlockRead() or USBHMSCBlockWrite() call,
+ * and so the longest the USB library stays locked by a disk access
+ */
+#ifndef USBMSCHFatFsTiva_MAX_BURST
+#define USBMSCHFatFsTiva_MAX_BURST  64
+#endif
+
+/*
+ * Ticks the service task waits for a USB interrupt before it runs
+ * USBHCDMain() anyway. Only a safety net: every interrupt, including the
+ * start-of-frame interrupt while a device is attached, wakes the task.
+ */
+#ifndef USBMSCHFatFsTiva_SERVICE_TIMEOUT
+#define USBMSCHFatFsTiva_SERVICE_TIMEOUT    100
+#endif
 
 /*
  * Array of USBMSCHFatFs_Handles to determine the association of the FatFs drive
  * number with a USBMSCHFatFs_Handle
  * _VOLUMES is defined in <ti/sysbios/fatfs/ffconf.h>
- * As only one USB MSC Host class can be defined only the 1st element is used.
  */
+static USBMSCHFatFs_Handle drives[_VOLUMES];
+
 extern USBMSCHFatFs_Config USBMSCHFatFs_config[];
 
+/*
+ * USB host stack. usbhmsc.c only has MSC drive instance 0, so a single
+ * USBMSCHFatFs_config entry (mscHandle) can own it at a time. The
+ * USBMSCHFatFsTiva_open() that claims mscHandle starts the stack and its
+ * USBMSCHFatFsTiva_close() stops it; no other open gets that far meanwhile.
+ */
+static struct {
+    USBMSCHFatFs_Handle mscHandle;          /* Drive owning the MSC instance */
+    ULong               unknownInstance;    /* Unknown device being shown */
+    Hwi_Struct          hwi;                /* USB interrupt */
+    Task_Struct         taskHCDMain;        /* Runs USBHCDMain() */
+    GateMutex_Struct    gateUSBLibAccess;   /* Serializes USB library calls */
+    Semaphore_Struct    semHCDService;      /* Wakes the service task */
+#if defined(TIVAWARE)
+    tHubInstance       *hubInstance;        /* USB hub class driver */
+#endif
+    /* Configuration descriptors of the drive and of a hub */
+    UChar               memPoolHCD[HCDMEMORYPOOLSIZE * 2];
+} host;
+
 /* Function prototypes */
+static Long USBMSCHFatFsTiva_blockRead(USBMSCHFatFsTiva_Object *object,
+                                       UChar *buf, ULong sector, UInt count);
+static Long USBMSCHFatFsTiva_blockWrite(USBMSCHFatFsTiva_Object *object,
+                                        const UChar *buf, ULong sector,
+                                        UInt count);
+static Int  USBMSCHFatFsTiva_cacheAlloc(USBMSCHFatFsTiva_Object *object,
+                                       USBMSCHFatFsTiva_HWAttrs const *hwAttrs,
+                                       UInt lines);
+static Void USBMSCHFatFsTiva_cacheCheck(USBMSCHFatFsTiva_Object *object);
+static Int  USBMSCHFatFsTiva_cacheFill(USBMSCHFatFsTiva_Object *object,
+                                      USBMSCHFatFsTiva_HWAttrs const *hwAttrs,
+                                      ULong sector);
+static Int  USBMSCHFatFsTiva_cacheFind(USBMSCHFatFsTiva_Object *object,
+                                      ULong sector);
+static Long USBMSCHFatFsTiva_cacheFlush(USBMSCHFatFsTiva_Object *object,
+                                       USBMSCHFatFsTiva_HWAttrs const *hwAttrs);
+static Long USBMSCHFatFsTiva_cacheWriteBack(USBMSCHFatFsTiva_Object *object,
+                                       USBMSCHFatFsTiva_HWAttrs const *hwAttrs,
+                                       UInt line);
+#if defined(TIVAWARE)
+static Void USBMSCHFatFsTiva_cbHubHandler(tHubInstance *hubInstance,
+                                          uint32_t event,
+                                          uint32_t msgParam,
+                                          Void *msgData);
+#endif
 static Void USBMSCHFatFsTiva_cbMSCHandler(USBMSCType instance,
                                           USBMSCEventType event,
                                           Void *eventMsgPtr);
+static Void USBMSCHFatFsTiva_hostInit(Void);
+static Void USBMSCHFatFsTiva_hostStart(USBMSCHFatFsTiva_HWAttrs const *hwAttrs,
+                                       USBMSCHFatFs_Params *params);
+static Void USBMSCHFatFsTiva_hostStop(Void);
 static Void USBMSCHFatFsTiva_hwiHandler(UArg arg0);
 static Void USBMSCHFatFsTiva_serviceUSBHost(UArg arg0, UArg arg1);
 static Void USBMSCHFatFsTiva_usbHCDEvents(Void *cbData);
@@ -116,6 +194,9 @@ DECLARE_EVENT_DRIVER(USBMSCHFatFs_eventDriver, 0, 0,
 /* A list of available Host Class Drivers */
 static tUSBHostClassDriver const * const usbHCDDriverList[] = {
     &g_sUSBHostMSCClassDriver,  /* MSC Host class driver */
+#if defined(TIVAWARE)
+    &g_sUSBHubClassDriver,      /* Hub class driver, for a drive on a hub */
+#endif
     &USBMSCHFatFs_eventDriver   /* Generic event notification handler */
 };
 
@@ -123,6 +204,254 @@ static tUSBHostClassDriver const * const usbHCDDriverList[] = {
 static const ULong numHostClassDrivers =
     sizeof(usbHCDDriverList) / sizeof(tUSBHostClassDriver *);
 
+/*
+ *  ======== USBMSCHFatFsTiva_blockRead ========
+ *  Reads sectors in bursts of up to USBMSCHFatFsTiva_MAX_BURST sectors.
+ *
+ *  gateUSBLibAccess is only held for one burst at a time, so the
+ *  USBMSCHFatFsTiva_serviceUSBHost task can run between bursts.
+ *
+ *  @return 0 on success
+ */
+static Long USBMSCHFatFsTiva_blockRead(USBMSCHFatFsTiva_Object *object,
+                                       UChar *buf, ULong sector, UInt count)
+{
+    UInt                        key;
+    UInt                        burst;
+    Long                        driveRead = 0;
+
+    while ((count != 0) && (driveRead == 0)) {
+        burst = (count < USBMSCHFatFsTiva_MAX_BURST) ?
+                count : USBMSCHFatFsTiva_MAX_BURST;
+
+        key = GateMutex_enter(GateMutex_handle(&(host.gateUSBLibAccess)));
+        driveRead = USBHMSCBlockRead(object->MSCInstance, sector, buf, burst);
+        GateMutex_leave(GateMutex_handle(&(host.gateUSBLibAccess)), key);
+
+        buf += burst * SECTOR_SIZE;
+        sector += burst;
+        count -= burst;
+    }
+
+    return (driveRead);
+}
+
+/*
+ *  ======== USBMSCHFatFsTiva_blockWrite ========
+ *  Writes sectors in bursts of up to USBMSCHFatFsTiva_MAX_BURST sectors.
+ *
+ *  @return 0 on success
+ */
+static Long USBMSCHFatFsTiva_blockWrite(USBMSCHFatFsTiva_Object *object,
+                                        const UChar *buf, ULong sector,
+                                        UInt count)
+{
+    UInt                        key;
+    UInt                        burst;
+    Long                        driveWrite = 0;
+
+    while ((count != 0) && (driveWrite == 0)) {
+        burst = (count < USBMSCHFatFsTiva_MAX_BURST) ?
+                count : USBMSCHFatFsTiva_MAX_BURST;
+
+        key = GateMutex_enter(GateMutex_handle(&(host.gateUSBLibAccess)));
+        driveWrite = USBHMSCBlockWrite(object->MSCInstance, sector,
+                                       (UChar *)buf, burst);
+        GateMutex_leave(GateMutex_handle(&(host.gateUSBLibAccess)), key);
+
+        buf += burst * SECTOR_SIZE;
+        sector += burst;
+        count -= burst;
+    }
+
+    return (driveWrite);
+}
+
+/*
+ *  ======== USBMSCHFatFsTiva_cacheAlloc ========
+ *  Takes the next lines of the sector cache for new sectors.
+ *
+ *  Dirty lines are written back and all of them are invalidated.
+ *
+ *  @param  lines   Number of adjacent lines needed
+ *
+ *  @return Index of the first line, or -1 if a write back failed
+ */
+static Int USBMSCHFatFsTiva_cacheAlloc(USBMSCHFatFsTiva_Object *object,
+                                       USBMSCHFatFsTiva_HWAttrs const *hwAttrs,
+                                       UInt lines)
+{
+    UInt                        i;
+    UInt                        first;
+
+    if (object->cacheNext + lines > object->cacheLines) {
+        object->cacheNext = 0;
+    }
+    first = object->cacheNext;
+
+    for (i = first; i < first + lines; i++) {
+        if (USBMSCHFatFsTiva_cacheWriteBack(object, hwAttrs, i) != 0) {
+            return (-1);
+        }
+        object->cacheState[i] = 0;
+    }
+
+    object->cacheNext = first + lines;
+
+    return (first);
+}
+
+/*
+ *  ======== USBMSCHFatFsTiva_cacheCheck ========
+ *  Drops every line of the sector cache, dirty or not, if the device has
+ *  changed since the lines were filled.
+ *
+ *  Called with gateDiskAccess held. USBMSCHFatFsTiva_cbMSCHandler() only
+ *  bumps object->generation, so a disk access it preempts cannot leave a
+ *  line of the old device behind for the next one.
+ */
+static Void USBMSCHFatFsTiva_cacheCheck(USBMSCHFatFsTiva_Object *object)
+{
+    UInt                        generation = object->generation;
+
+    if (object->cacheGeneration != generation) {
+        memset(object->cacheState, 0, sizeof(object->cacheState));
+        object->cacheGeneration = generation;
+    }
+}
+
+/*
+ *  ======== USBMSCHFatFsTiva_cacheFill ========
+ *  Reads a sector and the ones following it into the sector cache.
+ *
+ *  Half of the cache is filled at once, so FatFs's sequential FAT and
+ *  directory accesses hit the cache.
+ *
+ *  @return Index of the line holding sector, or -1 on error
+ */
+static Int USBMSCHFatFsTiva_cacheFill(USBMSCHFatFsTiva_Object *object,
+                                      USBMSCHFatFsTiva_HWAttrs const *hwAttrs,
+                                      ULong sector)
+{
+    Int                         first;
+    UInt                        i;
+    UInt                        lines = (object->cacheLines + 1) / 2;
+    UChar                      *buf;
+
+    first = USBMSCHFatFsTiva_cacheAlloc(object, hwAttrs, lines);
+    if (first < 0) {
+        return (-1);
+    }
+    buf = hwAttrs->cacheBuf + (first * SECTOR_SIZE);
+
+    if (USBMSCHFatFsTiva_blockRead(object, buf, sector, lines) != 0) {
+        /* Reading ahead fails past the end of the disk */
+        lines = 1;
+        if (USBMSCHFatFsTiva_blockRead(object, buf, sector, 1) != 0) {
+            return (-1);
+        }
+    }
+
+    for (i = 0; i < lines; i++) {
+        /* Keep the copy the cache holds already, it may be dirty */
+        if ((i == 0) || (USBMSCHFatFsTiva_cacheFind(object, sector + i) < 0)) {
+            object->cacheSector[first + i] = sector + i;
+            object->cacheState[first + i] = CACHE_VALID;
+        }
+    }
+
+    return (first);
+}
+
+/*
+ *  ======== USBMSCHFatFsTiva_cacheFind ========
+ *  @return Index of the line holding sector, or -1
+ */
+static Int USBMSCHFatFsTiva_cacheFind(USBMSCHFatFsTiva_Object *object,
+                                      ULong sector)
+{
+    UInt                        i;
+
+    for (i = 0; i < object->cacheLines; i++) {
+        if ((object->cacheState[i] & CACHE_VALID) &&
+            (object->cacheSector[i] == sector)) {
+            return (i);
+        }
+    }
+
+    return (-1);
+}
+
+/*
+ *  ======== USBMSCHFatFsTiva_cacheFlush ========
+ *  Writes all dirty lines of the sector cache back to the drive.
+ *
+ *  @return 0 on success
+ */
+static Long USBMSCHFatFsTiva_cacheFlush(USBMSCHFatFsTiva_Object *object,
+                                       USBMSCHFatFsTiva_HWAttrs const *hwAttrs)
+{
+    UInt                        i;
+    Long                        driveWrite = 0;
+
+    for (i = 0; i < object->cacheLines; i++) {
+        if (USBMSCHFatFsTiva_cacheWriteBack(object, hwAttrs, i) != 0) {
+            driveWrite = -1;
+        }
+    }
+
+    return (driveWrite);
+}
+
+/*
+ *  ======== USBMSCHFatFsTiva_cacheWriteBack ========
+ *  Writes a line of the sector cache back to the drive if it is dirty.
+ *
+ *  @return 0 on success
+ */
+static Long USBMSCHFatFsTiva_cacheWriteBack(USBMSCHFatFsTiva_Object *object,
+                                       USBMSCHFatFsTiva_HWAttrs const *hwAttrs,
+                                       UInt line)
+{
+    Long                        driveWrite;
+
+    if (!(object->cacheState[line] & CACHE_DIRTY)) {
+        return (0);
+    }
+
+    /* Never write a line of a device that has gone to the next one */
+    if (object->cacheGeneration != object->generation) {
+        return (-1);
+    }
+
+    driveWrite = USBMSCHFatFsTiva_blockWrite(object,
+                                  hwAttrs->cacheBuf + (line * SECTOR_SIZE),
+                                  object->cacheSector[line], 1);
+    if (driveWrite == 0) {
+        object->cacheState[line] &= ~CACHE_DIRTY;
+    }
+
+    return (driveWrite);
+}
+
+#if defined(TIVAWARE)
+/*
+ *  ======== USBMSCHFatFsTiva_cbHubHandler ========
+ *  Callback handler for the USB hub class driver.
+ *
+ *  Devices behind the hub are enumerated by the USB library; the MSC class
+ *  driver reports the drive to USBMSCHFatFsTiva_cbMSCHandler.
+ */
+static Void USBMSCHFatFsTiva_cbHubHandler(tHubInstance *hubInstance,
+                                          uint32_t event,
+                                          uint32_t msgParam,
+                                          Void *msgData)
+{
+    Log_print2(Diags_USER2, "USBMSCHFatFs: hub event 0x%x, param %d",
+                            event, msgParam);
+}
+#endif
+
 /*
  *  ======== USBMSCHFatFsTiva_cbMSCHandler ========
  *  Callback handler for the USB stack.
@@ -142,11 +471,21 @@ static Void USBMSCHFatFsTiva_cbMSCHandler(USBMSCType instance,
                                           USBMSCEventType event,
                                           Void *eventMsgPtr)
 {
-    USBMSCHFatFsTiva_Object    *object = USBMSCHFatFs_config->object;
+    USBMSCHFatFsTiva_Object    *object;
+
+    /* Ignore events of an instance that is being closed */
+    if (host.mscHandle == NULL) {
+        return;
+    }
+    object = host.mscHandle->object;
+    if (object->MSCInstance != instance) {
+        return;
+    }
 
     /* Determine what event has happened */
     switch (event) {
         case MSC_EVENT_OPEN:
+            object->generation++;
             object->state = USBMSCHFatFsTiva_CONNECTED;
             Log_print0(Diags_USER2, "USBMSCHFatFs: MSC DEVICE CONNECTED; "
                                     "Posting semUSBConnected");
@@ -155,6 +494,12 @@ static Void USBMSCHFatFsTiva_cbMSCHandler(USBMSCType instance,
 
         case MSC_EVENT_CLOSE:
             object->state = USBMSCHFatFsTiva_NO_DEVICE;
+
+            /*
+             * The cached sectors belong to the drive that has gone. The disk
+             * functions drop them under gateDiskAccess.
+             */
+            object->generation++;
             Log_print0(Diags_USER2, "USBMSCHFatFs: MSC DEVICE DISCONNECTED");
             break;
 
@@ -183,14 +528,14 @@ static DSTATUS USBMSCHFatFsTiva_diskInitialize(UChar drv)
     UInt                        i;
     UInt                        key;
     UInt                        driveReady;
-    USBMSCHFatFsTiva_Object    *object = USBMSCHFatFs_config->object;
+    USBMSCHFatFsTiva_Object    *object = drives[drv]->object;
 
     /* Determine if the USB Drive is ready up to 10 times */
     for (i = 0; i < 10; i++ ) {
 
-        key = GateMutex_enter(GateMutex_handle(&(object->gateUSBLibAccess)));
+        key = GateMutex_enter(GateMutex_handle(&(host.gateUSBLibAccess)));
         driveReady = USBHMSCDriveReady(object->MSCInstance);
-        GateMutex_leave(GateMutex_handle(&(object->gateUSBLibAccess)), key);
+        GateMutex_leave(GateMutex_handle(&(host.gateUSBLibAccess)), key);
 
         if (driveReady == 0) {
             Log_print1(Diags_USER1, "USBMSCHFatFs: disk initialization: "
@@ -218,7 +563,10 @@ static DSTATUS USBMSCHFatFsTiva_diskInitialize(UChar drv)
  */
 static DRESULT USBMSCHFatFsTiva_diskIOctl(UChar drv, UChar ctrl, Void *buf)
 {
-    USBMSCHFatFsTiva_Object    *object = USBMSCHFatFs_config->object;
+    UInt                        key;
+    Long                        driveWrite;
+    USBMSCHFatFsTiva_Object    *object = drives[drv]->object;
+    USBMSCHFatFsTiva_HWAttrs const *hwAttrs = drives[drv]->hwAttrs;
 
     if (object->state != USBMSCHFatFsTiva_CONNECTED) {
         Log_print0(Diags_USER1, "USBMSCHFatFs: disk IO control: not "
@@ -229,6 +577,18 @@ static DRESULT USBMSCHFatFsTiva_diskIOctl(UChar drv, UChar ctrl, Void *buf)
 
     switch (ctrl) {
         case CTRL_SYNC:
+            /* Write the sector cache back */
+            key = GateMutex_enter(GateMutex_handle(&(object->gateDiskAccess)));
+            USBMSCHFatFsTiva_cacheCheck(object);
+            driveWrite = USBMSCHFatFsTiva_cacheFlush(object, hwAttrs);
+            GateMutex_leave(GateMutex_handle(&(object->gateDiskAccess)), key);
+
+            if (driveWrite != 0) {
+                Log_print0(Diags_USER1, "USBMSCHFatFs: disk IO control: "
+                                        "sync error");
+                return (RES_ERROR);
+            }
+
             Log_print0(Diags_USER1, "USBMSCHFatFs: disk IO control: OK");
             return (RES_OK);
 
@@ -254,9 +614,12 @@ static DRESULT USBMSCHFatFsTiva_diskIOctl(UChar drv, UChar ctrl, Void *buf)
 static DRESULT USBMSCHFatFsTiva_diskRead(UChar drv, UChar *buf,
                                               ULong sector, UChar count)
 {
+    UInt                        i;
     UInt                        key;
+    Int                         line;
     Long                        driveRead;
-    USBMSCHFatFsTiva_Object    *object = USBMSCHFatFs_config->object;
+    USBMSCHFatFsTiva_Object    *object = drives[drv]->object;
+    USBMSCHFatFsTiva_HWAttrs const *hwAttrs = drives[drv]->hwAttrs;
 
     Log_print2(Diags_USER1, "USBMSCHFatFs: diskRead: Sector %d, Count %d",
                              sector, count);
@@ -266,10 +629,37 @@ static DRESULT USBMSCHFatFsTiva_diskRead(UChar drv, UChar *buf,
         return (RES_NOTRDY);
     }
 
-    /* READ BLOCK */
-    key = GateMutex_enter(GateMutex_handle(&(object->gateUSBLibAccess)));
-    driveRead = USBHMSCBlockRead(object->MSCInstance, sector, buf, count);
-    GateMutex_leave(GateMutex_handle(&(object->gateUSBLibAccess)), key);
+    key = GateMutex_enter(GateMutex_handle(&(object->gateDiskAccess)));
+    USBMSCHFatFsTiva_cacheCheck(object);
+
+    if ((count == 1) && (object->cacheLines != 0)) {
+        /* Single sectors go through the sector cache */
+        line = USBMSCHFatFsTiva_cacheFind(object, sector);
+        if (line < 0) {
+            line = USBMSCHFatFsTiva_cacheFill(object, hwAttrs, sector);
+        }
+
+        driveRead = -1;
+        if (line >= 0) {
+            memcpy(buf, hwAttrs->cacheBuf + (line * SECTOR_SIZE), SECTOR_SIZE);
+            driveRead = 0;
+        }
+    }
+    else {
+        /* READ BLOCK */
+        driveRead = USBMSCHFatFsTiva_blockRead(object, buf, sector, count);
+
+        /* Cached sectors may be newer than the drive's copy */
+        for (i = 0; (driveRead == 0) && (i < object->cacheLines); i++) {
+            if ((object->cacheState[i] & CACHE_VALID) &&
+                (object->cacheSector[i] - sector < count)) {
+                memcpy(buf + ((object->cacheSector[i] - sector) * SECTOR_SIZE),
+                       hwAttrs->cacheBuf + (i * SECTOR_SIZE), SECTOR_SIZE);
+            }
+        }
+    }
+
+    GateMutex_leave(GateMutex_handle(&(object->gateDiskAccess)), key);
 
     if (driveRead == 0) {
         Log_print0(Diags_USER2, "USBMSCHFatFs: diskRead: OK");
@@ -289,7 +679,7 @@ static DRESULT USBMSCHFatFsTiva_diskRead(UChar drv, UChar *buf,
  */
 static DSTATUS USBMSCHFatFsTiva_diskStatus(UChar drv)
 {
-    USBMSCHFatFsTiva_Object    *object = USBMSCHFatFs_config->object;
+    USBMSCHFatFsTiva_Object    *object = drives[drv]->object;
 
     if (object->state != USBMSCHFatFsTiva_CONNECTED) {
         Log_print0(Diags_USER1, "USBMSCHFatFs: diskStatus: not initialized");
@@ -315,9 +705,12 @@ static DSTATUS USBMSCHFatFsTiva_diskStatus(UChar drv)
 static DRESULT USBMSCHFatFsTiva_diskWrite(UChar drv, const UChar *buf,
                                           ULong sector, UChar count)
 {
+    UInt                        i;
     UInt                        key;
+    Int                         line;
     Long                        driveWrite;
-    USBMSCHFatFsTiva_Object    *object = USBMSCHFatFs_config->object;
+    USBMSCHFatFsTiva_Object    *object = drives[drv]->object;
+    USBMSCHFatFsTiva_HWAttrs const *hwAttrs = drives[drv]->hwAttrs;
 
     Log_print2(Diags_USER1, "USBMSCHFatFs: diskWrite: Sector %d, Count %d",
                              sector, count);
@@ -332,9 +725,40 @@ static DRESULT USBMSCHFatFsTiva_diskWrite(UChar drv, const UChar *buf,
         return (RES_NOTRDY);
     }
 
-    key = GateMutex_enter(GateMutex_handle(&(object->gateUSBLibAccess)));
-    driveWrite = USBHMSCBlockWrite(object->MSCInstance, sector, (UChar *)buf, count);
-    GateMutex_leave(GateMutex_handle(&(object->gateUSBLibAccess)), key);
+    key = GateMutex_enter(GateMutex_handle(&(object->gateDiskAccess)));
+    USBMSCHFatFsTiva_cacheCheck(object);
+
+    if ((count == 1) && (object->cacheLines != 0)) {
+        /* Single sectors are written back on CTRL_SYNC or when replaced */
+        line = USBMSCHFatFsTiva_cacheFind(object, sector);
+        if (line < 0) {
+            line = USBMSCHFatFsTiva_cacheAlloc(object, hwAttrs, 1);
+        }
+
+        driveWrite = -1;
+        if (line >= 0) {
+            memcpy(hwAttrs->cacheBuf + (line * SECTOR_SIZE), buf, SECTOR_SIZE);
+            object->cacheSector[line] = sector;
+            object->cacheState[line] = CACHE_VALID | CACHE_DIRTY;
+            driveWrite = 0;
+        }
+    }
+    else {
+        driveWrite = USBMSCHFatFsTiva_blockWrite(object, buf, sector, count);
+
+        /* Cached copies of the written sectors are now up to date */
+        for (i = 0; (driveWrite == 0) && (i < object->cacheLines); i++) {
+            if ((object->cacheState[i] & CACHE_VALID) &&
+                (object->cacheSector[i] - sector < count)) {
+                memcpy(hwAttrs->cacheBuf + (i * SECTOR_SIZE),
+                       buf + ((object->cacheSector[i] - sector) * SECTOR_SIZE),
+                       SECTOR_SIZE);
+                object->cacheState[i] = CACHE_VALID;
+            }
+        }
+    }
+
+    GateMutex_leave(GateMutex_handle(&(object->gateDiskAccess)), key);
 
     if (driveWrite == 0) {
         Log_print0(Diags_USER2, "USBMSCHFatFs: diskWrite: OK");
@@ -347,9 +771,100 @@ static DRESULT USBMSCHFatFsTiva_diskWrite(UChar drv, const UChar *buf,
 }
 #endif /* _READONLY */
 
+/*
+ *  ======== USBMSCHFatFsTiva_hostInit ========
+ *  Sets the USB library up for host mode, before the drive registers with
+ *  the MSC class driver.
+ */
+static Void USBMSCHFatFsTiva_hostInit(Void)
+{
+    union {
+        Semaphore_Params            semParams;
+        GateMutex_Params            gateParams;
+    } paramsUnion;
+
+    GateMutex_Params_init(&(paramsUnion.gateParams));
+    paramsUnion.gateParams.instance->name = "USB Library Access";
+    GateMutex_construct(&(host.gateUSBLibAccess), &(paramsUnion.gateParams));
+
+    /* The Hwi wakes the service task through this semaphore */
+    Semaphore_Params_init(&(paramsUnion.semParams));
+    paramsUnion.semParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&(host.semHCDService), 0, &(paramsUnion.semParams));
+
+    /* Initialize the USB stack for host mode. */
+    USBStackModeSet(0, eUSBModeHost, NULL);
+
+    /* Register host class drivers */
+    USBHCDRegisterDrivers(0, usbHCDDriverList, numHostClassDrivers);
+
+#if defined(TIVAWARE)
+    /* A drive behind a hub is enumerated through the hub class driver */
+    host.hubInstance = USBHHubOpen(USBMSCHFatFsTiva_cbHubHandler);
+#endif
+}
+
+/*
+ *  ======== USBMSCHFatFsTiva_hostStart ========
+ *  Enables the USB host controller and starts the service task, after the
+ *  drive has registered with the MSC class driver.
+ */
+static Void USBMSCHFatFsTiva_hostStart(USBMSCHFatFsTiva_HWAttrs const *hwAttrs,
+                                       USBMSCHFatFs_Params *params)
+{
+    Task_Params                 taskParams;
+
+    /* Create the Hwi object to service interrupts */
+    Hwi_construct(&(host.hwi), hwAttrs->intNum, USBMSCHFatFsTiva_hwiHandler,
+                  NULL, NULL);
+
+    /* Initialize USB power configuration */
+    USBHCDPowerConfigInit(0, USBHCD_VBUS_AUTO_HIGH | USBHCD_VBUS_FILTER);
+
+    /* Enable the USB stack */
+    USBHCDInit(0, host.memPoolHCD, sizeof(host.memPoolHCD));
+
+    /*
+     * Note that serviceUSBHost() should not be run until the USB Stack has been
+     * initialized!!
+     */
+    Task_Params_init(&taskParams);
+    taskParams.priority = params->servicePriority;
+    Task_construct(&(host.taskHCDMain), USBMSCHFatFsTiva_serviceUSBHost,
+                   &taskParams, NULL);
+}
+
+/*
+ *  ======== USBMSCHFatFsTiva_hostStop ========
+ *  Undoes USBMSCHFatFsTiva_hostInit() and USBMSCHFatFsTiva_hostStart() when
+ *  the drive is closed.
+ */
+static Void USBMSCHFatFsTiva_hostStop(Void)
+{
+    /* Delete the HCDMain service task*/
+    Task_destruct(&(host.taskHCDMain));
+
+    /* Delete the hwi */
+    Hwi_destruct(&(host.hwi));
+
+#if defined(TIVAWARE)
+    if (host.hubInstance != NULL) {
+        USBHHubClose(host.hubInstance);
+        host.hubInstance = NULL;
+    }
+#endif
+
+    /* Delete the semaphore, after the hwi that posts it */
+    Semaphore_destruct(&(host.semHCDService));
+
+    /* Delete the gate */
+    GateMutex_destruct(&(host.gateUSBLibAccess));
+}
+
 /*
  *  ======== USBMSCHFatFsTiva_hwiHandler ========
- *  This function calls the USB library's interrupt handler.
+ *  This function calls the USB library's interrupt handler and wakes the
+ *  USBMSCHFatFsTiva_serviceUSBHost task to act on what it has recorded.
  */
 static Void USBMSCHFatFsTiva_hwiHandler(UArg arg0)
 {
@@ -359,28 +874,30 @@ static Void USBMSCHFatFsTiva_hwiHandler(UArg arg0)
      */
     //USB0HostIntHandler();
     USB0OTGModeIntHandler();
+
+    Semaphore_post(Semaphore_handle(&(host.semHCDService)));
 }
 
 /*
  *  ======== USBMSCHFatFsTiva_serviceUSBHost ========
- *  Task to periodically service the USB Stack
+ *  Task to service the USB Stack
  *
  *  USBHCDMain handles the USB Stack's statemachine. For example it handles the
  *  enumeration process when a device connects.
- *  Future USB library improvement goal is to remove this polling requirement..
+ *  The USB interrupt posts semHCDService, so USBHCDMain runs as soon as the
+ *  interrupt handler has recorded an event instead of on the next poll.
  */
 static Void USBMSCHFatFsTiva_serviceUSBHost(UArg arg0, UArg arg1)
 {
     UInt                        key;
-    USBMSCHFatFsTiva_Object    *object = USBMSCHFatFs_config->object;
 
     while (TRUE) {
-        key = GateMutex_enter(GateMutex_handle(&(object->gateUSBLibAccess)));
+        key = GateMutex_enter(GateMutex_handle(&(host.gateUSBLibAccess)));
         USBHCDMain();
-        GateMutex_leave(GateMutex_handle(&(object->gateUSBLibAccess)), key);
+        GateMutex_leave(GateMutex_handle(&(host.gateUSBLibAccess)), key);
 
-        /* Future enhancement to remove the Task_sleep */
-        Task_sleep(10);
+        Semaphore_pend(Semaphore_handle(&(host.semHCDService)),
+                       USBMSCHFatFsTiva_SERVICE_TIMEOUT);
     }
 }
 
@@ -394,19 +911,35 @@ static Void USBMSCHFatFsTiva_serviceUSBHost(UArg arg0, UArg arg1)
 static Void USBMSCHFatFsTiva_usbHCDEvents(Void *cbData)
 {
     tEventInfo                 *pEventInfo = (tEventInfo *)cbData;
-    USBMSCHFatFsTiva_Object    *object = USBMSCHFatFs_config->object;
+    USBMSCHFatFsTiva_Object    *object;
+
+    if (host.mscHandle == NULL) {
+        return;
+    }
+    object = host.mscHandle->object;
 
+    /*
+     * An unknown device is only shown while the drive has no MSC device, and
+     * only its own disconnect clears it again; a power fault affects all
+     * devices.
+     */
     switch (pEventInfo->ui32Event) {
         case USB_EVENT_UNKNOWN_CONNECTED:
             /* An unknown device was detected. */
-            object->state = USBMSCHFatFsTiva_UNKNOWN;
+            if (object->state == USBMSCHFatFsTiva_NO_DEVICE) {
+                object->state = USBMSCHFatFsTiva_UNKNOWN;
+                host.unknownInstance = pEventInfo->ui32Instance;
+            }
             Log_print0(Diags_USER2, "USBMSCHFatFs: usbHCDEvent Callback: "
                                     "UNKNOWN DEVICE CONNECTED");
             break;
 
         case USB_EVENT_DISCONNECTED:
             /* Unknown device has been removed. */
-            object->state = USBMSCHFatFsTiva_NO_DEVICE;
+            if ((object->state == USBMSCHFatFsTiva_UNKNOWN) &&
+                (host.unknownInstance == pEventInfo->ui32Instance)) {
+                object->state = USBMSCHFatFsTiva_NO_DEVICE;
+            }
             Log_print0(Diags_USER2, "USBMSCHFatFs: usbHCDEvent Callback: "
                                     "UNKNOWN DEVICE DISCONNECTED");
             break;
@@ -432,6 +965,7 @@ Void USBMSCHFatFsTiva_init(USBMSCHFatFs_Handle handle)
 
     object->driveNumber = DRIVE_NOT_MOUNTED;
     object->state = USBMSCHFatFsTiva_NO_DEVICE;
+    object->cacheLines = 0;
 }
 
 /*
@@ -447,17 +981,26 @@ USBMSCHFatFs_Handle USBMSCHFatFsTiva_open(USBMSCHFatFs_Handle handle,
     USBMSCHFatFsTiva_Object        *object = handle->object;
     USBMSCHFatFsTiva_HWAttrs const *hwAttrs = handle->hwAttrs;
     union {
-        Task_Params                 taskParams;
         Semaphore_Params            semParams;
         GateMutex_Params            gateParams;
     } paramsUnion;
 
+    if (drv >= _VOLUMES) {
+        Log_error1("USBMSCHFatFs: drive %d out of range", drv);
+        return (NULL);
+    }
+
+    /* The USB library has one MSC drive instance, which this entry claims */
     key = Hwi_disable();
-    if (object->driveNumber != DRIVE_NOT_MOUNTED) {
+    if ((object->driveNumber != DRIVE_NOT_MOUNTED) || (drives[drv] != NULL) ||
+        (host.mscHandle != NULL)) {
         Hwi_restore(key);
+        Log_error1("USBMSCHFatFs: drive %d already in use", drv);
         return (NULL);
     }
     object->driveNumber = drv;
+    drives[drv] = handle;
+    host.mscHandle = handle;
     Hwi_restore(key);
 
     /* Store the USBMSCHFatFs parameters */
@@ -466,29 +1009,17 @@ USBMSCHFatFs_Handle USBMSCHFatFsTiva_open(USBMSCHFatFs_Handle handle,
         params = (USBMSCHFatFs_Params *) &USBMSCHFatFs_defaultParams;
     }
 
-    /* Initialize the USB stack for host mode. */
-    USBStackModeSet(0, eUSBModeHost, NULL);
-
-    /* Register host class drivers */
-    USBHCDRegisterDrivers(0, usbHCDDriverList, numHostClassDrivers);
-
-    /* Open an instance of the MSC host driver */
-    object->MSCInstance = USBHMSCDriveOpen(0, USBMSCHFatFsTiva_cbMSCHandler);
-    if (!(object->MSCInstance)) {
-        Log_print0(Diags_USER1,"USBMSCHFatFs: Error initializing the MSC Host");
-        USBMSCHFatFsTiva_close(handle);
-        return (NULL);
+    /* Sector cache */
+    object->cacheLines = 0;
+    if (hwAttrs->cacheBuf != NULL) {
+        object->cacheLines = hwAttrs->cacheSectors;
+        if (object->cacheLines > USBMSCHFatFsTiva_CACHE_LINES) {
+            object->cacheLines = USBMSCHFatFsTiva_CACHE_LINES;
+        }
     }
-
-    /* Create the Hwi object to service interrupts */
-   Hwi_construct(&(object->hwi), hwAttrs->intNum, USBMSCHFatFsTiva_hwiHandler,
-                 NULL, NULL);
-
-    /* Initialize USB power configuration */
-    USBHCDPowerConfigInit(0, USBHCD_VBUS_AUTO_HIGH | USBHCD_VBUS_FILTER);
-
-    /* Enable the USB stack */
-    USBHCDInit(0, object->memPoolHCD, HCDMEMORYPOOLSIZE);
+    object->cacheNext = 0;
+    object->cacheGeneration = object->generation;
+    memset(object->cacheState, 0, sizeof(object->cacheState));
 
     /* RTOS primitives */
     Semaphore_Params_init(&(paramsUnion.semParams));
@@ -496,20 +1027,30 @@ USBMSCHFatFs_Handle USBMSCHFatFsTiva_open(USBMSCHFatFs_Handle handle,
     Semaphore_construct(&(object->semUSBConnected), 0, &(paramsUnion.semParams));
 
     GateMutex_Params_init(&(paramsUnion.gateParams));
-    paramsUnion.gateParams.instance->name = "USB Library Access";
-    GateMutex_construct(&(object->gateUSBLibAccess), &(paramsUnion.gateParams));
-
     paramsUnion.gateParams.instance->name = "USB Wait";
     GateMutex_construct(&(object->gateUSBWait), &(paramsUnion.gateParams));
 
+    paramsUnion.gateParams.instance->name = "USB Disk Access";
+    GateMutex_construct(&(object->gateDiskAccess), &(paramsUnion.gateParams));
+
     /*
-     * Note that serviceUSBHost() should not be run until the USB Stack has been
-     * initialized!!
+     * Set up the USB host stack for this drive. The host is started even if
+     * the MSC instance cannot be opened, USBMSCHFatFsTiva_close() stops it.
      */
-    Task_Params_init(&(paramsUnion.taskParams));
-    paramsUnion.taskParams.priority = params->servicePriority;
-    Task_construct(&(object->taskHCDMain),USBMSCHFatFsTiva_serviceUSBHost,
-                   &(paramsUnion.taskParams), NULL);
+    USBMSCHFatFsTiva_hostInit();
+
+    /* Open an instance of the MSC host driver */
+    key = GateMutex_enter(GateMutex_handle(&(host.gateUSBLibAccess)));
+    object->MSCInstance = USBHMSCDriveOpen(0, USBMSCHFatFsTiva_cbMSCHandler);
+    GateMutex_leave(GateMutex_handle(&(host.gateUSBLibAccess)), key);
+
+    USBMSCHFatFsTiva_hostStart(hwAttrs, params);
+
+    if (!(object->MSCInstance)) {
+        Log_print0(Diags_USER1,"USBMSCHFatFs: Error initializing the MSC Host");
+        USBMSCHFatFsTiva_close(handle);
+        return (NULL);
+    }
 
     /* Register the new disk_*() functions */
     dresult = disk_register(drv,
@@ -545,9 +1086,22 @@ USBMSCHFatFs_Handle USBMSCHFatFsTiva_open(USBMSCHFatFs_Handle handle,
 Void USBMSCHFatFsTiva_close(USBMSCHFatFs_Handle handle)
 {
     UInt                        key;
+    Long                        driveWrite;
     DRESULT                     dresult;
     FRESULT                     fresult;
     USBMSCHFatFsTiva_Object    *object = handle->object;
+    USBMSCHFatFsTiva_HWAttrs const *hwAttrs = handle->hwAttrs;
+
+    /* Write the sector cache back while the drive is still open */
+    key = GateMutex_enter(GateMutex_handle(&(object->gateDiskAccess)));
+    USBMSCHFatFsTiva_cacheCheck(object);
+    driveWrite = USBMSCHFatFsTiva_cacheFlush(object, hwAttrs);
+    GateMutex_leave(GateMutex_handle(&(object->gateDiskAccess)), key);
+
+    if (driveWrite != 0) {
+        Log_print0(Diags_USER1, "USBMSCHFatFs: could not write the sector "
+                                "cache back");
+    }
 
     /* Unmount the FatFs drive */
     fresult = f_mount(object->driveNumber, NULL);
@@ -555,8 +1109,17 @@ Void USBMSCHFatFsTiva_close(USBMSCHFatFs_Handle handle)
         Log_print0(Diags_USER1, "USBMSCHFatFs: could not unmount FatFs volume");
     }
 
-    /* Close USB Drive */
-    USBHMSCDriveClose(object->MSCInstance);
+    /*
+     * Close USB Drive. The service task runs the MSC callbacks with the gate
+     * held, so they do not see this drive any more afterwards.
+     */
+    key = GateMutex_enter(GateMutex_handle(&(host.gateUSBLibAccess)));
+    if (object->MSCInstance) {
+        USBHMSCDriveClose(object->MSCInstance);
+        object->MSCInstance = 0;
+    }
+    drives[object->driveNumber] = NULL;
+    GateMutex_leave(GateMutex_handle(&(host.gateUSBLibAccess)), key);
 
     /* Unregister the disk_*() functions */
     dresult = disk_unregister(object->driveNumber);
@@ -565,26 +1128,24 @@ Void USBMSCHFatFsTiva_close(USBMSCHFatFs_Handle handle)
                                 "functions");
     }
 
-    /* Delete the HCDMain service task*/
-    Task_destruct(&(object->taskHCDMain));
-
     /* Delete the semaphore */
     Semaphore_destruct(&(object->semUSBConnected));
 
     /* Delete the gate */
-    GateMutex_destruct(&(object->gateUSBLibAccess));
+    GateMutex_destruct(&(object->gateUSBWait));
 
     /* Delete the gate */
-    GateMutex_destruct(&(object->gateUSBWait));
+    GateMutex_destruct(&(object->gateDiskAccess));
 
-    /* Delete the hwi */
-    Hwi_destruct(&(object->hwi));
+    /* Stop the USB host stack */
+    USBMSCHFatFsTiva_hostStop();
 
     Log_print1(Diags_USER1, "USBMSCHFatFs: drive %d closed",
                              object->driveNumber);
 
     key = Hwi_disable();
     object->driveNumber = DRIVE_NOT_MOUNTED;
+    host.mscHandle = NULL;
     Hwi_restore(key);
 }
 
@@ -43,8 +43,23 @@
  *  @endcode
  *
  *  This USBMSCHFatFs driver implementation is designed to operate with a
- *  Tiva' USB library. Only 1 instance of the USBMSCHFatFsTiva driver
- *  is supported.
+ *  Tiva' USB library. The USB library's MSC class driver (usbhmsc.c) has a
+ *  single drive instance, so only one USBMSCHFatFs_config entry can be open
+ *  at a time; opening a second one fails. With TivaWare, the drive can be
+ *  attached through a USB hub.
+ *
+ *  Transfers are split into bursts of at most USBMSCHFatFsTiva_MAX_BURST
+ *  sectors. The USB library is only locked for one burst at a time, so the
+ *  USB host service task keeps handling events during a large transfer.
+ *  The USB library moves bulk data with uDMA when the board has set up the
+ *  uDMA control table before the driver is opened.
+ *
+ *  Single sector accesses, such as the FatFs FAT and directory accesses, can
+ *  be served from an optional sector cache. It is enabled by pointing
+ *  USBMSCHFatFsTiva_HWAttrs.cacheBuf to a word aligned buffer of
+ *  cacheSectors * 512 bytes. A miss reads the following sectors ahead into
+ *  the cache as well. Writes stay in the cache until FatFs syncs the volume,
+ *  for example on f_sync() or f_close(), or until the line is reused.
  *
  *  ============================================================================
  */
@@ -79,6 +94,9 @@ typedef ULong               USBMSCType;
 /* Memory for the Host Class Driver */
 #define HCDMEMORYPOOLSIZE   128
 
+/* Largest number of sectors the sector cache uses */
+#define USBMSCHFatFsTiva_CACHE_LINES    8
+
 /* USBMSCHFatFs function table */
 extern const USBMSCHFatFs_FxnTable USBMSCHFatFsTiva_fxnTable;
 
@@ -106,6 +124,14 @@ typedef enum USBMSCHFatFsTiva_USBState {
  */
 typedef struct USBMSCHFatFsTiva_HWAttrs {
     Int                 intNum;             /*!< USB interrupt vector */
+    UChar              *cacheBuf;           /*!<
+                                             *   Sector cache of cacheSectors
+                                             *   * 512 bytes, or NULL
+                                             */
+    UInt                cacheSectors;       /*!<
+                                             *   Sectors in cacheBuf, up to
+                                             *   USBMSCHFatFsTiva_CACHE_LINES
+                                             */
 } USBMSCHFatFsTiva_HWAttrs;
 
 /*!
@@ -116,14 +142,19 @@ typedef struct USBMSCHFatFsTiva_HWAttrs {
 typedef struct USBMSCHFatFsTiva_Object {
     UInt                driveNumber;        /*!< Drive number used by FatFs */
     USBMSCHFatFsTiva_USBState volatile state; /*!< USB state */
-    ti_sysbios_family_arm_m3_Hwi_Struct hwi; /*!< Hwi handle */
-    Task_Struct         taskHCDMain;        /*!< Task handle */
     GateMutex_Struct    gateUSBWait;        /*!< Gate handle */
-    GateMutex_Struct    gateUSBLibAccess;   /*!< Gate handle */
+    GateMutex_Struct    gateDiskAccess;     /*!< Serializes disk I/O */
     Semaphore_Struct    semUSBConnected;    /*!< Semaphore handle */
     USBMSCType          MSCInstance;        /*!< USB MSC instance handle */
-    UChar               memPoolHCD[HCDMEMORYPOOLSIZE]; /* MSC memory buffer */
     FATFS               filesystem;         /*!< FATFS data object */
+
+    /* Sector cache */
+    UInt                cacheLines;         /*!< Lines in use */
+    UInt                cacheNext;          /*!< Next line to replace */
+    UInt volatile       generation;         /*!< Bumped on device changes */
+    UInt                cacheGeneration;    /*!< generation of the lines */
+    ULong               cacheSector[USBMSCHFatFsTiva_CACHE_LINES]; /*!< Sector of each line */
+    UChar               cacheState[USBMSCHFatFsTiva_CACHE_LINES]; /*!< Line state */
 } USBMSCHFatFsTiva_Object, *USBMSCHFatFsTiva_Handle;
 
 /* Do not interfere with the app if they include the family Hwi module */
@@ -35,11 +35,12 @@
 #include <xdc/runtime/Diags.h>
 #include <xdc/runtime/Error.h>
 #include <xdc/runtime/Log.h>
-#include <xdc/runtime/Types.h>
 
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
 
 #include <ti/drivers/SPI.h>
 
@@ -66,6 +67,9 @@
 #define SPI_HEADER_SIZE      (5)
 #define HEADERS_SIZE_EVNT    (SPI_HEADER_SIZE + 5)
 
+/* Time CS must be held around the first write after power up */
+#define FIRST_WRITE_DELAY_US 50
+
 /*
  *  The magic number that resides at the end of the TX/RX buffer (1 byte after
  *  the allocated size) for the purpose of detection of the overrun. The
@@ -93,9 +97,13 @@ static WiFi_Handle WiFiMSP430CC3000_open(WiFi_Handle handle, UInt spiIndex,
                                          WiFi_Params *params);
 static Void WiFiMSP430CC3000_readHeader(Void);
 static Long WiFiMSP430CC3000_readIrqPin(Void);
+static Void WiFiMSP430CC3000_sleepUs(UInt32 usecs);
 static Void WiFiMSP430CC3000_spiCallbackFxn(SPI_Handle spiHandle,
                                             SPI_Transaction *transaction);
 static Void WiFiMSP430CC3000_triggerRxProcessing(Void);
+static Bool WiFiMSP430CC3000_txOverrun(Void);
+static Void WiFiMSP430CC3000_waitWrite(Void);
+static Void WiFiMSP430CC3000_write(UChar *userBuffer, UShort length, Bool wait);
 static Void WiFiMSP430CC3000_writeWlanEnPin(UChar val);
 
 /* CC3000 function table for MSP430 implementation */
@@ -113,6 +121,7 @@ extern const WiFi_Params WiFi_defaultParams;
  *  code based on your project's configuration file.
  */
 extern const Int WiFi_TX_BUFFER_SIZE;
+extern const Int WiFi_TX_BUFFER_COUNT;
 extern const Int WiFi_RX_BUFFER_SIZE;
 
 /*
@@ -138,8 +147,9 @@ static Void WiFiMSP430CC3000_close(WiFi_Handle handle)
         SPI_close(object->spiHandle);
     }
 
-    /* Delete the semaphore */
+    /* Delete the semaphores */
     Semaphore_destruct(&(object->writeComplete));
+    Semaphore_destruct(&(object->stateChange));
 
     Log_print0(Diags_USER1, "WiFi: Object closed.");
 
@@ -177,29 +187,22 @@ static Void WiFiMSP430CC3000_enableIrqInt(Void)
 /*
  *  ======== WiFiMSP430CC3000_firstWrite ========
  *  Function to perform the first write after power up. CC3000 requires a few
- *  50 us delays during this first transaction.
+ *  50 us delays during this first transaction. The task sleeps through them
+ *  rather than spinning.
  */
 Void WiFiMSP430CC3000_firstWrite(UChar *userBuffer, UShort length)
 {
-    UInt            delayAmt;
-    UInt volatile   i;
-    Types_FreqHz    freq;
     WiFiMSP430CC3000_Object        *object  = wiFiHandle->object;
     WiFiMSP430CC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
 
     Log_print0(Diags_USER1, "WiFi: Performing first write to CC3000 after "
                             "wlan_start().");
 
-    /* Calculate delay amount */
-    BIOS_getCpuFreq(&freq);
-    delayAmt = freq.lo/60000;
-
     /* Assert CS */
     GPIO_setOutputLowOnPin(hwAttrs->csPort, hwAttrs->csPin);
 
     /* Need to wait at least 50 us after asserting CS */
-    for (i = delayAmt; i > 0; i--) {
-    }
+    WiFiMSP430CC3000_sleepUs(FIRST_WRITE_DELAY_US);
 
     /* SPI writes first 4 bytes of data */
     object->transaction.txBuf = userBuffer;
@@ -213,8 +216,7 @@ Void WiFiMSP430CC3000_firstWrite(UChar *userBuffer, UShort length)
             BIOS_WAIT_FOREVER);
 
     /* Need to wait at least 50 us again */
-    for (i = delayAmt; i > 0; i--) {
-    }
+    WiFiMSP430CC3000_sleepUs(FIRST_WRITE_DELAY_US);
 
     /* SPI writes another 4 bytes of data */
     object->transaction.txBuf = userBuffer + 4;
@@ -243,6 +245,7 @@ Void WiFiMSP430CC3000_hwiIntFxn(UArg arg)
         if (object->spiState == STATE_POWERUP) {
             /* Wi-Fi device is powered up and ready to interact with host. */
             object->spiState = STATE_INITIALIZED;
+            Semaphore_post(Semaphore_handle(&(object->stateChange)));
             Log_print0(Diags_USER1, "WiFi: CC3000 is powered up and ready.");
         }
         else if (object->spiState == STATE_IDLE) {
@@ -310,6 +313,9 @@ static WiFi_Handle WiFiMSP430CC3000_open(WiFi_Handle handle, UInt spiIndex,
     semParams.mode = Semaphore_Mode_BINARY;
     Semaphore_construct(&(object->writeComplete), 0, &semParams);
 
+    /* Create a semaphore to block for the IRQ/SPI state machine. */
+    Semaphore_construct(&(object->stateChange), 0, &semParams);
+
     /* Set up the parameters */
     if (params == NULL) {
         /* No params passed in, so use the defaults */
@@ -456,6 +462,16 @@ static Long WiFiMSP430CC3000_readIrqPin(Void)
     return (GPIO_getInputPinValue(hwAttrs->irqPort, hwAttrs->irqPin));
 }
 
+/*
+ *  ======== WiFiMSP430CC3000_sleepUs ========
+ *  Block the calling task for at least usecs microseconds. The current Clock
+ *  tick may be about to expire, so one extra tick is added.
+ */
+static Void WiFiMSP430CC3000_sleepUs(UInt32 usecs)
+{
+    Task_sleep((usecs + Clock_tickPeriod - 1) / Clock_tickPeriod + 1);
+}
+
 /*
  *  ======== WiFiMSP430CC3000_spiCallbackFxn ========
  *  Called by the SPI driver when a transmit has completed.
@@ -519,10 +535,136 @@ static Void WiFiMSP430CC3000_triggerRxProcessing(Void)
                             "Calling receive handler.");
 
     object->spiState = STATE_IDLE;
+    Semaphore_post(Semaphore_handle(&(object->stateChange)));
     object->spiRxHandler(wlan_rx_buffer + SPI_HEADER_SIZE);
     object->transaction.rxBuf = wlan_rx_buffer;
 }
 
+/*
+ *  ======== WiFiMSP430CC3000_txOverrun ========
+ *  Check the overrun markers at the end of each of the TX buffers.
+ */
+static Bool WiFiMSP430CC3000_txOverrun(Void)
+{
+    Int i;
+
+    for (i = 1; i <= WiFi_TX_BUFFER_COUNT; i++) {
+        if (wlan_tx_buffer[(i * WiFi_TX_BUFFER_SIZE) - 1] !=
+            WiFi_BUF_OVERRUN_DETECT) {
+            return (TRUE);
+        }
+    }
+
+    return (FALSE);
+}
+
+/*
+ *  ======== WiFiMSP430CC3000_waitWrite ========
+ *  Wait for a write started by SpiWriteAsync() to be clocked out.
+ */
+static Void WiFiMSP430CC3000_waitWrite(Void)
+{
+    WiFiMSP430CC3000_Object *object = wiFiHandle->object;
+
+    if (object->writePending) {
+        Semaphore_pend(Semaphore_handle(&(object->writeComplete)),
+                BIOS_WAIT_FOREVER);
+        object->writePending = FALSE;
+    }
+}
+
+/*
+ *  ======== WiFiMSP430CC3000_write ========
+ *  Write a packet to the CC3000. A write started with wait set to FALSE is
+ *  completed by the next write or by SpiClose().
+ */
+static Void WiFiMSP430CC3000_write(UChar *userBuffer, UShort length, Bool wait)
+{
+    UChar padByte = 0;
+    WiFiMSP430CC3000_Object        *object  = wiFiHandle->object;
+    WiFiMSP430CC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
+
+    /* Make sure WiFi is open */
+    Assert_isTrue(object->isOpen == TRUE, NULL);
+
+    /* Only one write can be on the wire; finish a posted one first */
+    WiFiMSP430CC3000_waitWrite();
+
+    /* Add a padding bit if necessary to make everything 16-bit aligned */
+    if (!(length & 0x0001)) {
+        padByte = 1;
+    }
+
+    userBuffer[0] = WRITE_OPCODE;
+    userBuffer[1] = HI(length + padByte);
+    userBuffer[2] = LO(length + padByte);
+    userBuffer[3] = 0;
+    userBuffer[4] = 0;
+
+    length += (SPI_HEADER_SIZE + padByte);
+
+    /*
+     *  The magic number that resides at the end of the TX/RX buffer (1 byte
+     *  after the allocated size) for the purpose of detection of the overrun.
+     *  If the magic number is overwritten - buffer overrun for the purpose of
+     *  detection of the overrun. If the magic number is overwritten, buffer
+     *  overrun occurred.
+     */
+    if (WiFiMSP430CC3000_txOverrun()) {
+        Log_error0("WiFi: Transfer buffer overrun. Closing CC3000.");
+        WiFiMSP430CC3000_close(wiFiHandle);
+        return;
+    }
+
+    if (object->spiState == STATE_POWERUP) {
+        /* Wait for CC3000 to assert IRQ line. The IRQ Hwi posts stateChange */
+        while (object->spiState != STATE_INITIALIZED) {
+            Semaphore_pend(Semaphore_handle(&(object->stateChange)),
+                    BIOS_WAIT_FOREVER);
+        }
+    }
+
+    if (object->spiState == STATE_INITIALIZED) {
+        /* IRQ line has been asserted and CC3000 is ready */
+        WiFiMSP430CC3000_firstWrite(userBuffer, length);
+    }
+    else {
+        /*
+         *  This is needed in the case where an IRQ interrupt for a read occurs
+         *  as the host device is preparing to perform a write. Must wait until
+         *  the state returns to IDLE, which the end of the read signals
+         *  through stateChange.
+         */
+        GPIO_disableInterrupt(hwAttrs->irqPort, hwAttrs->irqPin);
+        while (object->spiState != STATE_IDLE) {
+            Semaphore_pend(Semaphore_handle(&(object->stateChange)),
+                    BIOS_WAIT_FOREVER);
+        }
+
+        /* Prepare for a write */
+        object->spiState = STATE_WRITE_EOT;
+        object->transaction.txBuf = userBuffer;
+        object->transaction.count = length;
+
+        /* Assert CS line. There will be an IRQ when CC3000 is ready. */
+        GPIO_setOutputLowOnPin(hwAttrs->csPort, hwAttrs->csPin);
+        GPIO_enableInterrupt(hwAttrs->irqPort, hwAttrs->irqPin);
+    }
+
+    if (wait) {
+        /* Block until write has finished. SPI callback will post semaphore. */
+        Semaphore_pend(Semaphore_handle(&(object->writeComplete)),
+                BIOS_WAIT_FOREVER);
+
+        Log_print0(Diags_USER2, "WiFi: Write transaction to CC3000 has "
+                                "completed.");
+    }
+    else {
+        /* The SPI callback's post is collected by the next write */
+        object->writePending = TRUE;
+    }
+}
+
 /*
  *  ======== WiFiMSP430CC3000_writeWlanEnPin ========
  *  Callback for host driver. Registered with wlan_init() and called by
@@ -559,6 +701,11 @@ Void SpiClose(Void)
     Assert_isTrue(object->isOpen == TRUE, NULL);
 #endif
 
+    /* Let a posted write finish, unless closing from interrupt context */
+    if (BIOS_getThreadType() == BIOS_ThreadType_Task) {
+        WiFiMSP430CC3000_waitWrite();
+    }
+
     /* Disable IRQ Interrupt */
     GPIO_disableInterrupt(hwAttrs->irqPort, hwAttrs->irqPin);
 
@@ -572,6 +719,7 @@ Void SpiClose(Void)
  */
 Void SpiOpen(RxHandlerFxn rxHandler)
 {
+    Int                             i;
     WiFiMSP430CC3000_Object        *object  = wiFiHandle->object;
     WiFiMSP430CC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
 
@@ -580,6 +728,9 @@ Void SpiOpen(RxHandlerFxn rxHandler)
 
     object->spiState = STATE_POWERUP;
     object->spiRxHandler = rxHandler;
+    Semaphore_reset(Semaphore_handle(&(object->stateChange)), 0);
+    Semaphore_reset(Semaphore_handle(&(object->writeComplete)), 0);
+    object->writePending = FALSE;
 
     /* Initialize transaction structure */
     object->transaction.count = 0;
@@ -587,7 +738,9 @@ Void SpiOpen(RxHandlerFxn rxHandler)
     object->transaction.txBuf = NULL;
 
     wlan_rx_buffer[WiFi_RX_BUFFER_SIZE - 1] = WiFi_BUF_OVERRUN_DETECT;
-    wlan_tx_buffer[WiFi_TX_BUFFER_SIZE - 1] = WiFi_BUF_OVERRUN_DETECT;
+    for (i = 1; i <= WiFi_TX_BUFFER_COUNT; i++) {
+        wlan_tx_buffer[(i * WiFi_TX_BUFFER_SIZE) - 1] = WiFi_BUF_OVERRUN_DETECT;
+    }
 
     /* Enable interrupts on IRQ */
     GPIO_clearInterruptFlag(hwAttrs->irqPort, hwAttrs->irqPin);
@@ -616,72 +769,16 @@ Void SpiResumeSpi(Void)
  */
 Void SpiWrite(UChar *userBuffer, UShort length)
 {
-    UChar padByte = 0;
-    WiFiMSP430CC3000_Object        *object  = wiFiHandle->object;
-    WiFiMSP430CC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
-
-    /* Make sure WiFi is open */
-    Assert_isTrue(object->isOpen == TRUE, NULL);
-
-    /* Add a padding bit if necessary to make everything 16-bit aligned */
-    if (!(length & 0x0001)) {
-        padByte = 1;
-    }
-
-    userBuffer[0] = WRITE_OPCODE;
-    userBuffer[1] = HI(length + padByte);
-    userBuffer[2] = LO(length + padByte);
-    userBuffer[3] = 0;
-    userBuffer[4] = 0;
-
-    length += (SPI_HEADER_SIZE + padByte);
-
-    /*
-     *  The magic number that resides at the end of the TX/RX buffer (1 byte
-     *  after the allocated size) for the purpose of detection of the overrun.
-     *  If the magic number is overwritten - buffer overrun for the purpose of
-     *  detection of the overrun. If the magic number is overwritten, buffer
-     *  overrun occurred.
-     */
-    if (wlan_tx_buffer[WiFi_TX_BUFFER_SIZE - 1] != WiFi_BUF_OVERRUN_DETECT) {
-        Log_error0("WiFi: Transfer buffer overrun. Closing CC3000.");
-        WiFiMSP430CC3000_close(wiFiHandle);
-        return;
-    }
-
-    if (object->spiState == STATE_POWERUP) {
-        /* Wait for CC3000 to assert IRQ line */
-        while(object->spiState != STATE_INITIALIZED) {
-        }
-    }
-
-    if (object->spiState == STATE_INITIALIZED) {
-        /* IRQ line has been asserted and CC3000 is ready */
-        WiFiMSP430CC3000_firstWrite(userBuffer, length);
-    }
-    else {
-        /*
-         *  This is needed in the case where an IRQ interrupt for a read occurs
-         *  as the host device is preparing to perform a write. Must wait until
-         *  the state returns to IDLE.
-         */
-        GPIO_disableInterrupt(hwAttrs->irqPort, hwAttrs->irqPin);
-        while(object->spiState != STATE_IDLE) {
-        }
-
-        /* Prepare for a write */
-        object->spiState = STATE_WRITE_EOT;
-        object->transaction.txBuf = userBuffer;
-        object->transaction.count = length;
-
-        /* Assert CS line. There will be an IRQ when CC3000 is ready. */
-        GPIO_setOutputLowOnPin(hwAttrs->csPort, hwAttrs->csPin);
-        GPIO_enableInterrupt(hwAttrs->irqPort, hwAttrs->irqPin);
-    }
-
-    /* Block until write has finished. SPI callback will post semaphore. */
-    Semaphore_pend(Semaphore_handle(&(object->writeComplete)),
-            BIOS_WAIT_FOREVER);
+    WiFiMSP430CC3000_write(userBuffer, length, TRUE);
+}
 
-    Log_print0(Diags_USER2, "WiFi: Write transaction to CC3000 has completed.");
+/*
+ *  ======== SpiWriteAsync ========
+ *  Like SpiWrite() but returns once the write has started, so the HCI layer
+ *  can format the next packet into another TX buffer meanwhile. userBuffer
+ *  must not be modified until the next SPI write begins.
+ */
+Void SpiWriteAsync(UChar *userBuffer, UShort length)
+{
+    WiFiMSP430CC3000_write(userBuffer, length, FALSE);
 }
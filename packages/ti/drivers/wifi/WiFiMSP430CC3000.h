@@ -218,10 +218,12 @@ typedef struct WiFiMSP430CC3000_HWAttrs {
  */
 typedef struct WiFiMSP430CC3000_Object {
     Semaphore_Struct       writeComplete;   /* Indicates a write has finished */
+    Semaphore_Struct       stateChange;     /* IRQ/SPI reached a new state */
     SPI_Handle             spiHandle;       /* Handle for SPI module */
     RxHandlerFxn           spiRxHandler;    /* Host Driver's receive handler */
     WiFiMSP430CC3000_State volatile spiState; /* State of transfer layer */
     SPI_Transaction        transaction;     /* Transaction for SPI_transfer */
+    Bool                   writePending;    /* SpiWriteAsync() in flight */
     Bool                   isOpen;          /* Flag to indicate module is open */
 } WiFiMSP430CC3000_Object;
 
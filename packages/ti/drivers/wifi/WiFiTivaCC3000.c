@@ -35,11 +35,12 @@
 #include <xdc/runtime/Diags.h>
 #include <xdc/runtime/Error.h>
 #include <xdc/runtime/Log.h>
-#include <xdc/runtime/Types.h>
 
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/family/arm/m3/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
 
 #include <ti/drivers/SPI.h>
 #include <ti/drivers/spi/SPITivaDMA.h>
@@ -54,7 +55,6 @@
 
 /* driverlib header files */
 #include <driverlib/gpio.h>
-#include <driverlib/sysctl.h>
 
 /* SPI layer header opcodes */
 #define READ_OPCODE          3
@@ -68,6 +68,9 @@
 #define SPI_HEADER_SIZE      (5)
 #define HEADERS_SIZE_EVNT    (SPI_HEADER_SIZE + 5)
 
+/* Time CS must be held around the first write after power up */
+#define FIRST_WRITE_DELAY_US 50
+
 /*
  *  The magic number that resides at the end of the TX/RX buffer (1 byte after
  *  the allocated size) for the purpose of detection of the overrun. The
@@ -105,9 +108,14 @@ WiFi_Handle WiFiTivaCC3000_open(WiFi_Handle handle, UInt spiIndex,
                                 WiFi_Params *params);
 static Void WiFiTivaCC3000_readHeader(Void);
 static Long WiFiTivaCC3000_readIrqPin(Void);
+static Bool WiFiTivaCC3000_readUserNext(Void);
+static Void WiFiTivaCC3000_sleepUs(UInt32 usecs);
 static Void WiFiTivaCC3000_spiCallbackFxn(SPI_Handle spiHandle,
                                                SPI_Transaction *transaction);
 static Void WiFiTivaCC3000_triggerRxProcessing(Void);
+static Bool WiFiTivaCC3000_txOverrun(Void);
+static Void WiFiTivaCC3000_waitWrite(Void);
+static Void WiFiTivaCC3000_write(UChar *userBuffer, UShort length, Bool wait);
 static Void WiFiTivaCC3000_writeWlanEnPin(UChar val);
 
 /* CC3000 function table for Tiva implementation */
@@ -124,6 +132,7 @@ extern const WiFi_Params WiFi_defaultParams;
  *  code based on your project's configuration file.
  */
 extern const Int WiFi_TX_BUFFER_SIZE;
+extern const Int WiFi_TX_BUFFER_COUNT;
 extern const Int WiFi_RX_BUFFER_SIZE;
 
 /*
@@ -152,8 +161,9 @@ Void WiFiTivaCC3000_close(WiFi_Handle handle)
     /* Delete the IRQ Hwi */
     Hwi_destruct(&(object->hwiIrq));
 
-    /* Delete the semaphore */
+    /* Delete the semaphores */
     Semaphore_destruct(&(object->writeComplete));
+    Semaphore_destruct(&(object->stateChange));
 
     Log_print0(Diags_USER1, "WiFi: Object closed.");
 
@@ -191,27 +201,22 @@ static Void WiFiTivaCC3000_enableIrqInt(Void)
 /*
  *  ======== WiFiTivaCC3000_firstWrite ========
  *  Function to perform the first write after power up. CC3000 requires a few
- *  50 us delays during this first transaction.
+ *  50 us delays during this first transaction. The task sleeps through them
+ *  rather than spinning.
  */
 Void WiFiTivaCC3000_firstWrite(UChar *userBuffer, UShort length)
 {
-    UInt          delayAmt;
-    Types_FreqHz  freq;
     WiFiTivaCC3000_Object        *object  = wiFiHandle->object;
     WiFiTivaCC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
 
     Log_print0(Diags_USER1, "WiFi: Performing first write to CC3000 after "
                             "wlan_start().");
 
-    /* Calculate delay amount */
-    BIOS_getCpuFreq(&freq);
-    delayAmt = freq.lo/60000;
-
     /* Assert CS */
     GPIOPinWrite(hwAttrs->csPort, hwAttrs->csPin, 0);
 
     /* Need to wait at least 50 us after asserting CS */
-    SysCtlDelay(delayAmt);
+    WiFiTivaCC3000_sleepUs(FIRST_WRITE_DELAY_US);
 
     /* SPI writes first 4 bytes of data */
     object->transaction.txBuf = userBuffer;
@@ -225,7 +230,7 @@ Void WiFiTivaCC3000_firstWrite(UChar *userBuffer, UShort length)
     Semaphore_pend(Semaphore_handle(&(object->writeComplete)), BIOS_WAIT_FOREVER);
 
     /* Need to wait at least 50 us again */
-    SysCtlDelay(delayAmt);
+    WiFiTivaCC3000_sleepUs(FIRST_WRITE_DELAY_US);
 
     /* SPI writes another 4 bytes of data */
     object->transaction.txBuf = userBuffer + 4;
@@ -254,6 +259,7 @@ static Void WiFiTivaCC3000_hwiIrqFxn(UArg arg)
         if (object->spiState == STATE_POWERUP) {
             /* Wi-Fi device is powered up and ready to interact with host. */
             object->spiState = STATE_INITIALIZED;
+            Semaphore_post(Semaphore_handle(&(object->stateChange)));
             Log_print0(Diags_USER1, "WiFi: CC3000 is powered up and ready.");
         }
         else if (object->spiState == STATE_IDLE) {
@@ -325,6 +331,10 @@ WiFi_Handle WiFiTivaCC3000_open(WiFi_Handle handle, UInt spiIndex,
     paramsUnion.semParams.instance->name = "WiFi.writeComplete";
     Semaphore_construct(&(object->writeComplete), 0, &(paramsUnion.semParams));
 
+    /* Create a semaphore to block for the IRQ/SPI state machine. */
+    paramsUnion.semParams.instance->name = "WiFi.stateChange";
+    Semaphore_construct(&(object->stateChange), 0, &(paramsUnion.semParams));
+
     /* BIOS Hwi create for IRQ interrupt */
     Hwi_Params_init(&(paramsUnion.hwiParams));
 
@@ -391,6 +401,8 @@ static Long WiFiTivaCC3000_readData(Void)
 {
     Long    dataToRecv;
     UChar   type;
+    UChar   opcode;
+    UChar   argSize;
     WiFiTivaCC3000_Object *object = wiFiHandle->object;
 
     /* Determine what type of packet we have */
@@ -404,6 +416,35 @@ static Long WiFiTivaCC3000_readData(Void)
             /* Calculate amount of remaining data */
             STREAM_TO_UINT16((Char *)(wlan_rx_buffer + SPI_HEADER_SIZE),
                              HCI_DATA_LENGTH_OFFSET, dataToRecv);
+            STREAM_TO_UINT8((Char *)(wlan_rx_buffer + SPI_HEADER_SIZE),
+                            HCI_PACKET_OPCODE_OFFSET, opcode);
+            STREAM_TO_UINT8((Char *)(wlan_rx_buffer + SPI_HEADER_SIZE),
+                            HCI_PACKET_ARGSIZE_OFFSET, argSize);
+
+            /*
+             *  Data for a pending recv() that fits its buffer is read
+             *  straight into that buffer. Anything else goes through
+             *  wlan_rx_buffer.
+             */
+            if ((tSLInformation.pucRxUserBuffer != NULL) &&
+                ((opcode == HCI_DATA_RECV) || (opcode == HCI_DATA_RECVFROM)) &&
+                (dataToRecv > argSize) &&
+                ((dataToRecv - argSize) <=
+                    tSLInformation.usRxUserBufferLength)) {
+                object->rxArgCount = argSize;
+                object->rxUserBuf = tSLInformation.pucRxUserBuffer;
+                object->rxUserCount = dataToRecv - argSize;
+                object->rxPadBuf = wlan_rx_buffer + 10 + argSize;
+
+                /* Make amount 16-bit aligned if needed */
+                object->rxPadCount =
+                    ((HEADERS_SIZE_EVNT + dataToRecv) & 1) ? 0 : 1;
+
+                tSLInformation.usRxUserBufferFilled = object->rxUserCount;
+                object->spiState = STATE_READ_USER;
+
+                return (WiFiTivaCC3000_readUserNext());
+            }
 
             if (dataToRecv > DMA_WINDOW_SIZE) {
                 object->spiState = STATE_READ_FIRST_PART;
@@ -490,6 +531,59 @@ static Long WiFiTivaCC3000_readIrqPin(Void)
     return (GPIOPinRead(hwAttrs->irqPort, hwAttrs->irqPin));
 }
 
+/*
+ *  ======== WiFiTivaCC3000_readUserNext ========
+ *  Start the next piece of a data packet that is read into a recv() buffer:
+ *  the arguments into wlan_rx_buffer, the payload into the recv() buffer in
+ *  DMA_WINDOW_SIZE chunks and finally the padding byte. Returns FALSE when
+ *  the whole packet has been read.
+ */
+static Bool WiFiTivaCC3000_readUserNext(Void)
+{
+    UShort count;
+    WiFiTivaCC3000_Object *object = wiFiHandle->object;
+
+    if (object->rxArgCount) {
+        object->transaction.rxBuf = wlan_rx_buffer + 10;
+        count = object->rxArgCount;
+        object->rxArgCount = 0;
+    }
+    else if (object->rxUserCount) {
+        object->transaction.rxBuf = object->rxUserBuf;
+        count = (object->rxUserCount > DMA_WINDOW_SIZE) ?
+                DMA_WINDOW_SIZE : object->rxUserCount;
+        object->rxUserBuf += count;
+        object->rxUserCount -= count;
+    }
+    else if (object->rxPadCount) {
+        object->transaction.rxBuf = object->rxPadBuf;
+        count = object->rxPadCount;
+        object->rxPadCount = 0;
+    }
+    else {
+        return (FALSE);
+    }
+
+    object->transaction.txBuf = wlan_tx_buffer;
+    object->transaction.count = count;
+
+    if(!SPI_transfer(object->spiHandle, &object->transaction)){
+        Log_error0("WiFi: SPI transfer (read) failed to begin!");
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== WiFiTivaCC3000_sleepUs ========
+ *  Block the calling task for at least usecs microseconds. The current Clock
+ *  tick may be about to expire, so one extra tick is added.
+ */
+static Void WiFiTivaCC3000_sleepUs(UInt32 usecs)
+{
+    Task_sleep((usecs + Clock_tickPeriod - 1) / Clock_tickPeriod + 1);
+}
+
 /*
  *  ======== WiFiTivaCC3000_spiCallbackFxn ========
  *  Called by the SPI driver when a transmit has completed.
@@ -528,6 +622,12 @@ static Void WiFiTivaCC3000_spiCallbackFxn(SPI_Handle spiHandle,
             Log_error0("WiFi: SPI transfer (read) failed to begin!");
         }
     }
+    else if (object->spiState == STATE_READ_USER) {
+        /* Continue reading into the recv() buffer until the packet ends. */
+        if (!WiFiTivaCC3000_readUserNext()) {
+            WiFiTivaCC3000_triggerRxProcessing();
+        }
+    }
     else if (object->spiState == STATE_READ_EOT) {
         /* Read has completed. Trigger processing. */
         WiFiTivaCC3000_triggerRxProcessing();
@@ -581,110 +681,50 @@ static Void WiFiTivaCC3000_triggerRxProcessing(Void)
                             "Calling receive handler.");
 
     object->spiState = STATE_IDLE;
+    Semaphore_post(Semaphore_handle(&(object->stateChange)));
     object->spiRxHandler(wlan_rx_buffer + SPI_HEADER_SIZE);
     object->transaction.rxBuf = wlan_rx_buffer;
 }
 
 /*
- *  ======== WiFiTivaCC3000_writeWlanEnPin ========
- *  Callback for host driver. Registered with wlan_init() and called by
- *  wlan_start() and wlan_stop().
+ *  ======== WiFiTivaCC3000_txOverrun ========
+ *  Check the overrun markers at the end of each of the TX buffers.
  */
-static Void WiFiTivaCC3000_writeWlanEnPin(UChar val)
+static Bool WiFiTivaCC3000_txOverrun(Void)
 {
-    WiFiTivaCC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
+    Int i;
 
-    if (val) {
-        /* Enable CC3000 */
-        GPIOPinWrite(hwAttrs->enPort, hwAttrs->enPin, (~0));
-    }
-    else {
-        /* Disable CC3000 */
-        GPIOPinWrite(hwAttrs->enPort, hwAttrs->enPin, 0);
+    for (i = 1; i <= WiFi_TX_BUFFER_COUNT; i++) {
+        if (wlan_tx_buffer[(i * WiFi_TX_BUFFER_SIZE) - 1] !=
+            WiFi_BUF_OVERRUN_DETECT) {
+            return (TRUE);
+        }
     }
 
-    Log_print1(Diags_USER1, "WiFi: 0x%x was written to the WLAN EN pin.", val);
+    return (FALSE);
 }
 
 /*
- *  ======== SpiClose ========
- *  Called by wlan_stop().
+ *  ======== WiFiTivaCC3000_waitWrite ========
+ *  Wait for a write started by SpiWriteAsync() to be clocked out.
  */
-Void SpiClose(Void)
+static Void WiFiTivaCC3000_waitWrite(Void)
 {
-    WiFiTivaCC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
-
-#ifndef xdc_runtime_Assert_DISABLE_ALL
     WiFiTivaCC3000_Object *object = wiFiHandle->object;
 
-    /* Make sure WiFi is open */
-    Assert_isTrue(object->isOpen != FALSE, NULL);
-#endif
-
-    /* Disable IRQ Interrupt */
-    GPIOIntDisable(hwAttrs->irqPort, hwAttrs->irqPin);
-
-    Log_print0(Diags_USER1, "WiFi: wlan_stop() was called. IRQ interrupt is now"
-                            " disabled.");
-}
-
-/*
- *  ======== SpiOpen ========
- *  Called by wlan_start().
- */
-Void SpiOpen(RxHandlerFxn rxHandler)
-{
-    WiFiTivaCC3000_Object        *object  = wiFiHandle->object;
-    WiFiTivaCC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
-
-    /* Make sure WiFi is open */
-    Assert_isTrue(object->isOpen != FALSE, NULL);
-
-    object->spiState = STATE_POWERUP;
-    object->spiRxHandler = rxHandler;
-
-    /* Initialize transaction structure */
-    object->transaction.count = 0;
-    object->transaction.rxBuf = wlan_rx_buffer;
-    object->transaction.txBuf = NULL;
-
-    wlan_rx_buffer[WiFi_RX_BUFFER_SIZE - 1] = WiFi_BUF_OVERRUN_DETECT;
-    wlan_tx_buffer[WiFi_TX_BUFFER_SIZE - 1] = WiFi_BUF_OVERRUN_DETECT;
-
-    /* Enable interrupts on IRQ */
-    GPIOIntClear(hwAttrs->irqPort, hwAttrs->irqPin);
-    GPIOIntEnable(hwAttrs->irqPort, hwAttrs->irqPin);
-
-    /* Enable interrupt in NVIC */
-    Hwi_enableInterrupt(hwAttrs->irqIntNum);
-
-    Log_print0(Diags_USER1, "WiFi: wlan_start() was called. IRQ interrupt is "
-                            "now enabled.");
+    if (object->writePending) {
+        Semaphore_pend(Semaphore_handle(&(object->writeComplete)),
+                BIOS_WAIT_FOREVER);
+        object->writePending = FALSE;
+    }
 }
 
 /*
- *  ======== SpiResumeSpi ========
- *  This function is called by the host driver to reenable interrupts. Called
- *  by hci_unsolicited_event_handler().
+ *  ======== WiFiTivaCC3000_write ========
+ *  Write a packet to the CC3000. A write started with wait set to FALSE is
+ *  completed by the next write or by SpiClose().
  */
-Void SpiResumeSpi(Void)
-{
-    SPITivaDMA_HWAttrs     const *spiAttrs;
-    WiFiTivaCC3000_Object        *object  = wiFiHandle->object;
-    WiFiTivaCC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
-
-    spiAttrs = (SPITivaDMA_HWAttrs *)(object->spiHandle->hwAttrs);
-
-    Hwi_enableInterrupt(spiAttrs->intNum);
-    Hwi_enableInterrupt(hwAttrs->irqIntNum);
-}
-
-/*
- *  ======== SpiWrite ========
- *  Function used by the upper-level host-driver to send data and commands to
- *  the CC3000. Called by HCI layer.
- */
-Void SpiWrite(UChar *userBuffer, UShort length)
+static Void WiFiTivaCC3000_write(UChar *userBuffer, UShort length, Bool wait)
 {
     UChar padByte = 0;
     WiFiTivaCC3000_Object        *object  = wiFiHandle->object;
@@ -693,6 +733,9 @@ Void SpiWrite(UChar *userBuffer, UShort length)
     /* Make sure WiFi is open */
     Assert_isTrue(object->isOpen != FALSE, NULL);
 
+    /* Only one write can be on the wire; finish a posted one first */
+    WiFiTivaCC3000_waitWrite();
+
     /* Add a padding bit if necessary to make everything 16-bit aligned */
     if (!(length & 0x0001)) {
         padByte = 1;
@@ -713,15 +756,17 @@ Void SpiWrite(UChar *userBuffer, UShort length)
      *  detection of the overrun. If the magic number is overwritten, buffer
      *  overrun occurred.
      */
-    if (wlan_tx_buffer[WiFi_TX_BUFFER_SIZE - 1] != WiFi_BUF_OVERRUN_DETECT) {
+    if (WiFiTivaCC3000_txOverrun()) {
         Log_error0("WiFi: Transfer buffer overrun. Closing CC3000.");
         WiFiTivaCC3000_close(wiFiHandle);
         return;
     }
 
     if (object->spiState == STATE_POWERUP) {
-        /* Wait for CC3000 to assert IRQ line */
-        while(object->spiState != STATE_INITIALIZED) {
+        /* Wait for CC3000 to assert IRQ line. The IRQ Hwi posts stateChange */
+        while (object->spiState != STATE_INITIALIZED) {
+            Semaphore_pend(Semaphore_handle(&(object->stateChange)),
+                    BIOS_WAIT_FOREVER);
         }
     }
 
@@ -733,10 +778,13 @@ Void SpiWrite(UChar *userBuffer, UShort length)
         /*
          *  This is needed in the case where an IRQ interrupt for a read occurs
          *  as the host device is preparing to perform a write. Must wait until
-         *  the state returns to IDLE.
+         *  the state returns to IDLE, which the end of the read signals
+         *  through stateChange.
          */
         GPIOIntDisable(hwAttrs->irqPort, hwAttrs->irqPin);
-        while(object->spiState != STATE_IDLE) {
+        while (object->spiState != STATE_IDLE) {
+            Semaphore_pend(Semaphore_handle(&(object->stateChange)),
+                    BIOS_WAIT_FOREVER);
         }
 
         if (length > DMA_WINDOW_SIZE) {
@@ -773,8 +821,142 @@ Void SpiWrite(UChar *userBuffer, UShort length)
         }
     }
 
-    /* Block until write has finished. SPI callback will post semaphore. */
-    Semaphore_pend(Semaphore_handle(&(object->writeComplete)), BIOS_WAIT_FOREVER);
+    if (wait) {
+        /* Block until write has finished. SPI callback will post semaphore. */
+        Semaphore_pend(Semaphore_handle(&(object->writeComplete)),
+                BIOS_WAIT_FOREVER);
+
+        Log_print0(Diags_USER2, "WiFi: Write transaction to CC3000 has "
+                                "completed.");
+    }
+    else {
+        /* The SPI callback's post is collected by the next write */
+        object->writePending = TRUE;
+    }
+}
+
+/*
+ *  ======== WiFiTivaCC3000_writeWlanEnPin ========
+ *  Callback for host driver. Registered with wlan_init() and called by
+ *  wlan_start() and wlan_stop().
+ */
+static Void WiFiTivaCC3000_writeWlanEnPin(UChar val)
+{
+    WiFiTivaCC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
+
+    if (val) {
+        /* Enable CC3000 */
+        GPIOPinWrite(hwAttrs->enPort, hwAttrs->enPin, (~0));
+    }
+    else {
+        /* Disable CC3000 */
+        GPIOPinWrite(hwAttrs->enPort, hwAttrs->enPin, 0);
+    }
+
+    Log_print1(Diags_USER1, "WiFi: 0x%x was written to the WLAN EN pin.", val);
+}
+
+/*
+ *  ======== SpiClose ========
+ *  Called by wlan_stop().
+ */
+Void SpiClose(Void)
+{
+    WiFiTivaCC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
+
+#ifndef xdc_runtime_Assert_DISABLE_ALL
+    WiFiTivaCC3000_Object *object = wiFiHandle->object;
+
+    /* Make sure WiFi is open */
+    Assert_isTrue(object->isOpen != FALSE, NULL);
+#endif
+
+    /* Let a posted write finish, unless closing from interrupt context */
+    if (BIOS_getThreadType() == BIOS_ThreadType_Task) {
+        WiFiTivaCC3000_waitWrite();
+    }
+
+    /* Disable IRQ Interrupt */
+    GPIOIntDisable(hwAttrs->irqPort, hwAttrs->irqPin);
+
+    Log_print0(Diags_USER1, "WiFi: wlan_stop() was called. IRQ interrupt is now"
+                            " disabled.");
+}
+
+/*
+ *  ======== SpiOpen ========
+ *  Called by wlan_start().
+ */
+Void SpiOpen(RxHandlerFxn rxHandler)
+{
+    Int                             i;
+    WiFiTivaCC3000_Object        *object  = wiFiHandle->object;
+    WiFiTivaCC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
+
+    /* Make sure WiFi is open */
+    Assert_isTrue(object->isOpen != FALSE, NULL);
+
+    object->spiState = STATE_POWERUP;
+    object->spiRxHandler = rxHandler;
+    Semaphore_reset(Semaphore_handle(&(object->stateChange)), 0);
+    Semaphore_reset(Semaphore_handle(&(object->writeComplete)), 0);
+    object->writePending = FALSE;
+
+    /* Initialize transaction structure */
+    object->transaction.count = 0;
+    object->transaction.rxBuf = wlan_rx_buffer;
+    object->transaction.txBuf = NULL;
+
+    wlan_rx_buffer[WiFi_RX_BUFFER_SIZE - 1] = WiFi_BUF_OVERRUN_DETECT;
+    for (i = 1; i <= WiFi_TX_BUFFER_COUNT; i++) {
+        wlan_tx_buffer[(i * WiFi_TX_BUFFER_SIZE) - 1] = WiFi_BUF_OVERRUN_DETECT;
+    }
+
+    /* Enable interrupts on IRQ */
+    GPIOIntClear(hwAttrs->irqPort, hwAttrs->irqPin);
+    GPIOIntEnable(hwAttrs->irqPort, hwAttrs->irqPin);
+
+    /* Enable interrupt in NVIC */
+    Hwi_enableInterrupt(hwAttrs->irqIntNum);
+
+    Log_print0(Diags_USER1, "WiFi: wlan_start() was called. IRQ interrupt is "
+                            "now enabled.");
+}
 
-    Log_print0(Diags_USER2, "WiFi: Write transaction to CC3000 has completed.");
+/*
+ *  ======== SpiResumeSpi ========
+ *  This function is called by the host driver to reenable interrupts. Called
+ *  by hci_unsolicited_event_handler().
+ */
+Void SpiResumeSpi(Void)
+{
+    SPITivaDMA_HWAttrs     const *spiAttrs;
+    WiFiTivaCC3000_Object        *object  = wiFiHandle->object;
+    WiFiTivaCC3000_HWAttrs const *hwAttrs = wiFiHandle->hwAttrs;
+
+    spiAttrs = (SPITivaDMA_HWAttrs *)(object->spiHandle->hwAttrs);
+
+    Hwi_enableInterrupt(spiAttrs->intNum);
+    Hwi_enableInterrupt(hwAttrs->irqIntNum);
+}
+
+/*
+ *  ======== SpiWrite ========
+ *  Function used by the upper-level host-driver to send data and commands to
+ *  the CC3000. Called by HCI layer.
+ */
+Void SpiWrite(UChar *userBuffer, UShort length)
+{
+    WiFiTivaCC3000_write(userBuffer, length, TRUE);
+}
+
+/*
+ *  ======== SpiWriteAsync ========
+ *  Like SpiWrite() but returns once the write has started, so the HCI layer
+ *  can format the next packet into another TX buffer meanwhile. userBuffer
+ *  must not be modified until the next SPI write begins.
+ */
+Void SpiWriteAsync(UChar *userBuffer, UShort length)
+{
+    WiFiTivaCC3000_write(userBuffer, length, FALSE);
 }
@@ -155,7 +155,8 @@ typedef enum WiFiTivaCC3000_State {
     STATE_WRITE_EOT,
     STATE_READ_IRQ,
     STATE_READ_FIRST_PART,
-    STATE_READ_EOT
+    STATE_READ_EOT,
+    STATE_READ_USER
 } WiFiTivaCC3000_State;
 
 /*!
@@ -201,11 +202,18 @@ typedef struct WiFiTivaCC3000_HWAttrs {
  */
 typedef struct WiFiTivaCC3000_Object {
     Semaphore_Struct        writeComplete; /* Indicates a write has finished */
+    Semaphore_Struct        stateChange;   /* IRQ/SPI reached a new state */
     ti_sysbios_family_arm_m3_Hwi_Struct hwiIrq; /* Handle for IRQ line Hwi */
     SPI_Handle              spiHandle;     /* Handle for SPI module */
     RxHandlerFxn            spiRxHandler;  /* Host Driver's receive handler */
     WiFiTivaCC3000_State volatile spiState;/* State of transfer layer */
     SPI_Transaction         transaction;   /* Transaction for SPI_transfer */
+    UChar                  *rxUserBuf;     /* Next byte of the recv() buffer */
+    UShort                  rxUserCount;   /* Payload left for rxUserBuf */
+    UShort                  rxArgCount;    /* Data arguments left to read */
+    UChar                  *rxPadBuf;      /* Where the padding byte goes */
+    UShort                  rxPadCount;    /* Padding byte left to read */
+    Bool                    writePending;  /* SpiWriteAsync() in flight */
     Bool                    isOpen;
 } WiFiTivaCC3000_Object;
 
@@ -95,6 +95,31 @@ extern long hci_data_send(unsigned char ucOpcode,
                                       const unsigned char *ucTail,
                                       unsigned short usTailLength);
 
+//*****************************************************************************
+//
+//!  hci_data_post
+//!
+//!  @param  ucOpcode        command operation code
+//!  @param  ucArgs          pointer to the command's arguments buffer
+//!  @param  usArgsLength    length of the arguments
+//!  @param  usDataLength    length of the data following the arguments
+//!  @param  ucTail          pointer to the data buffer
+//!  @param  usTailLength    buffer length
+//!
+//!  @return ESUCCESS
+//!
+//!  @brief              Start an HCI data write operation and return while it
+//!                      is still being clocked out. ucArgs must not be
+//!                      touched until the next SPI write begins.
+//
+//*****************************************************************************
+extern long hci_data_post(unsigned char ucOpcode,
+                                      unsigned char *ucArgs,
+                                      unsigned short usArgsLength,
+                                      unsigned short usDataLength,
+                                      const unsigned char *ucTail,
+                                      unsigned short usTailLength);
+
 
 //*****************************************************************************
 //
@@ -361,6 +361,13 @@ extern int select(long nfds, fd_set *readsds, fd_set *writesds,
 //!            2. SOCKOPT_NONBLOCK (optname). sets the socket non-blocking mode on
 //!           or off.
 //!             In that case optval should be SOCK_ON or SOCK_OFF (optval).
+//!            3. SOCKOPT_SEND_COALESCE (optname), handled by the host.
+//!           send() collects small writes for up to optval ticks or until
+//!           a CC3000 buffer is full, then sends them at once. optval is a
+//!           pointer to unsigned long, 0 stops coalescing. send_flush()
+//!           and closesocket() send held data early. recv(), recvfrom()
+//!           and select() for read do so only if a CC3000 buffer is free,
+//!           they never wait for one.
 //!
 //!  @sa getsockopt
 //
@@ -575,6 +582,209 @@ extern int c_mdnsAdvertiser(unsigned short mdnsEnabled, char * deviceServiceName
 extern int mdnsAdvertiser(unsigned short mdnsEnabled, char * deviceServiceName, unsigned short deviceServiceNameLength);
 #endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
 
+//*****************************************************************************
+//
+//! set_send_buffer_timeout
+//!
+//!  @param  ulTimeout  maximum time in ticks send() and sendto() block
+//!                     waiting for a free CC3000 buffer, 0 waits forever.
+//!                     The OSAL reserves 1 as a flag, so it waits 2 ticks
+//!
+//!  @return none
+//!
+//!  @brief  Bound the time a send blocks on flow control. A send that times
+//!          out returns -2 without transmitting. Has no effect when
+//!          SEND_NON_BLOCKING is defined.
+//
+//*****************************************************************************
+extern void set_send_buffer_timeout(unsigned long ulTimeout);
+
+//*****************************************************************************
+//
+//! get_flow_control_info
+//!
+//!  @param  info  filled in with the current flow control state
+//!
+//!  @return none
+//!
+//!  @brief  Report the free CC3000 buffers, the size of each buffer and the
+//!          number of packets sent to and released by the device, so an
+//!          application can size its bursts to the credits available.
+//
+//*****************************************************************************
+extern void get_flow_control_info(tFlowControlInfo *info);
+
+//*****************************************************************************
+//
+//! flow_control_reserve_buffer
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return 0 once a buffer is taken, -1 in case of bad socket, -2 on send
+//!          buffer timeout, or the last transmit error
+//!
+//!  @brief  Wait for a free CC3000 buffer and take it for the next send.
+//
+//*****************************************************************************
+extern int flow_control_reserve_buffer(long sd);
+
+//*****************************************************************************
+//
+//! flow_control_use_reserved
+//!
+//!  @param  use  1 before the send, under the command lock, 0 after it
+//!
+//!  @return none
+//!
+//!  @brief  Hand the buffer taken by flow_control_reserve_buffer() to the
+//!          next send, and give it back if that send did not use it.
+//
+//*****************************************************************************
+extern void flow_control_use_reserved(int use);
+
+#ifndef CC3000_TINY_DRIVER
+//*****************************************************************************
+//
+//! gethostbyname_cache_lookup
+//!
+//!  @param[in]   hostname     host name
+//!  @param[in]   usNameLen    name length
+//!  @param[out]  out_ip_addr  cached host IP address
+//!  @param[out]  retVal       cached gethostbyname() return value
+//!
+//!  @return 1 on a cache hit, 0 otherwise
+//!
+//!  @brief  Look a host up in the gethostbyname() cache without locking or
+//!          talking to the CC3000.
+//
+//*****************************************************************************
+extern int gethostbyname_cache_lookup(char *hostname, unsigned short usNameLen,
+                                      unsigned long *out_ip_addr, int *retVal);
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_add
+//!
+//!  @param  hostname   host name
+//!  @param  usNameLen  name length
+//!  @param  ulIpAddr   IP address gethostbyname() returns for the host
+//!  @param  ulTtl      ticks the entry is valid, 0 keeps it until flushed
+//!
+//!  @return 0 on success, -1 if the name is too long or every entry is
+//!          permanent
+//!
+//!  @brief  Prefill the gethostbyname() cache.
+//
+//*****************************************************************************
+#ifdef __ENABLE_MULTITHREADED_SUPPORT__
+extern int c_gethostbyname_cache_add(char *hostname, unsigned short usNameLen,
+                                     unsigned long ulIpAddr, unsigned long ulTtl);
+#else /* __ENABLE_MULTITHREADED_SUPPORT__ */
+extern int gethostbyname_cache_add(char *hostname, unsigned short usNameLen,
+                                   unsigned long ulIpAddr, unsigned long ulTtl);
+#endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_flush
+//!
+//!  @return none
+//!
+//!  @brief  Forget every host in the gethostbyname() cache.
+//
+//*****************************************************************************
+#ifdef __ENABLE_MULTITHREADED_SUPPORT__
+extern void c_gethostbyname_cache_flush(void);
+#else /* __ENABLE_MULTITHREADED_SUPPORT__ */
+extern void gethostbyname_cache_flush(void);
+#endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
+
+//*****************************************************************************
+//
+//! send_flush
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return the number of bytes sent, 0 if nothing was held, or the error
+//!          of the send
+//!
+//!  @brief  Send the data a SOCKOPT_SEND_COALESCE socket is holding now.
+//
+//*****************************************************************************
+#ifdef __ENABLE_MULTITHREADED_SUPPORT__
+extern int c_send_flush(long sd);
+#else /* __ENABLE_MULTITHREADED_SUPPORT__ */
+extern int send_flush(long sd);
+#endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
+
+//*****************************************************************************
+//
+//! send_coalesce_flush_expired
+//!
+//!  @return the number of sockets still holding coalesced data
+//!
+//!  @brief  Send the coalesced data whose deadline has passed, as far as
+//!          free CC3000 buffers allow without waiting.
+//
+//*****************************************************************************
+extern int send_coalesce_flush_expired(void);
+
+//*****************************************************************************
+//
+//! send_coalesce_ticks_left
+//!
+//!  @return the ticks until the earliest coalescing deadline, 0 if one has
+//!          passed, or -1 if no data is held
+//!
+//!  @brief  Tells the thread that sends the expired data how long it can
+//!          sleep.
+//
+//*****************************************************************************
+extern long send_coalesce_ticks_left(void);
+
+//*****************************************************************************
+//
+//! send_coalesce_try_flush
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return the number of bytes sent, 0 if nothing was held or no CC3000
+//!          buffer is free, or the error of the send
+//!
+//!  @brief  Send the data the socket is holding if that does not need to
+//!          wait for a CC3000 buffer.
+//
+//*****************************************************************************
+extern int send_coalesce_try_flush(long sd);
+
+//*****************************************************************************
+//
+//! send_coalesce_must_flush
+//!
+//!  @param  sd   socket descriptor
+//!  @param  len  length of the next write, -1 for any held data
+//!
+//!  @return 1 if the socket holds data that has to be sent before a write
+//!          of len bytes, 0 otherwise
+//!
+//!  @brief  Lets send() flush with its own reserved buffer before it takes
+//!          the command lock.
+//
+//*****************************************************************************
+extern int send_coalesce_must_flush(long sd, long len);
+
+//*****************************************************************************
+//
+//! send_coalesce_reset
+//!
+//!  @return none
+//!
+//!  @brief  Drop every coalescing buffer, called when the CC3000 restarts.
+//
+//*****************************************************************************
+extern void send_coalesce_reset(void);
+#endif
+
 //*****************************************************************************
 //
 // Close the Doxygen group.
@@ -124,6 +124,8 @@ unsigned long socket_active_status = SOCKET_STATUS_INIT_VAL;
 
 static long hci_event_unsol_flowcontrol_handler(char *pEvent);
 
+static void free_buffers_post(long count);
+
 static void update_socket_active_status(char *resp_params);
 
 
@@ -263,6 +265,7 @@ hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen)
                                                         tSLInformation.usNumberOfFreeBuffers);
                         STREAM_TO_UINT16((char *)pucReceivedParams, 1,
                                                          tSLInformation.usSlBufferLength);
+                        free_buffers_post(tSLInformation.usNumberOfFreeBuffers);
                     }
                     break;
 
@@ -453,8 +456,14 @@ hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen)
                 memcpy(from, (pucReceivedData + HCI_DATA_HEADER_SIZE + BSD_RECV_FROM_FROM_OFFSET) ,*fromlen);
             }
 
-            memcpy(pRetParams, pucReceivedParams + HCI_DATA_HEADER_SIZE + ucArgsize,
-                         usLength - ucArgsize);
+            // The SPI layer may already have read the payload into the
+            // recv() buffer
+            if (tSLInformation.usRxUserBufferFilled == 0)
+            {
+                memcpy(pRetParams, pucReceivedParams + HCI_DATA_HEADER_SIZE + ucArgsize,
+                             usLength - ucArgsize);
+            }
+            tSLInformation.usRxUserBufferFilled = 0;
 
             tSLInformation.usRxDataPending = 0;
         }
@@ -590,9 +599,18 @@ hci_unsol_event_handler(char *event_hdr)
             break;
         case HCI_EVNT_BSD_TCP_CLOSE_WAIT:
             {
+                // data[0] is the socket for which the remote sent a FIN
+                data = (char*)(event_hdr) + HCI_EVENT_HEADER_SIZE;
+
+                // Wake up whoever is blocked on that socket
+                if( tSLInformation.sSocketEventCB )
+                {
+                    tSLInformation.sSocketEventCB((unsigned char)data[0], event_type);
+                }
+
                 if( tSLInformation.sWlanCB )
                 {
-                    tSLInformation.sWlanCB(event_type, NULL, 0);
+                    tSLInformation.sWlanCB(event_type, data, 1);
                 }
             }
             break;
@@ -623,8 +641,16 @@ hci_unsol_event_handler(char *event_hdr)
 
                     return (1);
                 }
-                else
-                    return (0);
+
+                // Sends are posted without waiting for their completion
+                // when there is more than one TX buffer
+                if ((WiFi_TX_BUFFER_COUNT > 1) &&
+                    ((event_type == HCI_EVNT_SEND) || (event_type == HCI_EVNT_SENDTO)))
+                {
+                    return (1);
+                }
+
+                return (0);
     }
 
     return(0);
@@ -709,6 +735,26 @@ void set_socket_active_status(long Sd, long Status)
 }
 
 
+//*****************************************************************************
+//
+//!  free_buffers_post
+//!
+//!  @param  count  number of CC3000 buffers that became free
+//!  @return        none
+//!
+//!  @brief  Hand one freeBuffersSem count per free buffer to the senders
+//!          blocked in HostFlowControlConsumeBuff.
+//
+//*****************************************************************************
+static void
+free_buffers_post(long count)
+{
+    while (count-- > 0)
+    {
+        OS_semaphore_post(freeBuffersSem);
+    }
+}
+
 //*****************************************************************************
 //
 //!  hci_event_unsol_flowcontrol_handler
@@ -745,6 +791,7 @@ hci_event_unsol_flowcontrol_handler(char *pEvent)
 
     tSLInformation.usNumberOfFreeBuffers += temp;
     tSLInformation.NumberOfReleasedPackets += temp;
+    free_buffers_post(temp);
 
     return(ESUCCESS);
 }
@@ -81,6 +81,36 @@ hci_command_send(unsigned short usOpcode, unsigned char *pucBuff,
     return(0);
 }
 
+//*****************************************************************************
+//
+//!  hci_data_fill_header
+//!
+//!  @param  ucOpcode        command operation code
+//!  @param  ucArgs          pointer to the command's arguments buffer
+//!  @param  usArgsLength    length of the arguments
+//!  @param  usTotalLength   length of the arguments, data and tail
+//!
+//!  @return none
+//!
+//!  @brief              Fill in the HCI data header in front of ucArgs
+//
+//*****************************************************************************
+static void
+hci_data_fill_header(unsigned char ucOpcode,
+                     unsigned char *ucArgs,
+                     unsigned short usArgsLength,
+                     unsigned short usTotalLength)
+{
+    unsigned char *stream;
+
+    stream = ((ucArgs) + SPI_HEADER_SIZE);
+
+    UINT8_TO_STREAM(stream, HCI_TYPE_DATA);
+    UINT8_TO_STREAM(stream, ucOpcode);
+    UINT8_TO_STREAM(stream, usArgsLength);
+    stream = UINT16_TO_STREAM(stream, usTotalLength);
+}
+
 //*****************************************************************************
 //
 //!  hci_data_send
@@ -104,14 +134,8 @@ hci_data_send(unsigned char ucOpcode,
               const unsigned char *ucTail,
               unsigned short usTailLength)
 {
-    unsigned char *stream;
-
-    stream = ((ucArgs) + SPI_HEADER_SIZE);
-
-    UINT8_TO_STREAM(stream, HCI_TYPE_DATA);
-    UINT8_TO_STREAM(stream, ucOpcode);
-    UINT8_TO_STREAM(stream, usArgsLength);
-    stream = UINT16_TO_STREAM(stream, usArgsLength + usDataLength + usTailLength);
+    hci_data_fill_header(ucOpcode, ucArgs, usArgsLength,
+                         usArgsLength + usDataLength + usTailLength);
 
     // Send the packet over the SPI
     SpiWrite(ucArgs, SIMPLE_LINK_HCI_DATA_HEADER_SIZE + usArgsLength + usDataLength + usTailLength);
@@ -119,6 +143,41 @@ hci_data_send(unsigned char ucOpcode,
     return(ESUCCESS);
 }
 
+//*****************************************************************************
+//
+//!  hci_data_post
+//!
+//!  @param  ucOpcode        command operation code
+//!  @param  ucArgs          pointer to the command's arguments buffer
+//!  @param  usArgsLength    length of the arguments
+//!  @param  usDataLength    length of the data following the arguments
+//!  @param  ucTail          pointer to the data buffer
+//!  @param  usTailLength    buffer length
+//!
+//!  @return ESUCCESS
+//!
+//!  @brief              Start an HCI data write operation and return while it
+//!                      is still being clocked out. ucArgs must not be
+//!                      touched until the next SPI write begins.
+//
+//*****************************************************************************
+long
+hci_data_post(unsigned char ucOpcode,
+              unsigned char *ucArgs,
+              unsigned short usArgsLength,
+              unsigned short usDataLength,
+              const unsigned char *ucTail,
+              unsigned short usTailLength)
+{
+    hci_data_fill_header(ucOpcode, ucArgs, usArgsLength,
+                         usArgsLength + usDataLength + usTailLength);
+
+    // Start the packet on the SPI
+    SpiWriteAsync(ucArgs, SIMPLE_LINK_HCI_DATA_HEADER_SIZE + usArgsLength + usDataLength + usTailLength);
+
+    return(ESUCCESS);
+}
+
 
 //*****************************************************************************
 //
@@ -46,6 +46,7 @@
 #include <cc3000_host_driver/core_driver/inc/hci.h>
 #include <cc3000_host_driver/core_driver/inc/socket.h>
 #include <cc3000_host_driver/core_driver/inc/evnt_handler.h>
+#include <spi.h>
 
 //*****************************************************************************
 //
@@ -57,6 +58,11 @@
 #define NVMEM_CREATE_PARAMS_LEN     (8)
 #define NVMEM_WRITE_PARAMS_LEN  (16)
 
+// Largest portion nvmem_write_patch_stream programs at once
+#ifndef NVMEM_PATCH_STREAM_PORTION_SIZE
+#define NVMEM_PATCH_STREAM_PORTION_SIZE (1024)
+#endif
+
 
 #ifndef __ENABLE_MULTITHREADED_SUPPORT__
 #define c_nvmem_write nvmem_write
@@ -270,6 +276,194 @@ unsigned char nvmem_write_patch(unsigned long ulFileId, unsigned long spLength,
     return status;
 }
 
+//*****************************************************************************
+//
+//!  nvmem_patch_portion_size
+//!
+//!  @return       number of patch bytes carried by one NVMEM write
+//!
+//!  @brief       The largest portion that fits both the host TX buffer and
+//!               the CC3000's buffers, capped by
+//!               NVMEM_PATCH_STREAM_PORTION_SIZE.
+//!
+//*****************************************************************************
+static unsigned long
+nvmem_patch_portion_size(void)
+{
+    unsigned long ulSize = NVMEM_PATCH_STREAM_PORTION_SIZE;
+    unsigned long ulHeaders;
+
+    // Keep a byte for the padding of odd length SPI writes and one for the
+    // overrun marker at the end of the TX buffer
+    ulHeaders = SPI_HEADER_SIZE + HCI_DATA_CMD_HEADER_SIZE +
+                NVMEM_WRITE_PARAMS_LEN + 2;
+    if (WiFi_TX_BUFFER_SIZE - ulHeaders < ulSize)
+    {
+        ulSize = WiFi_TX_BUFFER_SIZE - ulHeaders;
+    }
+
+    ulHeaders = HCI_DATA_CMD_HEADER_SIZE + NVMEM_WRITE_PARAMS_LEN;
+    if ((tSLInformation.usSlBufferLength > ulHeaders) &&
+        (tSLInformation.usSlBufferLength - ulHeaders < ulSize))
+    {
+        ulSize = tSLInformation.usSlBufferLength - ulHeaders;
+    }
+
+    return ulSize;
+}
+
+//*****************************************************************************
+//
+//!  nvmem_patch_pull
+//!
+//!  @param  stream     patch source
+//!  @param  ulOffset   offset of the portion in the patch
+//!  @param  buff       where to put the portion
+//!  @param  ulLength   length of the portion
+//!
+//!  @return       0 when the whole portion was read and accepted, -1 otherwise
+//!
+//!  @brief       Read one portion from the patch source, calling the read
+//!               callback until it is complete, and pass it to the verify
+//!               callback.
+//!
+//*****************************************************************************
+static long
+nvmem_patch_pull(const tNvmemPatchStream *stream, unsigned long ulOffset,
+                 unsigned char *buff, unsigned long ulLength)
+{
+    unsigned long ulDone = 0;
+    long iRead;
+
+    while (ulDone < ulLength)
+    {
+        iRead = stream->read(stream->arg, ulOffset + ulDone, buff + ulDone,
+                             ulLength - ulDone);
+        if (iRead <= 0)
+        {
+            return -1;
+        }
+        ulDone += iRead;
+    }
+
+    if ((stream->verify != NULL) &&
+        (stream->verify(stream->arg, ulOffset, buff, ulLength) != 0))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//!  nvmem_write_patch_stream
+//!
+//!  @param  ulFileId   nvmem file id:\n
+//!                     NVMEM_WLAN_DRIVER_SP_FILEID, NVMEM_WLAN_FW_SP_FILEID,
+//!  @param  spLength   number of bytes to write
+//!  @param  stream     SP source and callbacks
+//!
+//!  @return       on success 0, error otherwise.
+//!
+//!  @brief      program a patch to a specific file ID from a source that is
+//!              read a portion at a time, such as a file on an SD card.
+//!              Portions are as large as the TX buffers allow, up to
+//!              NVMEM_PATCH_STREAM_PORTION_SIZE bytes. Each portion is read
+//!              straight into the TX buffer. The next portion is read while
+//!              the CC3000 programs the previous one.
+//!
+//*****************************************************************************
+#ifdef __ENABLE_MULTITHREADED_SUPPORT__
+signed long c_nvmem_write_patch_stream(unsigned long ulFileId,
+                                       unsigned long spLength,
+                                       const tNvmemPatchStream *stream)
+#else /* __ENABLE_MULTITHREADED_SUPPORT__ */
+signed long nvmem_write_patch_stream(unsigned long ulFileId,
+                                     unsigned long spLength,
+                                     const tNvmemPatchStream *stream)
+#endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
+{
+    long iRes;
+    long iPull;
+    unsigned char *ptr;
+    unsigned char *args;
+    unsigned char *data;
+    unsigned long ulPortion;
+    unsigned long ulOffset;
+    unsigned long ulLength;
+    unsigned long ulNext;
+
+    ptr = tSLInformation.pucTxCommandBuffer;
+    data = (ptr + SPI_HEADER_SIZE + HCI_DATA_CMD_HEADER_SIZE +
+            NVMEM_WRITE_PARAMS_LEN);
+    ulPortion = nvmem_patch_portion_size();
+    ulOffset = 0;
+
+    ulLength = (spLength < ulPortion) ? spLength : ulPortion;
+    if (nvmem_patch_pull(stream, 0, data, ulLength) != 0)
+    {
+        return EFAIL;
+    }
+
+    while (ulLength != 0)
+    {
+        iRes = EFAIL;
+        args = (ptr + SPI_HEADER_SIZE + HCI_DATA_CMD_HEADER_SIZE);
+
+        // Fill in HCI packet structure
+        args = UINT32_TO_STREAM(args, ulFileId);
+        args = UINT32_TO_STREAM(args, 12);
+        args = UINT32_TO_STREAM(args, ulLength);
+        args = UINT32_TO_STREAM(args, ulOffset);
+
+        // Initiate a HCI command but it will come on data channel
+        hci_data_command_send(HCI_CMND_NVMEM_WRITE, ptr, NVMEM_WRITE_PARAMS_LEN,
+                                                    ulLength);
+
+        // The portion has been clocked out, so the TX buffer is free again.
+        // Read the next one while the CC3000 programs this one.
+        ulNext = spLength - (ulOffset + ulLength);
+        if (ulNext > ulPortion)
+        {
+            ulNext = ulPortion;
+        }
+        iPull = 0;
+        if (ulNext != 0)
+        {
+            iPull = nvmem_patch_pull(stream, ulOffset + ulLength, data, ulNext);
+        }
+
+        SimpleLinkWaitEvent(HCI_EVNT_NVMEM_WRITE, &iRes);
+        if (iRes != 0)
+        {
+            // NVMEM error occured
+            return iRes;
+        }
+
+        ulOffset += ulLength;
+        if (stream->progress != NULL)
+        {
+            stream->progress(stream->arg, ulOffset, spLength);
+        }
+
+        if (iPull != 0)
+        {
+            return EFAIL;
+        }
+        ulLength = ulNext;
+    }
+
+    // Let the verify callback accept or reject the patch as a whole
+    if ((stream->verify != NULL) &&
+        (stream->verify(stream->arg, spLength, NULL, 0) != 0))
+    {
+        return EFAIL;
+    }
+
+    return 0;
+}
+
 //*****************************************************************************
 //
 //!  nvmem_read_sp_version
@@ -41,6 +41,7 @@
 //*****************************************************************************
 
 #include <cc3000_host_driver/core_driver/inc/security.h>
+#include <string.h>
 
 #ifndef CC3000_UNENCRYPTED_SMART_CONFIG
 
@@ -92,346 +93,312 @@ const unsigned char Rcon[11] = {
   0x8d, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
 
 
-unsigned char expandedKey[176];
+// Encryption T-table: the MixColumns column of sbox[x] for a byte in row 0.
+// Bytes in rows 1 to 3 use the entry rotated left by 8, 16 and 24 bits.
+// State columns are kept in 32-bit words with row 0 in the low byte.
+static const unsigned long aesTe0[256] = {
+    0xa56363c6UL, 0x847c7cf8UL, 0x997777eeUL, 0x8d7b7bf6UL, 0x0df2f2ffUL, 0xbd6b6bd6UL,
+    0xb16f6fdeUL, 0x54c5c591UL, 0x50303060UL, 0x03010102UL, 0xa96767ceUL, 0x7d2b2b56UL,
+    0x19fefee7UL, 0x62d7d7b5UL, 0xe6abab4dUL, 0x9a7676ecUL, 0x45caca8fUL, 0x9d82821fUL,
+    0x40c9c989UL, 0x877d7dfaUL, 0x15fafaefUL, 0xeb5959b2UL, 0xc947478eUL, 0x0bf0f0fbUL,
+    0xecadad41UL, 0x67d4d4b3UL, 0xfda2a25fUL, 0xeaafaf45UL, 0xbf9c9c23UL, 0xf7a4a453UL,
+    0x967272e4UL, 0x5bc0c09bUL, 0xc2b7b775UL, 0x1cfdfde1UL, 0xae93933dUL, 0x6a26264cUL,
+    0x5a36366cUL, 0x413f3f7eUL, 0x02f7f7f5UL, 0x4fcccc83UL, 0x5c343468UL, 0xf4a5a551UL,
+    0x34e5e5d1UL, 0x08f1f1f9UL, 0x937171e2UL, 0x73d8d8abUL, 0x53313162UL, 0x3f15152aUL,
+    0x0c040408UL, 0x52c7c795UL, 0x65232346UL, 0x5ec3c39dUL, 0x28181830UL, 0xa1969637UL,
+    0x0f05050aUL, 0xb59a9a2fUL, 0x0907070eUL, 0x36121224UL, 0x9b80801bUL, 0x3de2e2dfUL,
+    0x26ebebcdUL, 0x6927274eUL, 0xcdb2b27fUL, 0x9f7575eaUL, 0x1b090912UL, 0x9e83831dUL,
+    0x742c2c58UL, 0x2e1a1a34UL, 0x2d1b1b36UL, 0xb26e6edcUL, 0xee5a5ab4UL, 0xfba0a05bUL,
+    0xf65252a4UL, 0x4d3b3b76UL, 0x61d6d6b7UL, 0xceb3b37dUL, 0x7b292952UL, 0x3ee3e3ddUL,
+    0x712f2f5eUL, 0x97848413UL, 0xf55353a6UL, 0x68d1d1b9UL, 0x00000000UL, 0x2cededc1UL,
+    0x60202040UL, 0x1ffcfce3UL, 0xc8b1b179UL, 0xed5b5bb6UL, 0xbe6a6ad4UL, 0x46cbcb8dUL,
+    0xd9bebe67UL, 0x4b393972UL, 0xde4a4a94UL, 0xd44c4c98UL, 0xe85858b0UL, 0x4acfcf85UL,
+    0x6bd0d0bbUL, 0x2aefefc5UL, 0xe5aaaa4fUL, 0x16fbfbedUL, 0xc5434386UL, 0xd74d4d9aUL,
+    0x55333366UL, 0x94858511UL, 0xcf45458aUL, 0x10f9f9e9UL, 0x06020204UL, 0x817f7ffeUL,
+    0xf05050a0UL, 0x443c3c78UL, 0xba9f9f25UL, 0xe3a8a84bUL, 0xf35151a2UL, 0xfea3a35dUL,
+    0xc0404080UL, 0x8a8f8f05UL, 0xad92923fUL, 0xbc9d9d21UL, 0x48383870UL, 0x04f5f5f1UL,
+    0xdfbcbc63UL, 0xc1b6b677UL, 0x75dadaafUL, 0x63212142UL, 0x30101020UL, 0x1affffe5UL,
+    0x0ef3f3fdUL, 0x6dd2d2bfUL, 0x4ccdcd81UL, 0x140c0c18UL, 0x35131326UL, 0x2fececc3UL,
+    0xe15f5fbeUL, 0xa2979735UL, 0xcc444488UL, 0x3917172eUL, 0x57c4c493UL, 0xf2a7a755UL,
+    0x827e7efcUL, 0x473d3d7aUL, 0xac6464c8UL, 0xe75d5dbaUL, 0x2b191932UL, 0x957373e6UL,
+    0xa06060c0UL, 0x98818119UL, 0xd14f4f9eUL, 0x7fdcdca3UL, 0x66222244UL, 0x7e2a2a54UL,
+    0xab90903bUL, 0x8388880bUL, 0xca46468cUL, 0x29eeeec7UL, 0xd3b8b86bUL, 0x3c141428UL,
+    0x79dedea7UL, 0xe25e5ebcUL, 0x1d0b0b16UL, 0x76dbdbadUL, 0x3be0e0dbUL, 0x56323264UL,
+    0x4e3a3a74UL, 0x1e0a0a14UL, 0xdb494992UL, 0x0a06060cUL, 0x6c242448UL, 0xe45c5cb8UL,
+    0x5dc2c29fUL, 0x6ed3d3bdUL, 0xefacac43UL, 0xa66262c4UL, 0xa8919139UL, 0xa4959531UL,
+    0x37e4e4d3UL, 0x8b7979f2UL, 0x32e7e7d5UL, 0x43c8c88bUL, 0x5937376eUL, 0xb76d6ddaUL,
+    0x8c8d8d01UL, 0x64d5d5b1UL, 0xd24e4e9cUL, 0xe0a9a949UL, 0xb46c6cd8UL, 0xfa5656acUL,
+    0x07f4f4f3UL, 0x25eaeacfUL, 0xaf6565caUL, 0x8e7a7af4UL, 0xe9aeae47UL, 0x18080810UL,
+    0xd5baba6fUL, 0x887878f0UL, 0x6f25254aUL, 0x722e2e5cUL, 0x241c1c38UL, 0xf1a6a657UL,
+    0xc7b4b473UL, 0x51c6c697UL, 0x23e8e8cbUL, 0x7cdddda1UL, 0x9c7474e8UL, 0x211f1f3eUL,
+    0xdd4b4b96UL, 0xdcbdbd61UL, 0x868b8b0dUL, 0x858a8a0fUL, 0x907070e0UL, 0x423e3e7cUL,
+    0xc4b5b571UL, 0xaa6666ccUL, 0xd8484890UL, 0x05030306UL, 0x01f6f6f7UL, 0x120e0e1cUL,
+    0xa36161c2UL, 0x5f35356aUL, 0xf95757aeUL, 0xd0b9b969UL, 0x91868617UL, 0x58c1c199UL,
+    0x271d1d3aUL, 0xb99e9e27UL, 0x38e1e1d9UL, 0x13f8f8ebUL, 0xb398982bUL, 0x33111122UL,
+    0xbb6969d2UL, 0x70d9d9a9UL, 0x898e8e07UL, 0xa7949433UL, 0xb69b9b2dUL, 0x221e1e3cUL,
+    0x92878715UL, 0x20e9e9c9UL, 0x49cece87UL, 0xff5555aaUL, 0x78282850UL, 0x7adfdfa5UL,
+    0x8f8c8c03UL, 0xf8a1a159UL, 0x80898909UL, 0x170d0d1aUL, 0xdabfbf65UL, 0x31e6e6d7UL,
+    0xc6424284UL, 0xb86868d0UL, 0xc3414182UL, 0xb0999929UL, 0x772d2d5aUL, 0x110f0f1eUL,
+    0xcbb0b07bUL, 0xfc5454a8UL, 0xd6bbbb6dUL, 0x3a16162cUL
+};
+
+// Decryption T-table: the InvMixColumns column of rsbox[x] for a byte in
+// row 0, used like aesTe0
+static const unsigned long aesTd0[256] = {
+    0x50a7f451UL, 0x5365417eUL, 0xc3a4171aUL, 0x965e273aUL, 0xcb6bab3bUL, 0xf1459d1fUL,
+    0xab58faacUL, 0x9303e34bUL, 0x55fa3020UL, 0xf66d76adUL, 0x9176cc88UL, 0x254c02f5UL,
+    0xfcd7e54fUL, 0xd7cb2ac5UL, 0x80443526UL, 0x8fa362b5UL, 0x495ab1deUL, 0x671bba25UL,
+    0x980eea45UL, 0xe1c0fe5dUL, 0x02752fc3UL, 0x12f04c81UL, 0xa397468dUL, 0xc6f9d36bUL,
+    0xe75f8f03UL, 0x959c9215UL, 0xeb7a6dbfUL, 0xda595295UL, 0x2d83bed4UL, 0xd3217458UL,
+    0x2969e049UL, 0x44c8c98eUL, 0x6a89c275UL, 0x78798ef4UL, 0x6b3e5899UL, 0xdd71b927UL,
+    0xb64fe1beUL, 0x17ad88f0UL, 0x66ac20c9UL, 0xb43ace7dUL, 0x184adf63UL, 0x82311ae5UL,
+    0x60335197UL, 0x457f5362UL, 0xe07764b1UL, 0x84ae6bbbUL, 0x1ca081feUL, 0x942b08f9UL,
+    0x58684870UL, 0x19fd458fUL, 0x876cde94UL, 0xb7f87b52UL, 0x23d373abUL, 0xe2024b72UL,
+    0x578f1fe3UL, 0x2aab5566UL, 0x0728ebb2UL, 0x03c2b52fUL, 0x9a7bc586UL, 0xa50837d3UL,
+    0xf2872830UL, 0xb2a5bf23UL, 0xba6a0302UL, 0x5c8216edUL, 0x2b1ccf8aUL, 0x92b479a7UL,
+    0xf0f207f3UL, 0xa1e2694eUL, 0xcdf4da65UL, 0xd5be0506UL, 0x1f6234d1UL, 0x8afea6c4UL,
+    0x9d532e34UL, 0xa055f3a2UL, 0x32e18a05UL, 0x75ebf6a4UL, 0x39ec830bUL, 0xaaef6040UL,
+    0x069f715eUL, 0x51106ebdUL, 0xf98a213eUL, 0x3d06dd96UL, 0xae053eddUL, 0x46bde64dUL,
+    0xb58d5491UL, 0x055dc471UL, 0x6fd40604UL, 0xff155060UL, 0x24fb9819UL, 0x97e9bdd6UL,
+    0xcc434089UL, 0x779ed967UL, 0xbd42e8b0UL, 0x888b8907UL, 0x385b19e7UL, 0xdbeec879UL,
+    0x470a7ca1UL, 0xe90f427cUL, 0xc91e84f8UL, 0x00000000UL, 0x83868009UL, 0x48ed2b32UL,
+    0xac70111eUL, 0x4e725a6cUL, 0xfbff0efdUL, 0x5638850fUL, 0x1ed5ae3dUL, 0x27392d36UL,
+    0x64d90f0aUL, 0x21a65c68UL, 0xd1545b9bUL, 0x3a2e3624UL, 0xb1670a0cUL, 0x0fe75793UL,
+    0xd296eeb4UL, 0x9e919b1bUL, 0x4fc5c080UL, 0xa220dc61UL, 0x694b775aUL, 0x161a121cUL,
+    0x0aba93e2UL, 0xe52aa0c0UL, 0x43e0223cUL, 0x1d171b12UL, 0x0b0d090eUL, 0xadc78bf2UL,
+    0xb9a8b62dUL, 0xc8a91e14UL, 0x8519f157UL, 0x4c0775afUL, 0xbbdd99eeUL, 0xfd607fa3UL,
+    0x9f2601f7UL, 0xbcf5725cUL, 0xc53b6644UL, 0x347efb5bUL, 0x7629438bUL, 0xdcc623cbUL,
+    0x68fcedb6UL, 0x63f1e4b8UL, 0xcadc31d7UL, 0x10856342UL, 0x40229713UL, 0x2011c684UL,
+    0x7d244a85UL, 0xf83dbbd2UL, 0x1132f9aeUL, 0x6da129c7UL, 0x4b2f9e1dUL, 0xf330b2dcUL,
+    0xec52860dUL, 0xd0e3c177UL, 0x6c16b32bUL, 0x99b970a9UL, 0xfa489411UL, 0x2264e947UL,
+    0xc48cfca8UL, 0x1a3ff0a0UL, 0xd82c7d56UL, 0xef903322UL, 0xc74e4987UL, 0xc1d138d9UL,
+    0xfea2ca8cUL, 0x360bd498UL, 0xcf81f5a6UL, 0x28de7aa5UL, 0x268eb7daUL, 0xa4bfad3fUL,
+    0xe49d3a2cUL, 0x0d927850UL, 0x9bcc5f6aUL, 0x62467e54UL, 0xc2138df6UL, 0xe8b8d890UL,
+    0x5ef7392eUL, 0xf5afc382UL, 0xbe805d9fUL, 0x7c93d069UL, 0xa92dd56fUL, 0xb31225cfUL,
+    0x3b99acc8UL, 0xa77d1810UL, 0x6e639ce8UL, 0x7bbb3bdbUL, 0x097826cdUL, 0xf418596eUL,
+    0x01b79aecUL, 0xa89a4f83UL, 0x656e95e6UL, 0x7ee6ffaaUL, 0x08cfbc21UL, 0xe6e815efUL,
+    0xd99be7baUL, 0xce366f4aUL, 0xd4099feaUL, 0xd67cb029UL, 0xafb2a431UL, 0x31233f2aUL,
+    0x3094a5c6UL, 0xc066a235UL, 0x37bc4e74UL, 0xa6ca82fcUL, 0xb0d090e0UL, 0x15d8a733UL,
+    0x4a9804f1UL, 0xf7daec41UL, 0x0e50cd7fUL, 0x2ff69117UL, 0x8dd64d76UL, 0x4db0ef43UL,
+    0x544daaccUL, 0xdf0496e4UL, 0xe3b5d19eUL, 0x1b886a4cUL, 0xb81f2cc1UL, 0x7f516546UL,
+    0x04ea5e9dUL, 0x5d358c01UL, 0x737487faUL, 0x2e410bfbUL, 0x5a1d67b3UL, 0x52d2db92UL,
+    0x335610e9UL, 0x1347d66dUL, 0x8c61d79aUL, 0x7a0ca137UL, 0x8e14f859UL, 0x893c13ebUL,
+    0xee27a9ceUL, 0x35c961b7UL, 0xede51ce1UL, 0x3cb1477aUL, 0x59dfd29cUL, 0x3f73f255UL,
+    0x79ce1418UL, 0xbf37c773UL, 0xeacdf753UL, 0x5baafd5fUL, 0x146f3ddfUL, 0x86db4478UL,
+    0x81f3afcaUL, 0x3ec468b9UL, 0x2c342438UL, 0x5f40a3c2UL, 0x72c31d16UL, 0x0c25e2bcUL,
+    0x8b493c28UL, 0x41950dffUL, 0x7101a839UL, 0xdeb30c08UL, 0x9ce4b4d8UL, 0x90c15664UL,
+    0x6184cb7bUL, 0x70b632d5UL, 0x745c6c48UL, 0x4257b8d0UL
+};
+
+#define AES_ROUNDS          (10)
+
+#define AES_ROTL(x, n)      ((((x) & 0xFFFFFFFFUL) << (n)) | \
+                             (((x) & 0xFFFFFFFFUL) >> (32 - (n))))
+
+#define AES_BYTE(x, n)      ((unsigned char)((x) >> (8 * (n))))
+
+#define AES_LOAD(p)         ((unsigned long)(p)[0] | \
+                             ((unsigned long)(p)[1] << 8) | \
+                             ((unsigned long)(p)[2] << 16) | \
+                             ((unsigned long)(p)[3] << 24))
+
+#define AES_STORE(p, x)     do { (p)[0] = AES_BYTE(x, 0); \
+                                 (p)[1] = AES_BYTE(x, 1); \
+                                 (p)[2] = AES_BYTE(x, 2); \
+                                 (p)[3] = AES_BYTE(x, 3); } while (0)
+
+// One column of a full round: SubBytes, ShiftRows and (Inv)MixColumns in
+// four table lookups. a to d are the columns the rows 0 to 3 come from
+#define AES_ROUND_COL(T, a, b, c, d, k) \
+    (T[AES_BYTE(a, 0)] ^ AES_ROTL(T[AES_BYTE(b, 1)], 8) ^ \
+     AES_ROTL(T[AES_BYTE(c, 2)], 16) ^ AES_ROTL(T[AES_BYTE(d, 3)], 24) ^ (k))
+
+// One column of the last round, without (Inv)MixColumns
+#define AES_FINAL_COL(S, a, b, c, d, k) \
+    (((unsigned long)S[AES_BYTE(a, 0)] | \
+      ((unsigned long)S[AES_BYTE(b, 1)] << 8) | \
+      ((unsigned long)S[AES_BYTE(c, 2)] << 16) | \
+      ((unsigned long)S[AES_BYTE(d, 3)] << 24)) ^ (k))
 
 //*****************************************************************************
 //
 //!  expandKey
 //!
-//!  @param  key          AES128 key - 16 bytes
-//!  @param  expandedKey  expanded AES128 key
+//!  @param  roundKey  44 words of round keys
+//!  @param  key       AES128 key - 16 bytes
 //!
 //!  @return  none
 //!
-//!  @brief  expend a 16 bytes key for AES128 implementation
+//!  @brief  expand a 16 bytes key into the AES128 encryption round keys
 //!
 //*****************************************************************************
 
-static void expandKey(unsigned char *expandedKey,
-                      unsigned char *key)
+static void expandKey(unsigned long *roundKey, const unsigned char *key)
 {
-  unsigned short ii, buf1;
-  for (ii=0;ii<16;ii++)
-    expandedKey[ii] = key[ii];
-  for (ii=1;ii<11;ii++){
-    buf1 = expandedKey[ii*16 - 4];
-    expandedKey[ii*16 + 0] = sbox[expandedKey[ii*16 - 3]]^expandedKey[(ii-1)*16 + 0]^Rcon[ii];
-    expandedKey[ii*16 + 1] = sbox[expandedKey[ii*16 - 2]]^expandedKey[(ii-1)*16 + 1];
-    expandedKey[ii*16 + 2] = sbox[expandedKey[ii*16 - 1]]^expandedKey[(ii-1)*16 + 2];
-    expandedKey[ii*16 + 3] = sbox[buf1                  ]^expandedKey[(ii-1)*16 + 3];
-    expandedKey[ii*16 + 4] = expandedKey[(ii-1)*16 + 4]^expandedKey[ii*16 + 0];
-    expandedKey[ii*16 + 5] = expandedKey[(ii-1)*16 + 5]^expandedKey[ii*16 + 1];
-    expandedKey[ii*16 + 6] = expandedKey[(ii-1)*16 + 6]^expandedKey[ii*16 + 2];
-    expandedKey[ii*16 + 7] = expandedKey[(ii-1)*16 + 7]^expandedKey[ii*16 + 3];
-    expandedKey[ii*16 + 8] = expandedKey[(ii-1)*16 + 8]^expandedKey[ii*16 + 4];
-    expandedKey[ii*16 + 9] = expandedKey[(ii-1)*16 + 9]^expandedKey[ii*16 + 5];
-    expandedKey[ii*16 +10] = expandedKey[(ii-1)*16 +10]^expandedKey[ii*16 + 6];
-    expandedKey[ii*16 +11] = expandedKey[(ii-1)*16 +11]^expandedKey[ii*16 + 7];
-    expandedKey[ii*16 +12] = expandedKey[(ii-1)*16 +12]^expandedKey[ii*16 + 8];
-    expandedKey[ii*16 +13] = expandedKey[(ii-1)*16 +13]^expandedKey[ii*16 + 9];
-    expandedKey[ii*16 +14] = expandedKey[(ii-1)*16 +14]^expandedKey[ii*16 +10];
-    expandedKey[ii*16 +15] = expandedKey[(ii-1)*16 +15]^expandedKey[ii*16 +11];
-  }
+    unsigned long temp;
+    int i;
 
+    for (i = 0; i < 4; i++)
+    {
+        roundKey[i] = AES_LOAD(key + (4 * i));
+    }
+
+    for (i = 4; i < 4 * (AES_ROUNDS + 1); i++)
+    {
+        temp = roundKey[i - 1];
+        if ((i & 3) == 0)
+        {
+            // SubWord(RotWord(temp)) ^ Rcon
+            temp = ((unsigned long)sbox[AES_BYTE(temp, 1)] |
+                    ((unsigned long)sbox[AES_BYTE(temp, 2)] << 8) |
+                    ((unsigned long)sbox[AES_BYTE(temp, 3)] << 16) |
+                    ((unsigned long)sbox[AES_BYTE(temp, 0)] << 24)) ^
+                   Rcon[i / 4];
+        }
+        roundKey[i] = roundKey[i - 4] ^ temp;
+    }
 }
 
 //*****************************************************************************
 //
-//!  galois_mul2
+//!  invertKey
 //!
-//!  @param  value    argument to multiply
+//!  @param  roundKey  44 words of round keys, converted in place
 //!
-//!  @return  multiplied argument
+//!  @return  none
 //!
-//!  @brief  multiply by 2 in the galois field
+//!  @brief  turn encryption round keys into the round keys of the
+//!          equivalent inverse cipher: reverse the round order and apply
+//!          InvMixColumns to all but the first and the last round key.
 //!
 //*****************************************************************************
 
-static unsigned char galois_mul2(unsigned char value)
+static void invertKey(unsigned long *roundKey)
 {
-    if (value>>7)
+    unsigned long temp;
+    int i, j, k;
+
+    for (i = 0, j = 4 * AES_ROUNDS; i < j; i += 4, j -= 4)
+    {
+        for (k = 0; k < 4; k++)
+        {
+            temp = roundKey[i + k];
+            roundKey[i + k] = roundKey[j + k];
+            roundKey[j + k] = temp;
+        }
+    }
+
+    // aesTd0 includes rsbox, so look the bytes up through sbox first
+    for (i = 4; i < 4 * AES_ROUNDS; i++)
     {
-        value = value << 1;
-        return (value^0x1b);
-    } else
-        return value<<1;
+        temp = roundKey[i];
+        roundKey[i] = aesTd0[sbox[AES_BYTE(temp, 0)]] ^
+                      AES_ROTL(aesTd0[sbox[AES_BYTE(temp, 1)]], 8) ^
+                      AES_ROTL(aesTd0[sbox[AES_BYTE(temp, 2)]], 16) ^
+                      AES_ROTL(aesTd0[sbox[AES_BYTE(temp, 3)]], 24);
+    }
 }
 
 //*****************************************************************************
 //
 //!  aes_encr
 //!
-//!  @param[in]  expandedKey expanded AES128 key
-//!  @param[in/out] state 16 bytes of plain text and cipher text
+//!  @param[in]  roundKey  encryption round keys
+//!  @param[in]  in        16 bytes of plain text
+//!  @param[out] out       16 bytes of cipher text, may be in
 //!
 //!  @return  none
 //!
-//!  @brief   internal implementation of AES128 encryption.
-//!           straight forward aes encryption implementation
-//!           first the group of operations
-//!          - addRoundKey
-//!          - subbytes
-//!          - shiftrows
-//!          - mixcolums
-//!          is executed 9 times, after this addroundkey to finish the 9th
-//!          round, after that the 10th round without mixcolums
-//!          no further subfunctions to save cycles for function calls
-//!          no structuring with "for (....)" to save cycles.
-//!
+//!  @brief   internal implementation of AES128 encryption. Each of the nine
+//!           full rounds is 16 T-table lookups on 32-bit columns.
 //!
 //*****************************************************************************
 
-static void aes_encr(unsigned char *state, unsigned char *expandedKey)
+static void aes_encr(const unsigned long *roundKey, const unsigned char *in,
+                     unsigned char *out)
 {
-  unsigned char buf1, buf2, buf3, round;
-
-  for (round = 0; round < 9; round ++){
-    // addroundkey, sbox and shiftrows
-    // row 0
-    state[ 0]  = sbox[(state[ 0] ^ expandedKey[(round*16)     ])];
-    state[ 4]  = sbox[(state[ 4] ^ expandedKey[(round*16) +  4])];
-    state[ 8]  = sbox[(state[ 8] ^ expandedKey[(round*16) +  8])];
-    state[12]  = sbox[(state[12] ^ expandedKey[(round*16) + 12])];
-    // row 1
-    buf1 = state[1] ^ expandedKey[(round*16) + 1];
-    state[ 1]  = sbox[(state[ 5] ^ expandedKey[(round*16) +  5])];
-    state[ 5]  = sbox[(state[ 9] ^ expandedKey[(round*16) +  9])];
-    state[ 9]  = sbox[(state[13] ^ expandedKey[(round*16) + 13])];
-    state[13]  = sbox[buf1];
-    // row 2
-    buf1 = state[2] ^ expandedKey[(round*16) + 2];
-    buf2 = state[6] ^ expandedKey[(round*16) + 6];
-    state[ 2]  = sbox[(state[10] ^ expandedKey[(round*16) + 10])];
-    state[ 6]  = sbox[(state[14] ^ expandedKey[(round*16) + 14])];
-    state[10]  = sbox[buf1];
-    state[14]  = sbox[buf2];
-    // row 3
-    buf1 = state[15] ^ expandedKey[(round*16) + 15];
-    state[15]  = sbox[(state[11] ^ expandedKey[(round*16) + 11])];
-    state[11]  = sbox[(state[ 7] ^ expandedKey[(round*16) +  7])];
-    state[ 7]  = sbox[(state[ 3] ^ expandedKey[(round*16) +  3])];
-    state[ 3]  = sbox[buf1];
-
-    // mixcolums //////////
-    // col1
-    buf1 = state[0] ^ state[1] ^ state[2] ^ state[3];
-    buf2 = state[0];
-    buf3 = state[0]^state[1]; buf3=galois_mul2(buf3); state[0] = state[0] ^ buf3 ^ buf1;
-    buf3 = state[1]^state[2]; buf3=galois_mul2(buf3); state[1] = state[1] ^ buf3 ^ buf1;
-    buf3 = state[2]^state[3]; buf3=galois_mul2(buf3); state[2] = state[2] ^ buf3 ^ buf1;
-    buf3 = state[3]^buf2;     buf3=galois_mul2(buf3); state[3] = state[3] ^ buf3 ^ buf1;
-    // col2
-    buf1 = state[4] ^ state[5] ^ state[6] ^ state[7];
-    buf2 = state[4];
-    buf3 = state[4]^state[5]; buf3=galois_mul2(buf3); state[4] = state[4] ^ buf3 ^ buf1;
-    buf3 = state[5]^state[6]; buf3=galois_mul2(buf3); state[5] = state[5] ^ buf3 ^ buf1;
-    buf3 = state[6]^state[7]; buf3=galois_mul2(buf3); state[6] = state[6] ^ buf3 ^ buf1;
-    buf3 = state[7]^buf2;     buf3=galois_mul2(buf3); state[7] = state[7] ^ buf3 ^ buf1;
-    // col3
-    buf1 = state[8] ^ state[9] ^ state[10] ^ state[11];
-    buf2 = state[8];
-    buf3 = state[8]^state[9];   buf3=galois_mul2(buf3); state[8] = state[8] ^ buf3 ^ buf1;
-    buf3 = state[9]^state[10];  buf3=galois_mul2(buf3); state[9] = state[9] ^ buf3 ^ buf1;
-    buf3 = state[10]^state[11]; buf3=galois_mul2(buf3); state[10] = state[10] ^ buf3 ^ buf1;
-    buf3 = state[11]^buf2;      buf3=galois_mul2(buf3); state[11] = state[11] ^ buf3 ^ buf1;
-    // col4
-    buf1 = state[12] ^ state[13] ^ state[14] ^ state[15];
-    buf2 = state[12];
-    buf3 = state[12]^state[13]; buf3=galois_mul2(buf3); state[12] = state[12] ^ buf3 ^ buf1;
-    buf3 = state[13]^state[14]; buf3=galois_mul2(buf3); state[13] = state[13] ^ buf3 ^ buf1;
-    buf3 = state[14]^state[15]; buf3=galois_mul2(buf3); state[14] = state[14] ^ buf3 ^ buf1;
-    buf3 = state[15]^buf2;      buf3=galois_mul2(buf3); state[15] = state[15] ^ buf3 ^ buf1;
-
-  }
-  // 10th round without mixcols
-  state[ 0]  = sbox[(state[ 0] ^ expandedKey[(round*16)     ])];
-  state[ 4]  = sbox[(state[ 4] ^ expandedKey[(round*16) +  4])];
-  state[ 8]  = sbox[(state[ 8] ^ expandedKey[(round*16) +  8])];
-  state[12]  = sbox[(state[12] ^ expandedKey[(round*16) + 12])];
-  // row 1
-  buf1 = state[1] ^ expandedKey[(round*16) + 1];
-  state[ 1]  = sbox[(state[ 5] ^ expandedKey[(round*16) +  5])];
-  state[ 5]  = sbox[(state[ 9] ^ expandedKey[(round*16) +  9])];
-  state[ 9]  = sbox[(state[13] ^ expandedKey[(round*16) + 13])];
-  state[13]  = sbox[buf1];
-  // row 2
-  buf1 = state[2] ^ expandedKey[(round*16) + 2];
-  buf2 = state[6] ^ expandedKey[(round*16) + 6];
-  state[ 2]  = sbox[(state[10] ^ expandedKey[(round*16) + 10])];
-  state[ 6]  = sbox[(state[14] ^ expandedKey[(round*16) + 14])];
-  state[10]  = sbox[buf1];
-  state[14]  = sbox[buf2];
-  // row 3
-  buf1 = state[15] ^ expandedKey[(round*16) + 15];
-  state[15]  = sbox[(state[11] ^ expandedKey[(round*16) + 11])];
-  state[11]  = sbox[(state[ 7] ^ expandedKey[(round*16) +  7])];
-  state[ 7]  = sbox[(state[ 3] ^ expandedKey[(round*16) +  3])];
-  state[ 3]  = sbox[buf1];
-  // last addroundkey
-  state[ 0]^=expandedKey[160];
-  state[ 1]^=expandedKey[161];
-  state[ 2]^=expandedKey[162];
-  state[ 3]^=expandedKey[163];
-  state[ 4]^=expandedKey[164];
-  state[ 5]^=expandedKey[165];
-  state[ 6]^=expandedKey[166];
-  state[ 7]^=expandedKey[167];
-  state[ 8]^=expandedKey[168];
-  state[ 9]^=expandedKey[169];
-  state[10]^=expandedKey[170];
-  state[11]^=expandedKey[171];
-  state[12]^=expandedKey[172];
-  state[13]^=expandedKey[173];
-  state[14]^=expandedKey[174];
-  state[15]^=expandedKey[175];
+    unsigned long s0, s1, s2, s3, t0, t1, t2, t3;
+    int round;
+
+    s0 = AES_LOAD(in     ) ^ roundKey[0];
+    s1 = AES_LOAD(in +  4) ^ roundKey[1];
+    s2 = AES_LOAD(in +  8) ^ roundKey[2];
+    s3 = AES_LOAD(in + 12) ^ roundKey[3];
+
+    for (round = 1; round < AES_ROUNDS; round++)
+    {
+        roundKey += 4;
+        t0 = AES_ROUND_COL(aesTe0, s0, s1, s2, s3, roundKey[0]);
+        t1 = AES_ROUND_COL(aesTe0, s1, s2, s3, s0, roundKey[1]);
+        t2 = AES_ROUND_COL(aesTe0, s2, s3, s0, s1, roundKey[2]);
+        t3 = AES_ROUND_COL(aesTe0, s3, s0, s1, s2, roundKey[3]);
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    roundKey += 4;
+    t0 = AES_FINAL_COL(sbox, s0, s1, s2, s3, roundKey[0]);
+    t1 = AES_FINAL_COL(sbox, s1, s2, s3, s0, roundKey[1]);
+    t2 = AES_FINAL_COL(sbox, s2, s3, s0, s1, roundKey[2]);
+    t3 = AES_FINAL_COL(sbox, s3, s0, s1, s2, roundKey[3]);
+
+    AES_STORE(out     , t0);
+    AES_STORE(out +  4, t1);
+    AES_STORE(out +  8, t2);
+    AES_STORE(out + 12, t3);
 }
 
 //*****************************************************************************
 //
 //!  aes_decr
 //!
-//!  @param[in]  expandedKey expanded AES128 key
-//!  @param[in\out] state 16 bytes of cipher text and plain text
+//!  @param[in]  roundKey  round keys from invertKey
+//!  @param[in]  in        16 bytes of cipher text
+//!  @param[out] out       16 bytes of plain text, may be in
 //!
 //!  @return  none
 //!
-//!  @brief   internal implementation of AES128 decryption.
-//!           straight forward aes decryption implementation
-//!           the order of substeps is the exact reverse of decryption
-//!           inverse functions:
-//!            - addRoundKey is its own inverse
-//!            - rsbox is inverse of sbox
-//!            - rightshift instead of leftshift
-//!            - invMixColumns = barreto + mixColumns
-//!           no further subfunctions to save cycles for function calls
-//!           no structuring with "for (....)" to save cycles
+//!  @brief   internal implementation of AES128 decryption as the equivalent
+//!           inverse cipher, with the same structure as aes_encr.
 //!
 //*****************************************************************************
 
-static void aes_decr(unsigned char *state, unsigned char *expandedKey)
+static void aes_decr(const unsigned long *roundKey, const unsigned char *in,
+                     unsigned char *out)
 {
-  unsigned char buf1, buf2, buf3;
-  signed char round;
-  round = 9;
-
-  // initial addroundkey
-  state[ 0]^=expandedKey[160];
-  state[ 1]^=expandedKey[161];
-  state[ 2]^=expandedKey[162];
-  state[ 3]^=expandedKey[163];
-  state[ 4]^=expandedKey[164];
-  state[ 5]^=expandedKey[165];
-  state[ 6]^=expandedKey[166];
-  state[ 7]^=expandedKey[167];
-  state[ 8]^=expandedKey[168];
-  state[ 9]^=expandedKey[169];
-  state[10]^=expandedKey[170];
-  state[11]^=expandedKey[171];
-  state[12]^=expandedKey[172];
-  state[13]^=expandedKey[173];
-  state[14]^=expandedKey[174];
-  state[15]^=expandedKey[175];
-
-  // 10th round without mixcols
-  state[ 0]  = rsbox[state[ 0]] ^ expandedKey[(round*16)     ];
-  state[ 4]  = rsbox[state[ 4]] ^ expandedKey[(round*16) +  4];
-  state[ 8]  = rsbox[state[ 8]] ^ expandedKey[(round*16) +  8];
-  state[12]  = rsbox[state[12]] ^ expandedKey[(round*16) + 12];
-  // row 1
-  buf1 =       rsbox[state[13]] ^ expandedKey[(round*16) +  1];
-  state[13]  = rsbox[state[ 9]] ^ expandedKey[(round*16) + 13];
-  state[ 9]  = rsbox[state[ 5]] ^ expandedKey[(round*16) +  9];
-  state[ 5]  = rsbox[state[ 1]] ^ expandedKey[(round*16) +  5];
-  state[ 1]  = buf1;
-  // row 2
-  buf1 =       rsbox[state[ 2]] ^ expandedKey[(round*16) + 10];
-  buf2 =       rsbox[state[ 6]] ^ expandedKey[(round*16) + 14];
-  state[ 2]  = rsbox[state[10]] ^ expandedKey[(round*16) +  2];
-  state[ 6]  = rsbox[state[14]] ^ expandedKey[(round*16) +  6];
-  state[10]  = buf1;
-  state[14]  = buf2;
-  // row 3
-  buf1 =       rsbox[state[ 3]] ^ expandedKey[(round*16) + 15];
-  state[ 3]  = rsbox[state[ 7]] ^ expandedKey[(round*16) +  3];
-  state[ 7]  = rsbox[state[11]] ^ expandedKey[(round*16) +  7];
-  state[11]  = rsbox[state[15]] ^ expandedKey[(round*16) + 11];
-  state[15]  = buf1;
-
-  for (round = 8; round >= 0; round--){
-    // barreto
-    //col1
-    buf1 = galois_mul2(galois_mul2(state[0]^state[2]));
-    buf2 = galois_mul2(galois_mul2(state[1]^state[3]));
-    state[0] ^= buf1;     state[1] ^= buf2;    state[2] ^= buf1;    state[3] ^= buf2;
-    //col2
-    buf1 = galois_mul2(galois_mul2(state[4]^state[6]));
-    buf2 = galois_mul2(galois_mul2(state[5]^state[7]));
-    state[4] ^= buf1;    state[5] ^= buf2;    state[6] ^= buf1;    state[7] ^= buf2;
-    //col3
-    buf1 = galois_mul2(galois_mul2(state[8]^state[10]));
-    buf2 = galois_mul2(galois_mul2(state[9]^state[11]));
-    state[8] ^= buf1;    state[9] ^= buf2;    state[10] ^= buf1;    state[11] ^= buf2;
-    //col4
-    buf1 = galois_mul2(galois_mul2(state[12]^state[14]));
-    buf2 = galois_mul2(galois_mul2(state[13]^state[15]));
-    state[12] ^= buf1;    state[13] ^= buf2;    state[14] ^= buf1;    state[15] ^= buf2;
-    // mixcolums //////////
-    // col1
-    buf1 = state[0] ^ state[1] ^ state[2] ^ state[3];
-    buf2 = state[0];
-    buf3 = state[0]^state[1]; buf3=galois_mul2(buf3); state[0] = state[0] ^ buf3 ^ buf1;
-    buf3 = state[1]^state[2]; buf3=galois_mul2(buf3); state[1] = state[1] ^ buf3 ^ buf1;
-    buf3 = state[2]^state[3]; buf3=galois_mul2(buf3); state[2] = state[2] ^ buf3 ^ buf1;
-    buf3 = state[3]^buf2;     buf3=galois_mul2(buf3); state[3] = state[3] ^ buf3 ^ buf1;
-    // col2
-    buf1 = state[4] ^ state[5] ^ state[6] ^ state[7];
-    buf2 = state[4];
-    buf3 = state[4]^state[5]; buf3=galois_mul2(buf3); state[4] = state[4] ^ buf3 ^ buf1;
-    buf3 = state[5]^state[6]; buf3=galois_mul2(buf3); state[5] = state[5] ^ buf3 ^ buf1;
-    buf3 = state[6]^state[7]; buf3=galois_mul2(buf3); state[6] = state[6] ^ buf3 ^ buf1;
-    buf3 = state[7]^buf2;     buf3=galois_mul2(buf3); state[7] = state[7] ^ buf3 ^ buf1;
-    // col3
-    buf1 = state[8] ^ state[9] ^ state[10] ^ state[11];
-    buf2 = state[8];
-    buf3 = state[8]^state[9];   buf3=galois_mul2(buf3); state[8] = state[8] ^ buf3 ^ buf1;
-    buf3 = state[9]^state[10];  buf3=galois_mul2(buf3); state[9] = state[9] ^ buf3 ^ buf1;
-    buf3 = state[10]^state[11]; buf3=galois_mul2(buf3); state[10] = state[10] ^ buf3 ^ buf1;
-    buf3 = state[11]^buf2;      buf3=galois_mul2(buf3); state[11] = state[11] ^ buf3 ^ buf1;
-    // col4
-    buf1 = state[12] ^ state[13] ^ state[14] ^ state[15];
-    buf2 = state[12];
-    buf3 = state[12]^state[13]; buf3=galois_mul2(buf3); state[12] = state[12] ^ buf3 ^ buf1;
-    buf3 = state[13]^state[14]; buf3=galois_mul2(buf3); state[13] = state[13] ^ buf3 ^ buf1;
-    buf3 = state[14]^state[15]; buf3=galois_mul2(buf3); state[14] = state[14] ^ buf3 ^ buf1;
-    buf3 = state[15]^buf2;      buf3=galois_mul2(buf3); state[15] = state[15] ^ buf3 ^ buf1;
-
-    // addroundkey, rsbox and shiftrows
-    // row 0
-    state[ 0]  = rsbox[state[ 0]] ^ expandedKey[(round*16)     ];
-    state[ 4]  = rsbox[state[ 4]] ^ expandedKey[(round*16) +  4];
-    state[ 8]  = rsbox[state[ 8]] ^ expandedKey[(round*16) +  8];
-    state[12]  = rsbox[state[12]] ^ expandedKey[(round*16) + 12];
-    // row 1
-    buf1 =       rsbox[state[13]] ^ expandedKey[(round*16) +  1];
-    state[13]  = rsbox[state[ 9]] ^ expandedKey[(round*16) + 13];
-    state[ 9]  = rsbox[state[ 5]] ^ expandedKey[(round*16) +  9];
-    state[ 5]  = rsbox[state[ 1]] ^ expandedKey[(round*16) +  5];
-    state[ 1]  = buf1;
-    // row 2
-    buf1 =       rsbox[state[ 2]] ^ expandedKey[(round*16) + 10];
-    buf2 =       rsbox[state[ 6]] ^ expandedKey[(round*16) + 14];
-    state[ 2]  = rsbox[state[10]] ^ expandedKey[(round*16) +  2];
-    state[ 6]  = rsbox[state[14]] ^ expandedKey[(round*16) +  6];
-    state[10]  = buf1;
-    state[14]  = buf2;
-    // row 3
-    buf1 =       rsbox[state[ 3]] ^ expandedKey[(round*16) + 15];
-    state[ 3]  = rsbox[state[ 7]] ^ expandedKey[(round*16) +  3];
-    state[ 7]  = rsbox[state[11]] ^ expandedKey[(round*16) +  7];
-    state[11]  = rsbox[state[15]] ^ expandedKey[(round*16) + 11];
-    state[15]  = buf1;
-  }
+    unsigned long s0, s1, s2, s3, t0, t1, t2, t3;
+    int round;
+
+    s0 = AES_LOAD(in     ) ^ roundKey[0];
+    s1 = AES_LOAD(in +  4) ^ roundKey[1];
+    s2 = AES_LOAD(in +  8) ^ roundKey[2];
+    s3 = AES_LOAD(in + 12) ^ roundKey[3];
 
+    for (round = 1; round < AES_ROUNDS; round++)
+    {
+        roundKey += 4;
+        t0 = AES_ROUND_COL(aesTd0, s0, s3, s2, s1, roundKey[0]);
+        t1 = AES_ROUND_COL(aesTd0, s1, s0, s3, s2, roundKey[1]);
+        t2 = AES_ROUND_COL(aesTd0, s2, s1, s0, s3, roundKey[2]);
+        t3 = AES_ROUND_COL(aesTd0, s3, s2, s1, s0, roundKey[3]);
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    roundKey += 4;
+    t0 = AES_FINAL_COL(rsbox, s0, s3, s2, s1, roundKey[0]);
+    t1 = AES_FINAL_COL(rsbox, s1, s0, s3, s2, roundKey[1]);
+    t2 = AES_FINAL_COL(rsbox, s2, s1, s0, s3, roundKey[2]);
+    t3 = AES_FINAL_COL(rsbox, s3, s2, s1, s0, roundKey[3]);
+
+    AES_STORE(out     , t0);
+    AES_STORE(out +  4, t1);
+    AES_STORE(out +  8, t2);
+    AES_STORE(out + 12, t3);
 }
 
 //*****************************************************************************
@@ -446,7 +413,8 @@ static void aes_decr(unsigned char *state, unsigned char *expandedKey)
 //!  @brief   AES128 encryption:
 //!           Given AES128 key and  16 bytes plain text, cipher text of 16 bytes
 //!           is computed. The AES implementation is in mode ECB (Electronic
-//!           Code Book).
+//!           Code Book). Expands the key on every call, use aes_set_key and
+//!           aes_encrypt_block for more than one block.
 //!
 //!
 //*****************************************************************************
@@ -456,9 +424,10 @@ void c_aes_encrypt(unsigned char *state, unsigned char *key)
 void aes_encrypt(unsigned char *state, unsigned char *key)
 #endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
 {
-    // expand the key into 176 bytes
-    expandKey(expandedKey, key);
-    aes_encr(state, expandedKey);
+    unsigned long roundKey[4 * (AES_ROUNDS + 1)];
+
+    expandKey(roundKey, key);
+    aes_encr(roundKey, state, state);
 }
 
 //*****************************************************************************
@@ -473,7 +442,8 @@ void aes_encrypt(unsigned char *state, unsigned char *key)
 //!  @brief   AES128 decryption:
 //!           Given AES128 key and  16 bytes cipher text, plain text of 16 bytes
 //!           is computed The AES implementation is in mode ECB
-//!           (Electronic Code Book).
+//!           (Electronic Code Book). Expands the key on every call, use
+//!           aes_set_key and aes_decrypt_block for more than one block.
 //!
 //!
 //*****************************************************************************
@@ -483,8 +453,214 @@ void c_aes_decrypt(unsigned char *state, unsigned char *key)
 void aes_decrypt(unsigned char *state, unsigned char *key)
 #endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
 {
-    expandKey(expandedKey, key);       // expand the key into 176 bytes
-    aes_decr(state, expandedKey);
+    unsigned long roundKey[4 * (AES_ROUNDS + 1)];
+
+    expandKey(roundKey, key);
+    invertKey(roundKey);
+    aes_decr(roundKey, state, state);
+}
+
+//*****************************************************************************
+//
+//!  aes_set_key
+//!
+//!  @param[out]  ctx   AES128 context
+//!  @param[in]   key   AES128 key of size 16 bytes
+//!
+//!  @return  none
+//!
+//!  @brief   Compute the encryption and decryption round keys of a key once,
+//!           for any number of blocks. The context is only read afterwards,
+//!           so several tasks can share it.
+//!
+//*****************************************************************************
+void aes_set_key(tAesContext *ctx, const unsigned char *key)
+{
+    expandKey(ctx->ulEncKey, key);
+    memcpy(ctx->ulDecKey, ctx->ulEncKey, sizeof(ctx->ulDecKey));
+    invertKey(ctx->ulDecKey);
+}
+
+//*****************************************************************************
+//
+//!  aes_encrypt_block
+//!
+//!  @param[in]  ctx   AES128 context
+//!  @param[in]  in    16 bytes of plain text
+//!  @param[out] out   16 bytes of cipher text, may be in
+//!
+//!  @return  none
+//!
+//!  @brief   AES128 encryption of one block (ECB).
+//!
+//*****************************************************************************
+void aes_encrypt_block(const tAesContext *ctx, const unsigned char *in,
+                       unsigned char *out)
+{
+    aes_encr(ctx->ulEncKey, in, out);
+}
+
+//*****************************************************************************
+//
+//!  aes_decrypt_block
+//!
+//!  @param[in]  ctx   AES128 context
+//!  @param[in]  in    16 bytes of cipher text
+//!  @param[out] out   16 bytes of plain text, may be in
+//!
+//!  @return  none
+//!
+//!  @brief   AES128 decryption of one block (ECB).
+//!
+//*****************************************************************************
+void aes_decrypt_block(const tAesContext *ctx, const unsigned char *in,
+                       unsigned char *out)
+{
+    aes_decr(ctx->ulDecKey, in, out);
+}
+
+//*****************************************************************************
+//
+//!  aes_cbc_encrypt
+//!
+//!  @param[in]     ctx   AES128 context
+//!  @param[in\out] iv    16 bytes initialization vector, updated so that a
+//!                       further call continues the chain
+//!  @param[in]     in    plain text
+//!  @param[out]    out   cipher text, may be in
+//!  @param[in]     len   length of the text, a multiple of 16 bytes
+//!
+//!  @return  0 on success, -1 if len is not a multiple of 16 bytes
+//!
+//!  @brief   AES128 encryption in mode CBC (Cipher Block Chaining).
+//!
+//*****************************************************************************
+signed long aes_cbc_encrypt(const tAesContext *ctx, unsigned char *iv,
+                            const unsigned char *in, unsigned char *out,
+                            unsigned long len)
+{
+    unsigned char block[AES128_KEY_SIZE];
+    int i;
+
+    if (len % AES128_KEY_SIZE)
+    {
+        return -1;
+    }
+
+    for (; len != 0; len -= AES128_KEY_SIZE)
+    {
+        for (i = 0; i < AES128_KEY_SIZE; i++)
+        {
+            block[i] = in[i] ^ iv[i];
+        }
+
+        aes_encr(ctx->ulEncKey, block, out);
+        memcpy(iv, out, AES128_KEY_SIZE);
+
+        in += AES128_KEY_SIZE;
+        out += AES128_KEY_SIZE;
+    }
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//!  aes_cbc_decrypt
+//!
+//!  @param[in]     ctx   AES128 context
+//!  @param[in\out] iv    16 bytes initialization vector, updated so that a
+//!                       further call continues the chain
+//!  @param[in]     in    cipher text
+//!  @param[out]    out   plain text, may be in
+//!  @param[in]     len   length of the text, a multiple of 16 bytes
+//!
+//!  @return  0 on success, -1 if len is not a multiple of 16 bytes
+//!
+//!  @brief   AES128 decryption in mode CBC (Cipher Block Chaining).
+//!
+//*****************************************************************************
+signed long aes_cbc_decrypt(const tAesContext *ctx, unsigned char *iv,
+                            const unsigned char *in, unsigned char *out,
+                            unsigned long len)
+{
+    unsigned char block[AES128_KEY_SIZE];
+    unsigned char cipher[AES128_KEY_SIZE];
+    int i;
+
+    if (len % AES128_KEY_SIZE)
+    {
+        return -1;
+    }
+
+    for (; len != 0; len -= AES128_KEY_SIZE)
+    {
+        // Keep the cipher text, out may overwrite it
+        memcpy(cipher, in, AES128_KEY_SIZE);
+        aes_decr(ctx->ulDecKey, cipher, block);
+
+        for (i = 0; i < AES128_KEY_SIZE; i++)
+        {
+            out[i] = block[i] ^ iv[i];
+        }
+        memcpy(iv, cipher, AES128_KEY_SIZE);
+
+        in += AES128_KEY_SIZE;
+        out += AES128_KEY_SIZE;
+    }
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//!  aes_ctr_crypt
+//!
+//!  @param[in]     ctx      AES128 context
+//!  @param[in\out] counter  16 bytes counter block, incremented as a 128-bit
+//!                          big endian number for every block used
+//!  @param[in]     in       plain or cipher text
+//!  @param[out]    out      cipher or plain text, may be in
+//!  @param[in]     len      length of the text in bytes
+//!
+//!  @return  none
+//!
+//!  @brief   AES128 encryption and decryption in mode CTR (Counter). A last
+//!           partial block uses up a whole counter value, so only the final
+//!           call of a message may have a length that is not a multiple of
+//!           16 bytes.
+//!
+//*****************************************************************************
+void aes_ctr_crypt(const tAesContext *ctx, unsigned char *counter,
+                   const unsigned char *in, unsigned char *out,
+                   unsigned long len)
+{
+    unsigned char stream[AES128_KEY_SIZE];
+    unsigned long n;
+    unsigned long i;
+
+    while (len != 0)
+    {
+        aes_encr(ctx->ulEncKey, counter, stream);
+
+        for (i = AES128_KEY_SIZE; i > 0; i--)
+        {
+            if (++counter[i - 1] != 0)
+            {
+                break;
+            }
+        }
+
+        n = (len < AES128_KEY_SIZE) ? len : AES128_KEY_SIZE;
+        for (i = 0; i < n; i++)
+        {
+            out[i] = in[i] ^ stream[i];
+        }
+
+        in += n;
+        out += n;
+        len -= n;
+    }
 }
 
 //*****************************************************************************
@@ -89,76 +89,946 @@
 
 #define MDNS_DEVICE_SERVICE_MAX_LENGTH  (32)
 
+#ifndef CC3000_TINY_DRIVER
+
+// Number of host names gethostbyname() remembers
+#ifndef DNS_CACHE_ENTRIES
+#define DNS_CACHE_ENTRIES               (4)
+#endif
+
+// Longest host name kept in the cache, longer names always go to the CC3000
+#ifndef DNS_CACHE_NAME_LENGTH
+#define DNS_CACHE_NAME_LENGTH           (64)
+#endif
+
+// Ticks a resolved address and a failed lookup are remembered. The CC3000
+// does not report the DNS record TTL. 0 disables caching of that kind
+#ifndef DNS_CACHE_TTL_TICKS
+#define DNS_CACHE_TTL_TICKS             (300000)
+#endif
+
+#ifndef DNS_CACHE_NEGATIVE_TTL_TICKS
+#define DNS_CACHE_NEGATIVE_TTL_TICKS    (10000)
+#endif
+
+typedef struct
+{
+    unsigned long   ulExpires;
+    unsigned long   ulIpAddr;
+    int             iRetVal;
+    unsigned char   ucPermanent;
+    unsigned char   ucNameLen;      // 0 if the entry is free
+    char            cName[DNS_CACHE_NAME_LENGTH];
+}tDnsCacheEntry;
+
+static tDnsCacheEntry dnsCache[DNS_CACHE_ENTRIES];
+
+// Odd while the cache is being written. Lookups do not lock, they retry on
+// the CC3000 if the count changed under them
+static volatile unsigned long dnsCacheSeq;
+
+// Sockets that can coalesce small send()s at a time, see
+// SOCKOPT_SEND_COALESCE
+#ifndef SEND_COALESCE_BUFFERS
+#define SEND_COALESCE_BUFFERS           (2)
+#endif
+
+// Bytes a coalescing socket collects before it sends them. Clamped to the
+// payload of a CC3000 buffer
+#ifndef SEND_COALESCE_SIZE
+#define SEND_COALESCE_SIZE              (512)
+#endif
+
+// How send() sends held data, see send_coalesce_flush(). Sends run under
+// the command lock with __ENABLE_MULTITHREADED_SUPPORT__ and must not wait
+// there for a CC3000 buffer
+#ifdef __ENABLE_MULTITHREADED_SUPPORT__
+#define SEND_COALESCE_WAIT              (0)
+#else
+#define SEND_COALESCE_WAIT              (1)
+#endif
+
+typedef struct
+{
+    long            sd;
+    unsigned long   ulDelay;        // 0 if the buffer is free
+    unsigned long   ulDeadline;
+    unsigned short  usLength;
+    unsigned char   ucData[SEND_COALESCE_SIZE];
+}tSendCoalesce;
+
+static tSendCoalesce sendCoalesce[SEND_COALESCE_BUFFERS];
+
+#endif
+
+static int simple_link_send(long sd, const void *buf, long len, long flags,
+                            const sockaddr *to, long tolen, long opcode);
+
 int connectExpected;
 
+// 1 while the task holding the command lock owns a freeBuffersSem count that
+// it took with flow_control_reserve_buffer() before taking the lock
+static int flowControlReserved;
+
+//*****************************************************************************
+//
+//! tx_buffer_advance
+//!
+//!  @return none
+//!
+//!  @brief  Move pucTxCommandBuffer to the next of the WiFi_TX_BUFFER_COUNT
+//!          buffers in wlan_tx_buffer, leaving the current one to the SPI
+//!          write in flight.
+//
+//*****************************************************************************
+static void
+tx_buffer_advance(void)
+{
+    unsigned long index;
+
+    index = (tSLInformation.pucTxCommandBuffer - wlan_tx_buffer) /
+            WiFi_TX_BUFFER_SIZE;
+    if (++index >= WiFi_TX_BUFFER_COUNT)
+    {
+        index = 0;
+    }
+
+    tSLInformation.pucTxCommandBuffer = wlan_tx_buffer +
+                                        (index * WiFi_TX_BUFFER_SIZE);
+}
+
+//*****************************************************************************
+//
+//! HostFlowControlStatus
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return 0 if the socket can send, -1 in case of bad socket, or the
+//!          error of the last failed transmission
+//!
+//!  @brief  In case the last transmission failed, return its failure reason
+//!          once. No buffer is allocated in that case.
+//
+//*****************************************************************************
+static int
+HostFlowControlStatus(int sd)
+{
+    if (tSLInformation.slTransmitDataError != 0)
+    {
+        errno = tSLInformation.slTransmitDataError;
+        tSLInformation.slTransmitDataError = 0;
+        return errno;
+    }
+
+    if(SOCKET_STATUS_ACTIVE != get_socket_active_status(sd))
+        return -1;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! HostFlowControlWaitBuff
+//!
+//!  @param  sd       socket descriptor
+//!
+//!  @return 0 in case there are buffers available,
+//!          -1 in case of bad socket
+//!          -2 if no buffer became free within the send buffer timeout, or
+//!          if there are no free buffers present and SEND_NON_BLOCKING is
+//!          enabled
+//!
+//!  @brief  Every free CC3000 buffer is one count of freeBuffersSem, posted
+//!          by the flow control event handler. Take one count. If
+//!          SEND_NON_BLOCKING is not defined, pend on it for the send
+//!          buffer timeout, else return immediately with the buffer status.
+//!          A transmit error or a closed socket that happens while blocked
+//!          is reported once a buffer becomes free.
+//
+//*****************************************************************************
+static int
+HostFlowControlWaitBuff(int sd)
+{
+    int res;
+#ifndef SEND_NON_BLOCKING
+    unsigned long timeout = tSLInformation.ulSendBufferTimeout;
+    unsigned long wait;
+#endif
+
+    if (0 != (res = HostFlowControlStatus(sd)))
+    {
+        return res;
+    }
+
+#ifndef SEND_NON_BLOCKING
+    // e_NO_WAIT and e_WAIT_FOREVER are flags of OS_semaphore_pend(), not
+    // tick counts, so the shortest timeout is one tick above them
+    if (timeout == 0)
+    {
+        wait = e_WAIT_FOREVER;
+    }
+    else if (timeout <= e_WAIT_FOREVER)
+    {
+        wait = e_WAIT_FOREVER + 1;
+    }
+    else
+    {
+        wait = timeout;
+    }
+
+    if (e_SUCCESS != OS_semaphore_pend(freeBuffersSem, wait))
+    {
+        return -2;
+    }
+
+    // The socket may have closed or a transmission failed while blocked
+    if (0 != (res = HostFlowControlStatus(sd)))
+    {
+        OS_semaphore_post(freeBuffersSem);
+        return res;
+    }
+#else
+    //If there are no available buffers, return -2. It is recommended to use
+    // select or receive to see if there is any buffer occupied with received data
+    // If so, call receive() to release the buffer.
+    if (e_SUCCESS != OS_semaphore_pend(freeBuffersSem, e_NO_WAIT))
+    {
+        return -2;
+    }
+#endif
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! HostFlowControlConsumeBuff
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return see HostFlowControlWaitBuff
+//!
+//!  @brief  Take one free CC3000 buffer for a send, blocking until one
+//!          becomes available unless SEND_NON_BLOCKING is defined. A
+//!          buffer reserved by the caller is used without waiting.
+//
+//*****************************************************************************
+static int
+HostFlowControlConsumeBuff(int sd)
+{
+    int res;
+
+    if (flowControlReserved)
+    {
+        flowControlReserved = 0;
+    }
+    else if (0 != (res = HostFlowControlWaitBuff(sd)))
+    {
+        return res;
+    }
+
+    tSLInformation.usNumberOfFreeBuffers--;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! flow_control_reserve_buffer
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return see HostFlowControlWaitBuff
+//!
+//!  @brief  Wait for a free CC3000 buffer and take it for the next send,
+//!          so that callers can block before acquiring the command lock.
+//!          Hand it to that send with flow_control_use_reserved(1).
+//
+//*****************************************************************************
+int
+flow_control_reserve_buffer(long sd)
+{
+    return HostFlowControlWaitBuff(sd);
+}
+
+//*****************************************************************************
+//
+//! flow_control_use_reserved
+//!
+//!  @param  use  1 before the send, under the command lock, 0 after it
+//!
+//!  @return none
+//!
+//!  @brief  Let the next send use the buffer taken by
+//!          flow_control_reserve_buffer(). After the send, a buffer it did
+//!          not use, e.g. because the data was coalesced or the send failed
+//!          early, is given back.
+//
+//*****************************************************************************
+void
+flow_control_use_reserved(int use)
+{
+    if (use)
+    {
+        flowControlReserved = 1;
+    }
+    else if (flowControlReserved)
+    {
+        flowControlReserved = 0;
+        OS_semaphore_post(freeBuffersSem);
+    }
+}
+
+//*****************************************************************************
+//
+//! set_send_buffer_timeout
+//!
+//!  @param  ulTimeout  maximum time in ticks send() and sendto() block
+//!                     waiting for a free CC3000 buffer, 0 waits forever.
+//!                     The OSAL reserves 1 as a flag, so it waits 2 ticks
+//!
+//!  @return none
+//!
+//!  @brief  Bound the time a send blocks on flow control. A send that times
+//!          out returns -2 without transmitting. Has no effect when
+//!          SEND_NON_BLOCKING is defined.
+//
+//*****************************************************************************
+void
+set_send_buffer_timeout(unsigned long ulTimeout)
+{
+    tSLInformation.ulSendBufferTimeout = ulTimeout;
+}
+
+//*****************************************************************************
+//
+//! get_flow_control_info
+//!
+//!  @param  info  filled in with the current flow control state
+//!
+//!  @return none
+//!
+//!  @brief  Report the free CC3000 buffers, the size of each buffer and the
+//!          number of packets sent to and released by the device, so an
+//!          application can size its bursts to the credits available.
+//
+//*****************************************************************************
+void
+get_flow_control_info(tFlowControlInfo *info)
+{
+    info->usFreeBuffers = tSLInformation.usNumberOfFreeBuffers;
+    info->usBufferLength = tSLInformation.usSlBufferLength;
+    info->ulSentPackets = tSLInformation.NumberOfSentPackets;
+    info->ulReleasedPackets = tSLInformation.NumberOfReleasedPackets;
+}
+
+#ifndef CC3000_TINY_DRIVER
+//*****************************************************************************
+//
+//! send_coalesce_find
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return the coalescing buffer of the socket, NULL if it has none
+//
+//*****************************************************************************
+static tSendCoalesce *
+send_coalesce_find(long sd)
+{
+    int index;
+
+    for (index = 0; index < SEND_COALESCE_BUFFERS; index++)
+    {
+        if ((sendCoalesce[index].ulDelay != 0) &&
+            (sendCoalesce[index].sd == sd))
+        {
+            return &sendCoalesce[index];
+        }
+    }
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+//! send_coalesce_flush
+//!
+//!  @param  co    coalescing buffer, may be NULL
+//!  @param  wait  1 to send like send_flush(), with the buffer the caller
+//!                reserved or by blocking for one, 0 to send only if a
+//!                CC3000 buffer is free right now and keep the data held
+//!                otherwise
+//!
+//!  @return the number of bytes sent, 0 if nothing was sent, or the error
+//!          of the send
+//!
+//!  @brief  Send the data collected in a coalescing buffer in one HCI send.
+//!          The data stays held if the send fails, unless the socket is
+//!          gone. The receive and select paths must not wait: the buffer
+//!          they would wait for may only be freed by reading.
+//
+//*****************************************************************************
+static int
+send_coalesce_flush(tSendCoalesce *co, int wait)
+{
+    int reserved = 0;
+    int res;
+
+    if ((co == NULL) || (co->usLength == 0))
+    {
+        return 0;
+    }
+
+    if (!wait)
+    {
+        // Take the buffer here and hand it to simple_link_send() as if it
+        // were reserved, setting aside the one the caller reserved before
+        // taking the command lock: that one is for the caller's own data
+        if (e_SUCCESS != OS_semaphore_pend(freeBuffersSem, e_NO_WAIT))
+        {
+            return 0;
+        }
+        reserved = flowControlReserved;
+        flowControlReserved = 1;
+    }
+
+    // simple_link_send() copies the data into the TX buffer
+    res = simple_link_send(co->sd, co->ucData, co->usLength, 0, NULL, 0,
+                           HCI_CMND_SEND);
+    if ((res >= 0) || (res == -1))
+    {
+        co->usLength = 0;
+    }
+
+    if (!wait)
+    {
+        // Gives the buffer back if the send failed before taking it
+        flow_control_use_reserved(0);
+        flowControlReserved = reserved;
+    }
+
+    return res;
+}
+
+//*****************************************************************************
+//
+//! send_coalesce_limit
+//!
+//!  @return the number of bytes a coalescing buffer sends at once
+//
+//*****************************************************************************
+static unsigned short
+send_coalesce_limit(void)
+{
+    unsigned short usPayload;
+
+    usPayload = tSLInformation.usSlBufferLength -
+                (HEADERS_SIZE_DATA + HCI_CMND_SEND_ARG_LENGTH);
+
+    if ((tSLInformation.usSlBufferLength >
+         HEADERS_SIZE_DATA + HCI_CMND_SEND_ARG_LENGTH) &&
+        (usPayload < SEND_COALESCE_SIZE))
+    {
+        return usPayload;
+    }
+
+    return SEND_COALESCE_SIZE;
+}
+
+//*****************************************************************************
+//
+//! send_coalesce_set
+//!
+//!  @param  sd       socket descriptor
+//!  @param  ulDelay  ticks small writes may be held, 0 to stop coalescing
+//!
+//!  @return 0 on success, -1 if no coalescing buffer is free
+//!
+//!  @brief  Start or stop coalescing the send()s of a socket. Stopping sends
+//!          the data still held.
+//
+//*****************************************************************************
+static int
+send_coalesce_set(long sd, unsigned long ulDelay)
+{
+    tSendCoalesce *co = send_coalesce_find(sd);
+    int index;
+
+    if (ulDelay == 0)
+    {
+        if (co != NULL)
+        {
+            send_coalesce_flush(co, 1);
+            co->ulDelay = 0;
+        }
+        return 0;
+    }
+
+    for (index = 0; (co == NULL) && (index < SEND_COALESCE_BUFFERS); index++)
+    {
+        if (sendCoalesce[index].ulDelay == 0)
+        {
+            co = &sendCoalesce[index];
+            co->sd = sd;
+            co->usLength = 0;
+        }
+    }
+
+    if (co == NULL)
+    {
+        return -1;
+    }
+
+    co->ulDelay = ulDelay;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! send_coalesce_write
+//!
+//!  @param  co     coalescing buffer of the socket
+//!  @param  buf    data to send
+//!  @param  len    data length
+//!  @param  flags  send() flags
+//!
+//!  @return len, or the error of a send the write triggered
+//!
+//!  @brief  Append a write to the coalescing buffer, sending the buffer when
+//!          the write does not fit or the deadline of the oldest held data
+//!          has passed. A write of a full buffer or more is sent directly.
+//!          With __ENABLE_MULTITHREADED_SUPPORT__ the held data is only sent
+//!          with a buffer that is free right now, as the command lock is
+//!          held: send() flushes data a write does not fit behind before it
+//!          takes the lock, and the write fails with -2 if data it must
+//!          follow is still held.
+//
+//*****************************************************************************
+static int
+send_coalesce_write(tSendCoalesce *co, const void *buf, long len, long flags)
+{
+    unsigned short usLimit = send_coalesce_limit();
+    unsigned long now = OS_ticks_get();
+    int res;
+
+    if (co->usLength + len > usLimit)
+    {
+        res = send_coalesce_flush(co, SEND_COALESCE_WAIT);
+        if (co->usLength != 0)
+        {
+            return (res < 0) ? res : -2;
+        }
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    if (len >= usLimit)
+    {
+        return simple_link_send(co->sd, buf, len, flags, NULL, 0,
+                                HCI_CMND_SEND);
+    }
+
+    if (co->usLength == 0)
+    {
+        co->ulDeadline = now + co->ulDelay;
+    }
+
+    memcpy(co->ucData + co->usLength, buf, len);
+    co->usLength += len;
+
+    if ((co->usLength == usLimit) || ((long)(now - co->ulDeadline) >= 0))
+    {
+        // The write is taken even if the data has to stay held, unless the
+        // socket is gone
+        res = send_coalesce_flush(co, SEND_COALESCE_WAIT);
+        if ((res < 0) && (co->usLength == 0))
+        {
+            return res;
+        }
+    }
+
+    return len;
+}
+
 //*****************************************************************************
 //
-//! HostFlowControlConsumeBuff
+//! send_coalesce_flush_expired
+//!
+//!  @return the number of sockets still holding coalesced data
+//!
+//!  @brief  Send the coalesced data whose deadline has passed, as far as
+//!          free CC3000 buffers allow without waiting.
+//
+//*****************************************************************************
+int
+send_coalesce_flush_expired(void)
+{
+    unsigned long now = OS_ticks_get();
+    int pending = 0;
+    int index;
+
+    for (index = 0; index < SEND_COALESCE_BUFFERS; index++)
+    {
+        if ((sendCoalesce[index].ulDelay == 0) ||
+            (sendCoalesce[index].usLength == 0))
+        {
+            continue;
+        }
+
+        if ((long)(now - sendCoalesce[index].ulDeadline) >= 0)
+        {
+            send_coalesce_flush(&sendCoalesce[index], 0);
+        }
+
+        // Still held if it is not due or could not be sent yet
+        if (sendCoalesce[index].usLength != 0)
+        {
+            pending++;
+        }
+    }
+
+    return pending;
+}
+
+//*****************************************************************************
+//
+//! send_coalesce_ticks_left
+//!
+//!  @return the ticks until the earliest coalescing deadline, 0 if one has
+//!          passed, or -1 if no data is held
+//!
+//!  @brief  Tells the thread that sends the expired data how long it can
+//!          sleep.
+//
+//*****************************************************************************
+long
+send_coalesce_ticks_left(void)
+{
+    unsigned long now = OS_ticks_get();
+    long left = -1;
+    long ticks;
+    int index;
+
+    for (index = 0; index < SEND_COALESCE_BUFFERS; index++)
+    {
+        if ((sendCoalesce[index].ulDelay == 0) ||
+            (sendCoalesce[index].usLength == 0))
+        {
+            continue;
+        }
+
+        ticks = (long)(sendCoalesce[index].ulDeadline - now);
+        if (ticks < 0)
+        {
+            ticks = 0;
+        }
+        if ((left < 0) || (ticks < left))
+        {
+            left = ticks;
+        }
+    }
+
+    return left;
+}
+
+//*****************************************************************************
+//
+//! send_coalesce_try_flush
 //!
 //!  @param  sd  socket descriptor
 //!
-//!  @return 0 in case there are buffers available,
-//!          -1 in case of bad socket
-//!          -2 if there are no free buffers present (only when
-//!          SEND_NON_BLOCKING is enabled)
+//!  @return the number of bytes sent, 0 if nothing was held or no CC3000
+//!          buffer is free, or the error of the send
+//!
+//!  @brief  Send the data the socket is holding if that does not need to
+//!          wait for a CC3000 buffer. Used before a read, whose answer may
+//!          depend on the held data.
+//
+//*****************************************************************************
+int
+send_coalesce_try_flush(long sd)
+{
+    return send_coalesce_flush(send_coalesce_find(sd), 0);
+}
+
+//*****************************************************************************
+//
+//! send_coalesce_must_flush
+//!
+//!  @param  sd   socket descriptor
+//!  @param  len  length of the next write, -1 for any held data
+//!
+//!  @return 1 if the socket holds data that has to be sent before a write
+//!          of len bytes, 0 otherwise
+//!
+//!  @brief  Lets send() flush with its own reserved buffer before it takes
+//!          the command lock. Reads the coalescing state without the lock,
+//!          the send checks again under it.
+//
+//*****************************************************************************
+int
+send_coalesce_must_flush(long sd, long len)
+{
+    tSendCoalesce *co = send_coalesce_find(sd);
+
+    if ((co == NULL) || (co->usLength == 0))
+    {
+        return 0;
+    }
+
+    return (len < 0) || (co->usLength + len > send_coalesce_limit());
+}
+
+//*****************************************************************************
+//
+//! send_coalesce_reset
+//!
+//!  @return none
+//!
+//!  @brief  Drop every coalescing buffer. The sockets they belonged to are
+//!          gone once the CC3000 restarts.
+//
+//*****************************************************************************
+void
+send_coalesce_reset(void)
+{
+    int index;
+
+    for (index = 0; index < SEND_COALESCE_BUFFERS; index++)
+    {
+        sendCoalesce[index].ulDelay = 0;
+        sendCoalesce[index].usLength = 0;
+    }
+}
+
+//*****************************************************************************
+//
+//! send_flush
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return the number of bytes sent, 0 if nothing was held, or the error
+//!          of the send
+//!
+//!  @brief  Send the data a SOCKOPT_SEND_COALESCE socket is holding now.
+//
+//*****************************************************************************
+#ifdef __ENABLE_MULTITHREADED_SUPPORT__
+int
+c_send_flush(long sd)
+#else /* __ENABLE_MULTITHREADED_SUPPORT__ */
+int
+send_flush(long sd)
+#endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
+{
+    return send_coalesce_flush(send_coalesce_find(sd), 1);
+}
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+//*****************************************************************************
+//
+//! dns_cache_store
 //!
-//!  @brief  if SEND_NON_BLOCKING not define - block until have free buffer
-//!          becomes available, else return immediately  with correct status
-//!          regarding the buffers available.
+//!  @param  hostname   host name
+//!  @param  usNameLen  name length
+//!  @param  ulIpAddr   address of the host, 0 if it did not resolve
+//!  @param  iRetVal    value gethostbyname() returns for the host
+//!  @param  ulTtl      ticks the entry is valid, 0 never expires
+//!
+//!  @return 0 if the entry was stored, -1 otherwise
+//!
+//!  @brief  Store a lookup result, replacing the entry for the same name, a
+//!          free or expired entry, or else the entry expiring first.
+//!          Permanent entries are only replaced by name. Writers must be
+//!          serialized by the caller.
 //
 //*****************************************************************************
 static int
-HostFlowControlConsumeBuff(int sd)
+dns_cache_store(char *hostname, unsigned short usNameLen,
+                unsigned long ulIpAddr, int iRetVal, unsigned long ulTtl)
 {
-#ifndef SEND_NON_BLOCKING
-    /* wait in busy loop */
-    do
+    tDnsCacheEntry *entry;
+    tDnsCacheEntry *victim = NULL;
+    unsigned long now = OS_ticks_get();
+    int index;
+
+    if ((usNameLen == 0) || (usNameLen > DNS_CACHE_NAME_LENGTH))
+    {
+        return -1;
+    }
+
+    for (index = 0; index < DNS_CACHE_ENTRIES; index++)
     {
-        // In case last transmission failed then we will return the last failure
-        // reason here.
-        // Note that the buffer will not be allocated in this case
-        if (tSLInformation.slTransmitDataError != 0)
+        entry = &dnsCache[index];
+
+        if ((entry->ucNameLen == usNameLen) &&
+            (memcmp(entry->cName, hostname, usNameLen) == 0))
+        {
+            victim = entry;
+            break;
+        }
+
+        if ((entry->ucNameLen == 0) ||
+            (!entry->ucPermanent && ((long)(now - entry->ulExpires) >= 0)))
+        {
+            if ((victim == NULL) || (victim->ucNameLen != 0))
+            {
+                victim = entry;
+            }
+        }
+        else if (!entry->ucPermanent &&
+                 ((victim == NULL) || ((victim->ucNameLen != 0) &&
+                  ((long)(entry->ulExpires - victim->ulExpires) < 0))))
         {
-            errno = tSLInformation.slTransmitDataError;
-            tSLInformation.slTransmitDataError = 0;
-            return errno;
+            victim = entry;
         }
+    }
+
+    if (victim == NULL)
+    {
+        return -1;
+    }
 
-        if(SOCKET_STATUS_ACTIVE != get_socket_active_status(sd))
-            return -1;
-    } while(0 == tSLInformation.usNumberOfFreeBuffers);
+    dnsCacheSeq++;
 
-    tSLInformation.usNumberOfFreeBuffers--;
+    victim->ucNameLen = (unsigned char)usNameLen;
+    memcpy(victim->cName, hostname, usNameLen);
+    victim->ulIpAddr = ulIpAddr;
+    victim->iRetVal = iRetVal;
+    victim->ucPermanent = (ulTtl == 0);
+    victim->ulExpires = now + ulTtl;
+
+    dnsCacheSeq++;
 
     return 0;
-#else
+}
 
-    // In case last transmission failed then we will return the last failure
-    // reason here.
-    // Note that the buffer will not be allocated in this case
-    if (tSLInformation.slTransmitDataError != 0)
+//*****************************************************************************
+//
+//! gethostbyname_cache_lookup
+//!
+//!  @param[in]   hostname     host name
+//!  @param[in]   usNameLen    name length
+//!  @param[out]  out_ip_addr  cached host IP address, zero for a cached
+//!                            failure
+//!  @param[out]  retVal       cached gethostbyname() return value
+//!
+//!  @return 1 on a cache hit, 0 otherwise
+//!
+//!  @brief  Look a host up in the gethostbyname() cache without locking or
+//!          talking to the CC3000. A lookup that races with an update of
+//!          the cache reports a miss.
+//
+//*****************************************************************************
+int
+gethostbyname_cache_lookup(char *hostname, unsigned short usNameLen,
+                           unsigned long *out_ip_addr, int *retVal)
+{
+    tDnsCacheEntry *entry;
+    unsigned long seq = dnsCacheSeq;
+    unsigned long now = OS_ticks_get();
+    unsigned long ulIpAddr = 0;
+    int iRetVal = 0;
+    int hit = 0;
+    int index;
+
+    if (seq & 1)
     {
-        errno = tSLInformation.slTransmitDataError;
-        tSLInformation.slTransmitDataError = 0;
-        return errno;
+        return 0;
     }
-    if(SOCKET_STATUS_ACTIVE != get_socket_active_status(sd))
-        return -1;
 
-    //If there are no available buffers, return -2. It is recommended to use
-    // select or receive to see if there is any buffer occupied with received data
-    // If so, call receive() to release the buffer.
-    if(0 == tSLInformation.usNumberOfFreeBuffers)
+    for (index = 0; index < DNS_CACHE_ENTRIES; index++)
     {
-        return -2;
+        entry = &dnsCache[index];
+
+        if ((entry->ucNameLen == usNameLen) && (usNameLen != 0) &&
+            (memcmp(entry->cName, hostname, usNameLen) == 0))
+        {
+            if (entry->ucPermanent ||
+                ((long)(now - entry->ulExpires) < 0))
+            {
+                ulIpAddr = entry->ulIpAddr;
+                iRetVal = entry->iRetVal;
+                hit = 1;
+            }
+            break;
+        }
     }
-    else
+
+    if (!hit || (dnsCacheSeq != seq))
     {
-        tSLInformation.usNumberOfFreeBuffers--;
         return 0;
     }
-#endif
+
+    *out_ip_addr = ulIpAddr;
+    *retVal = iRetVal;
+
+    return 1;
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_add
+//!
+//!  @param  hostname   host name
+//!  @param  usNameLen  name length
+//!  @param  ulIpAddr   IP address gethostbyname() returns for the host
+//!  @param  ulTtl      ticks the entry is valid, 0 keeps it until flushed
+//!
+//!  @return 0 on success, -1 if the name is too long or every entry is
+//!          permanent
+//!
+//!  @brief  Prefill the gethostbyname() cache, e.g. with the brokers an
+//!          application always connects to.
+//
+//*****************************************************************************
+#ifdef __ENABLE_MULTITHREADED_SUPPORT__
+int
+c_gethostbyname_cache_add(char *hostname, unsigned short usNameLen,
+                          unsigned long ulIpAddr, unsigned long ulTtl)
+#else /* __ENABLE_MULTITHREADED_SUPPORT__ */
+int
+gethostbyname_cache_add(char *hostname, unsigned short usNameLen,
+                        unsigned long ulIpAddr, unsigned long ulTtl)
+#endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
+{
+    return dns_cache_store(hostname, usNameLen, ulIpAddr, 1, ulTtl);
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_flush
+//!
+//!  @return none
+//!
+//!  @brief  Forget every cached host, including the permanent ones, e.g.
+//!          after joining a different network.
+//
+//*****************************************************************************
+#ifdef __ENABLE_MULTITHREADED_SUPPORT__
+void
+c_gethostbyname_cache_flush(void)
+#else /* __ENABLE_MULTITHREADED_SUPPORT__ */
+void
+gethostbyname_cache_flush(void)
+#endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
+{
+    int index;
+
+    dnsCacheSeq++;
+
+    for (index = 0; index < DNS_CACHE_ENTRIES; index++)
+    {
+        dnsCache[index].ucNameLen = 0;
+    }
+
+    dnsCacheSeq++;
 }
+#endif
 
 //*****************************************************************************
 //
@@ -235,6 +1105,11 @@ long closesocket(long sd)
     long ret;
     unsigned char *ptr, *args;
 
+#ifndef CC3000_TINY_DRIVER
+    // Send what the socket still holds and release its coalescing buffer
+    send_coalesce_set(sd, 0);
+#endif
+
     ret = EFAIL;
     ptr = tSLInformation.pucTxCommandBuffer;
     args = (ptr + HEADERS_SIZE_CMD);
@@ -480,6 +1355,8 @@ gethostbyname(char * hostname, unsigned short usNameLen, unsigned long* out_ip_a
 {
     tBsdGethostbynameParams ret;
     unsigned char *ptr, *args;
+    unsigned long ulTtl;
+    int retVal;
 
     errno = EFAIL;
 
@@ -488,6 +1365,12 @@ gethostbyname(char * hostname, unsigned short usNameLen, unsigned long* out_ip_a
         return errno;
     }
 
+    if (gethostbyname_cache_lookup(hostname, usNameLen, out_ip_addr, &retVal))
+    {
+        errno = retVal;
+        return (errno);
+    }
+
     ptr = tSLInformation.pucTxCommandBuffer;
     args = (ptr + SIMPLE_LINK_HCI_CMND_TRANSPORT_HEADER_SIZE);
 
@@ -507,6 +1390,15 @@ gethostbyname(char * hostname, unsigned short usNameLen, unsigned long* out_ip_a
 
     (*((long*)out_ip_addr)) = ret.outputAddress;
 
+    // Remember failures too, for a shorter time
+    ulTtl = ((ret.retVal < 0) || (ret.outputAddress == 0)) ?
+            DNS_CACHE_NEGATIVE_TTL_TICKS : DNS_CACHE_TTL_TICKS;
+    if (ulTtl != 0)
+    {
+        dns_cache_store(hostname, usNameLen, ret.outputAddress, ret.retVal,
+                        ulTtl);
+    }
+
     return (errno);
 
 }
@@ -628,6 +1520,21 @@ int select(long nfds, fd_set *readsds, fd_set *writesds,
     tBsdSelectRecvParams tParams;
     unsigned long is_blocking;
 
+#ifndef CC3000_TINY_DRIVER
+    int index;
+
+    // Readers wait for answers to what they sent, do not hold it back
+    for (index = 0; readsds && (index < SEND_COALESCE_BUFFERS); index++)
+    {
+        if ((sendCoalesce[index].ulDelay != 0) &&
+            FD_ISSET(sendCoalesce[index].sd, readsds))
+        {
+            send_coalesce_flush(&sendCoalesce[index], 0);
+        }
+    }
+    send_coalesce_flush_expired();
+#endif
+
     if( timeout == NULL)
     {
         is_blocking = 1; /* blocking , infinity timeout */
@@ -738,6 +1645,13 @@ int select(long nfds, fd_set *readsds, fd_set *writesds,
 //!            2. SOCKOPT_NONBLOCK (optname). sets the socket non-blocking mode on
 //!           or off.
 //!             In that case optval should be SOCK_ON or SOCK_OFF (optval).
+//!            3. SOCKOPT_SEND_COALESCE (optname), handled by the host.
+//!           send() collects small writes for up to optval ticks or until
+//!           a CC3000 buffer is full, then sends them at once. optval is a
+//!           pointer to unsigned long, 0 stops coalescing. send_flush()
+//!           and closesocket() send held data early. recv(), recvfrom()
+//!           and select() for read do so only if a CC3000 buffer is free,
+//!           they never wait for one.
 //!
 //!  @sa getsockopt
 //
@@ -755,6 +1669,20 @@ setsockopt(long sd, long level, long optname, const void *optval, socklen_t optl
     int ret;
     unsigned char *ptr, *args;
 
+    // Handled by the host, the CC3000 does not know this option
+    if ((level == SOL_SOCKET) && (optname == SOCKOPT_SEND_COALESCE))
+    {
+        if ((optval == NULL) || (optlen < sizeof(unsigned long)) ||
+            (SOCKET_STATUS_ACTIVE != get_socket_active_status(sd)))
+        {
+            errno = EFAIL;
+            return (errno);
+        }
+
+        errno = send_coalesce_set(sd, *(const unsigned long *)optval);
+        return (errno);
+    }
+
     ptr = tSLInformation.pucTxCommandBuffer;
     args = (ptr + HEADERS_SIZE_CMD);
 
@@ -842,6 +1770,18 @@ int getsockopt(long sd, long level, long optname, void *optval,
     unsigned char *ptr, *args;
     tBsdGetSockOptReturnParams  tRetParams;
 
+#ifndef CC3000_TINY_DRIVER
+    tSendCoalesce *co;
+
+    if ((level == SOL_SOCKET) && (optname == SOCKOPT_SEND_COALESCE))
+    {
+        co = send_coalesce_find(sd);
+        *(unsigned long *)optval = (co != NULL) ? co->ulDelay : 0;
+        *optlen = 4;
+        return (0);
+    }
+#endif
+
     ptr = tSLInformation.pucTxCommandBuffer;
     args = (ptr + HEADERS_SIZE_CMD);
 
@@ -898,6 +1838,11 @@ simple_link_recv(long sd, void *buf, long len, long flags, sockaddr *from,
     unsigned char *ptr, *args;
     tBsdReadReturnParams tSocketReadEvent;
 
+#ifndef CC3000_TINY_DRIVER
+    // The answer may depend on data the socket is still holding
+    send_coalesce_flush(send_coalesce_find(sd), 0);
+#endif
+
     ptr = tSLInformation.pucTxCommandBuffer;
     args = (ptr + HEADERS_SIZE_CMD);
 
@@ -906,6 +1851,13 @@ simple_link_recv(long sd, void *buf, long len, long flags, sockaddr *from,
     args = UINT32_TO_STREAM(args, len);
     args = UINT32_TO_STREAM(args, flags);
 
+    // Offer buf to the SPI layer for the payload. The data packet may be
+    // read as soon as the event below is handled, so do it before sending.
+    tSLInformation.usRxUserBufferFilled = 0;
+    tSLInformation.usRxUserBufferLength = (len <= 0) ? 0 :
+                                          (len > 0xFFFF) ? 0xFFFF : len;
+    tSLInformation.pucRxUserBuffer = buf;
+
     // Generate the read command, and wait for the
     hci_command_send(opcode,  ptr, SOCKET_RECV_FROM_PARAMS_LEN);
 
@@ -920,6 +1872,8 @@ simple_link_recv(long sd, void *buf, long len, long flags, sockaddr *from,
         SimpleLinkWaitData(buf, (unsigned char *)from, (unsigned char *)fromlen);
     }
 
+    tSLInformation.pucRxUserBuffer = NULL;
+
     errno = tSocketReadEvent.iNumberOfBytes;
 
     return(tSocketReadEvent.iNumberOfBytes);
@@ -1086,12 +2040,23 @@ simple_link_send(long sd, const void *buf, long len, long flags,
         ARRAY_TO_STREAM(pDataPtr, ((unsigned char *)to), tolen);
     }
 
-    // Initiate a HCI command
-    hci_data_send(opcode, ptr, uArgSize, len,(unsigned char*)to, tolen);
-    if (opcode == HCI_CMND_SENDTO)
-        SimpleLinkWaitEvent(HCI_EVNT_SENDTO, &tSocketSendEvent);
+    if (WiFi_TX_BUFFER_COUNT > 1)
+    {
+        // Post the packet and format the next command into the following TX
+        // buffer while this one is clocked out. The send event is consumed
+        // by hci_unsol_event_handler.
+        hci_data_post(opcode, ptr, uArgSize, len,(unsigned char*)to, tolen);
+        tx_buffer_advance();
+    }
     else
-        SimpleLinkWaitEvent(HCI_EVNT_SEND, &tSocketSendEvent);
+    {
+        // Initiate a HCI command
+        hci_data_send(opcode, ptr, uArgSize, len,(unsigned char*)to, tolen);
+        if (opcode == HCI_CMND_SENDTO)
+            SimpleLinkWaitEvent(HCI_EVNT_SENDTO, &tSocketSendEvent);
+        else
+            SimpleLinkWaitEvent(HCI_EVNT_SEND, &tSocketSendEvent);
+    }
 
     return  (len);
 }
@@ -1124,6 +2089,17 @@ int c_send(long sd, const void *buf, long len, long flags)
 int send(long sd, const void *buf, long len, long flags)
 #endif /* __ENABLE_MULTITHREADED_SUPPORT__ */
 {
+#ifndef CC3000_TINY_DRIVER
+    tSendCoalesce *co = send_coalesce_find(sd);
+
+    send_coalesce_flush_expired();
+
+    if (co != NULL)
+    {
+        return(send_coalesce_write(co, buf, len, flags));
+    }
+#endif
+
     return(simple_link_send(sd, buf, len, flags, NULL, 0, HCI_CMND_SEND));
 }
 
@@ -53,6 +53,7 @@
 volatile sSimplLinkInformation tSLInformation;
 
 SemaphoreHandle eventOrDataReceivedSem;
+SemaphoreHandle freeBuffersSem;
 
 #define SMART_CONFIG_PROFILE_SIZE       67      // 67 = 32 (max ssid) + 32 (max key) + 1 (SSID length) + 1 (security type) + 1 (key length)
 
@@ -293,12 +294,21 @@ void wlan_start(unsigned short usPatchesAvailableAtHost)
     tSLInformation.slTransmitDataError = 0;
     tSLInformation.usEventOrDataReceived = 0;
     tSLInformation.pucReceivedData = 0;
+    tSLInformation.pucRxUserBuffer = 0;
+    tSLInformation.usRxUserBufferFilled = 0;
+
+#ifndef CC3000_TINY_DRIVER
+    send_coalesce_reset();
+#endif
 
     // Allocate the memory for the RX/TX data transactions
     tSLInformation.pucTxCommandBuffer = (unsigned char *)wlan_tx_buffer;
 
     OS_semaphore_create(&eventOrDataReceivedSem, "EvntHandlerSem", e_MODE_BINARY, 0);
 
+    // One count per free CC3000 buffer, posted by the flow control events
+    OS_semaphore_create(&freeBuffersSem, "FreeBuffersSem", e_MODE_COUNTING, 0);
+
     // init spi
     SpiOpen(SpiReceiveHandler);
 
@@ -369,6 +379,7 @@ void wlan_stop(void)
     }
 
     OS_semaphore_delete(&eventOrDataReceivedSem);
+    OS_semaphore_delete(&freeBuffersSem);
 
     SpiClose();
 }
@@ -71,9 +71,8 @@ extern MutexKey                mtx_key;
 void aes_encrypt(unsigned char *state,
                  unsigned char *key)
 {
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    // No shared state, the key schedule lives on the caller's stack
     c_aes_encrypt(state, key);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
 }
 
 //*****************************************************************************
@@ -96,9 +95,8 @@ void aes_encrypt(unsigned char *state,
 void aes_decrypt(unsigned char *state,
                  unsigned char *key)
 {
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    // No shared state, the key schedule lives on the caller's stack
     c_aes_decrypt(state, key);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
 }
 
 //*****************************************************************************
@@ -43,6 +43,7 @@
 #include <cc3000_host_driver/include/wlan.h>
 
 #include <cc3000_host_driver/core_driver/inc/socket.h>
+#include <cc3000_host_driver/core_driver/inc/evnt_handler.h>
 
 #include <osal/inc/osal.h>
 #include <string.h>
@@ -52,6 +53,7 @@ extern wlan_socket_t           g_sockets[MAX_NUM_OF_SOCKETS];
 /* Handles for making the APIs asychronous and thread-safe */
 extern SemaphoreHandle         g_accept_semaphore;
 extern SemaphoreHandle         g_select_sleep_semaphore;
+extern SemaphoreHandle         g_select_wake_semaphore;
 extern MutexHandle             g_main_mutex;
 extern MutexKey                mtx_key;
 
@@ -61,6 +63,8 @@ extern int                     g_wlan_stopped;
 extern int                     g_accept_new_sd;
 extern int                     g_accept_addrlen;
 extern int                     g_should_poll_accept;
+extern volatile unsigned int   g_cmd_count;
+extern int                     g_send_coalesce_held;
 
 //Enable this flag if and only if you must comply with BSD socket close() function
 #ifdef _API_USE_BSD_CLOSE
@@ -74,6 +78,95 @@ extern int                     g_should_poll_accept;
 #endif
 
 
+//*****************************************************************************
+//
+//  The CC3000 host interface tracks a single outstanding HCI request, so
+//  commands stay serialized on g_main_mutex. What is kept out of it is the
+//  waiting: readers wait for data on their socket semaphore and senders
+//  reserve a free CC3000 buffer before taking the lock, so a send never
+//  blocks in flow control while holding it. g_cmd_count lets the
+//  SelectThread notice socket traffic and keep its own select() short so it
+//  does not hold the channel against the senders.
+//
+//*****************************************************************************
+
+static void cmd_lock(void)
+{
+    OS_mutex_lock(g_main_mutex, &mtx_key);
+    g_cmd_count++;
+}
+
+static void cmd_unlock(void)
+{
+    OS_mutex_unlock(g_main_mutex, mtx_key);
+}
+
+//*****************************************************************************
+//
+//  Take a free CC3000 buffer without holding the command channel, waiting
+//  for one if needed. The c_send()/c_sendto() that follows uses it through
+//  flow_control_use_reserved(), so another sender cannot take it in between
+//  and the send does not stall the other sockets in its flow control.
+//  Returns 0 or the error the send should fail with.
+//
+//*****************************************************************************
+
+static int reserve_free_buffer(long sd)
+{
+    if (g_wlan_stopped) {
+        return -1;
+    }
+
+    return flow_control_reserve_buffer(sd);
+}
+
+//*****************************************************************************
+//
+//  The answer a reader waits for may depend on data its socket still holds
+//  for SOCKOPT_SEND_COALESCE, so send that first. This never waits for a
+//  CC3000 buffer: the one it would wait for may only be freed by reading.
+//  Data that cannot go out now is sent by the SelectThread at its deadline.
+//
+//*****************************************************************************
+
+static void send_coalesce_before_read(long sd)
+{
+#ifndef CC3000_TINY_DRIVER
+    if (g_send_coalesce_held) {
+        cmd_lock();
+        send_coalesce_try_flush(sd);
+        cmd_unlock();
+    }
+#endif
+}
+
+//*****************************************************************************
+//
+//  Send the data a SOCKOPT_SEND_COALESCE socket holds before a call that
+//  would have to send it under the command lock: a write of len bytes it
+//  does not fit in front of, or closing or reconfiguring the socket (len
+//  -1). send_flush() reserves a CC3000 buffer of its own before it takes
+//  the lock, the buffer reserved for the write is left for the write.
+//  Returns 0 or the error of the flush.
+//
+//*****************************************************************************
+
+static int send_coalesce_before_send(long sd, long len)
+{
+#ifndef CC3000_TINY_DRIVER
+    int ret;
+
+    if (send_coalesce_must_flush(sd, len)) {
+        ret = send_flush(sd);
+        if (ret < 0) {
+            return(ret);
+        }
+    }
+#endif
+
+    return(0);
+}
+
 static void find_add_next_free_socket(int sd)
 {
     int index = 0;
@@ -93,6 +186,7 @@ static void find_clear_socket(int sd)
         if (g_sockets[index].sd == sd){
             g_sockets[index].status = SOC_NOT_INITED;
             g_sockets[index].sd = -1;
+            g_sockets[index].waiting = 0;
         }
     }
 }
@@ -124,12 +218,12 @@ socket(long domain, long type, long protocol)
 {
     int ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    cmd_lock();
     ret = c_socket(domain, type, protocol);
     /*if the value is not error then add to our array for later reference */
     if (-1 != ret)
         find_add_next_free_socket(ret);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
@@ -151,13 +245,15 @@ closesocket(long sd)
 {
     int ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    send_coalesce_before_send(sd, -1);
+
+    cmd_lock();
     ret = c_closesocket(sd);
     /* remove from our array if no error */
     if (0 == ret){
         find_clear_socket(sd);
     }
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
@@ -212,20 +308,23 @@ accept(long sd, sockaddr *addr, socklen_t *addrlen)
 {
     char val;
     int index = 0;
+    int found = -1;
 	int retSock;
 
     /* set socket options to non blocking for accept polling purposes */
     val = SOCK_ON;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    cmd_lock();
     c_setsockopt( sd, SOL_SOCKET, SOCKOPT_NONBLOCK, &val, sizeof(val));
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     OS_semaphore_post(g_select_sleep_semaphore); /* wakeup select thread if needed */
 
     for (index = 0; index < MAX_NUM_OF_SOCKETS; index++){
         if (g_sockets[index].sd == sd) {
+            found = index;
             g_sockets[index].status = SOC_ACCEPTING;
+            OS_semaphore_post(g_select_wake_semaphore);
             OS_semaphore_pend(g_sockets[index].sd_semaphore, e_WAIT_FOREVER);
             break;
         }
@@ -238,7 +337,9 @@ accept(long sd, sockaddr *addr, socklen_t *addrlen)
         return -1;
     }
 
-    g_sockets[sd].status = SOCK_ON;
+    if (found >= 0) {
+        g_sockets[found].status = SOCK_ON;
+    }
 
     memcpy(addr, &g_accept_sock_addr, g_accept_addrlen);
     memcpy(addrlen, &g_accept_addrlen, sizeof(socklen_t));
@@ -249,7 +350,9 @@ accept(long sd, sockaddr *addr, socklen_t *addrlen)
     /* New socket created and accept success or SOC_ERROR
        If sock error do not take an empty place in the sockets array */
     if (retSock != SOC_ERROR) {
+        cmd_lock();
         find_add_next_free_socket(retSock);
+        cmd_unlock();
     }
 
     return retSock;
@@ -283,9 +386,9 @@ bind(long sd, const sockaddr *addr, long addrlen)
 {
     long ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    cmd_lock();
     ret = c_bind(sd, addr, addrlen);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
@@ -318,9 +421,9 @@ listen(long sd, long backlog)
 {
     long ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    cmd_lock();
     ret = c_listen(sd, backlog);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
@@ -350,12 +453,67 @@ gethostbyname(char * hostname, unsigned short usNameLen, unsigned long* out_ip_a
 {
     int ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    // A cached host is answered without the command channel
+    if ((usNameLen <= HOSTNAME_MAX_LENGTH) &&
+        gethostbyname_cache_lookup(hostname, usNameLen, out_ip_addr, &ret)) {
+        errno = ret;
+        return(ret);
+    }
+
+    cmd_lock();
     ret = c_gethostbyname(hostname, usNameLen, out_ip_addr);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
+
+    return(ret);
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_add
+//!
+//!  @param  hostname   host name
+//!  @param  usNameLen  name length
+//!  @param  ulIpAddr   IP address gethostbyname() returns for the host
+//!  @param  ulTtl      ticks the entry is valid, 0 keeps it until flushed
+//!
+//!  @return 0 on success, -1 if the name is too long or every entry is
+//!          permanent
+//!
+//!  @brief  Prefill the gethostbyname() cache. Takes the command lock only
+//!          to serialize with the lookups that update the cache.
+//
+//*****************************************************************************
+
+int
+gethostbyname_cache_add(char *hostname, unsigned short usNameLen,
+                        unsigned long ulIpAddr, unsigned long ulTtl)
+{
+    int ret;
+
+    cmd_lock();
+    ret = c_gethostbyname_cache_add(hostname, usNameLen, ulIpAddr, ulTtl);
+    cmd_unlock();
 
     return(ret);
 }
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_flush
+//!
+//!  @return none
+//!
+//!  @brief  Forget every host in the gethostbyname() cache.
+//
+//*****************************************************************************
+
+void
+gethostbyname_cache_flush(void)
+{
+    cmd_lock();
+    c_gethostbyname_cache_flush();
+    cmd_unlock();
+}
 #endif
 
 //*****************************************************************************
@@ -392,9 +550,9 @@ connect(long sd, const sockaddr *addr, long addrlen)
 {
     long ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    cmd_lock();
     ret = c_connect(sd, addr, addrlen);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
@@ -503,9 +661,13 @@ setsockopt(long sd, long level, long optname, const void *optval, socklen_t optl
 {
     int ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    if ((level == SOL_SOCKET) && (optname == SOCKOPT_SEND_COALESCE)) {
+        send_coalesce_before_send(sd, -1);
+    }
+
+    cmd_lock();
     ret = c_setsockopt(sd, level, optname, optval, optlen);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
@@ -563,9 +725,9 @@ getsockopt(long sd, long level, long optname, void *optval, socklen_t *optlen)
 {
     int ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    cmd_lock();
     ret = c_getsockopt(sd, level, optname, optval, optlen);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
@@ -598,7 +760,17 @@ recv(long sd, void *buf, long len, long flags)
     int ret;
     int index = 0;
 
+    send_coalesce_before_read(sd);
+
+    /* tell the select thread and socket events that sd has a reader */
+    for (index = 0; index < MAX_NUM_OF_SOCKETS; index++){
+        if (g_sockets[index].sd == sd){
+            g_sockets[index].waiting = 1;
+        }
+    }
+
     OS_semaphore_post(g_select_sleep_semaphore); //wakeup select thread if needed
+    OS_semaphore_post(g_select_wake_semaphore);
 
     for (index = 0; index < MAX_NUM_OF_SOCKETS; index++){
         if (g_sockets[index].sd == sd){
@@ -616,9 +788,9 @@ recv(long sd, void *buf, long len, long flags)
 
     /* call the original recv knowing there is available data
        and it's a non-blocking call */
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    cmd_lock();
     ret = c_recv(sd, buf, len, flags);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
@@ -658,7 +830,17 @@ recvfrom(long sd, void *buf, long len, long flags,
     int index = 0;
     int ret;
 
+    send_coalesce_before_read(sd);
+
+    /* tell the select thread and socket events that sd has a reader */
+    for (index = 0; index < MAX_NUM_OF_SOCKETS; index++){
+        if (g_sockets[index].sd == sd){
+            g_sockets[index].waiting = 1;
+        }
+    }
+
     OS_semaphore_post(g_select_sleep_semaphore); //wakeup select thread if needed
+    OS_semaphore_post(g_select_wake_semaphore);
     for (index = 0; index < MAX_NUM_OF_SOCKETS; index++){
         if (g_sockets[index].sd == sd){
             /* wait for data to become available */
@@ -673,9 +855,9 @@ recvfrom(long sd, void *buf, long len, long flags,
 
     /* Call the original recv knowing there is available data
        and it's a non-blocking call */
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    cmd_lock();
     ret = c_recvfrom(sd, buf, len, flags, from, fromlen);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
@@ -707,12 +889,70 @@ send(long sd, const void *buf, long len, long flags)
 {
     int ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    ret = send_coalesce_before_send(sd, len);
+    if (ret != 0) {
+        return(ret);
+    }
+
+    ret = reserve_free_buffer(sd);
+    if (ret != 0) {
+        return(ret);
+    }
+
+    cmd_lock();
+    flow_control_use_reserved(1);
     ret = c_send(sd, buf, len, flags);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    flow_control_use_reserved(0);
+
+#ifndef CC3000_TINY_DRIVER
+    /*
+     *  Keep the SelectThread running while send() data is coalesced, it
+     *  sends the data once its deadline passes.
+     */
+    if (!g_send_coalesce_held && (send_coalesce_flush_expired() > 0)) {
+        g_send_coalesce_held = 1;
+        OS_semaphore_post(g_select_sleep_semaphore);
+        OS_semaphore_post(g_select_wake_semaphore);
+    }
+#endif
+    cmd_unlock();
+
+    return(ret);
+}
+
+#ifndef CC3000_TINY_DRIVER
+//*****************************************************************************
+//
+//!  send_flush
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return the number of bytes sent, 0 if nothing was held, or the error
+//!          of the send
+//!
+//!  @brief  Send the data a SOCKOPT_SEND_COALESCE socket is holding now.
+//
+//*****************************************************************************
+
+int
+send_flush(long sd)
+{
+    int ret;
+
+    ret = reserve_free_buffer(sd);
+    if (ret != 0) {
+        return(ret);
+    }
+
+    cmd_lock();
+    flow_control_use_reserved(1);
+    ret = c_send_flush(sd);
+    flow_control_use_reserved(0);
+    cmd_unlock();
 
     return(ret);
 }
+#endif
 
 //*****************************************************************************
 //
@@ -746,9 +986,16 @@ sendto(long sd, const void *buf, long len, long flags,
 {
     int ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    ret = reserve_free_buffer(sd);
+    if (ret != 0) {
+        return(ret);
+    }
+
+    cmd_lock();
+    flow_control_use_reserved(1);
     ret = c_sendto(sd, buf, len, flags, to, tolen);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    flow_control_use_reserved(0);
+    cmd_unlock();
 
     return(ret);
 }
@@ -775,9 +1022,9 @@ mdnsAdvertiser(unsigned short mdnsEnabled, char * deviceServiceName, unsigned sh
 {
     int ret;
 
-    OS_mutex_lock(g_main_mutex, &mtx_key);
+    cmd_lock();
     ret = c_mdnsAdvertiser(mdnsEnabled, deviceServiceName, deviceServiceNameLength);
-    OS_mutex_unlock(g_main_mutex, mtx_key);
+    cmd_unlock();
 
     return(ret);
 }
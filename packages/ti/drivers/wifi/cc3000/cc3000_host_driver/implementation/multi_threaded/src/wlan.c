@@ -57,6 +57,7 @@ wlan_socket_t           g_sockets[MAX_NUM_OF_SOCKETS];
 /* Handles for making the APIs asychronous and thread-safe */
 SemaphoreHandle         g_accept_semaphore;
 SemaphoreHandle         g_select_sleep_semaphore;
+SemaphoreHandle         g_select_wake_semaphore;
 MutexHandle             g_main_mutex;
 TaskHandle              g_select_thread;
 MutexKey                mtx_key;
@@ -68,10 +69,31 @@ int                     g_accept_new_sd;
 int                     g_accept_socket;
 int                     g_accept_addrlen;
 int                     g_should_poll_accept;
+volatile unsigned int   g_cmd_count;
+int                     g_send_coalesce_held;
 
 //char                    selectThreadStack[512];
 
+/*
+ *  Upper bound of one select() issued by the SelectThread. The CC3000 answers
+ *  as soon as a socket becomes ready, so this only bounds how long accept()
+ *  polling and the other API calls can be held off by a quiet select().
+ */
+#ifndef SELECT_THREAD_TIMEOUT_MS
+#define SELECT_THREAD_TIMEOUT_MS   100
+#endif
+
+/*
+ *  select() bound used while other socket commands are flowing, so the
+ *  SelectThread holds the command channel only briefly. 5 ms is the
+ *  smallest timeout the CC3000 accepts.
+ */
+#ifndef SELECT_THREAD_BUSY_TIMEOUT_MS
+#define SELECT_THREAD_BUSY_TIMEOUT_MS   5
+#endif
+
 static void SelectThread(void *);
+static void wlan_socket_event(long sd, long event_type);
 
 //*****************************************************************************
 //
@@ -135,6 +157,9 @@ void wlan_init(tWlanCB     sWlanCB,
     c_wlan_init(sWlanCB, sFWPatches, sDriverPatches,\
                 sBootLoaderPatches, sReadWlanInterruptPin,\
                 sWlanInterruptEnable, sWlanInterruptDisable, sWriteWlanPin);
+
+    /* Socket events from the CC3000 wake the blocked task directly */
+    tSLInformation.sSocketEventCB = wlan_socket_event;
     OS_mutex_unlock(g_main_mutex, mtx_key);
 }
 
@@ -175,6 +200,7 @@ void wlan_start(unsigned short usPatchesAvailableAtHost)
     for(index = 0; index < MAX_NUM_OF_SOCKETS; index++){
         g_sockets[index].sd = -1;
         g_sockets[index].status = SOC_NOT_INITED;
+        g_sockets[index].waiting = 0;
         if (NULL == g_sockets[index].sd_semaphore)
             OS_semaphore_create(&g_sockets[index].sd_semaphore, "SockSem", e_MODE_BINARY, 0);
     }
@@ -185,6 +211,10 @@ void wlan_start(unsigned short usPatchesAvailableAtHost)
     if (NULL == g_select_sleep_semaphore)
         OS_semaphore_create(&g_select_sleep_semaphore, "SelectSleepSem", e_MODE_COUNTING, 0);
 
+    if (NULL == g_select_wake_semaphore)
+        OS_semaphore_create(&g_select_wake_semaphore, "SelectWakeSem", e_MODE_BINARY, 0);
+    g_send_coalesce_held = 0;
+
     /**/
     c_wlan_start(usPatchesAvailableAtHost);
 
@@ -197,7 +227,7 @@ void wlan_start(unsigned short usPatchesAvailableAtHost)
         params.thread_name = "SelectThread";
         params.p_stack_start = NULL; /* TBD - Mandatory in Thread-X */
         params.p_entry_function = SelectThread;
-        *(sInt32 *)params.p_func_params = 0;
+        params.p_func_params = NULL;
         params.priority = SELECT_THREAD_PRI;
 
 #ifdef MSP430WARE
@@ -250,6 +280,7 @@ void wlan_stop(void)
 
     OS_semaphore_delete(&g_accept_semaphore);
     OS_semaphore_delete(&g_select_sleep_semaphore);
+    OS_semaphore_delete(&g_select_wake_semaphore);
     OS_mutex_unlock(g_main_mutex, mtx_key);
 }
 
@@ -729,6 +760,36 @@ long wlan_smart_config_process()
 }
 #endif //CC3000_UNENCRYPTED_SMART_CONFIG
 
+//*****************************************************************************
+//
+//!  wlan_socket_event
+//!
+//!  @param  sd          socket the event is for
+//!  @param  event_type  HCI event (or HCI_EVNT_SELECT from the SelectThread)
+//!
+//!  @return none
+//!
+//!  @brief  Release the task blocked in recv/recvfrom on sd. Called by the
+//!          SelectThread and, for unsolicited socket events such as
+//!          HCI_EVNT_BSD_TCP_CLOSE_WAIT, straight from the event handler in
+//!          the SPI receive context.
+//
+//*****************************************************************************
+
+static void wlan_socket_event(long sd, long event_type)
+{
+    int index;
+
+    for (index = 0; index < MAX_NUM_OF_SOCKETS; index++){
+        if ((g_sockets[index].sd == sd) &&
+            (g_sockets[index].status == SOCK_ON) &&
+            g_sockets[index].waiting) {
+            g_sockets[index].waiting = 0;
+            OS_semaphore_post(g_sockets[index].sd_semaphore);
+        }
+    }
+}
+
 static void SelectThread(void *ptr)
 {
     struct timeval timeout;
@@ -738,10 +799,14 @@ static void SelectThread(void *ptr)
     int ret = 0;
     int maxFD;
     int index = 0;
+    uInt32 wait;
+#ifndef CC3000_TINY_DRIVER
+    long ticksLeft;
+#endif
+    unsigned int lastCmdCount = g_cmd_count;
 
     memset(&timeout, 0, sizeof(struct timeval));
     timeout.tv_sec = 0;
-    timeout.tv_usec = ((long)100) * ((long)1000); /* 100 msecs */
 
     while(1) //run until closed by wlan_stop
     {
@@ -750,12 +815,34 @@ static void SelectThread(void *ptr)
         /* increase the count back by one to be decreased by the original caller */
         OS_semaphore_post(g_select_sleep_semaphore);
 
+        /*
+         *  send() holds a count while coalesced data is waiting. Send what
+         *  is due and drop the count once nothing is held any more.
+         */
+#ifndef CC3000_TINY_DRIVER
+        if (g_send_coalesce_held) {
+            OS_mutex_lock(g_main_mutex, &mtx_key);
+            if (send_coalesce_flush_expired() == 0) {
+                g_send_coalesce_held = 0;
+                OS_semaphore_pend(g_select_sleep_semaphore, e_NO_WAIT);
+            }
+            OS_mutex_unlock(g_main_mutex, mtx_key);
+        }
+#endif
+
         FD_ZERO(&readsds);
         FD_ZERO(&exceptsds);
-
-        /* ping correct socket descriptor param for select */
+        maxFD = 0;
+
+        /*
+         *  Only watch sockets somebody is blocked on. A socket with unread
+         *  data and no reader would otherwise make every select() return
+         *  at once and keep the SPI busy. Listening sockets are included
+         *  so a pending connection ends the select() early.
+         */
         for(index = 0; index < MAX_NUM_OF_SOCKETS; index++){
-            if(g_sockets[index].status == SOCK_ON){
+            if((g_sockets[index].status == SOCK_ON && g_sockets[index].waiting) ||
+               (g_sockets[index].status == SOC_ACCEPTING)){
                 FD_SET(g_sockets[index].sd, &readsds);
                 FD_SET(g_sockets[index].sd, &exceptsds);
                 if(maxFD <= g_sockets[index].sd)
@@ -763,10 +850,39 @@ static void SelectThread(void *ptr)
             }
         }
 
-        ret = select(maxFD, &readsds, NULL, &exceptsds, &timeout); /* Polling instead of blocking here\
-                                                                to process "accept" below */
-        //System_printf("SelectThread: Running..!! \n");
-        //System_flush();
+        /*
+         *  Nothing to select: the waiters were already released by socket
+         *  events and still have to take their counts off
+         *  g_select_sleep_semaphore, or only coalesced send() data is held.
+         *  Sleep until the next reader or the next coalescing deadline.
+         */
+        if (maxFD == 0) {
+            wait = e_WAIT_FOREVER;
+#ifndef CC3000_TINY_DRIVER
+            if (g_send_coalesce_held) {
+                OS_mutex_lock(g_main_mutex, &mtx_key);
+                ticksLeft = send_coalesce_ticks_left();
+                OS_mutex_unlock(g_main_mutex, mtx_key);
+
+                /* e_NO_WAIT and e_WAIT_FOREVER are flags, not tick counts */
+                wait = (ticksLeft > e_WAIT_FOREVER) ? ticksLeft :
+                       (e_WAIT_FOREVER + 1);
+            }
+#endif
+            OS_semaphore_pend(g_select_wake_semaphore, wait);
+            continue;
+        }
+
+        /* Keep out of the way of the other sockets while they are busy */
+        if (g_cmd_count != lastCmdCount) {
+            timeout.tv_usec = ((long)SELECT_THREAD_BUSY_TIMEOUT_MS) * ((long)1000);
+        }
+        else {
+            timeout.tv_usec = ((long)SELECT_THREAD_TIMEOUT_MS) * ((long)1000);
+        }
+
+        ret = select(maxFD, &readsds, NULL, &exceptsds, &timeout);
+        lastCmdCount = g_cmd_count;
 
         if (g_wlan_stopped)
         {
@@ -777,15 +893,18 @@ static void SelectThread(void *ptr)
 
         if (ret>0){
             for (index = 0; index < MAX_NUM_OF_SOCKETS; index++){
-                if (g_sockets[index].status != SOC_NOT_INITED && //check that the socket is valid
-                    g_sockets[index].status != SOC_ACCEPTING &&    //verify this is not an accept socket
-                    (FD_ISSET(g_sockets[index].sd, &readsds) ||    //and has pending data
-                    FD_ISSET(g_sockets[index].sd, &exceptsds))){    //and has pending data
-                    OS_semaphore_post(g_sockets[index].sd_semaphore); //release the semaphore
+                if (g_sockets[index].status == SOCK_ON &&        //check that the socket is valid
+                    (FD_ISSET(g_sockets[index].sd, &readsds) ||  //and has pending data
+                    FD_ISSET(g_sockets[index].sd, &exceptsds))){ //or was closed
+                    wlan_socket_event(g_sockets[index].sd, HCI_EVNT_SELECT);
                 }
             }
         }
 
+        /*
+         *  The CC3000 does not signal incoming connections, so accept is
+         *  still polled, but only once per select() instead of spinning.
+         */
         for (index = 0; index < MAX_NUM_OF_SOCKETS; index++){
             if (g_sockets[index].status == SOC_ACCEPTING) {
                 OS_mutex_lock(g_main_mutex, &mtx_key);
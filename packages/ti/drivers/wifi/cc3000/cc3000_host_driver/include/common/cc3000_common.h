@@ -143,17 +143,26 @@ extern "C" {
 //*****************************************************************************
 //                  Compound Types
 //*****************************************************************************
+#ifdef CC3000_OSAL_POSIX
+// Host builds get these types from the C library, whose headers define them
+// as well. <sys/select.h> is included here so that the C library's fd_set
+// and select() are declared before the CC3000's ones below are renamed.
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/select.h>
+#else
 typedef long time_t;
 typedef unsigned long clock_t;
 typedef long suseconds_t;
 
-typedef struct timeval timeval;
-
 struct timeval
 {
     time_t         tv_sec;                  /* seconds */
     suseconds_t    tv_usec;                 /* microseconds */
 };
+#endif
+
+typedef struct timeval timeval;
 
 typedef char *(*tFWPatches)(unsigned long *usLength);
 
@@ -163,6 +172,8 @@ typedef char *(*tBootLoaderPatches)(unsigned long *usLength);
 
 typedef void (*tWlanCB)(long event_type, char * data, unsigned char length );
 
+typedef void (*tSocketEventCB)(long sd, long event_type);
+
 typedef long (*tWlanReadInteruptPin)(void);
 
 typedef void (*tWlanInterruptEnable)(void);
@@ -186,6 +197,7 @@ typedef struct
     tWlanInterruptEnable  WlanInterruptEnable;
     tWlanInterruptDisable WlanInterruptDisable;
     tWriteWlanPin         WriteWlanPin;
+    tSocketEventCB        sSocketEventCB;
 
     signed long      slTransmitDataError;
     unsigned short   usNumberOfFreeBuffers;
@@ -193,12 +205,49 @@ typedef struct
     unsigned short   usBufferSize;
     unsigned short   usRxDataPending;
 
+    // recv() buffer the SPI layer may read the payload of the pending data
+    // packet into, bypassing the receive buffer. The SPI layer sets
+    // usRxUserBufferFilled to the payload length when it does so.
+    unsigned char   *pucRxUserBuffer;
+    unsigned short   usRxUserBufferLength;
+    unsigned short   usRxUserBufferFilled;
+
     unsigned long    NumberOfSentPackets;
     unsigned long    NumberOfReleasedPackets;
 
+    unsigned long    ulSendBufferTimeout;
+
     unsigned char    InformHostOnTxComplete;
 }sSimplLinkInformation;
 
+// Snapshot of the CC3000 transmit flow control state, see
+// get_flow_control_info()
+typedef struct
+{
+    unsigned short   usFreeBuffers;
+    unsigned short   usBufferLength;
+    unsigned long    ulSentPackets;
+    unsigned long    ulReleasedPackets;
+}tFlowControlInfo;
+
+// AES128 round keys cached by aes_set_key (security.h)
+typedef struct
+{
+    unsigned long ulEncKey[44];
+    unsigned long ulDecKey[44];
+}tAesContext;
+
+// Patch source and callbacks of nvmem_write_patch_stream (nvmem.h)
+typedef struct
+{
+    long (*read)(void *arg, unsigned long ulOffset, unsigned char *buff,
+                 unsigned long ulLength);
+    long (*verify)(void *arg, unsigned long ulOffset, const unsigned char *buff,
+                   unsigned long ulLength);
+    void (*progress)(void *arg, unsigned long ulWritten, unsigned long ulTotal);
+    void *arg;
+}tNvmemPatchStream;
+
 
 
 //*************************************************************************************
@@ -281,6 +330,7 @@ typedef struct _netapp_pingreport_args
 #define  SOCKOPT_NONBLOCK       2           // accept non block mode set SOCK_ON or SOCK_OFF (default block mode )
 #define  SOCK_ON                0           // socket non-blocking mode is enabled
 #define  SOCK_OFF               1           // socket blocking mode is enabled
+#define  SOCKOPT_SEND_COALESCE  0x100       // host side: hold small send()s up to optval ticks, 0 disables
 
 #define  TCP_NODELAY            0x0001
 #define  TCP_BSDURGENT          0x7000
@@ -293,6 +343,19 @@ typedef struct _netapp_pingreport_args
 #undef ENOBUFS
 #define ENOBUFS                 55          // No buffer space available
 
+#ifdef CC3000_OSAL_POSIX
+// Replace the C library's fd_set macros by the CC3000 ones
+#undef __FD_SETSIZE
+#undef __NFDBITS
+#undef __FDELT
+#undef __FDMASK
+#undef __FDS_BITS
+#undef __FD_ZERO
+#undef __FD_SET
+#undef __FD_CLR
+#undef __FD_ISSET
+#endif
+
 #define __FD_SETSIZE            32
 
 #define  ASIC_ADDR_LEN          8
@@ -330,6 +393,12 @@ typedef long int __fd_mask;
 #define __FDMASK(d)             ((__fd_mask) 1 << ((d) % __NFDBITS))
 
 #undef fd_set
+#ifdef CC3000_OSAL_POSIX
+// The C library has its own fd_set and select(); the CC3000's fd_set is 32
+// bits wide
+#define fd_set                  cc3000_fd_set
+#define select                  cc3000_select
+#endif
 // fd_set for select and pselect.
 typedef struct
 {
@@ -559,6 +628,7 @@ typedef struct
 #define HCI_PATCH_HEADER_SIZE       (6)
 
 #define HCI_PACKET_TYPE_OFFSET      (0)
+#define HCI_PACKET_OPCODE_OFFSET    (1)
 #define HCI_PACKET_ARGSIZE_OFFSET   (2)
 #define HCI_PACKET_LENGTH_OFFSET    (3)
 
@@ -578,6 +648,8 @@ extern volatile sSimplLinkInformation tSLInformation;
 
 extern SemaphoreHandle eventOrDataReceivedSem;
 
+extern SemaphoreHandle freeBuffersSem;
+
 extern int connectExpected;
 
 
@@ -185,6 +185,37 @@ extern  unsigned char nvmem_get_mac_address(unsigned char *mac);
 extern  unsigned char nvmem_write_patch(unsigned long ulFileId, unsigned long spLength, const unsigned char *spData);
 
 
+//*****************************************************************************
+//
+//!  nvmem_write_patch_stream
+//!
+//!  @param  ulFileId   nvmem file id:\n
+//!                     NVMEM_WLAN_DRIVER_SP_FILEID, NVMEM_WLAN_FW_SP_FILEID,
+//!  @param  spLength   number of bytes to write
+//!  @param  stream     SP source and callbacks
+//!
+//!  @return       on success 0, error otherwise.
+//!
+//!  @brief      program a patch to a specific file ID from a source that is
+//!              read a portion at a time, such as a file on an SD card.
+//!              Portions are as large as the TX buffers allow, up to
+//!              NVMEM_PATCH_STREAM_PORTION_SIZE bytes, and the next portion
+//!              is read while the CC3000 programs the previous one.
+//!              stream->read must fill buff with bytes of the patch starting
+//!              at ulOffset and return how many it read, 0 or less on error.
+//!              stream->verify, if not NULL, sees every portion before it is
+//!              sent and finally gets a NULL buff once the whole patch is
+//!              written. A non-zero return aborts the write with an error.
+//!              stream->progress, if not NULL, is called after each portion
+//!              with the number of bytes programmed so far.
+//!              The callbacks run inside the driver and must not call it.
+//!
+//*****************************************************************************
+extern signed long nvmem_write_patch_stream(unsigned long ulFileId,
+                                            unsigned long spLength,
+                                            const tNvmemPatchStream *stream);
+
+
 //*****************************************************************************
 //
 //!  nvmem_read_sp_version
@@ -89,6 +89,117 @@ extern void aes_encrypt(unsigned char *state, unsigned char *key);
 extern void aes_decrypt(unsigned char *state, unsigned char *key);
 
 
+//*****************************************************************************
+//
+//!  aes_set_key
+//!
+//!  @param[out]  ctx   AES128 context
+//!  @param[in]   key   AES128 key of size 16 bytes
+//!
+//!  @return  none
+//!
+//!  @brief   Computes the encryption and decryption round keys of a key
+//!           once, for any number of blocks. The context is only read by
+//!           the functions below, so several tasks can share it.
+//!
+//*****************************************************************************
+extern void aes_set_key(tAesContext *ctx, const unsigned char *key);
+
+//*****************************************************************************
+//
+//!  aes_encrypt_block
+//!
+//!  @param[in]  ctx   AES128 context
+//!  @param[in]  in    16 bytes of plain text
+//!  @param[out] out   16 bytes of cipher text, may be in
+//!
+//!  @return  none
+//!
+//!  @brief   AES128 encryption of one block (ECB).
+//!
+//*****************************************************************************
+extern void aes_encrypt_block(const tAesContext *ctx, const unsigned char *in,
+                              unsigned char *out);
+
+//*****************************************************************************
+//
+//!  aes_decrypt_block
+//!
+//!  @param[in]  ctx   AES128 context
+//!  @param[in]  in    16 bytes of cipher text
+//!  @param[out] out   16 bytes of plain text, may be in
+//!
+//!  @return  none
+//!
+//!  @brief   AES128 decryption of one block (ECB).
+//!
+//*****************************************************************************
+extern void aes_decrypt_block(const tAesContext *ctx, const unsigned char *in,
+                              unsigned char *out);
+
+//*****************************************************************************
+//
+//!  aes_cbc_encrypt
+//!
+//!  @param[in]     ctx   AES128 context
+//!  @param[in\out] iv    16 bytes initialization vector, updated so that a
+//!                       further call continues the chain
+//!  @param[in]     in    plain text
+//!  @param[out]    out   cipher text, may be in
+//!  @param[in]     len   length of the text, a multiple of 16 bytes
+//!
+//!  @return  0 on success, -1 if len is not a multiple of 16 bytes
+//!
+//!  @brief   AES128 encryption in mode CBC (Cipher Block Chaining).
+//!
+//*****************************************************************************
+extern signed long aes_cbc_encrypt(const tAesContext *ctx, unsigned char *iv,
+                                   const unsigned char *in, unsigned char *out,
+                                   unsigned long len);
+
+//*****************************************************************************
+//
+//!  aes_cbc_decrypt
+//!
+//!  @param[in]     ctx   AES128 context
+//!  @param[in\out] iv    16 bytes initialization vector, updated so that a
+//!                       further call continues the chain
+//!  @param[in]     in    cipher text
+//!  @param[out]    out   plain text, may be in
+//!  @param[in]     len   length of the text, a multiple of 16 bytes
+//!
+//!  @return  0 on success, -1 if len is not a multiple of 16 bytes
+//!
+//!  @brief   AES128 decryption in mode CBC (Cipher Block Chaining).
+//!
+//*****************************************************************************
+extern signed long aes_cbc_decrypt(const tAesContext *ctx, unsigned char *iv,
+                                   const unsigned char *in, unsigned char *out,
+                                   unsigned long len);
+
+//*****************************************************************************
+//
+//!  aes_ctr_crypt
+//!
+//!  @param[in]     ctx      AES128 context
+//!  @param[in\out] counter  16 bytes counter block, incremented as a 128-bit
+//!                          big endian number for every block used
+//!  @param[in]     in       plain or cipher text
+//!  @param[out]    out      cipher or plain text, may be in
+//!  @param[in]     len      length of the text in bytes
+//!
+//!  @return  none
+//!
+//!  @brief   AES128 encryption and decryption in mode CTR (Counter). A last
+//!           partial block uses up a whole counter value, so only the final
+//!           call of a message may have a length that is not a multiple of
+//!           16 bytes.
+//!
+//*****************************************************************************
+extern void aes_ctr_crypt(const tAesContext *ctx, unsigned char *counter,
+                          const unsigned char *in, unsigned char *out,
+                          unsigned long len);
+
 //*****************************************************************************
 //
 //!  aes_read_key
@@ -207,10 +207,59 @@ extern long listen(long sd, long backlog);
 //!
 //!  @note  On this version, only blocking mode is supported. Also note that
 //!          the function requires DNS server to be configured prior to its usage.
+//!          Results, including failures, are cached for DNS_CACHE_TTL_TICKS
+//!          and DNS_CACHE_NEGATIVE_TTL_TICKS; a cached host is answered
+//!          without a request to the CC3000.
 //
 //*****************************************************************************
 #ifndef CC3000_TINY_DRIVER
 extern int gethostbyname(char * hostname, unsigned short usNameLen, unsigned long* out_ip_addr);
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_add
+//!
+//!  @param  hostname   host name
+//!  @param  usNameLen  name length
+//!  @param  ulIpAddr   IP address gethostbyname() returns for the host
+//!  @param  ulTtl      ticks the entry is valid, 0 keeps it until flushed
+//!
+//!  @return 0 on success, -1 if the name is too long or every entry is
+//!          permanent
+//!
+//!  @brief  Prefill the gethostbyname() cache, e.g. with the brokers an
+//!          application always connects to.
+//
+//*****************************************************************************
+extern int gethostbyname_cache_add(char *hostname, unsigned short usNameLen,
+                                   unsigned long ulIpAddr, unsigned long ulTtl);
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_flush
+//!
+//!  @return none
+//!
+//!  @brief  Forget every host in the gethostbyname() cache, including the
+//!          prefilled ones, e.g. after joining a different network.
+//
+//*****************************************************************************
+extern void gethostbyname_cache_flush(void);
+
+//*****************************************************************************
+//
+//! send_flush
+//!
+//!  @param  sd  socket descriptor
+//!
+//!  @return the number of bytes sent, 0 if nothing was held, or the error
+//!          of the send
+//!
+//!  @brief  Send the data a SOCKOPT_SEND_COALESCE socket is holding now,
+//!          for latency sensitive writes.
+//
+//*****************************************************************************
+extern int send_flush(long sd);
 #endif
 
 
@@ -325,6 +374,13 @@ extern int select(long nfds, fd_set *readsds, fd_set *writesds, fd_set *exceptsd
 //!            2. SOCKOPT_NONBLOCK (optname). sets the socket non-blocking mode on
 //!           or off.
 //!             In that case optval should be SOCK_ON or SOCK_OFF (optval).
+//!            3. SOCKOPT_SEND_COALESCE (optname), handled by the host.
+//!           send() collects small writes for up to optval ticks or until
+//!           a CC3000 buffer is full, then sends them at once. optval is a
+//!           pointer to unsigned long, 0 stops coalescing. send_flush()
+//!           and closesocket() send held data early. recv(), recvfrom()
+//!           and select() for read do so only if a CC3000 buffer is free,
+//!           they never wait for one.
 //!
 //!  @sa getsockopt
 //
@@ -507,6 +563,37 @@ extern int sendto(long sd, const void *buf, long len, long flags,
 //*****************************************************************************
 extern int mdnsAdvertiser(unsigned short mdnsEnabled, char * deviceServiceName, unsigned short deviceServiceNameLength);
 
+//*****************************************************************************
+//
+//! set_send_buffer_timeout
+//!
+//!  @param  ulTimeout  maximum time in ticks send() and sendto() block
+//!                     waiting for a free CC3000 buffer, 0 waits forever
+//!
+//!  @return none
+//!
+//!  @brief  Bound the time a send blocks on flow control. A send that times
+//!          out returns -2 without transmitting. Has no effect when
+//!          SEND_NON_BLOCKING is defined.
+//
+//*****************************************************************************
+extern void set_send_buffer_timeout(unsigned long ulTimeout);
+
+//*****************************************************************************
+//
+//! get_flow_control_info
+//!
+//!  @param  info  filled in with the current flow control state
+//!
+//!  @return none
+//!
+//!  @brief  Report the free CC3000 buffers, the size of each buffer and the
+//!          number of packets sent to and released by the device, so an
+//!          application can size its bursts to the credits available.
+//
+//*****************************************************************************
+extern void get_flow_control_info(tFlowControlInfo *info);
+
 //*****************************************************************************
 //
 // Close the Doxygen group.
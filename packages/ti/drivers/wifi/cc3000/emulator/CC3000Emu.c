@@ -0,0 +1,1653 @@
+/*
+ * Copyright (c) 2013, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ======== CC3000Emu.c ========
+ *  Host-side CC3000 emulator. See CC3000Emu.h.
+ */
+
+#include <string.h>
+
+#include <xdc/std.h>
+
+/* CC3000 Host Driver header files */
+#include <cc3000_host_driver/core_driver/inc/evnt_handler.h>
+#include <cc3000_host_driver/include/nvmem.h>
+#include <cc3000_host_driver/include/wlan.h>
+#include <osal/inc/osal.h>
+#include <spi.h>
+
+#include <emulator/CC3000Emu.h>
+
+/* Largest payload of a CC3000 buffer */
+#ifndef CC3000Emu_PAYLOAD_SIZE
+#define CC3000Emu_PAYLOAD_SIZE      1468
+#endif
+
+/* Number of TX buffers, see WiFi.txBufferCount */
+#ifndef CC3000Emu_TX_BUFFER_COUNT
+#define CC3000Emu_TX_BUFFER_COUNT   1
+#endif
+
+/* Receive buffer of each emulated socket */
+#ifndef CC3000Emu_SOCKET_BUF_SIZE
+#define CC3000Emu_SOCKET_BUF_SIZE   16384
+#endif
+
+/* Packets waiting to be handed to the host driver */
+#ifndef CC3000Emu_QUEUE_LENGTH
+#define CC3000Emu_QUEUE_LENGTH      16
+#endif
+
+#ifndef OS_TICK_PERIOD_US
+#define OS_TICK_PERIOD_US           1000
+#endif
+
+#define CC3000Emu_NUM_SOCKETS       8
+#define CC3000Emu_NUM_HOSTS         8
+#define CC3000Emu_HOST_NAME_LEN     64
+#define CC3000Emu_NVMEM_FILE_SIZE   8192
+
+/* Largest packet sent to the host: data header, recv arguments, payload */
+#define CC3000Emu_MAX_PACKET        (HCI_DATA_HEADER_SIZE + RECV_ARGS_SIZE + \
+                                     CC3000Emu_PAYLOAD_SIZE)
+
+/* Arguments of the recv()/recvfrom() data packets, from at offset 16 */
+#define RECV_ARGS_SIZE              24
+
+/* Patch data is sent in portions of this size, as in hci.c */
+#define PATCH_PORTION_SIZE          1000
+
+/* SIMPLE_LINK_START argument asking for the patches from the host */
+#define PATCHES_REQUEST_FORCE_HOST  1
+
+/* Event layouts parsed by evnt_handler.c */
+#define FLOW_CONTROL_EVENT_FREE_BUFFS_OFFSET    2
+#define FLOW_CONTROL_EVENT_SIZE                 4
+#define NETAPP_IPCONFIG_SSID_OFFSET             26
+#define NETAPP_IPCONFIG_SSID_LENGTH             32
+
+/* Values returned by wlan_ioctl_statusget() */
+#define WLAN_STATUS_DISCONNECTED    0
+#define WLAN_STATUS_CONNECTED       3
+
+/* First port given to sockets that connect or send without bind() */
+#define EPHEMERAL_PORT              49152
+
+/* Socket states */
+#define SOCKET_IDLE                 0
+#define SOCKET_LISTENING            1
+#define SOCKET_CONNECTED            2
+#define SOCKET_PEER_CLOSED          3
+
+/* A UDP datagram is stored as length, source port and address, payload */
+#define DATAGRAM_HEADER_SIZE        8
+
+/*
+ *  Transmit and receive buffers of the host driver. The WiFi module
+ *  normally generates these from its configuration (WiFi.xdt).
+ */
+const Int WiFi_TX_BUFFER_COUNT = CC3000Emu_TX_BUFFER_COUNT;
+const Int WiFi_TX_BUFFER_SIZE = CC3000Emu_PAYLOAD_SIZE + 51;
+UChar wlan_tx_buffer[CC3000Emu_TX_BUFFER_COUNT * (CC3000Emu_PAYLOAD_SIZE + 51)];
+const Int WiFi_RX_BUFFER_SIZE = CC3000Emu_PAYLOAD_SIZE + 51;
+UChar wlan_rx_buffer[CC3000Emu_PAYLOAD_SIZE + 51];
+const Int SELECT_THREAD_PRI = 1;
+
+typedef struct CC3000Emu_Host {
+    Char            name[CC3000Emu_HOST_NAME_LEN];
+    UInt32          ipAddr;
+} CC3000Emu_Host;
+
+typedef struct CC3000Emu_Packet {
+    UShort          length;
+    UChar           data[CC3000Emu_MAX_PACKET];
+} CC3000Emu_Packet;
+
+/* Command the host driver is blocked on until the device can answer it */
+typedef struct CC3000Emu_Pending {
+    UShort          opcode;         /* 0 if there is none */
+    Int             sd;
+    UInt32          length;
+    UInt32          flags;
+    UInt32          readFds;
+    UInt32          writeFds;
+    Bool            timed;
+    UInt32          deadline;       /* OS ticks */
+} CC3000Emu_Pending;
+
+typedef struct CC3000Emu_Socket {
+    Bool            inUse;
+    Bool            accepted;       /* FALSE while queued on a listener */
+    UInt32          type;
+    UInt            state;
+    UShort          port;
+    Int             peer;
+    Int             listener;
+    UInt32          seq;            /* Connection order on the listener */
+    UInt32          backlog;
+    UInt32          nonBlocking;    /* SOCKOPT_NONBLOCK */
+    UInt32          recvTimeout;    /* SOCKOPT_RECV_TIMEOUT in ms */
+    UInt            head;
+    UInt            count;
+    UChar           buf[CC3000Emu_SOCKET_BUF_SIZE];
+} CC3000Emu_Socket;
+
+typedef struct CC3000Emu_Object {
+    Bool            isOpen;
+    Bool            stop;
+    MutexHandle     mutex;
+    SemaphoreHandle kick;           /* Device state changed */
+    TaskHandle      thread;
+    RxHandlerFxn    rxHandler;
+    CC3000Emu_Params params;
+    CC3000Emu_Stats stats;
+
+    Bool            enabled;        /* WLAN EN pin */
+    Bool            irqEnabled;
+    Bool            resumed;        /* Host is done with wlan_rx_buffer */
+    Bool            connected;
+
+    CC3000Emu_Packet queue[CC3000Emu_QUEUE_LENGTH];
+    UInt            queueHead;
+    UInt            queueCount;
+    UInt32          freedBuffers;   /* For the next flow control event */
+    Bool            holdBuffers;    /* Keep freedBuffers, see holdBuffers() */
+    CC3000Emu_Pending pending;
+
+    UChar           patchType;      /* Patch being requested, 0 if none */
+    UInt32          patchRemaining;
+
+    UShort          nextPort;
+    UInt32          nextSeq;
+    CC3000Emu_Socket sockets[CC3000Emu_NUM_SOCKETS];
+    UChar           nvmem[NVMEM_MAX_ENTRY][CC3000Emu_NVMEM_FILE_SIZE];
+} CC3000Emu_Object;
+
+static CC3000Emu_Object CC3000Emu_object;
+
+/* Names for gethostbyname(), kept across CC3000Emu_open() */
+static CC3000Emu_Host CC3000Emu_hosts[CC3000Emu_NUM_HOSTS];
+
+/* Function prototypes */
+static Bool CC3000Emu_accept(CC3000Emu_Pending *pending);
+static UShort CC3000Emu_allocPort(Void);
+static Int CC3000Emu_allocSocket(Void);
+static Void CC3000Emu_closeSocket(Int sd);
+static Void CC3000Emu_command(UChar *packet);
+static Long CC3000Emu_connect(Int sd, UChar *addr);
+static Void CC3000Emu_data(UChar *packet);
+static Void CC3000Emu_deliver(Void);
+static Void CC3000Emu_disableIrqInt(Void);
+static Void CC3000Emu_enableIrqInt(Void);
+static Void CC3000Emu_event(UShort opcode, UChar status, UChar *params,
+                            UShort length);
+static Void CC3000Emu_eventLong(UShort opcode, Long value);
+static Void CC3000Emu_fillAddr(UChar *addr, UShort port);
+static UInt CC3000Emu_get(CC3000Emu_Socket *sock, UChar *dst, UInt count);
+static Void CC3000Emu_patch(UChar *packet);
+static Void CC3000Emu_patchDone(Void);
+static Void CC3000Emu_patchRequest(UChar type);
+static UInt CC3000Emu_put(CC3000Emu_Socket *sock, UChar *src, UInt count);
+static CC3000Emu_Packet *CC3000Emu_queue(Void);
+static Long CC3000Emu_readIrqPin(Void);
+static Bool CC3000Emu_readable(Int sd);
+static Bool CC3000Emu_recv(CC3000Emu_Pending *pending, Bool expired);
+static Void CC3000Emu_reset(Void);
+static Bool CC3000Emu_select(CC3000Emu_Pending *pending, Bool expired);
+static Void CC3000Emu_sendTo(Int sd, UChar *data, UInt32 length, UChar *to);
+static Void CC3000Emu_service(Void);
+static Void CC3000Emu_taskFxn(Void *arg);
+static UInt32 CC3000Emu_timeout(Void);
+static Void CC3000Emu_write(UChar *userBuffer, UShort length);
+static Void CC3000Emu_writeWlanEnPin(UChar val);
+
+/*
+ *  ======== CC3000Emu_accept ========
+ *  Complete an accept() once a connection is queued on the listener. A
+ *  non-blocking listener answers SOC_IN_PROGRESS right away.
+ */
+static Bool CC3000Emu_accept(CC3000Emu_Pending *pending)
+{
+    Int               i;
+    Int               child = -1;
+    UChar             params[8 + sizeof(sockaddr)];
+    UChar            *p;
+    CC3000Emu_Socket *sock;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    sock = &object->sockets[pending->sd];
+
+    for (i = 0; i < CC3000Emu_NUM_SOCKETS; i++) {
+        if (object->sockets[i].inUse && !object->sockets[i].accepted &&
+            (object->sockets[i].listener == pending->sd) &&
+            ((child < 0) ||
+             (object->sockets[i].seq < object->sockets[child].seq))) {
+            child = i;
+        }
+    }
+
+    memset(params, 0, sizeof(params));
+    p = params;
+
+    if (child >= 0) {
+        object->sockets[child].accepted = TRUE;
+        p = UINT32_TO_STREAM(p, child);
+        p = UINT32_TO_STREAM(p, child);
+        CC3000Emu_fillAddr(p, object->sockets[object->sockets[child].peer].port);
+    }
+    else if (sock->state != SOCKET_LISTENING) {
+        p = UINT32_TO_STREAM(p, SOC_ERROR);
+        p = UINT32_TO_STREAM(p, SOC_ERROR);
+    }
+    else if (sock->nonBlocking == SOCK_ON) {
+        p = UINT32_TO_STREAM(p, SOC_IN_PROGRESS);
+        p = UINT32_TO_STREAM(p, SOC_IN_PROGRESS);
+    }
+    else {
+        return (FALSE);
+    }
+
+    CC3000Emu_event(HCI_EVNT_ACCEPT, 0, params, sizeof(params));
+
+    return (TRUE);
+}
+
+/*
+ *  ======== CC3000Emu_allocPort ========
+ *  Pick a port no socket is using.
+ */
+static UShort CC3000Emu_allocPort(Void)
+{
+    Int               i;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    for (;;) {
+        if (object->nextPort < EPHEMERAL_PORT) {
+            object->nextPort = EPHEMERAL_PORT;
+        }
+
+        for (i = 0; i < CC3000Emu_NUM_SOCKETS; i++) {
+            if (object->sockets[i].inUse &&
+                (object->sockets[i].port == object->nextPort)) {
+                break;
+            }
+        }
+
+        if (i == CC3000Emu_NUM_SOCKETS) {
+            return (object->nextPort++);
+        }
+        object->nextPort++;
+    }
+}
+
+/*
+ *  ======== CC3000Emu_allocSocket ========
+ *  Returns the lowest free socket descriptor or -1.
+ */
+static Int CC3000Emu_allocSocket(Void)
+{
+    Int               sd;
+    CC3000Emu_Socket *sock;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    for (sd = 0; sd < CC3000Emu_NUM_SOCKETS; sd++) {
+        sock = &object->sockets[sd];
+        if (!sock->inUse) {
+            memset(sock, 0, sizeof(CC3000Emu_Socket) - CC3000Emu_SOCKET_BUF_SIZE);
+            sock->inUse = TRUE;
+            sock->accepted = TRUE;
+            sock->peer = -1;
+            sock->listener = -1;
+            sock->nonBlocking = SOCK_OFF;
+            return (sd);
+        }
+    }
+
+    return (-1);
+}
+
+/*
+ *  ======== CC3000Emu_closeSocket ========
+ *  Release a socket. The peer of a connection sees it closed, the
+ *  connections still queued on a listener are dropped.
+ */
+static Void CC3000Emu_closeSocket(Int sd)
+{
+    Int               i;
+    UChar             params[4];
+    CC3000Emu_Socket *peer;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+    CC3000Emu_Socket *sock = &object->sockets[sd];
+
+    if (sock->peer >= 0) {
+        peer = &object->sockets[sock->peer];
+        peer->peer = -1;
+        peer->state = SOCKET_PEER_CLOSED;
+
+        if (peer->accepted) {
+            UINT32_TO_STREAM(params, sock->peer);
+            CC3000Emu_event(HCI_EVNT_BSD_TCP_CLOSE_WAIT, 0, params,
+                            sizeof(params));
+        }
+    }
+
+    sock->inUse = FALSE;
+
+    if (sock->state == SOCKET_LISTENING) {
+        for (i = 0; i < CC3000Emu_NUM_SOCKETS; i++) {
+            if (object->sockets[i].inUse && !object->sockets[i].accepted &&
+                (object->sockets[i].listener == sd)) {
+                CC3000Emu_closeSocket(i);
+            }
+        }
+    }
+}
+
+/*
+ *  ======== CC3000Emu_command ========
+ *  Handle an HCI command packet.
+ */
+static Void CC3000Emu_command(UChar *packet)
+{
+    UShort            opcode;
+    UChar            *args = packet + SIMPLE_LINK_HCI_CMND_HEADER_SIZE;
+    UChar             params[64];
+    UChar            *p;
+    UInt32            value;
+    UInt32            mask;
+    Int               i;
+    Long              sd;
+    UShort            port;
+    CC3000Emu_Socket *sock;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    STREAM_TO_UINT16((Char *)packet, HCI_PACKET_OPCODE_OFFSET, opcode);
+    STREAM_TO_UINT32((Char *)args, 0, sd);
+    sock = M_IS_VALID_SD(sd) && object->sockets[sd].inUse ?
+           &object->sockets[sd] : NULL;
+
+    object->stats.commands++;
+
+    switch (opcode) {
+        case HCI_CMND_SIMPLE_LINK_START:
+            if (args[0] == PATCHES_REQUEST_FORCE_HOST) {
+                CC3000Emu_patchRequest(HCI_EVENT_PATCHES_DRV_REQ);
+            }
+            else {
+                CC3000Emu_event(opcode, 0, NULL, 0);
+            }
+            break;
+
+        case HCI_CMND_READ_BUFFER_SIZE:
+            params[0] = object->params.numBuffers;
+            UINT16_TO_STREAM(params + 1, object->params.bufferLength);
+            CC3000Emu_event(opcode, 0, params, 3);
+            break;
+
+        case HCI_CMND_SOCKET:
+            STREAM_TO_UINT32((Char *)args, 4, value);
+            sd = ((value == SOCK_STREAM) || (value == SOCK_DGRAM)) ?
+                 CC3000Emu_allocSocket() : -1;
+            if (sd >= 0) {
+                object->sockets[sd].type = value;
+            }
+            CC3000Emu_eventLong(opcode, sd);
+            break;
+
+        case HCI_CMND_CLOSE_SOCKET:
+            if (sock) {
+                CC3000Emu_closeSocket(sd);
+            }
+            CC3000Emu_eventLong(opcode, sock ? 0 : SOC_ERROR);
+            break;
+
+        case HCI_CMND_BIND:
+            port = (args[14] << 8) | args[15];
+            for (i = 0; sock && port && (i < CC3000Emu_NUM_SOCKETS); i++) {
+                if (object->sockets[i].inUse &&
+                    (object->sockets[i].port == port) &&
+                    (object->sockets[i].type == sock->type)) {
+                    sock = NULL;
+                }
+            }
+            if (sock) {
+                sock->port = port ? port : CC3000Emu_allocPort();
+            }
+            CC3000Emu_eventLong(opcode, sock ? 0 : SOC_ERROR);
+            break;
+
+        case HCI_CMND_LISTEN:
+            if (sock && (sock->type == SOCK_STREAM) && sock->port &&
+                (sock->state == SOCKET_IDLE)) {
+                STREAM_TO_UINT32((Char *)args, 4, sock->backlog);
+                sock->state = SOCKET_LISTENING;
+                CC3000Emu_eventLong(opcode, 0);
+            }
+            else {
+                CC3000Emu_eventLong(opcode, SOC_ERROR);
+            }
+            break;
+
+        case HCI_CMND_CONNECT:
+            CC3000Emu_eventLong(opcode,
+                                sock ? CC3000Emu_connect(sd, args + 12) : SOC_ERROR);
+            break;
+
+        case HCI_CMND_ACCEPT:
+        case HCI_CMND_RECV:
+        case HCI_CMND_RECVFROM:
+        case HCI_CMND_BSD_SELECT:
+            /* Answered by CC3000Emu_service() when the device is ready */
+            memset(&object->pending, 0, sizeof(CC3000Emu_Pending));
+            object->pending.opcode = opcode;
+            object->pending.sd = sd;
+
+            if (opcode == HCI_CMND_BSD_SELECT) {
+                STREAM_TO_UINT32((Char *)args, 24, object->pending.readFds);
+                STREAM_TO_UINT32((Char *)args, 28, object->pending.writeFds);
+                STREAM_TO_UINT32((Char *)args, 20, value);
+                if (value == 0) {
+                    STREAM_TO_UINT32((Char *)args, 36, value);
+                    STREAM_TO_UINT32((Char *)args, 40, mask);
+                    value = (value * 1000000 + mask + OS_TICK_PERIOD_US - 1) /
+                            OS_TICK_PERIOD_US;
+                    object->pending.timed = TRUE;
+                    object->pending.deadline = OS_ticks_get() + value;
+                }
+            }
+            else if (opcode != HCI_CMND_ACCEPT) {
+                STREAM_TO_UINT32((Char *)args, 4, object->pending.length);
+                STREAM_TO_UINT32((Char *)args, 8, object->pending.flags);
+                if (sock && sock->recvTimeout) {
+                    object->pending.timed = TRUE;
+                    object->pending.deadline = OS_ticks_get() +
+                        (sock->recvTimeout * 1000 + OS_TICK_PERIOD_US - 1) /
+                        OS_TICK_PERIOD_US;
+                }
+            }
+
+            if (!sock && (opcode != HCI_CMND_BSD_SELECT)) {
+                object->pending.sd = -1;
+            }
+            break;
+
+        case HCI_CMND_SETSOCKOPT:
+            STREAM_TO_UINT32((Char *)args, 8, mask);
+            STREAM_TO_UINT32((Char *)args, 20, value);
+            if (sock && (mask == SOCKOPT_NONBLOCK)) {
+                sock->nonBlocking = value;
+            }
+            else if (sock && (mask == SOCKOPT_RECV_TIMEOUT)) {
+                sock->recvTimeout = value;
+            }
+            CC3000Emu_eventLong(opcode, sock ? 0 : SOC_ERROR);
+            break;
+
+        case HCI_CMND_GETSOCKOPT:
+            STREAM_TO_UINT32((Char *)args, 8, mask);
+            value = 0;
+            if (sock && (mask == SOCKOPT_NONBLOCK)) {
+                value = sock->nonBlocking;
+            }
+            else if (sock && (mask == SOCKOPT_RECV_TIMEOUT)) {
+                value = sock->recvTimeout;
+            }
+            UINT32_TO_STREAM(params, value);
+            CC3000Emu_event(opcode, sock ? 0 : 1, params, 4);
+            break;
+
+        case HCI_CMND_GETHOSTNAME:
+            STREAM_TO_UINT32((Char *)args, 4, value);
+            for (i = 0; i < CC3000Emu_NUM_HOSTS; i++) {
+                if ((CC3000Emu_hosts[i].name[0] != '\0') &&
+                    (strlen(CC3000Emu_hosts[i].name) == value) &&
+                    (memcmp(CC3000Emu_hosts[i].name, args + 8, value) == 0)) {
+                    break;
+                }
+            }
+            p = params;
+            p = UINT32_TO_STREAM(p, (i < CC3000Emu_NUM_HOSTS) ? 1 : SOC_ERROR);
+            p = UINT32_TO_STREAM(p, (i < CC3000Emu_NUM_HOSTS) ?
+                                    CC3000Emu_hosts[i].ipAddr : 0);
+            CC3000Emu_event(opcode, 0, params, 8);
+            break;
+
+        case HCI_CMND_WLAN_CONNECT:
+            object->connected = TRUE;
+            CC3000Emu_eventLong(opcode, 0);
+            CC3000Emu_event(HCI_EVNT_WLAN_UNSOL_CONNECT, 0, NULL, 0);
+
+            /* IP, subnet, gateway, DHCP and DNS servers */
+            p = params;
+            p = UINT32_TO_STREAM(p, object->params.ipAddr);
+            p = UINT32_TO_STREAM(p, 0xFFFFFF00);
+            for (i = 0; i < 3; i++) {
+                p = UINT32_TO_STREAM(p, (object->params.ipAddr & 0xFFFFFF00) | 1);
+            }
+            CC3000Emu_event(HCI_EVNT_WLAN_UNSOL_DHCP, 0, params, 20);
+            break;
+
+        case HCI_CMND_WLAN_DISCONNECT:
+            object->connected = FALSE;
+            CC3000Emu_eventLong(opcode, 0);
+            CC3000Emu_event(HCI_EVNT_WLAN_UNSOL_DISCONNECT, 0, NULL, 0);
+            break;
+
+        case HCI_CMND_WLAN_IOCTL_STATUSGET:
+            CC3000Emu_eventLong(opcode, object->connected ?
+                                WLAN_STATUS_CONNECTED : WLAN_STATUS_DISCONNECTED);
+            break;
+
+        case HCI_NETAPP_IPCONFIG:
+            /* Addresses as in the DHCP event, then MAC and SSID */
+            memset(params, 0, sizeof(params));
+            p = params;
+            p = UINT32_TO_STREAM(p, object->params.ipAddr);
+            p = UINT32_TO_STREAM(p, 0xFFFFFF00);
+            for (i = 0; i < 3; i++) {
+                p = UINT32_TO_STREAM(p, (object->params.ipAddr & 0xFFFFFF00) | 1);
+            }
+            memcpy(p, "\x00\x12\x4b\x00\x00\x01", 6);
+            memcpy(p + 6, "CC3000Emu", 9);
+            CC3000Emu_event(opcode, 0, params,
+                            NETAPP_IPCONFIG_SSID_OFFSET + NETAPP_IPCONFIG_SSID_LENGTH);
+            break;
+
+        case HCI_CMND_NVMEM_READ:
+            STREAM_TO_UINT32((Char *)args, 4, value);
+            STREAM_TO_UINT32((Char *)args, 8, mask);
+            if ((sd >= NVMEM_MAX_ENTRY) || (mask > CC3000Emu_NVMEM_FILE_SIZE) ||
+                (value > CC3000Emu_NVMEM_FILE_SIZE - mask) ||
+                (value > CC3000Emu_MAX_PACKET - HCI_DATA_HEADER_SIZE)) {
+                CC3000Emu_event(opcode, 1, NULL, 0);
+                value = 0;
+            }
+            else {
+                CC3000Emu_event(opcode, 0, NULL, 0);
+            }
+
+            /* The host driver waits for the data even on an error */
+            if ((p = (UChar *)CC3000Emu_queue()) != NULL) {
+                CC3000Emu_Packet *data = (CC3000Emu_Packet *)p;
+
+                data->data[HCI_PACKET_TYPE_OFFSET] = HCI_TYPE_DATA;
+                data->data[HCI_PACKET_OPCODE_OFFSET] = HCI_DATA_NVMEM;
+                data->data[HCI_PACKET_ARGSIZE_OFFSET] = 0;
+                UINT16_TO_STREAM(data->data + HCI_PACKET_LENGTH_OFFSET, value);
+                if (value) {
+                    memcpy(data->data + HCI_DATA_HEADER_SIZE,
+                           object->nvmem[sd] + mask, value);
+                }
+                data->length = HCI_DATA_HEADER_SIZE + value;
+            }
+            break;
+
+        default:
+            /*
+             *  Plain acknowledgement. Zeroed parameters read as success both
+             *  for the events parsed as a status byte and as a 32-bit result.
+             */
+            memset(params, 0, sizeof(params));
+            CC3000Emu_event(opcode, 0, params, sizeof(params));
+            break;
+    }
+}
+
+/*
+ *  ======== CC3000Emu_connect ========
+ *  Queue a TCP connection on the socket listening on the port in addr.
+ */
+static Long CC3000Emu_connect(Int sd, UChar *addr)
+{
+    Int               i;
+    Int               child;
+    Int               listener = -1;
+    UInt32            queued = 0;
+    UShort            port = (addr[2] << 8) | addr[3];
+    CC3000Emu_Object *object = &CC3000Emu_object;
+    CC3000Emu_Socket *sock = &object->sockets[sd];
+
+    if ((sock->type != SOCK_STREAM) || (sock->state != SOCKET_IDLE)) {
+        return (SOC_ERROR);
+    }
+
+    for (i = 0; i < CC3000Emu_NUM_SOCKETS; i++) {
+        if (object->sockets[i].inUse &&
+            (object->sockets[i].state == SOCKET_LISTENING) &&
+            (object->sockets[i].port == port)) {
+            listener = i;
+        }
+    }
+    if (listener < 0) {
+        return (SOC_ERROR);
+    }
+
+    for (i = 0; i < CC3000Emu_NUM_SOCKETS; i++) {
+        if (object->sockets[i].inUse && !object->sockets[i].accepted &&
+            (object->sockets[i].listener == listener)) {
+            queued++;
+        }
+    }
+    if ((queued >= object->sockets[listener].backlog) && (queued > 0)) {
+        return (SOC_ERROR);
+    }
+
+    child = CC3000Emu_allocSocket();
+    if (child < 0) {
+        return (SOC_ERROR);
+    }
+
+    if (sock->port == 0) {
+        sock->port = CC3000Emu_allocPort();
+    }
+
+    object->sockets[child].type = SOCK_STREAM;
+    object->sockets[child].state = SOCKET_CONNECTED;
+    object->sockets[child].port = port;
+    object->sockets[child].peer = sd;
+    object->sockets[child].listener = listener;
+    object->sockets[child].accepted = FALSE;
+    object->sockets[child].seq = object->nextSeq++;
+
+    sock->state = SOCKET_CONNECTED;
+    sock->peer = child;
+
+    return (0);
+}
+
+/*
+ *  ======== CC3000Emu_data ========
+ *  Handle an HCI data packet: send(), sendto() or nvmem_write().
+ */
+static Void CC3000Emu_data(UChar *packet)
+{
+    UChar             opcode = packet[HCI_PACKET_OPCODE_OFFSET];
+    UChar             argSize = packet[HCI_PACKET_ARGSIZE_OFFSET];
+    UChar            *args = packet + HCI_DATA_HEADER_SIZE;
+    UChar             params[8];
+    UInt32            length;
+    UInt32            offset;
+    Long              sd;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    STREAM_TO_UINT32((Char *)args, 0, sd);
+    STREAM_TO_UINT32((Char *)args, 8, length);
+
+    object->stats.dataPackets++;
+
+    switch (opcode) {
+        case HCI_CMND_SEND:
+        case HCI_CMND_SENDTO:
+            object->stats.bytesToDevice += length;
+
+            if (M_IS_VALID_SD(sd) && object->sockets[sd].inUse) {
+                CC3000Emu_sendTo(sd, args + argSize, length,
+                    (opcode == HCI_CMND_SENDTO) ? args + argSize + length : NULL);
+            }
+
+            UINT32_TO_STREAM(params, sd);
+            UINT32_TO_STREAM(params + 4, length);
+            CC3000Emu_event((opcode == HCI_CMND_SEND) ?
+                            HCI_EVNT_SEND : HCI_EVNT_SENDTO, 0, params, 8);
+
+            /* The buffer is free again once the data has been queued */
+            object->freedBuffers++;
+            break;
+
+        case HCI_CMND_NVMEM_WRITE:
+            STREAM_TO_UINT32((Char *)args, 12, offset);
+            if ((sd >= NVMEM_MAX_ENTRY) || (offset > CC3000Emu_NVMEM_FILE_SIZE) ||
+                (length > CC3000Emu_NVMEM_FILE_SIZE - offset)) {
+                CC3000Emu_eventLong(HCI_EVNT_NVMEM_WRITE, SOC_ERROR);
+            }
+            else {
+                memcpy(object->nvmem[sd] + offset, args + argSize, length);
+                CC3000Emu_eventLong(HCI_EVNT_NVMEM_WRITE, 0);
+            }
+            break;
+    }
+}
+
+/*
+ *  ======== CC3000Emu_deliver ========
+ *  Copy the oldest queued packet to wlan_rx_buffer, or its recv() payload
+ *  straight to the buffer registered by the host driver.
+ */
+static Void CC3000Emu_deliver(Void)
+{
+    UChar             argSize;
+    UShort            length;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+    CC3000Emu_Packet *packet = &object->queue[object->queueHead];
+    UChar            *data = packet->data;
+
+    object->queueHead = (object->queueHead + 1) % CC3000Emu_QUEUE_LENGTH;
+    object->queueCount--;
+    object->resumed = FALSE;
+
+    if (data[HCI_PACKET_TYPE_OFFSET] == HCI_TYPE_EVNT) {
+        object->stats.events++;
+        memcpy(wlan_rx_buffer + SPI_HEADER_SIZE, data, packet->length);
+        return;
+    }
+
+    object->stats.dataDelivered++;
+    argSize = data[HCI_PACKET_ARGSIZE_OFFSET];
+    STREAM_TO_UINT16((Char *)data, HCI_PACKET_LENGTH_OFFSET, length);
+    length -= argSize;
+
+    if ((tSLInformation.pucRxUserBuffer != NULL) &&
+        ((data[HCI_PACKET_OPCODE_OFFSET] == HCI_DATA_RECV) ||
+         (data[HCI_PACKET_OPCODE_OFFSET] == HCI_DATA_RECVFROM)) &&
+        (length > 0) && (length <= tSLInformation.usRxUserBufferLength)) {
+        memcpy(wlan_rx_buffer + SPI_HEADER_SIZE, data,
+               HCI_DATA_HEADER_SIZE + argSize);
+        memcpy(tSLInformation.pucRxUserBuffer,
+               data + HCI_DATA_HEADER_SIZE + argSize, length);
+        tSLInformation.usRxUserBufferFilled = length;
+    }
+    else {
+        memcpy(wlan_rx_buffer + SPI_HEADER_SIZE, data, packet->length);
+    }
+}
+
+/*
+ *  ======== CC3000Emu_disableIrqInt ========
+ *  Callback for host driver. Registered with wlan_init().
+ */
+static Void CC3000Emu_disableIrqInt(Void)
+{
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+    object->irqEnabled = FALSE;
+    OS_mutex_unlock(object->mutex, key);
+}
+
+/*
+ *  ======== CC3000Emu_enableIrqInt ========
+ *  Callback for host driver. Registered with wlan_init().
+ */
+static Void CC3000Emu_enableIrqInt(Void)
+{
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+    object->irqEnabled = TRUE;
+    OS_mutex_unlock(object->mutex, key);
+
+    OS_semaphore_post(object->kick);
+}
+
+/*
+ *  ======== CC3000Emu_event ========
+ *  Queue an HCI event for the host driver.
+ */
+static Void CC3000Emu_event(UShort opcode, UChar status, UChar *params,
+                            UShort length)
+{
+    CC3000Emu_Packet *packet = CC3000Emu_queue();
+
+    if (packet == NULL) {
+        return;
+    }
+
+    packet->data[HCI_PACKET_TYPE_OFFSET] = HCI_TYPE_EVNT;
+    UINT16_TO_STREAM(packet->data + HCI_EVENT_OPCODE_OFFSET, opcode);
+    packet->data[HCI_EVENT_LENGTH_OFFSET] = length + 1;
+    packet->data[HCI_EVENT_STATUS_OFFSET] = status;
+    if (length) {
+        memcpy(packet->data + HCI_EVENT_HEADER_SIZE, params, length);
+    }
+    packet->length = HCI_EVENT_HEADER_SIZE + length;
+}
+
+/*
+ *  ======== CC3000Emu_eventLong ========
+ *  Queue an event carrying a single 32-bit result.
+ */
+static Void CC3000Emu_eventLong(UShort opcode, Long value)
+{
+    UChar params[4];
+
+    UINT32_TO_STREAM(params, value);
+    CC3000Emu_event(opcode, 0, params, sizeof(params));
+}
+
+/*
+ *  ======== CC3000Emu_fillAddr ========
+ *  Fill an AF_INET sockaddr with the emulated address and port.
+ */
+static Void CC3000Emu_fillAddr(UChar *addr, UShort port)
+{
+    UInt32 ipAddr = CC3000Emu_object.params.ipAddr;
+
+    UINT16_TO_STREAM(addr, AF_INET);
+    addr[2] = port >> 8;
+    addr[3] = port & 0xFF;
+    addr[4] = ipAddr >> 24;
+    addr[5] = (ipAddr >> 16) & 0xFF;
+    addr[6] = (ipAddr >> 8) & 0xFF;
+    addr[7] = ipAddr & 0xFF;
+}
+
+/*
+ *  ======== CC3000Emu_get ========
+ *  Take up to count bytes from a socket's receive buffer. dst may be NULL
+ *  to drop them.
+ */
+static UInt CC3000Emu_get(CC3000Emu_Socket *sock, UChar *dst, UInt count)
+{
+    UInt i;
+
+    if (count > sock->count) {
+        count = sock->count;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (dst) {
+            dst[i] = sock->buf[sock->head];
+        }
+        sock->head = (sock->head + 1) % CC3000Emu_SOCKET_BUF_SIZE;
+    }
+    sock->count -= count;
+
+    return (count);
+}
+
+/*
+ *  ======== CC3000Emu_patch ========
+ *  Handle the first packet of a patch. hci_patch_send() sends larger patches
+ *  as a header packet followed by PATCH_PORTION_SIZE portions.
+ */
+static Void CC3000Emu_patch(UChar *packet)
+{
+    UShort            total;
+    UShort            portion;
+    UInt32            length;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    STREAM_TO_UINT16((Char *)packet, 2, total);
+    STREAM_TO_UINT16((Char *)packet, 4, portion);
+
+    if ((object->patchType == 0) ||
+        (packet[HCI_PACKET_OPCODE_OFFSET] != object->patchType)) {
+        return;
+    }
+
+    object->stats.patchBytes[object->patchType - 1] += portion;
+
+    /*
+     *  total counts the patch, its header and one length word per extra
+     *  portion as estimated by hci_patch_send(). Find the patch length.
+     */
+    length = (total >= SIMPLE_LINK_HCI_PATCH_HEADER_SIZE) ?
+             total - SIMPLE_LINK_HCI_PATCH_HEADER_SIZE : 0;
+    while ((length > portion) &&
+           (length + (length / PATCH_PORTION_SIZE) *
+            SIMPLE_LINK_HCI_PATCH_HEADER_SIZE + SIMPLE_LINK_HCI_PATCH_HEADER_SIZE
+            > total)) {
+        length--;
+    }
+
+    object->patchRemaining = (length > portion) ? length - portion : 0;
+    if (object->patchRemaining == 0) {
+        CC3000Emu_patchDone();
+    }
+}
+
+/*
+ *  ======== CC3000Emu_patchDone ========
+ *  Request the next patch, or finish SIMPLE_LINK_START after the last one.
+ */
+static Void CC3000Emu_patchDone(Void)
+{
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    if (object->patchType < HCI_EVENT_PATCHES_BOOTLOAD_REQ) {
+        CC3000Emu_patchRequest(object->patchType + 1);
+    }
+    else {
+        object->patchType = 0;
+        CC3000Emu_event(HCI_CMND_SIMPLE_LINK_START, 0, NULL, 0);
+    }
+}
+
+/*
+ *  ======== CC3000Emu_patchRequest ========
+ *  Ask the host driver for a patch.
+ */
+static Void CC3000Emu_patchRequest(UChar type)
+{
+    CC3000Emu_object.patchType = type;
+    CC3000Emu_event(HCI_EVNT_PATCHES_REQ, 0, &type, 1);
+}
+
+/*
+ *  ======== CC3000Emu_put ========
+ *  Append up to count bytes to a socket's receive buffer.
+ */
+static UInt CC3000Emu_put(CC3000Emu_Socket *sock, UChar *src, UInt count)
+{
+    UInt i;
+    UInt tail = (sock->head + sock->count) % CC3000Emu_SOCKET_BUF_SIZE;
+
+    if (count > CC3000Emu_SOCKET_BUF_SIZE - sock->count) {
+        count = CC3000Emu_SOCKET_BUF_SIZE - sock->count;
+    }
+
+    for (i = 0; i < count; i++) {
+        sock->buf[tail] = src[i];
+        tail = (tail + 1) % CC3000Emu_SOCKET_BUF_SIZE;
+    }
+    sock->count += count;
+
+    return (count);
+}
+
+/*
+ *  ======== CC3000Emu_queue ========
+ *  Returns the next free packet of the queue to the host, NULL if full.
+ */
+static CC3000Emu_Packet *CC3000Emu_queue(Void)
+{
+    CC3000Emu_Object *object = &CC3000Emu_object;
+    CC3000Emu_Packet *packet;
+
+    if (object->queueCount == CC3000Emu_QUEUE_LENGTH) {
+        object->stats.overflows++;
+        return (NULL);
+    }
+
+    packet = &object->queue[(object->queueHead + object->queueCount) %
+                            CC3000Emu_QUEUE_LENGTH];
+    object->queueCount++;
+
+    return (packet);
+}
+
+/*
+ *  ======== CC3000Emu_readIrqPin ========
+ *  Callback for host driver. Registered with wlan_init(). The device pulls
+ *  IRQ low as soon as it is enabled.
+ */
+static Long CC3000Emu_readIrqPin(Void)
+{
+    return (CC3000Emu_object.enabled ? 0 : 1);
+}
+
+/*
+ *  ======== CC3000Emu_readable ========
+ *  TRUE if a recv() or accept() on sd would not block.
+ */
+static Bool CC3000Emu_readable(Int sd)
+{
+    Int               i;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+    CC3000Emu_Socket *sock = &object->sockets[sd];
+
+    if (!sock->inUse || !sock->accepted) {
+        return (FALSE);
+    }
+
+    if (sock->count || (sock->state == SOCKET_PEER_CLOSED)) {
+        return (TRUE);
+    }
+
+    for (i = 0; (sock->state == SOCKET_LISTENING) &&
+                (i < CC3000Emu_NUM_SOCKETS); i++) {
+        if (object->sockets[i].inUse && !object->sockets[i].accepted &&
+            (object->sockets[i].listener == sd)) {
+            return (TRUE);
+        }
+    }
+
+    return (FALSE);
+}
+
+/*
+ *  ======== CC3000Emu_recv ========
+ *  Complete a recv() or recvfrom() once there is data, the peer has closed
+ *  the connection or the receive timeout has expired.
+ */
+static Bool CC3000Emu_recv(CC3000Emu_Pending *pending, Bool expired)
+{
+    Long              count = 0;
+    UShort            length;
+    UShort            port = 0;
+    UChar             params[12];
+    UChar             header[DATAGRAM_HEADER_SIZE];
+    UChar            *args;
+    CC3000Emu_Packet *packet;
+    CC3000Emu_Socket *sock;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    sock = (pending->sd >= 0) ? &object->sockets[pending->sd] : NULL;
+
+    if (sock && sock->count) {
+        count = pending->length;
+        if (count > object->params.bufferLength) {
+            count = object->params.bufferLength;
+        }
+
+        if (sock->type == SOCK_DGRAM) {
+            CC3000Emu_get(sock, header, DATAGRAM_HEADER_SIZE);
+            STREAM_TO_UINT16((Char *)header, 0, length);
+            port = (header[2] << 8) | header[3];
+            if (count > length) {
+                count = length;
+            }
+        }
+        else if (count > sock->count) {
+            count = sock->count;
+        }
+    }
+    else if (sock && !expired && (sock->type == SOCK_STREAM ?
+             sock->state == SOCKET_CONNECTED : TRUE)) {
+        return (FALSE);
+    }
+    else if (!sock) {
+        count = SOC_ERROR;
+    }
+
+    /* Event, then the data packet for the host driver's SimpleLinkWaitData() */
+    UINT32_TO_STREAM(params, pending->sd);
+    UINT32_TO_STREAM(params + 4, count);
+    UINT32_TO_STREAM(params + 8, pending->flags);
+    CC3000Emu_event(pending->opcode, 0, params, sizeof(params));
+
+    if (count <= 0) {
+        return (TRUE);
+    }
+
+    packet = CC3000Emu_queue();
+    if (packet == NULL) {
+        CC3000Emu_get(sock, NULL, (sock->type == SOCK_DGRAM) ? length : count);
+        return (TRUE);
+    }
+
+    packet->data[HCI_PACKET_TYPE_OFFSET] = HCI_TYPE_DATA;
+    packet->data[HCI_PACKET_OPCODE_OFFSET] =
+        (pending->opcode == HCI_CMND_RECVFROM) ? HCI_DATA_RECVFROM : HCI_DATA_RECV;
+    packet->data[HCI_PACKET_ARGSIZE_OFFSET] = RECV_ARGS_SIZE;
+    UINT16_TO_STREAM(packet->data + HCI_PACKET_LENGTH_OFFSET,
+                     RECV_ARGS_SIZE + count);
+
+    args = packet->data + HCI_DATA_HEADER_SIZE;
+    memset(args, 0, RECV_ARGS_SIZE);
+    UINT32_TO_STREAM(args, pending->sd);
+    UINT32_TO_STREAM(args + BSD_RECV_FROM_FROMLEN_OFFSET, ASIC_ADDR_LEN);
+    UINT32_TO_STREAM(args + 8, count);
+    CC3000Emu_fillAddr(args + BSD_RECV_FROM_FROM_OFFSET,
+        (sock->type == SOCK_DGRAM) ? port :
+        ((sock->peer >= 0) ? object->sockets[sock->peer].port : 0));
+
+    CC3000Emu_get(sock, args + RECV_ARGS_SIZE, count);
+    packet->length = HCI_DATA_HEADER_SIZE + RECV_ARGS_SIZE + count;
+
+    /* The rest of a datagram that did not fit is lost */
+    if ((sock->type == SOCK_DGRAM) && (length > count)) {
+        CC3000Emu_get(sock, NULL, length - count);
+    }
+
+    object->stats.bytesToHost += count;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== CC3000Emu_reset ========
+ *  Power the device down: all sockets and queued packets are lost.
+ */
+static Void CC3000Emu_reset(Void)
+{
+    Int               i;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    for (i = 0; i < CC3000Emu_NUM_SOCKETS; i++) {
+        object->sockets[i].inUse = FALSE;
+    }
+
+    object->queueHead = 0;
+    object->queueCount = 0;
+    object->freedBuffers = 0;
+    object->holdBuffers = FALSE;
+    object->pending.opcode = 0;
+    object->patchType = 0;
+    object->patchRemaining = 0;
+    object->connected = FALSE;
+}
+
+/*
+ *  ======== CC3000Emu_select ========
+ *  Complete a select() once a socket is ready or the timeout has expired.
+ *  Sockets are always writable.
+ */
+static Bool CC3000Emu_select(CC3000Emu_Pending *pending, Bool expired)
+{
+    Int               sd;
+    Long              ready = 0;
+    UInt32            readFds = 0;
+    UInt32            writeFds = 0;
+    UChar             params[16];
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    for (sd = 0; sd < CC3000Emu_NUM_SOCKETS; sd++) {
+        if ((pending->readFds & (1 << sd)) && CC3000Emu_readable(sd)) {
+            readFds |= 1 << sd;
+            ready++;
+        }
+        if ((pending->writeFds & (1 << sd)) && object->sockets[sd].inUse &&
+            object->sockets[sd].accepted) {
+            writeFds |= 1 << sd;
+            ready++;
+        }
+    }
+
+    if ((ready == 0) && !expired) {
+        return (FALSE);
+    }
+
+    UINT32_TO_STREAM(params, ready);
+    UINT32_TO_STREAM(params + 4, readFds);
+    UINT32_TO_STREAM(params + 8, writeFds);
+    UINT32_TO_STREAM(params + 12, 0);
+    CC3000Emu_event(HCI_EVNT_SELECT, 0, params, sizeof(params));
+
+    return (TRUE);
+}
+
+/*
+ *  ======== CC3000Emu_sendTo ========
+ *  Pass sent data to the peer of a TCP connection, or a datagram to the
+ *  UDP socket bound to the destination port. Data that does not fit the
+ *  receiving socket's buffer is dropped.
+ */
+static Void CC3000Emu_sendTo(Int sd, UChar *data, UInt32 length, UChar *to)
+{
+    Int               i;
+    UShort            port;
+    UChar             header[DATAGRAM_HEADER_SIZE];
+    CC3000Emu_Socket *dest = NULL;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+    CC3000Emu_Socket *sock = &object->sockets[sd];
+
+    if (sock->type == SOCK_STREAM) {
+        if (sock->peer >= 0) {
+            dest = &object->sockets[sock->peer];
+            if (CC3000Emu_put(dest, data, length) != length) {
+                object->stats.overflows++;
+            }
+        }
+        return;
+    }
+
+    if (to == NULL) {
+        return;
+    }
+
+    if (sock->port == 0) {
+        sock->port = CC3000Emu_allocPort();
+    }
+
+    port = (to[2] << 8) | to[3];
+    for (i = 0; i < CC3000Emu_NUM_SOCKETS; i++) {
+        if (object->sockets[i].inUse && (object->sockets[i].type == SOCK_DGRAM) &&
+            (object->sockets[i].port == port)) {
+            dest = &object->sockets[i];
+        }
+    }
+
+    if (dest == NULL) {
+        return;
+    }
+
+    if (CC3000Emu_SOCKET_BUF_SIZE - dest->count <
+        DATAGRAM_HEADER_SIZE + length) {
+        object->stats.overflows++;
+        return;
+    }
+
+    /* Source port and address, the family replaced by the length */
+    CC3000Emu_fillAddr(header, sock->port);
+    UINT16_TO_STREAM(header, length);
+    CC3000Emu_put(dest, header, DATAGRAM_HEADER_SIZE);
+    CC3000Emu_put(dest, data, length);
+}
+
+/*
+ *  ======== CC3000Emu_service ========
+ *  Answer the pending command if the device can, and release the buffers
+ *  freed by sends once everything queued before them has been delivered.
+ */
+static Void CC3000Emu_service(Void)
+{
+    Bool               done = TRUE;
+    Bool               expired;
+    UChar              params[2 + FLOW_CONTROL_EVENT_SIZE];
+    CC3000Emu_Object  *object = &CC3000Emu_object;
+    CC3000Emu_Pending *pending = &object->pending;
+
+    if (pending->opcode) {
+        expired = pending->timed &&
+                  ((Int32)(OS_ticks_get() - pending->deadline) >= 0);
+
+        switch (pending->opcode) {
+            case HCI_CMND_ACCEPT:
+                if (pending->sd < 0) {
+                    CC3000Emu_eventLong(HCI_EVNT_ACCEPT, SOC_ERROR);
+                }
+                else {
+                    done = CC3000Emu_accept(pending);
+                }
+                break;
+
+            case HCI_CMND_RECV:
+            case HCI_CMND_RECVFROM:
+                done = CC3000Emu_recv(pending, expired);
+                break;
+
+            case HCI_CMND_BSD_SELECT:
+                done = CC3000Emu_select(pending, expired);
+                break;
+        }
+
+        if (done) {
+            pending->opcode = 0;
+        }
+    }
+
+    if (object->freedBuffers && (object->queueCount == 0) &&
+        !object->holdBuffers) {
+        memset(params, 0, sizeof(params));
+        UINT16_TO_STREAM(params, 1);
+        UINT16_TO_STREAM(params + 2 + FLOW_CONTROL_EVENT_FREE_BUFFS_OFFSET,
+                         object->freedBuffers);
+        CC3000Emu_event(HCI_EVNT_DATA_UNSOL_FREE_BUFF, 0, params,
+                        sizeof(params));
+
+        object->stats.freedBuffers += object->freedBuffers;
+        object->freedBuffers = 0;
+    }
+}
+
+/*
+ *  ======== CC3000Emu_taskFxn ========
+ *  The device's side of the IRQ line. Hands the queued packets one at a time
+ *  to the receive handler registered by SpiOpen(), the next one only after
+ *  SpiResumeSpi(), and times out pending commands.
+ */
+static Void CC3000Emu_taskFxn(Void *arg)
+{
+    RxHandlerFxn      rxHandler;
+    MutexKey          key;
+    UInt32            timeout;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+
+    while (!object->stop) {
+        CC3000Emu_service();
+
+        if (object->enabled && object->irqEnabled && object->resumed &&
+            object->queueCount) {
+            CC3000Emu_deliver();
+            rxHandler = object->rxHandler;
+
+            /* The handler may call back into the emulator */
+            OS_mutex_unlock(object->mutex, key);
+            rxHandler(wlan_rx_buffer + SPI_HEADER_SIZE);
+            OS_mutex_lock(object->mutex, &key);
+            continue;
+        }
+
+        timeout = CC3000Emu_timeout();
+
+        OS_mutex_unlock(object->mutex, key);
+        OS_semaphore_pend(object->kick, timeout);
+        OS_mutex_lock(object->mutex, &key);
+    }
+
+    OS_mutex_unlock(object->mutex, key);
+}
+
+/*
+ *  ======== CC3000Emu_timeout ========
+ *  Ticks until the pending command times out, for OS_semaphore_pend().
+ */
+static UInt32 CC3000Emu_timeout(Void)
+{
+    Int32             ticks;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    if (!object->pending.opcode || !object->pending.timed) {
+        return (e_WAIT_FOREVER);
+    }
+
+    ticks = (Int32)(object->pending.deadline - OS_ticks_get());
+
+    /* 0 and 1 would mean e_NO_WAIT and e_WAIT_FOREVER */
+    return ((ticks < 2) ? 2 : ticks);
+}
+
+/*
+ *  ======== CC3000Emu_write ========
+ *  Take a packet from the host driver. The SPI header in the first
+ *  SPI_HEADER_SIZE bytes is not used.
+ */
+static Void CC3000Emu_write(UChar *userBuffer, UShort length)
+{
+    MutexKey          key;
+    UChar            *packet = userBuffer + SPI_HEADER_SIZE;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+
+    if (!object->enabled) {
+        OS_mutex_unlock(object->mutex, key);
+        return;
+    }
+
+    if (object->patchRemaining) {
+        /* Further portion of a patch: length word and data */
+        length -= SIMPLE_LINK_HCI_PATCH_HEADER_SIZE;
+        object->stats.patchBytes[object->patchType - 1] += length;
+        object->patchRemaining = (object->patchRemaining > length) ?
+                                 object->patchRemaining - length : 0;
+        if (object->patchRemaining == 0) {
+            CC3000Emu_patchDone();
+        }
+    }
+    else {
+        switch (packet[HCI_PACKET_TYPE_OFFSET]) {
+            case HCI_TYPE_CMND:
+                CC3000Emu_command(packet);
+                break;
+
+            case HCI_TYPE_DATA:
+                CC3000Emu_data(packet);
+                break;
+
+            case HCI_TYPE_PATCH:
+                CC3000Emu_patch(packet);
+                break;
+        }
+    }
+
+    /* Answer in the caller's context so that runs are repeatable */
+    CC3000Emu_service();
+
+    OS_mutex_unlock(object->mutex, key);
+
+    OS_semaphore_post(object->kick);
+}
+
+/*
+ *  ======== CC3000Emu_writeWlanEnPin ========
+ *  Callback for host driver. Registered with wlan_init() and called by
+ *  wlan_start() and wlan_stop().
+ */
+static Void CC3000Emu_writeWlanEnPin(UChar val)
+{
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+    if (!val) {
+        CC3000Emu_reset();
+    }
+    object->enabled = val ? TRUE : FALSE;
+    OS_mutex_unlock(object->mutex, key);
+}
+
+/*
+ *  ======== CC3000Emu_addHost ========
+ */
+Bool CC3000Emu_addHost(const Char *name, UInt32 ipAddr)
+{
+    Int               i;
+    Bool              added = FALSE;
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    if (strlen(name) >= CC3000Emu_HOST_NAME_LEN) {
+        return (FALSE);
+    }
+
+    if (object->isOpen) {
+        OS_mutex_lock(object->mutex, &key);
+    }
+
+    for (i = 0; i < CC3000Emu_NUM_HOSTS; i++) {
+        if (CC3000Emu_hosts[i].name[0] == '\0') {
+            strcpy(CC3000Emu_hosts[i].name, name);
+            CC3000Emu_hosts[i].ipAddr = ipAddr;
+            added = TRUE;
+            break;
+        }
+    }
+
+    if (object->isOpen) {
+        OS_mutex_unlock(object->mutex, key);
+    }
+
+    return (added);
+}
+
+/*
+ *  ======== CC3000Emu_close ========
+ */
+Void CC3000Emu_close(Void)
+{
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    if (!object->isOpen) {
+        return;
+    }
+
+    wlan_stop();
+
+    OS_mutex_lock(object->mutex, &key);
+    object->stop = TRUE;
+    OS_mutex_unlock(object->mutex, key);
+
+    OS_semaphore_post(object->kick);
+    OS_thread_delete(&object->thread);
+
+    OS_semaphore_delete(&object->kick);
+    OS_mutex_delete(&object->mutex);
+    object->isOpen = FALSE;
+}
+
+/*
+ *  ======== CC3000Emu_getStats ========
+ */
+Void CC3000Emu_getStats(CC3000Emu_Stats *stats)
+{
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+    *stats = object->stats;
+    OS_mutex_unlock(object->mutex, key);
+}
+
+/*
+ *  ======== CC3000Emu_holdBuffers ========
+ */
+Void CC3000Emu_holdBuffers(Bool hold)
+{
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+    object->holdBuffers = hold;
+    OS_mutex_unlock(object->mutex, key);
+
+    OS_semaphore_post(object->kick);
+}
+
+/*
+ *  ======== CC3000Emu_open ========
+ */
+Bool CC3000Emu_open(CC3000Emu_Params *params, tWlanCB wlanCB,
+                    tFWPatches fwPatches, tDriverPatches driverPatches,
+                    tBootLoaderPatches bootLoaderPatches)
+{
+    s_thread_params   threadParams = {0};
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    if (object->isOpen) {
+        return (FALSE);
+    }
+
+    memset(object, 0, sizeof(CC3000Emu_Object));
+
+    if (params == NULL) {
+        CC3000Emu_Params_init(&object->params);
+    }
+    else {
+        object->params = *params;
+    }
+
+    if (e_SUCCESS != OS_mutex_create(&object->mutex, "CC3000Emu.mutex")) {
+        return (FALSE);
+    }
+
+    if (e_SUCCESS != OS_semaphore_create(&object->kick, "CC3000Emu.kick",
+                                         e_MODE_BINARY, 0)) {
+        OS_mutex_delete(&object->mutex);
+        return (FALSE);
+    }
+
+    threadParams.thread_name = (sInt8 *)"CC3000Emu";
+    threadParams.p_entry_function = CC3000Emu_taskFxn;
+    if (e_SUCCESS != OS_thread_create(&object->thread, &threadParams)) {
+        OS_semaphore_delete(&object->kick);
+        OS_mutex_delete(&object->mutex);
+        return (FALSE);
+    }
+
+    object->isOpen = TRUE;
+
+    /* Register callbacks with the host driver */
+    wlan_init(wlanCB, fwPatches, driverPatches, bootLoaderPatches,
+              CC3000Emu_readIrqPin,
+              CC3000Emu_enableIrqInt,
+              CC3000Emu_disableIrqInt,
+              CC3000Emu_writeWlanEnPin);
+
+    /* Have the patches requested from the host if there are any */
+    wlan_start((fwPatches || driverPatches || bootLoaderPatches) ? 1 : 0);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== CC3000Emu_Params_init ========
+ */
+Void CC3000Emu_Params_init(CC3000Emu_Params *params)
+{
+    params->numBuffers = 6;
+    params->bufferLength = CC3000Emu_PAYLOAD_SIZE;
+    params->ipAddr = 0x7F000001;
+}
+
+/*
+ *  ======== SpiClose ========
+ *  Called by wlan_stop().
+ */
+Void SpiClose(Void)
+{
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+    object->irqEnabled = FALSE;
+    OS_mutex_unlock(object->mutex, key);
+}
+
+/*
+ *  ======== SpiOpen ========
+ *  Called by wlan_start().
+ */
+Void SpiOpen(RxHandlerFxn rxHandler)
+{
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+    object->rxHandler = rxHandler;
+    object->irqEnabled = TRUE;
+    object->resumed = TRUE;
+    OS_mutex_unlock(object->mutex, key);
+}
+
+/*
+ *  ======== SpiResumeSpi ========
+ *  Called by the host driver once it is done with wlan_rx_buffer.
+ */
+Void SpiResumeSpi(Void)
+{
+    MutexKey          key;
+    CC3000Emu_Object *object = &CC3000Emu_object;
+
+    OS_mutex_lock(object->mutex, &key);
+    object->resumed = TRUE;
+    OS_mutex_unlock(object->mutex, key);
+
+    OS_semaphore_post(object->kick);
+}
+
+/*
+ *  ======== SpiWrite ========
+ *  Function used by the upper-level host-driver to send data and commands to
+ *  the CC3000. Called by HCI layer.
+ */
+Void SpiWrite(UChar *userBuffer, UShort length)
+{
+    CC3000Emu_write(userBuffer, length);
+}
+
+/*
+ *  ======== SpiWriteAsync ========
+ *  The emulated write completes before returning, which satisfies the
+ *  posted write contract of SpiWriteAsync().
+ */
+Void SpiWriteAsync(UChar *userBuffer, UShort length)
+{
+    CC3000Emu_write(userBuffer, length);
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2013, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** ============================================================================
+ *  @file       CC3000Emu.h
+ *
+ *  @brief      Host-side emulation of a CC3000 module
+ *
+ *  The emulator stands in for WiFiTivaCC3000.c and the CC3000 itself so the
+ *  CC3000 host driver can be run, regression tested and benchmarked on a
+ *  Linux host with no module attached. It implements the transport API of
+ *  spi.h and a model of the device behind it:
+ *
+ *  - HCI command/event framing, including the SIMPLE_LINK_START patch-request
+ *    sequence (driver, firmware and bootloader patches) when the host offers
+ *    patches, and the READ_BUFFER_SIZE handshake.
+ *  - Data packets for send(), sendto() and recv()/recvfrom(), including
+ *    recv() payloads placed straight into the caller's buffer like the Tiva
+ *    transport does.
+ *  - HCI_EVNT_DATA_UNSOL_FREE_BUFF flow control events releasing the
+ *    buffers consumed by sends, and HCI_EVNT_BSD_TCP_CLOSE_WAIT when a peer
+ *    closes its end of a connection.
+ *  - A loopback network. TCP and UDP sockets opened through the host driver
+ *    talk to each other inside the emulator: connect() and sendto() reach the
+ *    socket bound to the destination port, whatever the destination address.
+ *    gethostbyname() resolves names registered with CC3000Emu_addHost().
+ *  - An in-memory NVMEM for nvmem_read() and nvmem_write().
+ *
+ *  The device side runs in its own thread, which plays the part of the IRQ
+ *  interrupt: it hands one packet at a time to the host driver's receive
+ *  handler and waits for SpiResumeSpi() before the next, as the Tiva
+ *  transport does with the IRQ and SPI interrupts. Everything is built on the
+ *  OSAL, so the whole stack links against osal/posix/src/os.c.
+ *
+ *  Host build: define CC3000_OSAL_POSIX, use the XDCtools headers for
+ *  xdc/std.h and compile for 32 bits (-m32) with -funsigned-char, because
+ *  the host driver relies on long being 32 bits wide and on char being
+ *  unsigned as on ARM. Add packages/ti/drivers/wifi/cc3000 to the include
+ *  path and link the core_driver sources (plus implementation/multi_threaded
+ *  with __ENABLE_MULTITHREADED_SUPPORT__), osal/posix/src/os.c, this module
+ *  and -lpthread. The emulator provides the wlan_tx_buffer and wlan_rx_buffer
+ *  that the WiFi module normally generates. The Makefile in this directory
+ *  does all of that and builds the regression tests (CC3000EmuTest.c, run
+ *  by "make test"), the benchmarks (CC3000EmuBench.c, "make bench") and the
+ *  AES128 benchmark (CC3000EmuAesBench.c, "make aesbench").
+ *
+ *  ============================================================================
+ */
+
+#ifndef ti_drivers_wifi_cc3000_emulator_CC3000Emu__include
+#define ti_drivers_wifi_cc3000_emulator_CC3000Emu__include
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <xdc/std.h>
+
+#include <cc3000_host_driver/include/common/cc3000_common.h>
+
+/*!
+ *  @brief  Emulated device parameters
+ */
+typedef struct CC3000Emu_Params {
+    UChar           numBuffers;     /*!< Buffers reported by READ_BUFFER_SIZE */
+    UShort          bufferLength;   /*!< Buffer length reported to the host */
+    UInt32          ipAddr;         /*!< Address reported by DHCP, e.g. 0x7F000001 */
+} CC3000Emu_Params;
+
+/*!
+ *  @brief  Traffic counters, see CC3000Emu_getStats()
+ */
+typedef struct CC3000Emu_Stats {
+    UInt32          commands;       /*!< HCI commands received */
+    UInt32          dataPackets;    /*!< HCI data packets received */
+    UInt32          events;         /*!< Events delivered to the host */
+    UInt32          dataDelivered;  /*!< Data packets delivered to the host */
+    UInt32          bytesToDevice;  /*!< Payload bytes sent by the host */
+    UInt32          bytesToHost;    /*!< Payload bytes received by the host */
+    UInt32          freedBuffers;   /*!< Buffers released by flow control */
+    UInt32          patchBytes[3];  /*!< Driver, firmware, bootloader patch bytes */
+    UInt32          overflows;      /*!< Packets dropped on a full queue */
+} CC3000Emu_Stats;
+
+/*!
+ *  @brief  Register a name for gethostbyname()
+ *
+ *  @param  name    Host name, up to 63 characters
+ *  @param  ipAddr  Address returned for it, e.g. 0x7F000001 for 127.0.0.1
+ *
+ *  @return TRUE if the name was added, FALSE if the table is full
+ */
+extern Bool CC3000Emu_addHost(const Char *name, UInt32 ipAddr);
+
+/*!
+ *  @brief  Stop the host driver and the emulated device
+ *
+ *  Calls wlan_stop().
+ */
+extern Void CC3000Emu_close(Void);
+
+/*!
+ *  @brief  Read the traffic counters
+ *
+ *  @param  stats   Filled with the counters since CC3000Emu_open()
+ */
+extern Void CC3000Emu_getStats(CC3000Emu_Stats *stats);
+
+/*!
+ *  @brief  Hold back the buffers freed by sends
+ *
+ *  While held, no HCI_EVNT_DATA_UNSOL_FREE_BUFF event is sent, so the host
+ *  runs out of CC3000 buffers as it would behind a slow link. Releasing
+ *  them sends everything freed in the meantime.
+ *
+ *  @param  hold    TRUE to hold the buffers, FALSE to release them
+ */
+extern Void CC3000Emu_holdBuffers(Bool hold);
+
+/*!
+ *  @brief  Start the emulated device and the host driver on top of it
+ *
+ *  Calls wlan_init() with the emulator's pin and interrupt callbacks and
+ *  wlan_start(). Patches are requested from the host if any of the patch
+ *  callbacks is given; the emulator only counts the bytes it receives.
+ *
+ *  @param  params          Device parameters, NULL for the defaults
+ *  @param  wlanCB          Asynchronous event callback of the host driver
+ *  @param  fwPatches       Firmware patch callback or NULL
+ *  @param  driverPatches   Driver patch callback or NULL
+ *  @param  bootLoaderPatches Bootloader patch callback or NULL
+ *
+ *  @return TRUE on success, FALSE if the emulator is already open or its OSAL
+ *          objects could not be created
+ */
+extern Bool CC3000Emu_open(CC3000Emu_Params *params, tWlanCB wlanCB,
+                           tFWPatches fwPatches, tDriverPatches driverPatches,
+                           tBootLoaderPatches bootLoaderPatches);
+
+/*!
+ *  @brief  Initialize params to the defaults
+ *
+ *  Defaults: 6 buffers of 1468 bytes, like the CC3000, and 127.0.0.1.
+ *
+ *  @param  params  Parameter structure to initialize
+ */
+extern Void CC3000Emu_Params_init(CC3000Emu_Params *params);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ti_drivers_wifi_cc3000_emulator_CC3000Emu__include */
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2013, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ======== CC3000EmuBench.c ========
+ *  Throughput and latency benchmarks of the CC3000 host driver, run against
+ *  the emulator. See Makefile.
+ *
+ *  Every benchmark moves a fixed amount of data, so runs can be compared
+ *  against each other. An optional argument scales the amounts, e.g. 0.1
+ *  for a quick run. The emulator answers instantly, so the results measure
+ *  the host driver: HCI framing, flow control and the multi-threaded
+ *  wrappers.
+ */
+
+/* clock_gettime() */
+#define _POSIX_C_SOURCE             200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xdc/std.h>
+
+/* CC3000 Host Driver header files */
+#include <cc3000_host_driver/include/socket.h>
+#include <cc3000_host_driver/include/wlan.h>
+#include <osal/inc/osal.h>
+
+#include <emulator/CC3000Emu.h>
+
+#define TCP_PORT            5101
+#define UDP_PORT_A          6101
+#define UDP_PORT_B          6102
+
+/* Data sent before the receiver drains it, below the emulator's socket buffer */
+#define BATCH_SIZE          8192
+
+/* Default amounts, scaled by the command line argument */
+#define BULK_BYTES          (4 * 1024 * 1024)
+#define SMALL_BYTES         (512 * 1024)
+#define ROUND_TRIPS         5000
+
+/* Function prototypes */
+static Void CC3000EmuBench_fillAddr(sockaddr *addr, UShort port);
+static Void CC3000EmuBench_latency(UInt roundTrips);
+static double CC3000EmuBench_now(Void);
+static Void CC3000EmuBench_throughput(const Char *name, UInt total,
+                                      UInt sendSize, unsigned long coalesce);
+static Void CC3000EmuBench_wlanCB(long eventType, char *data,
+                                  unsigned char length);
+
+/*
+ *  ======== CC3000EmuBench_fillAddr ========
+ */
+static Void CC3000EmuBench_fillAddr(sockaddr *addr, UShort port)
+{
+    memset(addr, 0, sizeof(sockaddr));
+    addr->sa_family = AF_INET;
+    addr->sa_data[0] = port >> 8;
+    addr->sa_data[1] = port & 0xFF;
+    addr->sa_data[2] = 127;
+    addr->sa_data[5] = 1;
+}
+
+/*
+ *  ======== CC3000EmuBench_latency ========
+ *  UDP ping-pong between two sockets: sendto() and recvfrom() each way.
+ */
+static Void CC3000EmuBench_latency(UInt roundTrips)
+{
+    long            a;
+    long            b;
+    UInt            i;
+    double          start;
+    double          t;
+    double          best = 1e9;
+    double          total = 0;
+    UChar           buf[32];
+    sockaddr        addrA;
+    sockaddr        addrB;
+    sockaddr        from;
+    socklen_t       fromLen = sizeof(sockaddr);
+
+    a = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    b = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    CC3000EmuBench_fillAddr(&addrA, UDP_PORT_A);
+    CC3000EmuBench_fillAddr(&addrB, UDP_PORT_B);
+    bind(a, &addrA, sizeof(sockaddr));
+    bind(b, &addrB, sizeof(sockaddr));
+    memset(buf, 0x5A, sizeof(buf));
+
+    for (i = 0; i < roundTrips; i++) {
+        start = CC3000EmuBench_now();
+        sendto(a, buf, sizeof(buf), 0, &addrB, sizeof(sockaddr));
+        recvfrom(b, buf, sizeof(buf), 0, &from, &fromLen);
+        sendto(b, buf, sizeof(buf), 0, &addrA, sizeof(sockaddr));
+        recvfrom(a, buf, sizeof(buf), 0, &from, &fromLen);
+        t = CC3000EmuBench_now() - start;
+
+        total += t;
+        if (t < best) {
+            best = t;
+        }
+    }
+
+    printf("udp round trip (%u x 32 bytes): mean %.1f us, min %.1f us\n",
+           roundTrips, total * 1e6 / roundTrips, best * 1e6);
+
+    closesocket(b);
+    closesocket(a);
+}
+
+/*
+ *  ======== CC3000EmuBench_now ========
+ *  Seconds on the monotonic clock.
+ */
+static double CC3000EmuBench_now(Void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+/*
+ *  ======== CC3000EmuBench_throughput ========
+ *  Send total bytes over a loopback TCP connection in sendSize writes, in
+ *  batches that the receiving end drains with recv().
+ */
+static Void CC3000EmuBench_throughput(const Char *name, UInt total,
+                                      UInt sendSize, unsigned long coalesce)
+{
+    long            server;
+    long            client;
+    long            child;
+    UInt            sent;
+    UInt            batch;
+    Int             ret;
+    double          start;
+    double          elapsed;
+    static UChar    buf[BATCH_SIZE];
+    sockaddr        addr;
+    socklen_t       addrLen = sizeof(sockaddr);
+    CC3000Emu_Stats before;
+    CC3000Emu_Stats after;
+
+    server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    CC3000EmuBench_fillAddr(&addr, TCP_PORT);
+    bind(server, &addr, sizeof(sockaddr));
+    listen(server, 1);
+    connect(client, &addr, sizeof(sockaddr));
+    child = accept(server, &addr, &addrLen);
+    if (coalesce) {
+        setsockopt(client, SOL_SOCKET, SOCKOPT_SEND_COALESCE, &coalesce,
+                   sizeof(coalesce));
+    }
+
+    CC3000Emu_getStats(&before);
+    start = CC3000EmuBench_now();
+
+    for (sent = 0; sent < total; sent += BATCH_SIZE) {
+        for (batch = 0; batch < BATCH_SIZE; batch += sendSize) {
+            send(client, buf + batch, sendSize, 0);
+        }
+        for (batch = 0; batch < BATCH_SIZE; batch += ret) {
+            ret = recv(child, buf + batch, BATCH_SIZE - batch, 0);
+            if (ret <= 0) {
+                printf("%s: recv() failed\n", name);
+                total = sent;
+                break;
+            }
+        }
+    }
+
+    elapsed = CC3000EmuBench_now() - start;
+    CC3000Emu_getStats(&after);
+
+    printf("%s (%u bytes in %u byte sends): %.2f MB/s, %u data packets\n",
+           name, total, sendSize, total / elapsed / 1e6,
+           after.dataPackets - before.dataPackets);
+
+    closesocket(child);
+    closesocket(client);
+    closesocket(server);
+}
+
+/*
+ *  ======== CC3000EmuBench_wlanCB ========
+ */
+static Void CC3000EmuBench_wlanCB(long eventType, char *data,
+                                  unsigned char length)
+{
+}
+
+/*
+ *  ======== main ========
+ */
+int main(int argc, char *argv[])
+{
+    double          scale = 1.0;
+
+    if (argc > 1) {
+        scale = atof(argv[1]);
+    }
+
+    if (!CC3000Emu_open(NULL, CC3000EmuBench_wlanCB, NULL, NULL, NULL)) {
+        printf("CC3000Emu_open() failed\n");
+        return (1);
+    }
+    wlan_connect(WLAN_SEC_UNSEC, "CC3000Emu", 9, NULL, NULL, 0);
+
+    CC3000EmuBench_throughput("tcp bulk", (UInt)(BULK_BYTES * scale) /
+                              BATCH_SIZE * BATCH_SIZE, 1024, 0);
+    CC3000EmuBench_throughput("tcp small", (UInt)(SMALL_BYTES * scale) /
+                              BATCH_SIZE * BATCH_SIZE, 64, 0);
+    CC3000EmuBench_throughput("tcp small coalesced", (UInt)(SMALL_BYTES *
+                              scale) / BATCH_SIZE * BATCH_SIZE, 64, 10);
+    CC3000EmuBench_latency((UInt)(ROUND_TRIPS * scale));
+
+    CC3000Emu_close();
+
+    return (0);
+}
@@ -0,0 +1,727 @@
+/*
+ * Copyright (c) 2013, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ======== CC3000EmuTest.c ========
+ *  Regression tests of the CC3000 host driver, run against the emulator.
+ *  See Makefile. Exits with the number of failed checks.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <xdc/std.h>
+
+/* CC3000 Host Driver header files */
+#include <cc3000_host_driver/include/netapp.h>
+#include <cc3000_host_driver/include/nvmem.h>
+#include <cc3000_host_driver/include/socket.h>
+#include <cc3000_host_driver/include/wlan.h>
+#include <osal/inc/osal.h>
+
+#include <emulator/CC3000Emu.h>
+
+#define CHECK(cond)     CC3000EmuTest_check((cond), #cond, __LINE__)
+
+/* Ports of the loopback sockets */
+#define TCP_PORT        5001
+#define UDP_PORT_A      6001
+#define UDP_PORT_B      6002
+
+/* Bytes moved by the TCP test, several CC3000 buffers' worth */
+#define TCP_LENGTH      6000
+#define TCP_CHUNK       1000
+
+#define DRIVER_PATCH_LENGTH 2500
+
+/* Too big to coalesce, SEND_COALESCE_SIZE is 512 */
+#define BIG_LENGTH      600
+
+/* Streamed patch, several NVMEM write portions long */
+#define PATCH_LENGTH    3000
+#define PATCH_CHUNK     100
+
+/* Patch source of nvmem_write_patch_stream() */
+typedef struct CC3000EmuTest_Patch {
+    UChar           data[PATCH_LENGTH];
+    long            failAt;         /* read() fails from here on, -1 never */
+    long            rejectAt;       /* verify() rejects the portion with it */
+    Bool            rejectFinal;    /* verify() rejects the whole patch */
+    Bool            final;          /* verify() saw the whole patch */
+    UInt            reads;
+    unsigned long   verified;       /* Bytes verify() has seen */
+    unsigned long   written;        /* Last progress() report */
+    unsigned long   total;
+} CC3000EmuTest_Patch;
+
+static Int failures;
+static volatile Bool dhcpDone;
+static char driverPatch[DRIVER_PATCH_LENGTH];
+
+/* Threads of CC3000EmuTest_testCoalesceShort() */
+static UChar bigOut[BIG_LENGTH];
+static volatile Int bigSent;
+static volatile Bool statusDone;
+
+/* Function prototypes */
+static Void CC3000EmuTest_bigSend(Void *arg);
+static Void CC3000EmuTest_check(Bool ok, const Char *what, Int line);
+static char *CC3000EmuTest_driverPatches(unsigned long *length);
+static Void CC3000EmuTest_fillAddr(sockaddr *addr, UShort port);
+static long CC3000EmuTest_patchRead(void *arg, unsigned long offset,
+                                    unsigned char *buff, unsigned long length);
+static Void CC3000EmuTest_patchProgress(void *arg, unsigned long written,
+                                        unsigned long total);
+static Int  CC3000EmuTest_patchStream(CC3000EmuTest_Patch *patch);
+static long CC3000EmuTest_patchVerify(void *arg, unsigned long offset,
+                                      const unsigned char *buff,
+                                      unsigned long length);
+static UShort CC3000EmuTest_port(sockaddr *addr);
+static Int CC3000EmuTest_recvAll(long sd, UChar *buf, Int length);
+static Void CC3000EmuTest_statusGet(Void *arg);
+static Void CC3000EmuTest_testCoalesce(Void);
+static Void CC3000EmuTest_testCoalesceShort(Void);
+static Void CC3000EmuTest_testConnect(Void);
+static Void CC3000EmuTest_testHostByName(Void);
+static Void CC3000EmuTest_testNvmem(Void);
+static Void CC3000EmuTest_testSelect(Void);
+static Void CC3000EmuTest_testTcp(Void);
+static Void CC3000EmuTest_testUdp(Void);
+static Void CC3000EmuTest_wlanCB(long eventType, char *data,
+                                 unsigned char length);
+
+/*
+ *  ======== CC3000EmuTest_bigSend ========
+ */
+static Void CC3000EmuTest_bigSend(Void *arg)
+{
+    bigSent = send(*(long *)arg, bigOut, sizeof(bigOut), 0);
+}
+
+/*
+ *  ======== CC3000EmuTest_check ========
+ */
+static Void CC3000EmuTest_check(Bool ok, const Char *what, Int line)
+{
+    if (!ok) {
+        printf("FAIL line %d: %s\n", line, what);
+        failures++;
+    }
+}
+
+/*
+ *  ======== CC3000EmuTest_driverPatches ========
+ */
+static char *CC3000EmuTest_driverPatches(unsigned long *length)
+{
+    *length = sizeof(driverPatch);
+    return (driverPatch);
+}
+
+/*
+ *  ======== CC3000EmuTest_fillAddr ========
+ *  AF_INET address of 127.0.0.1 and port; the emulator only looks at the
+ *  port.
+ */
+static Void CC3000EmuTest_fillAddr(sockaddr *addr, UShort port)
+{
+    memset(addr, 0, sizeof(sockaddr));
+    addr->sa_family = AF_INET;
+    addr->sa_data[0] = port >> 8;
+    addr->sa_data[1] = port & 0xFF;
+    addr->sa_data[2] = 127;
+    addr->sa_data[5] = 1;
+}
+
+/*
+ *  ======== CC3000EmuTest_patchProgress ========
+ */
+static Void CC3000EmuTest_patchProgress(void *arg, unsigned long written,
+                                        unsigned long total)
+{
+    CC3000EmuTest_Patch *patch = arg;
+
+    patch->written = written;
+    patch->total = total;
+}
+
+/*
+ *  ======== CC3000EmuTest_patchRead ========
+ *  Short reads of at most PATCH_CHUNK bytes.
+ */
+static long CC3000EmuTest_patchRead(void *arg, unsigned long offset,
+                                    unsigned char *buff, unsigned long length)
+{
+    CC3000EmuTest_Patch *patch = arg;
+
+    patch->reads++;
+    if ((patch->failAt >= 0) && (offset >= patch->failAt)) {
+        return (-1);
+    }
+    if (length > PATCH_CHUNK) {
+        length = PATCH_CHUNK;
+    }
+    memcpy(buff, patch->data + offset, length);
+
+    return (length);
+}
+
+/*
+ *  ======== CC3000EmuTest_patchStream ========
+ *  Writes the patch to NVMEM_WLAN_DRIVER_SP_FILEID.
+ */
+static Int CC3000EmuTest_patchStream(CC3000EmuTest_Patch *patch)
+{
+    tNvmemPatchStream stream;
+
+    patch->final = FALSE;
+    patch->reads = 0;
+    patch->verified = 0;
+    patch->written = 0;
+    patch->total = 0;
+
+    stream.read = CC3000EmuTest_patchRead;
+    stream.verify = CC3000EmuTest_patchVerify;
+    stream.progress = CC3000EmuTest_patchProgress;
+    stream.arg = patch;
+
+    return (nvmem_write_patch_stream(NVMEM_WLAN_DRIVER_SP_FILEID,
+                                     PATCH_LENGTH, &stream));
+}
+
+/*
+ *  ======== CC3000EmuTest_patchVerify ========
+ */
+static long CC3000EmuTest_patchVerify(void *arg, unsigned long offset,
+                                      const unsigned char *buff,
+                                      unsigned long length)
+{
+    CC3000EmuTest_Patch *patch = arg;
+
+    if (buff == NULL) {
+        patch->final = TRUE;
+        return (patch->rejectFinal ? -1 : 0);
+    }
+
+    CHECK(offset == patch->verified);
+    CHECK(memcmp(buff, patch->data + offset, length) == 0);
+    patch->verified += length;
+
+    if ((patch->rejectAt >= 0) && (offset <= patch->rejectAt) &&
+        (patch->rejectAt < offset + length)) {
+        return (-1);
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== CC3000EmuTest_port ========
+ */
+static UShort CC3000EmuTest_port(sockaddr *addr)
+{
+    return ((addr->sa_data[0] << 8) | addr->sa_data[1]);
+}
+
+/*
+ *  ======== CC3000EmuTest_recvAll ========
+ *  Receive length bytes, returns the number received before an error.
+ */
+static Int CC3000EmuTest_recvAll(long sd, UChar *buf, Int length)
+{
+    Int received = 0;
+    Int ret;
+
+    while (received < length) {
+        ret = recv(sd, buf + received, length - received, 0);
+        if (ret <= 0) {
+            break;
+        }
+        received += ret;
+    }
+
+    return (received);
+}
+
+/*
+ *  ======== CC3000EmuTest_statusGet ========
+ */
+static Void CC3000EmuTest_statusGet(Void *arg)
+{
+    wlan_ioctl_statusget();
+    statusDone = TRUE;
+}
+
+/*
+ *  ======== CC3000EmuTest_testCoalesce ========
+ *  Small send()s on a SOCKOPT_SEND_COALESCE socket leave in one data packet,
+ *  either on send_flush() or when the coalescing delay expires.
+ */
+static Void CC3000EmuTest_testCoalesce(Void)
+{
+    long            server;
+    long            client;
+    long            child;
+    Int             i;
+    UInt32          start;
+    unsigned long   delay = 50;
+    UChar           out[100];
+    UChar           in[100];
+    sockaddr        addr;
+    socklen_t       addrLen = sizeof(sockaddr);
+    CC3000Emu_Stats before;
+    CC3000Emu_Stats after;
+
+    server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    CC3000EmuTest_fillAddr(&addr, TCP_PORT + 1);
+    CHECK(bind(server, &addr, sizeof(sockaddr)) == 0);
+    CHECK(listen(server, 1) == 0);
+    CHECK(connect(client, &addr, sizeof(sockaddr)) == 0);
+    child = accept(server, &addr, &addrLen);
+    CHECK(child >= 0);
+
+    CHECK(setsockopt(client, SOL_SOCKET, SOCKOPT_SEND_COALESCE, &delay,
+                     sizeof(delay)) == 0);
+
+    for (i = 0; i < sizeof(out); i++) {
+        out[i] = i;
+    }
+
+    /* Sent by send_flush() */
+    CC3000Emu_getStats(&before);
+    for (i = 0; i < 10; i++) {
+        CHECK(send(client, out + i * 10, 10, 0) == 10);
+    }
+    CHECK(send_flush(client) == sizeof(out));
+    CHECK(CC3000EmuTest_recvAll(child, in, sizeof(in)) == sizeof(in));
+    CHECK(memcmp(in, out, sizeof(in)) == 0);
+    CC3000Emu_getStats(&after);
+    CHECK(after.dataPackets - before.dataPackets == 1);
+
+    /* Sent by the select thread once the delay has expired */
+    CC3000Emu_getStats(&before);
+    start = OS_ticks_get();
+    for (i = 0; i < 5; i++) {
+        CHECK(send(client, out + i * 10, 10, 0) == 10);
+    }
+    CHECK(CC3000EmuTest_recvAll(child, in, 50) == 50);
+    CHECK(OS_ticks_get() - start < 10 * delay);
+    CHECK(memcmp(in, out, 50) == 0);
+    CC3000Emu_getStats(&after);
+    CHECK(after.dataPackets - before.dataPackets == 1);
+
+    delay = 0;
+    CHECK(setsockopt(client, SOL_SOCKET, SOCKOPT_SEND_COALESCE, &delay,
+                     sizeof(delay)) == 0);
+
+    CHECK(closesocket(child) == 0);
+    CHECK(closesocket(client) == 0);
+    CHECK(closesocket(server) == 0);
+}
+
+/*
+ *  ======== CC3000EmuTest_testCoalesceShort ========
+ *  A send() too big to coalesce, behind held data while the CC3000 is out of
+ *  buffers, waits for a buffer without holding up the other threads, and
+ *  its data follows the held data.
+ */
+static Void CC3000EmuTest_testCoalesceShort(Void)
+{
+    long            server;
+    long            client;
+    long            child;
+    Int             i;
+    unsigned long   delay = 10000;
+    UChar           in[10 + BIG_LENGTH];
+    sockaddr        addr;
+    socklen_t       addrLen = sizeof(sockaddr);
+    TaskHandle      sender = NULL;
+    TaskHandle      status = NULL;
+    s_thread_params threadParams;
+    tFlowControlInfo info;
+
+    server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    CC3000EmuTest_fillAddr(&addr, TCP_PORT + 2);
+    CHECK(bind(server, &addr, sizeof(sockaddr)) == 0);
+    CHECK(listen(server, 1) == 0);
+    CHECK(connect(client, &addr, sizeof(sockaddr)) == 0);
+    child = accept(server, &addr, &addrLen);
+    CHECK(child >= 0);
+
+    CHECK(setsockopt(client, SOL_SOCKET, SOCKOPT_SEND_COALESCE, &delay,
+                     sizeof(delay)) == 0);
+
+    for (i = 0; i < sizeof(bigOut); i++) {
+        bigOut[i] = i;
+    }
+    CHECK(send(client, bigOut, 10, 0) == 10);
+
+    /* Use up all but one buffer, sending the other way */
+    get_flow_control_info(&info);
+    for (i = 0; (i < 1000) && (info.usFreeBuffers < 6); i++) {
+        OS_thread_sleep(1);
+        get_flow_control_info(&info);
+    }
+    CHECK(info.usFreeBuffers == 6);
+    CC3000Emu_holdBuffers(TRUE);
+    for (i = 0; i < 5; i++) {
+        CHECK(send(child, bigOut, 10, 0) == 10);
+    }
+
+    /* The held data takes the last buffer, the big send() has to wait */
+    bigSent = 0;
+    statusDone = FALSE;
+    memset(&threadParams, 0, sizeof(threadParams));
+    threadParams.p_entry_function = CC3000EmuTest_bigSend;
+    threadParams.p_func_params = &client;
+    CHECK(OS_thread_create(&sender, &threadParams) == e_SUCCESS);
+    OS_thread_sleep(20);
+
+    /* Other commands go on meanwhile */
+    threadParams.p_entry_function = CC3000EmuTest_statusGet;
+    threadParams.p_func_params = NULL;
+    CHECK(OS_thread_create(&status, &threadParams) == e_SUCCESS);
+    for (i = 0; (i < 200) && !statusDone; i++) {
+        OS_thread_sleep(1);
+    }
+    CHECK(statusDone);
+    CHECK(bigSent == 0);
+
+    CC3000Emu_holdBuffers(FALSE);
+    OS_thread_delete(&sender);
+    OS_thread_delete(&status);
+    CHECK(bigSent == BIG_LENGTH);
+
+    CHECK(CC3000EmuTest_recvAll(child, in, sizeof(in)) == sizeof(in));
+    CHECK(memcmp(in, bigOut, 10) == 0);
+    CHECK(memcmp(in + 10, bigOut, BIG_LENGTH) == 0);
+    CHECK(CC3000EmuTest_recvAll(client, in, 50) == 50);
+
+    delay = 0;
+    CHECK(setsockopt(client, SOL_SOCKET, SOCKOPT_SEND_COALESCE, &delay,
+                     sizeof(delay)) == 0);
+
+    CHECK(closesocket(child) == 0);
+    CHECK(closesocket(client) == 0);
+    CHECK(closesocket(server) == 0);
+}
+
+/*
+ *  ======== CC3000EmuTest_testConnect ========
+ *  The patches offered by the host reach the device, and connecting gets an
+ *  address by DHCP.
+ */
+static Void CC3000EmuTest_testConnect(Void)
+{
+    Int             i;
+    CC3000Emu_Stats stats;
+
+    CC3000Emu_getStats(&stats);
+    CHECK(stats.patchBytes[0] == DRIVER_PATCH_LENGTH);
+    CHECK(stats.patchBytes[1] == 0);
+    CHECK(stats.patchBytes[2] == 0);
+
+    CHECK(wlan_connect(WLAN_SEC_UNSEC, "CC3000Emu", 9, NULL, NULL, 0) == 0);
+    for (i = 0; (i < 1000) && !dhcpDone; i++) {
+        OS_thread_sleep(1);
+    }
+    CHECK(dhcpDone);
+
+    /* 3 is "connected" */
+    CHECK(wlan_ioctl_statusget() == 3);
+}
+
+/*
+ *  ======== CC3000EmuTest_testHostByName ========
+ *  Names resolve through the emulator once and are cached after that.
+ */
+static Void CC3000EmuTest_testHostByName(Void)
+{
+    unsigned long   ipAddr = 0;
+    CC3000Emu_Stats before;
+    CC3000Emu_Stats after;
+
+    CHECK(gethostbyname("emu.example", 11, &ipAddr) > 0);
+    CHECK(ipAddr == 0x0A000002);
+
+    CC3000Emu_getStats(&before);
+    ipAddr = 0;
+    CHECK(gethostbyname("emu.example", 11, &ipAddr) > 0);
+    CHECK(ipAddr == 0x0A000002);
+    CC3000Emu_getStats(&after);
+    CHECK(after.commands == before.commands);
+
+    ipAddr = 1;
+    CHECK(gethostbyname("unknown.example", 15, &ipAddr) < 0);
+    CHECK(ipAddr == 0);
+}
+
+/*
+ *  ======== CC3000EmuTest_testNvmem ========
+ *  nvmem_write()/nvmem_read(), and nvmem_write_patch_stream() with short
+ *  reads, a read error and rejections by the verify callback.
+ */
+static Void CC3000EmuTest_testNvmem(Void)
+{
+    Int             i;
+    UChar           out[64];
+    UChar           in[64];
+    UChar           readBack[500];
+    static CC3000EmuTest_Patch patch;
+
+    for (i = 0; i < sizeof(out); i++) {
+        out[i] = 0xA5 ^ i;
+    }
+    memset(in, 0, sizeof(in));
+
+    CHECK(nvmem_write(NVMEM_SHARED_MEM_FILEID, sizeof(out), 16, out) == 0);
+    CHECK(nvmem_read(NVMEM_SHARED_MEM_FILEID, sizeof(in), 16, in) == 0);
+    CHECK(memcmp(in, out, sizeof(in)) == 0);
+
+    for (i = 0; i < PATCH_LENGTH; i++) {
+        patch.data[i] = i ^ (i >> 8);
+    }
+    patch.failAt = -1;
+    patch.rejectAt = -1;
+    patch.rejectFinal = FALSE;
+
+    /* Streamed in several portions from short reads */
+    CHECK(CC3000EmuTest_patchStream(&patch) == 0);
+    CHECK(patch.reads >= PATCH_LENGTH / PATCH_CHUNK);
+    CHECK(patch.verified == PATCH_LENGTH);
+    CHECK(patch.final);
+    CHECK(patch.written == PATCH_LENGTH);
+    CHECK(patch.total == PATCH_LENGTH);
+    for (i = 0; i < PATCH_LENGTH; i += sizeof(readBack)) {
+        CHECK(nvmem_read(NVMEM_WLAN_DRIVER_SP_FILEID, sizeof(readBack), i,
+                         readBack) == 0);
+        CHECK(memcmp(readBack, patch.data + i, sizeof(readBack)) == 0);
+    }
+
+    /* A read error stops the write */
+    patch.failAt = PATCH_LENGTH / 2;
+    CHECK(CC3000EmuTest_patchStream(&patch) != 0);
+    CHECK(patch.verified <= PATCH_LENGTH / 2);
+    CHECK(patch.written <= PATCH_LENGTH / 2);
+    CHECK(!patch.final);
+    patch.failAt = -1;
+
+    /* So does the verify callback rejecting a portion */
+    patch.rejectAt = PATCH_LENGTH / 2;
+    CHECK(CC3000EmuTest_patchStream(&patch) != 0);
+    CHECK(patch.verified > PATCH_LENGTH / 2);
+    CHECK(patch.written <= PATCH_LENGTH / 2);
+    CHECK(!patch.final);
+    patch.rejectAt = -1;
+
+    /* Or rejecting the whole patch once it is written */
+    patch.rejectFinal = TRUE;
+    CHECK(CC3000EmuTest_patchStream(&patch) != 0);
+    CHECK(patch.verified == PATCH_LENGTH);
+    CHECK(patch.written == PATCH_LENGTH);
+    CHECK(patch.final);
+    patch.rejectFinal = FALSE;
+}
+
+/*
+ *  ======== CC3000EmuTest_testSelect ========
+ *  select() times out on an idle socket and reports a readable one.
+ */
+static Void CC3000EmuTest_testSelect(Void)
+{
+    long            a;
+    long            b;
+    UInt32          start;
+    UInt32          elapsed;
+    fd_set          readFds;
+    struct timeval  timeout;
+    sockaddr        addr;
+
+    a = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    b = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    CC3000EmuTest_fillAddr(&addr, UDP_PORT_A + 10);
+    CHECK(bind(a, &addr, sizeof(sockaddr)) == 0);
+
+    FD_ZERO(&readFds);
+    FD_SET(a, &readFds);
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 100000;
+    start = OS_ticks_get();
+    CHECK(select(a + 1, &readFds, NULL, NULL, &timeout) == 0);
+    elapsed = OS_ticks_get() - start;
+    CHECK(elapsed >= 100000 / OS_TICK_PERIOD_US - 1);
+    CHECK(elapsed < 1000000 / OS_TICK_PERIOD_US);
+
+    CHECK(sendto(b, "x", 1, 0, &addr, sizeof(sockaddr)) == 1);
+
+    FD_ZERO(&readFds);
+    FD_SET(a, &readFds);
+    timeout.tv_sec = 1;
+    timeout.tv_usec = 0;
+    CHECK(select(a + 1, &readFds, NULL, NULL, &timeout) == 1);
+    CHECK(FD_ISSET(a, &readFds));
+
+    CHECK(closesocket(b) == 0);
+    CHECK(closesocket(a) == 0);
+}
+
+/*
+ *  ======== CC3000EmuTest_testTcp ========
+ *  A loopback TCP connection moves data in both directions, and the sends
+ *  get their buffers back through flow control.
+ */
+static Void CC3000EmuTest_testTcp(Void)
+{
+    long            server;
+    long            client;
+    long            child;
+    Int             i;
+    static UChar    out[TCP_LENGTH];
+    static UChar    in[TCP_LENGTH];
+    sockaddr        addr;
+    socklen_t       addrLen = sizeof(sockaddr);
+    CC3000Emu_Stats before;
+    CC3000Emu_Stats after;
+
+    server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    CHECK(server >= 0);
+    CC3000EmuTest_fillAddr(&addr, TCP_PORT);
+    CHECK(bind(server, &addr, sizeof(sockaddr)) == 0);
+    CHECK(listen(server, 1) == 0);
+
+    client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    CHECK(client >= 0);
+    CHECK(connect(client, &addr, sizeof(sockaddr)) == 0);
+
+    child = accept(server, &addr, &addrLen);
+    CHECK(child >= 0);
+
+    for (i = 0; i < TCP_LENGTH; i++) {
+        out[i] = i * 7;
+    }
+
+    CC3000Emu_getStats(&before);
+    for (i = 0; i < TCP_LENGTH; i += TCP_CHUNK) {
+        CHECK(send(client, out + i, TCP_CHUNK, 0) == TCP_CHUNK);
+    }
+    CHECK(CC3000EmuTest_recvAll(child, in, TCP_LENGTH) == TCP_LENGTH);
+    CHECK(memcmp(in, out, TCP_LENGTH) == 0);
+    CC3000Emu_getStats(&after);
+    CHECK(after.bytesToDevice - before.bytesToDevice == TCP_LENGTH);
+    CHECK(after.dataPackets - before.dataPackets == TCP_LENGTH / TCP_CHUNK);
+    CHECK(after.freedBuffers > before.freedBuffers);
+    CHECK(after.overflows == 0);
+
+    CHECK(send(child, "pong", 4, 0) == 4);
+    CHECK(CC3000EmuTest_recvAll(client, in, 4) == 4);
+    CHECK(memcmp(in, "pong", 4) == 0);
+
+    CHECK(closesocket(child) == 0);
+    CHECK(closesocket(client) == 0);
+    CHECK(closesocket(server) == 0);
+}
+
+/*
+ *  ======== CC3000EmuTest_testUdp ========
+ *  Datagrams keep their boundaries and report their source port.
+ */
+static Void CC3000EmuTest_testUdp(Void)
+{
+    long            a;
+    long            b;
+    UChar           in[32];
+    sockaddr        addrA;
+    sockaddr        addrB;
+    sockaddr        from;
+    socklen_t       fromLen = sizeof(sockaddr);
+
+    a = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    b = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    CHECK((a >= 0) && (b >= 0));
+    CC3000EmuTest_fillAddr(&addrA, UDP_PORT_A);
+    CC3000EmuTest_fillAddr(&addrB, UDP_PORT_B);
+    CHECK(bind(a, &addrA, sizeof(sockaddr)) == 0);
+    CHECK(bind(b, &addrB, sizeof(sockaddr)) == 0);
+
+    CHECK(sendto(b, "hello", 5, 0, &addrA, sizeof(sockaddr)) == 5);
+    CHECK(sendto(b, "world!", 6, 0, &addrA, sizeof(sockaddr)) == 6);
+
+    CHECK(recvfrom(a, in, sizeof(in), 0, &from, &fromLen) == 5);
+    CHECK(memcmp(in, "hello", 5) == 0);
+    CHECK(CC3000EmuTest_port(&from) == UDP_PORT_B);
+    CHECK(recvfrom(a, in, sizeof(in), 0, &from, &fromLen) == 6);
+    CHECK(memcmp(in, "world!", 6) == 0);
+
+    CHECK(closesocket(b) == 0);
+    CHECK(closesocket(a) == 0);
+}
+
+/*
+ *  ======== CC3000EmuTest_wlanCB ========
+ */
+static Void CC3000EmuTest_wlanCB(long eventType, char *data,
+                                 unsigned char length)
+{
+    if (eventType == HCI_EVNT_WLAN_UNSOL_DHCP) {
+        dhcpDone = TRUE;
+    }
+}
+
+/*
+ *  ======== main ========
+ */
+int main(int argc, char *argv[])
+{
+    CHECK(CC3000Emu_addHost("emu.example", 0x0A000002));
+    if (!CC3000Emu_open(NULL, CC3000EmuTest_wlanCB, NULL,
+                        CC3000EmuTest_driverPatches, NULL)) {
+        printf("FAIL: CC3000Emu_open()\n");
+        return (1);
+    }
+
+    CC3000EmuTest_testConnect();
+    CC3000EmuTest_testTcp();
+    CC3000EmuTest_testUdp();
+    CC3000EmuTest_testSelect();
+    CC3000EmuTest_testHostByName();
+    CC3000EmuTest_testNvmem();
+    CC3000EmuTest_testCoalesce();
+    CC3000EmuTest_testCoalesceShort();
+
+    CC3000Emu_close();
+
+    printf("%s: %d failure(s)\n", failures ? "FAILED" : "PASSED", failures);
+
+    return (failures);
+}
@@ -46,7 +46,15 @@ extern "C" {
 #endif
 
 //#ifdef MULTI_THREAD_SUPPORT
+/*
+ * CC3000_OSAL_POSIX selects the pthread implementation in osal/posix, used
+ * to run the host driver on a Linux host against the CC3000 emulator.
+ */
+#if defined(CC3000_OSAL_POSIX)
+#include <osal/posix/inc/os.h>
+#else
 #include <osal/sys_bios/inc/os.h>
+#endif
 
 //*****************************************************************************
 //
@@ -103,6 +111,7 @@ typedef struct _wlan_socket_t
     int sd;
     long status;
     SemaphoreHandle sd_semaphore;
+    int waiting;    /* a task is pending on sd_semaphore */
 }wlan_socket_t;
 /* TBD - Move to a different place */
 
@@ -363,6 +372,21 @@ e_ret_status OS_thread_delete(handle p_handle);
  */
 e_ret_status OS_thread_sleep(uInt16 ticks);
 
+/**
+ * \brief get the current time in timer ticks
+ *
+ * Returns the number of timer ticks elapsed since the system started.
+ * The count wraps around, so only differences between two calls are meaningful.
+ *
+ * \return   current tick count
+ *
+ * \sa OS_thread_sleep, OS_semaphore_pend
+ * \note
+ *
+ * \warning
+ */
+uInt32 OS_ticks_get(void);
+
 /**
  * \brief start the system with a specific entry function
  *
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2013, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* NOTE: Responsibility of memory alloc/dealloc is in OSAL users' domain
+   This file intends to hide OS specific structures from OSAL users */
+
+/*
+ * POSIX threads flavour of the OSAL, selected by defining CC3000_OSAL_POSIX.
+ * The handles are opaque so that the CC3000 headers, which declare their own
+ * time_t, clock_t and fd_set, never meet the host's <pthread.h>.
+ */
+
+#ifndef __OS_POSIX_H__
+#define __OS_POSIX_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /*__cplusplus*/
+
+/* Length of one OSAL timer tick, matches the default SYS/BIOS Clock period */
+#ifndef OS_TICK_PERIOD_US
+#define OS_TICK_PERIOD_US       1000
+#endif
+
+typedef struct os_mutex        *MutexHandle;
+typedef struct os_semaphore    *SemaphoreHandle;
+typedef struct os_thread       *TaskHandle;
+
+typedef long                    MutexKey;
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif /* __OS_POSIX_H__ */
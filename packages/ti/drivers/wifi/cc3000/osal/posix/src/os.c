@@ -0,0 +1,591 @@
+/*
+ * Copyright (c) 2013, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//*****************************************************************************
+//
+//! \addtogroup os_api
+//! @{
+//
+//*****************************************************************************
+
+/*
+ * POSIX threads implementation of the OSAL, the host counterpart of
+ * osal/sys_bios/src/os.c. Built with CC3000_OSAL_POSIX defined so the CC3000
+ * host driver can run on a Linux host, e.g. against the emulator in
+ * ../../emulator. Thread priorities and stack sizes are left to the host
+ * scheduler.
+ */
+
+/* CLOCK_MONOTONIC, recursive mutexes and clock_nanosleep() are POSIX.1-2008 */
+#define _POSIX_C_SOURCE             200809L
+#define _XOPEN_SOURCE               700
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <osal/inc/osal.h>
+#include <osal/posix/inc/os.h>
+
+struct os_mutex {
+    pthread_mutex_t     mutex;
+};
+
+struct os_semaphore {
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    uInt32              count;
+    uInt16              mode;
+};
+
+struct os_thread {
+    pthread_t           thread;
+    entry_func          entry;
+    handle              arg;
+};
+
+/*
+ *  Compute the absolute CLOCK_MONOTONIC time ticks from now.
+ */
+static void os_deadline(struct timespec *ts, uInt32 ticks)
+{
+    unsigned long long nsecs;
+
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    nsecs = (unsigned long long)ticks * OS_TICK_PERIOD_US * 1000 + ts->tv_nsec;
+    ts->tv_sec += nsecs / 1000000000;
+    ts->tv_nsec = nsecs % 1000000000;
+}
+
+/*
+ *  Entry point of all OSAL threads. Runs the OSAL entry function.
+ */
+static void *os_thread_entry(void *arg)
+{
+    struct os_thread *thread = arg;
+
+    thread->entry(thread->arg);
+
+    return NULL;
+}
+
+/*
+ *  Cancellation cleanup handler. A thread cancelled by OS_thread_terminate
+ *  while pending on a semaphore must not keep the semaphore's lock.
+ */
+static void os_unlock(void *arg)
+{
+    pthread_mutex_unlock(arg);
+}
+
+/**
+ * \brief allocate memory
+ *
+ * Function allocates size bytes of uninitialized memory, and returns a pointer to the allocated memory.\n
+ * The allocated space is suitably aligned (after possible pointer coercion) for storage of any type of object.
+ *
+ * \param[in] size    number of memory bytes to allocate
+ *
+ * \return   On success return a pointer to the allocated space, on failure return null
+ * \sa OS_free
+ * \note
+ *
+ * \warning
+ */
+void *OS_malloc(uInt32 size)
+{
+    return malloc(size);
+}
+
+/**
+ * \brief free allocated memory
+ *
+ * Function causes the allocated memory referenced by ptr to
+ *  be made available for future allocations.\n If ptr is
+ * NULL, no action occurs.
+ *
+ *  \param[in] ptr   pointer to previously allocated memory
+ *
+ * \return   None
+ *
+ * \sa OS_malloc
+ * \note
+ *
+ * \warning
+ */
+void OS_free(void *ptr)
+{
+    free(ptr);
+}
+
+/**
+ * \brief creates a mutex for inter-thread mutual exclusion for resource protection
+ *
+ * The mutex is recursive, like a SYS/BIOS GateMutex.
+ *
+ *  \param[in] p_handle     Handle to a mutex control block
+ *  \param[in] p_name       Name of mutex - UNUSED
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_mutex_delete, OS_mutex_lock, OS_mutex_unlock
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_mutex_create(handle p_handle, const void *const p_name)
+{
+    pthread_mutexattr_t attr;
+    struct os_mutex *mtx;
+
+    mtx = malloc(sizeof(struct os_mutex));
+    if (NULL == mtx) {
+        return e_FAILURE;
+    }
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    if (0 != pthread_mutex_init(&mtx->mutex, &attr)) {
+        pthread_mutexattr_destroy(&attr);
+        free(mtx);
+        return e_FAILURE;
+    }
+    pthread_mutexattr_destroy(&attr);
+
+    *(MutexHandle *)p_handle = mtx;
+    return e_SUCCESS;
+}
+
+/**
+ * \brief delete mutex object
+ *
+ * Deletes the specified mutex.
+ *
+ * \param[in] p_handle      Pointer to the handle of a mutex control block
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_mutex_create, OS_mutex_lock, OS_mutex_unlock
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_mutex_delete(handle p_handle)
+{
+    struct os_mutex *mtx = *(MutexHandle *)p_handle;
+
+    if (NULL == mtx) {
+        return e_FAILURE;
+    }
+
+    pthread_mutex_destroy(&mtx->mutex);
+    free(mtx);
+    *(MutexHandle *)p_handle = NULL;
+    return e_SUCCESS;
+}
+
+/**
+ * \brief try to obtain the exclusive ownership on the mutex
+ *
+ * Attempts to obtain exclusive ownership of the specified mutex.
+ * If the calling thread already owns the mutex, an internal counter is incremented
+ * and a successful status is returned.
+ *
+ * \param[in] p_handle      Handle to a mutex control block
+ * \param[out] p_key        Key for nested mutex - always set to -1
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_mutex_create, OS_mutex_delete, OS_mutex_unlock
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_mutex_lock(handle p_handle, handle p_key)
+{
+    struct os_mutex *mtx = p_handle;
+
+    if (0 != pthread_mutex_lock(&mtx->mutex)) {
+        return e_FAILURE;
+    }
+
+    *(sInt32 *)p_key = -1;
+    return e_SUCCESS;
+}
+
+/**
+ * \brief release the mutex
+ *
+ * decrements the ownership count of the specified mutex.
+ * If the ownership count is zero, the mutex is made available
+ *
+ * \param[in] p_handle   Handle to a mutex control block
+ * \param[in] key        Key for nested mutex - UNUSED
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_mutex_create, OS_mutex_lock, OS_mutex_delete
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_mutex_unlock(handle p_handle, sInt32 key)
+{
+    struct os_mutex *mtx = p_handle;
+
+    if (0 != pthread_mutex_unlock(&mtx->mutex)) {
+        return e_FAILURE;
+    }
+
+    return e_SUCCESS;
+}
+
+/**
+ * \brief create semaphore object
+ *
+ * Creates a counting or binary semaphore for inter-thread synchronization.
+ * The initial semaphore count is specified as an input parameter.
+ *
+ * \param[in] p_handle          Handle to semaphore control block
+ * \param[in] p_name            Name of the semaphore - UNUSED
+ * \param[in] mode              e_MODE_COUNTING or e_MODE_BINARY
+ * \param[in] count             Initial count of the semaphore
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_semaphore_delete, OS_semaphore_post, OS_semaphore_pend
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_semaphore_create(handle p_handle,
+                                 const void *const p_name,
+                                 uInt16 mode,
+                                 uInt16 count)
+{
+    pthread_condattr_t attr;
+    struct os_semaphore *sem;
+
+    sem = malloc(sizeof(struct os_semaphore));
+    if (NULL == sem) {
+        return e_FAILURE;
+    }
+
+    /* Timeouts are measured on the monotonic clock */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+    if ((0 != pthread_mutex_init(&sem->lock, NULL)) ||
+        (0 != pthread_cond_init(&sem->cond, &attr))) {
+        pthread_condattr_destroy(&attr);
+        free(sem);
+        return e_FAILURE;
+    }
+    pthread_condattr_destroy(&attr);
+
+    sem->mode = mode;
+    sem->count = ((mode == e_MODE_BINARY) && (count > 1)) ? 1 : count;
+
+    *(SemaphoreHandle *)p_handle = sem;
+    return e_SUCCESS;
+}
+
+/**
+ * \brief delete semaphore object
+ *
+ * Deletes the specified semaphore.
+ *
+ * \param[in] p_sem_handle      Pointer to the handle of a semaphore control block
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_semaphore_create, OS_semaphore_post, OS_semaphore_pend
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_semaphore_delete(handle p_sem_handle)
+{
+    struct os_semaphore *sem = *(SemaphoreHandle *)p_sem_handle;
+
+    if (NULL == sem) {
+        return e_FAILURE;
+    }
+
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+    *(SemaphoreHandle *)p_sem_handle = NULL;
+    return e_SUCCESS;
+}
+
+/**
+ * \brief decrease semaphore object counter
+ *
+ * retrieves an instance (a single count) from the specified semaphore.
+ * As a result, the specified semaphore's count is decreased by one
+ *
+ * \param[in] p_sem_handle      Handle to semaphore control block
+ * \param[in] timeout           Timeout in ticks - Can also take e_NO_WAIT or e_WAIT_FOREVER
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error or timeout
+ *
+ * \sa OS_semaphore_delete, OS_semaphore_post, OS_semaphore_create
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_semaphore_pend(handle p_sem_handle,
+                               uInt32 timeout)
+{
+    struct os_semaphore *sem = p_sem_handle;
+    struct timespec deadline;
+    e_ret_status ret_status = e_FAILURE;
+    int status = 0;
+
+    if ((timeout != e_NO_WAIT) && (timeout != e_WAIT_FOREVER)) {
+        os_deadline(&deadline, timeout);
+    }
+
+    pthread_mutex_lock(&sem->lock);
+    pthread_cleanup_push(os_unlock, &sem->lock);
+
+    while ((sem->count == 0) && (status == 0)) {
+        switch (timeout)
+        {
+            case e_NO_WAIT: status = ETIMEDOUT; break;
+            case e_WAIT_FOREVER: pthread_cond_wait(&sem->cond, &sem->lock); break;
+            default: status = pthread_cond_timedwait(&sem->cond, &sem->lock, &deadline); break;
+        }
+    }
+
+    /* A post racing with the timeout still counts */
+    if (sem->count) {
+        sem->count--;
+        ret_status = e_SUCCESS;
+    }
+
+    pthread_cleanup_pop(1);
+
+    return ret_status;
+}
+
+/**
+ * \brief increase semaphore object count
+ *
+ * puts an instance into the specified semaphore. A binary semaphore's
+ * count saturates at one.
+ *
+ * \param[in] p_sem_handle      Handle to semaphore control block
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_semaphore_delete, OS_semaphore_create, OS_semaphore_pend
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_semaphore_post(handle p_sem_handle)
+{
+    struct os_semaphore *sem = p_sem_handle;
+
+    pthread_mutex_lock(&sem->lock);
+    if (sem->mode == e_MODE_BINARY) {
+        sem->count = 1;
+    }
+    else {
+        sem->count++;
+    }
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+
+    return e_SUCCESS;
+}
+
+/**
+ * \brief create and run a new thread
+ *
+ * creates an application thread that starts execution at the specified task entry function.
+ * The thread starts running immediately. priority and stack_size are not used,
+ * the thread gets the host's default scheduling and stack.
+ *
+ *  \param[in] p_handle     Handle to a thread control block
+ *  \param[in] p_params     Thread params - Memory to be freed by caller
+ *                              p_entry_function = Task's entry function
+ *                              p_func_params = Argument of the entry function
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_thread_delete, OS_thread_terminate, OS_thread_sleep
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_thread_create(handle p_handle,
+                              s_thread_params *p_params)
+{
+    struct os_thread *thread;
+
+    thread = malloc(sizeof(struct os_thread));
+    if (NULL == thread) {
+        return e_FAILURE;
+    }
+
+    thread->entry = p_params->p_entry_function;
+    thread->arg = p_params->p_func_params;
+
+    if (0 != pthread_create(&thread->thread, NULL, os_thread_entry, thread)) {
+        free(thread);
+        return e_FAILURE;
+    }
+
+    *(TaskHandle *)p_handle = thread;
+    return e_SUCCESS;
+}
+
+/**
+ * \brief terminates a thread
+ *
+ * requests cancellation of the specified thread. The thread stops at its next
+ * cancellation point, e.g. while pending on a semaphore or sleeping.
+ *
+ * \param[in] p_handle     Handle to a thread control block
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_thread_create, OS_thread_delete, OS_thread_sleep
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_thread_terminate(handle p_handle)
+{
+    struct os_thread *thread = p_handle;
+
+    if ((NULL == thread) || (0 != pthread_cancel(thread->thread))) {
+        return e_FAILURE;
+    }
+
+    return e_SUCCESS;
+}
+
+/**
+ * \brief delete a thread
+ *
+ * waits for the specified thread to finish and releases it. The thread must
+ * have returned from its entry function or have been terminated.
+ *
+ * \param[in] p_handle     Pointer to the handle of a thread control block
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_thread_create, OS_thread_terminate, OS_thread_sleep
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_thread_delete(handle p_handle)
+{
+    struct os_thread *thread = *(TaskHandle *)p_handle;
+
+    if ((NULL == thread) || (0 != pthread_join(thread->thread, NULL))) {
+        return e_FAILURE;
+    }
+
+    free(thread);
+    *(TaskHandle *)p_handle = NULL;
+    return e_SUCCESS;
+}
+
+/**
+ * \brief suspend the thread for limited time
+ *
+ * causes the calling thread to suspend for the specified number of timer ticks.
+ * A tick lasts OS_TICK_PERIOD_US microseconds.
+ *
+ *  \param[in] ticks        The number of timer ticks to suspend the calling thread.
+ *                          If 0 is specified, the service returns immediately.
+ *
+ * \return   e_SUCCESS on success, e_FAILURE on error
+ *
+ * \sa OS_thread_create, OS_thread_delete, OS_thread_terminate
+ * \note
+ *
+ * \warning
+ */
+e_ret_status OS_thread_sleep(uInt16 ticks)
+{
+    struct timespec deadline;
+
+    if (ticks == 0) {
+        return e_SUCCESS;
+    }
+
+    os_deadline(&deadline, ticks);
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                                    &deadline, NULL)) {
+    }
+
+    return e_SUCCESS;
+}
+
+/**
+ * \brief get the current time in timer ticks
+ *
+ * Returns the number of timer ticks elapsed since the system started.
+ * The count wraps around, so only differences between two calls are meaningful.
+ *
+ * \return   current tick count
+ *
+ * \sa OS_thread_sleep, OS_semaphore_pend
+ * \note
+ *
+ * \warning
+ */
+uInt32 OS_ticks_get(void)
+{
+    struct timespec now;
+    unsigned long long usecs;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    usecs = (unsigned long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+
+    return (uInt32)(usecs / OS_TICK_PERIOD_US);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
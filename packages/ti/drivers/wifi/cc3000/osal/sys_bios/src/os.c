@@ -54,6 +54,7 @@
 
 #include <ti/sysbios/BIOS.h>
 
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Semaphore.h>
 #include <ti/sysbios/knl/Task.h>
 
@@ -452,6 +453,24 @@ e_ret_status OS_thread_sleep(uInt16 ticks)
     return e_SUCCESS;
 }
 
+/**
+ * \brief get the current time in timer ticks
+ *
+ * Returns the number of timer ticks elapsed since the system started.
+ * The count wraps around, so only differences between two calls are meaningful.
+ *
+ * \return   current tick count
+ *
+ * \sa OS_thread_sleep, OS_semaphore_pend
+ * \note
+ *
+ * \warning
+ */
+uInt32 OS_ticks_get(void)
+{
+    return Clock_getTicks();
+}
+
 //*****************************************************************************
 //
 // Close the Doxygen group.
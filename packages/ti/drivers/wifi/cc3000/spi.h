@@ -46,9 +46,12 @@ extern "C" {
 typedef Void (*RxHandlerFxn)(Void *buffer);
 
 /*
- *  Transmit buffer required by upper layer CC3000 host driver
+ *  Transmit buffers required by upper layer CC3000 host driver. wlan_tx_buffer
+ *  holds WiFi_TX_BUFFER_COUNT buffers of WiFi_TX_BUFFER_SIZE bytes each.
  */
 extern UChar wlan_tx_buffer[];
+extern const Int WiFi_TX_BUFFER_SIZE;
+extern const Int WiFi_TX_BUFFER_COUNT;
 
 /*
  *  Prototypes for APIs used by CC3000 Host Driver
@@ -57,6 +60,7 @@ extern Void SpiClose(Void);
 extern Void SpiOpen(RxHandlerFxn rxHandler);
 extern Void SpiResumeSpi(Void);
 extern Void SpiWrite(UChar *userBuffer, UShort length);
+extern Void SpiWriteAsync(UChar *userBuffer, UShort length);
 
 #ifdef  __cplusplus
 }